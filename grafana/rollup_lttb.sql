@@ -0,0 +1,107 @@
+-- rollup_lttb.sql — выборка для панелей Grafana из агрегатов sensor_rollup_* (collector --rollup)
+-- --------------------------------------------------------------------------------------------
+-- rollup_lttb(tag, stat, asset, t_from, t_to, max_points) → (ts, value)
+--   tag   — vibration | temperature | pressure
+--   stat  — min | max | avg | last
+-- Уровень выбирается по ширине окна: самый мелкий (1 с, 1 мин, 1 ч), у которого
+-- в окне не больше max_points * 8 корзин; затем Largest-Triangle-Three-Buckets
+-- оставляет max_points точек, сохраняя форму кривой (пики не усредняются).
+-- Окно в сутки на панели шириной 1000 точек — ~1440 строк sensor_rollup_1m
+-- вместо 86 400 строк на агрегат из sensor_data2.
+--
+-- Установка:
+--   psql -d postgres -f grafana/rollup_lttb.sql
+--
+-- Запрос панели:
+--   select ts, value as vibration
+--   from rollup_lttb('vibration', 'avg', $asset, $__timeFrom(), $__timeTo(),
+--                    ($__range_ms / $__interval_ms)::int)
+
+CREATE OR REPLACE FUNCTION public.rollup_lttb(tag text, stat text, asset integer,
+                                              t_from timestamptz, t_to timestamptz,
+                                              max_points integer DEFAULT 1000)
+RETURNS TABLE (ts timestamptz, value double precision)
+LANGUAGE plpgsql STABLE AS $$
+DECLARE
+    span   double precision := extract(epoch FROM t_to - t_from);
+    pts    integer := greatest(coalesce(max_points, 1000), 3);
+    lvl    text;
+    t      double precision[];
+    v      double precision[];
+    n      integer;
+    every  double precision;
+    a      integer := 1;     -- выбранная точка предыдущей корзины
+    nxt    integer;
+    avg_t  double precision;
+    avg_v  double precision;
+    avg_s  integer;
+    avg_e  integer;
+    area   double precision;
+    best   double precision;
+BEGIN
+    IF tag NOT IN ('vibration', 'temperature', 'pressure') THEN
+        RAISE EXCEPTION 'rollup_lttb: неизвестный тег %', tag;
+    END IF;
+    IF stat NOT IN ('min', 'max', 'avg', 'last') THEN
+        RAISE EXCEPTION 'rollup_lttb: неизвестная статистика %', stat;
+    END IF;
+
+    IF span <= pts * 8 THEN
+        lvl := '1s';
+    ELSIF span <= pts * 8 * 60 THEN
+        lvl := '1m';
+    ELSE
+        lvl := '1h';
+    END IF;
+
+    EXECUTE format('SELECT array_agg(extract(epoch FROM bucket) ORDER BY bucket),'
+                   ' array_agg(%I ORDER BY bucket)'
+                   ' FROM public.%I WHERE asset_id = $1 AND bucket >= $2 AND bucket < $3',
+                   tag || '_' || stat, 'sensor_rollup_' || lvl)
+        INTO t, v USING asset, t_from, t_to;
+    n := coalesce(array_length(t, 1), 0);
+
+    -- Точек не больше, чем нужно панели, — отдаём как есть
+    IF n <= pts THEN
+        FOR k IN 1 .. n LOOP
+            ts := to_timestamp(t[k]); value := v[k];
+            RETURN NEXT;
+        END LOOP;
+        RETURN;
+    END IF;
+
+    -- LTTB: первая и последняя точки остаются, внутренние n - 2 делятся на pts - 2 корзин;
+    -- из каждой берётся точка с наибольшей площадью треугольника с выбранной
+    -- точкой предыдущей корзины и средним следующей
+    every := (n - 2)::double precision / (pts - 2);
+    ts := to_timestamp(t[1]); value := v[1];
+    RETURN NEXT;
+    FOR i IN 0 .. pts - 3 LOOP
+        avg_s := floor((i + 1) * every)::integer + 2;
+        avg_e := least(floor((i + 2) * every)::integer + 1, n);
+        avg_t := 0; avg_v := 0;
+        FOR j IN avg_s .. avg_e LOOP
+            avg_t := avg_t + t[j];
+            avg_v := avg_v + coalesce(v[j], 0);
+        END LOOP;
+        avg_t := avg_t / (avg_e - avg_s + 1);
+        avg_v := avg_v / (avg_e - avg_s + 1);
+
+        best := -1;
+        nxt := floor(i * every)::integer + 2;
+        FOR j IN floor(i * every)::integer + 2 .. floor((i + 1) * every)::integer + 1 LOOP
+            area := abs((t[a] - avg_t) * (coalesce(v[j], 0) - coalesce(v[a], 0))
+                        - (t[a] - t[j]) * (avg_v - coalesce(v[a], 0)));
+            IF area > best THEN
+                best := area;
+                nxt := j;
+            END IF;
+        END LOOP;
+        ts := to_timestamp(t[nxt]); value := v[nxt];
+        RETURN NEXT;
+        a := nxt;
+    END LOOP;
+    ts := to_timestamp(t[n]); value := v[n];
+    RETURN NEXT;
+END;
+$$;
@@ -0,0 +1,89 @@
+-- sdt_interp.sql — восстановление сигнала из точек излома sensor_sdt (collector --sdt)
+-- ---------------------------------------------------------------------------------
+-- sdt_series(tag, asset, t_from, t_to, step) → (ts, value)
+--   tag  — vibration | temperature | pressure | alarm
+--   Значение в узлах сетки t_from, t_from + step, ... <= t_to — линейная интерполяция
+--   между соседними точками (для alarm — ступенька: последняя точка не позже узла).
+--   Берутся точки окна и по одной за его краями; отклонение от отсчёта, принятого
+--   сборщиком, не больше погрешности тега в --sdt. До первой точки тега узлов нет,
+--   после последней — её значение.
+-- sdt_rows(asset, t_from, t_to, step) → строки в форме sensor_data2
+--   (ts, vibration, temperature, pressure, vibration_alarm) — для скриптов ml/,
+--   ожидающих полные строки.
+--
+-- Установка:
+--   psql -d postgres -f grafana/sdt_interp.sql
+--
+-- Запрос панели (Grafana сама соединяет точки отрезками — интерполяция не нужна):
+--   select ts, value as pressure from sensor_sdt
+--   where asset_id = $asset and tag = 2 and $__timeFilter(ts) order by ts
+-- Сетка с шагом:
+--   select * from sdt_series('pressure', 0, now() - interval '1 hour', now(), interval '1 second')
+
+CREATE OR REPLACE FUNCTION public.sdt_series(tag text, asset integer,
+                                             t_from timestamptz, t_to timestamptz,
+                                             step interval DEFAULT interval '1 second')
+RETURNS TABLE (ts timestamptz, value double precision)
+LANGUAGE plpgsql STABLE AS $$
+DECLARE
+    code  smallint := array_position(ARRAY['vibration', 'temperature', 'pressure', 'alarm'], tag) - 1;
+    t     timestamptz[];
+    v     double precision[];
+    n     integer;
+    j     integer := 1;     -- последняя точка не позже узла g
+    g     timestamptz := t_from;
+BEGIN
+    IF code IS NULL THEN
+        RAISE EXCEPTION 'sdt_series: неизвестный тег %', tag;
+    END IF;
+    IF step <= interval '0' THEN
+        RAISE EXCEPTION 'sdt_series: шаг должен быть положительным';
+    END IF;
+
+    SELECT array_agg(p.ts ORDER BY p.ts), array_agg(p.value ORDER BY p.ts) INTO t, v
+    FROM ((SELECT s.ts, s.value FROM public.sensor_sdt s
+           WHERE s.asset_id = asset AND s.tag = code AND s.ts < t_from
+           ORDER BY s.ts DESC LIMIT 1)
+          UNION ALL
+          (SELECT s.ts, s.value FROM public.sensor_sdt s
+           WHERE s.asset_id = asset AND s.tag = code AND s.ts >= t_from AND s.ts <= t_to)
+          UNION ALL
+          (SELECT s.ts, s.value FROM public.sensor_sdt s
+           WHERE s.asset_id = asset AND s.tag = code AND s.ts > t_to
+           ORDER BY s.ts LIMIT 1)) p;
+    n := coalesce(array_length(t, 1), 0);
+    IF n = 0 THEN
+        RETURN;
+    END IF;
+
+    -- Сетка и точки упорядочены: один проход по обоим
+    WHILE g <= t_to LOOP
+        WHILE j < n AND t[j + 1] <= g LOOP
+            j := j + 1;
+        END LOOP;
+        IF g >= t[1] THEN
+            ts := g;
+            IF j = n OR code = 3 OR t[j] = g THEN
+                value := v[j];
+            ELSE
+                value := v[j] + (v[j + 1] - v[j])
+                         * extract(epoch FROM g - t[j]) / extract(epoch FROM t[j + 1] - t[j]);
+            END IF;
+            RETURN NEXT;
+        END IF;
+        g := g + step;
+    END LOOP;
+END $$;
+
+CREATE OR REPLACE FUNCTION public.sdt_rows(asset integer, t_from timestamptz, t_to timestamptz,
+                                           step interval DEFAULT interval '1 second')
+RETURNS TABLE (ts timestamptz, vibration double precision, temperature double precision,
+               pressure double precision, vibration_alarm boolean)
+LANGUAGE sql STABLE AS $$
+    SELECT v.ts, v.value, t.value, p.value, a.value > 0.5
+    FROM public.sdt_series('vibration', asset, t_from, t_to, step) v
+    JOIN public.sdt_series('temperature', asset, t_from, t_to, step) t ON t.ts = v.ts
+    JOIN public.sdt_series('pressure', asset, t_from, t_to, step) p ON p.ts = v.ts
+    LEFT JOIN public.sdt_series('alarm', asset, t_from, t_to, step) a ON a.ts = v.ts
+    ORDER BY v.ts
+$$;
@@ -0,0 +1,241 @@
+/*
+ * anomaly.c — реализация anomaly.h
+ * -------------------------------
+ */
+#include "anomaly.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Состояние канала (тег агрегата): прогноз Холта и базовая линия
+typedef struct {
+    double level, trend; // прогноз следующего отсчёта — level + trend
+    double rvar;         // дисперсия остатков прогноза
+    double mid;          // сглаженный обрезанный отсчёт — его дрейф и меряется
+    double smean, svar;  // базовая линия и её дисперсия
+} Channel;
+
+struct AnomalyDetector {
+    AnomalyConfig cfg;
+    double   alpha, beta;  // сглаживание уровня и наклона Холта
+    double   gamma;        // сглаживание mid и уровня оценок агрегата
+    size_t   n;
+    Channel *ch;           // [n * ANOMALY_TAGS]
+    double  *level;        // [n] уровень оценок агрегата
+    uint32_t *count;       // [n] отсчётов агрегата (до насыщения)
+
+    // Лес: дерево t, узел k (полное двоичное дерево, потомки 2k + 1 и 2k + 2)
+    size_t   nodes;        // узлов в дереве
+    uint8_t *dim;          // [trees * nodes] ось разбиения
+    float   *split;        // граница: u[dim] < split — левый потомок
+    uint32_t *ref, *cur;   // масса прошлого окна и счёт текущего
+    uint32_t limit;        // ANOMALY_SIZE_LIMIT · window
+    float   *surprise;     // [(depth + 1) * (window + 1)] оценка узла по глубине и массе
+    size_t   filled;       // строк в текущем окне
+    uint64_t windows, samples;
+};
+
+static inline uint64_t splitmix64(uint64_t *s) {
+    uint64_t z = (*s += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline double urand(uint64_t *s) {
+    return (double)(splitmix64(s) >> 11) * 0x1.0p-53;
+}
+
+// Разбиения поддерева k: случайная ось, граница — середина текущего диапазона по ней
+static void build(AnomalyDetector *d, size_t t, size_t k, unsigned depth,
+                  double *lo, double *hi, uint64_t *rng) {
+    if (depth == d->cfg.depth)
+        return;
+    const unsigned q = (unsigned)(splitmix64(rng) % ANOMALY_DIMS);
+    const double mid = 0.5 * (lo[q] + hi[q]), saveHi = hi[q], saveLo = lo[q];
+    d->dim[t * d->nodes + k] = (uint8_t)q;
+    d->split[t * d->nodes + k] = (float)mid;
+    hi[q] = mid;
+    build(d, t, 2 * k + 1, depth + 1, lo, hi, rng);
+    hi[q] = saveHi;
+    lo[q] = mid;
+    build(d, t, 2 * k + 2, depth + 1, lo, hi, rng);
+    lo[q] = saveLo;
+}
+
+AnomalyDetector *anomaly_new(size_t nAssets, const AnomalyConfig *cfg) {
+    AnomalyDetector *d = calloc(1, sizeof(*d));
+    if (!d)
+        return NULL;
+    AnomalyConfig c = cfg ? *cfg : (AnomalyConfig){ 0 };
+    if (c.trees == 0)  c.trees = 25;
+    if (c.depth == 0)  c.depth = 10;
+    if (c.depth > ANOMALY_MAX_DEPTH) c.depth = ANOMALY_MAX_DEPTH;
+    if (c.window == 0) c.window = 2048;
+    if (c.fast <= 0)   c.fast = 3.0;
+    if (c.slow <= 0)   c.slow = 2000.0;
+    if (c.warmup == 0) c.warmup = (size_t)(c.slow / 2);
+    if (c.seed == 0)   c.seed = 1;
+    d->cfg = c;
+    d->alpha = 2.0 / (c.fast + 1.0);
+    d->beta = d->alpha / 2;
+    d->gamma = 2.0 / (10.0 * c.fast + 1.0);
+    d->n = nAssets;
+    d->nodes = ((size_t)2 << c.depth) - 1;
+    d->limit = (uint32_t)(ANOMALY_SIZE_LIMIT * (double)c.window);
+
+    const size_t total = c.trees * d->nodes;
+    d->ch = calloc(nAssets * ANOMALY_TAGS, sizeof(Channel));
+    d->level = calloc(nAssets, sizeof(double));
+    d->count = calloc(nAssets, sizeof(uint32_t));
+    d->dim = calloc(total, sizeof(uint8_t));
+    d->split = calloc(total, sizeof(float));
+    d->ref = calloc(total, sizeof(uint32_t));
+    d->cur = calloc(total, sizeof(uint32_t));
+    d->surprise = malloc((c.depth + 1) * (c.window + 1) * sizeof(float));
+    if (!d->ch || !d->level || !d->count || !d->dim || !d->split || !d->ref || !d->cur || !d->surprise) {
+        anomaly_free(d);
+        return NULL;
+    }
+
+    // Оценки узлов заранее: масса узла не больше window — без log2 в спуске
+    const double logW = log2((double)c.window);
+    for (unsigned h = 0; h <= c.depth; h++)
+        for (size_t r = 0; r <= c.window; r++) {
+            const double s = logW - log2((double)r + 1.0) - h;
+            d->surprise[h * (c.window + 1) + r] = s > 0.0 ? (float)s : 0.0f;
+        }
+
+    // Рабочее пространство дерева — [0, 1] со случайным сдвигом: s ± 2·max(s, 1 - s) по оси
+    uint64_t rng = c.seed;
+    for (size_t t = 0; t < c.trees; t++) {
+        double lo[ANOMALY_DIMS], hi[ANOMALY_DIMS];
+        for (int q = 0; q < ANOMALY_DIMS; q++) {
+            const double s = urand(&rng), r = 2.0 * (s > 1.0 - s ? s : 1.0 - s);
+            lo[q] = s - r;
+            hi[q] = s + r;
+        }
+        build(d, t, 0, 0, lo, hi, &rng);
+    }
+    return d;
+}
+
+void anomaly_free(AnomalyDetector *d) {
+    if (!d)
+        return;
+    free(d->ch); free(d->level); free(d->count);
+    free(d->dim); free(d->split); free(d->ref); free(d->cur); free(d->surprise);
+    free(d);
+}
+
+// Шаг канала: z-оценки инновации и дрейфа до обновления, затем обновление (k — отсчётов до этого)
+static inline void channel_step(const AnomalyDetector *d, Channel *c, uint32_t k, double x,
+                                double *zInnov, double *zDrift) {
+    if (k == 0) {
+        c->level = c->mid = c->smean = x;
+        c->trend = c->rvar = c->svar = 0.0;
+        *zInnov = *zDrift = 0.0;
+        return;
+    }
+    const double eps = 1e-12 + 1e-18 * x * x; // нулевая дисперсия постоянного тега
+    const double kk = (double)k;
+
+    // Инновация: остаток прогноза Холта; в прогноз и дисперсию — обрезанный
+    const double pred = c->level + c->trend, r = x - pred, sd = sqrt(c->rvar + eps);
+    *zInnov = r / sd;
+    const double rc = (k > 2 && fabs(r) > ANOMALY_CLIP * sd) ? copysign(ANOMALY_CLIP * sd, r) : r;
+    const double level = pred + d->alpha * rc;
+    c->trend += d->beta * (level - c->level - c->trend);
+    c->level = level;
+    const double av = fmax(1.0 / kk, 10.0 / d->cfg.slow);
+    c->rvar += av * (rc * rc - c->rvar);
+
+    // Дрейф: сглаженный отсчёт относительно базовой линии; дисперсия базы — только без дрейфа
+    c->mid += d->gamma * (pred + rc - c->mid);
+    const double dev = c->mid - c->smean;
+    *zDrift = dev / sqrt(c->svar + eps);
+    const double as = fmax(1.0 / kk, 1.0 / d->cfg.slow);
+    c->smean += as * dev;
+    if (kk < d->cfg.slow || fabs(*zDrift) <= ANOMALY_CLIP)
+        c->svar += as * (dev * dev - c->svar);
+}
+
+double anomaly_update(AnomalyDetector *d, size_t asset, const double x[ANOMALY_TAGS],
+                      AnomalyInfo *info) {
+    double z[ANOMALY_DIMS], u[ANOMALY_DIMS];
+    if (asset >= d->n) { // чужой номер агрегата: без оценки и обучения
+        if (info)
+            memset(info, 0, sizeof(*info));
+        return 0.0;
+    }
+    const uint32_t k = d->count[asset];
+    Channel *ch = &d->ch[asset * ANOMALY_TAGS];
+    for (int c = 0; c < ANOMALY_TAGS; c++)
+        channel_step(d, &ch[c], k, x[c], &z[2 * c], &z[2 * c + 1]);
+    if (k < UINT32_MAX)
+        d->count[asset] = k + 1;
+    d->samples++;
+    if (info) {
+        info->level = d->level[asset];
+        memcpy(info->z, z, sizeof(z));
+    }
+    if (k < d->cfg.warmup)
+        return 0.0;
+
+    for (int j = 0; j < ANOMALY_DIMS; j++)
+        u[j] = 0.5 + copysign(fmin(log2(1.0 + fabs(z[j])) * (1.0 / 14.0), 0.5), z[j]);
+
+    // Спуск по каждому дереву: счёт окна на всём пути, оценка — по первому редкому узлу
+    const unsigned H = d->cfg.depth;
+    const size_t W1 = d->cfg.window + 1;
+    float surprise = 0.0f;
+    for (size_t t = 0; t < d->cfg.trees; t++) {
+        const uint8_t *dim = &d->dim[t * d->nodes];
+        const float *split = &d->split[t * d->nodes];
+        const uint32_t *ref = &d->ref[t * d->nodes];
+        uint32_t *cur = &d->cur[t * d->nodes];
+        size_t node = 0;
+        int scored = 0;
+        for (unsigned depth = 0;; depth++) {
+            cur[node]++;
+            if (!scored && (ref[node] < d->limit || depth == H)) {
+                surprise += d->surprise[depth * W1 + ref[node]];
+                scored = 1;
+            }
+            if (depth == H)
+                break;
+            node = 2 * node + 1 + (u[dim[node]] >= split[node]);
+        }
+    }
+
+    double score = 0.0;
+    if (d->windows > 0) {
+        score = surprise / (double)d->cfg.trees;
+        d->level[asset] += d->gamma * (score - d->level[asset]);
+        if (info)
+            info->level = d->level[asset];
+    }
+
+    // Конец окна: текущий счёт — опорная масса следующего
+    if (++d->filled == d->cfg.window) {
+        uint32_t *swap = d->ref;
+        d->ref = d->cur;
+        d->cur = swap;
+        memset(d->cur, 0, d->cfg.trees * d->nodes * sizeof(uint32_t));
+        d->filled = 0;
+        d->windows++;
+    }
+    return score;
+}
+
+double anomaly_level(const AnomalyDetector *d, size_t asset) {
+    return asset < d->n ? d->level[asset] : 0.0;
+}
+
+uint64_t anomaly_samples(const AnomalyDetector *d) {
+    return d->samples;
+}
+
+int anomaly_ready(const AnomalyDetector *d) {
+    return d->windows > 0;
+}
@@ -0,0 +1,86 @@
+/*
+ * anomaly.h — потоковый детектор аномалий без учителя по трём тегам агрегата
+ * -------------------------------------------------------------------------
+ * Модель тревоги (rf_infer.c, online_model.c) учит метку vibration_alarm, то есть
+ * порог vib >= 7 мм/с, и не видит ни перегревов, ни медленного износа. Здесь метки
+ * нет: строка агрегата оценивается тем, насколько она непохожа на недавний поток.
+ *
+ * 1. Нормировка по агрегату (O(1) памяти на канал, без окон):
+ *    инновация — отклонение тега от прогноза Холта (уровень + наклон, постоянная
+ *                cfg.fast отсчётов) в СКО остатков; в прогноз и дисперсию выброс
+ *                входит обрезанным до ±ANOMALY_CLIP СКО — перегрев не сдвигает базу;
+ *    дрейф     — отклонение сглаженного (10 × cfg.fast) обрезанного отсчёта от
+ *                медленной базовой линии (cfg.slow отсчётов) в СКО базы. Дисперсия
+ *                базы не обновляется, пока дрейф больше ANOMALY_CLIP СКО: затяжной
+ *                рост (износ) не «привыкает» к себе.
+ *    Шесть z-оценок (инновация и дрейф трёх тегов) сжимаются в [0, 1] логарифмически:
+ *    0.5 ± log2(1 + |z|) / 14 — хвосты не слипаются, как у tanh.
+ *
+ * 2. Оценка — лес полупространственных деревьев (Half-Space Trees, потоковый
+ *    вариант isolation forest), общий для парка: cfg.trees случайных деревьев
+ *    глубины cfg.depth делят рабочее пространство пополам по случайной оси.
+ *    Узел считает строки текущего окна из cfg.window строк; в конце окна счёт
+ *    становится опорной «массой», а новый начинается с нуля. Строка спускается до
+ *    узла, где опорных строк меньше ANOMALY_SIZE_LIMIT доли окна (или до дна);
+ *    оценка дерева — «неожиданность» узла в битах, log2(window / ((масса + 1) · 2^глубина)),
+ *    ниже нуля — 0; оценка строки — среднее по деревьям.
+ *    Частые события (скачки вибрации 5 %) — плотная область, оценка около нуля;
+ *    редкие (перегрев 0,1 %) — пустые узлы на малой глубине.
+ *
+ * 3. Уровень агрегата — экспоненциальное среднее оценок его строк (10 × cfg.fast):
+ *    одиночный выброс его почти не сдвигает, а умеренная, но упорная оценка дрейфа
+ *    накапливается. Пороги по замерам на модели dynamic4 (signal_model.c) —
+ *    ANOMALY_SCORE_ALERT и ANOMALY_LEVEL_ALERT: на норме не превышаются.
+ *
+ * Сначала оценка, потом обучение (test-then-train). Первые cfg.warmup строк агрегата
+ * и первое окно леса — оценка 0. Память — ~160 байт на агрегат и trees × 2^(depth+1)
+ * узлов по 13 байт; строка — O(trees × depth), конец окна — O(узлов) раз в window строк.
+ * Модуль не зависит от open62541: используется в сборщике и в anomaly_scan.c.
+ */
+#ifndef ANOMALY_H
+#define ANOMALY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ANOMALY_TAGS        3    // vibration, temperature, pressure
+#define ANOMALY_DIMS        (2 * ANOMALY_TAGS) // инновация и дрейф каждого тега
+#define ANOMALY_CLIP        4.0  // СКО: обрезка инноваций, порог обновления базы
+#define ANOMALY_SIZE_LIMIT  0.05 // доля окна: в узле реже — спуск останавливается
+#define ANOMALY_MAX_DEPTH   15
+#define ANOMALY_SCORE_ALERT 1.0  // оценка строки: выброс (перегрев)
+#define ANOMALY_LEVEL_ALERT 0.4  // уровень агрегата: затяжное отклонение (износ)
+
+// Параметры; нулевое поле — значение по умолчанию
+typedef struct {
+    size_t   trees;    // деревьев (25)
+    unsigned depth;    // глубина, 1..ANOMALY_MAX_DEPTH (10)
+    size_t   window;   // строк в окне массы, по всему парку (2048)
+    double   fast;     // постоянная прогноза Холта, отсчётов агрегата (3)
+    double   slow;     // постоянная базовой линии, отсчётов агрегата (2000)
+    size_t   warmup;   // отсчётов агрегата до первой оценки (slow / 2)
+    uint64_t seed;     // разбиения деревьев (1)
+} AnomalyConfig;
+
+// Подробности оценки строки
+typedef struct {
+    double level;              // уровень агрегата после этой строки
+    double z[ANOMALY_DIMS];    // [2c] — инновация тега c, [2c + 1] — дрейф
+} AnomalyInfo;
+
+typedef struct AnomalyDetector AnomalyDetector;
+
+// Детектор на nAssets агрегатов; NULL при нехватке памяти
+AnomalyDetector *anomaly_new(size_t nAssets, const AnomalyConfig *cfg);
+void anomaly_free(AnomalyDetector *d);
+
+// Оценка строки агрегата в битах (0 — норма или прогрев), затем обучение; info может быть NULL.
+// asset >= nAssets — 0 без обучения, info обнуляется
+double anomaly_update(AnomalyDetector *d, size_t asset, const double x[ANOMALY_TAGS],
+                      AnomalyInfo *info);
+
+double   anomaly_level(const AnomalyDetector *d, size_t asset); // уровень агрегата (вне диапазона — 0)
+uint64_t anomaly_samples(const AnomalyDetector *d);             // строк принято
+int      anomaly_ready(const AnomalyDetector *d);               // первое окно массы закрыто
+
+#endif
@@ -0,0 +1,204 @@
+/*
+ * anomaly_scan.c — оценка аномалий (anomaly.c) по истории хранилища сегментов
+ * --------------------------------------------------------------------------
+ * Прогоняет строки seg_store.c через anomaly_update() — так же, как сборщик с
+ * --anomaly на живом потоке: сначала оценка, потом обучение, один проход, без меток.
+ * Печатает число строк выше ANOMALY_SCORE_ALERT, агрегаты, чей уровень поднимался
+ * выше ANOMALY_LEVEL_ALERT (с первым таким моментом), --top строк с наибольшей
+ * оценкой и скорость.
+ *
+ * Строки идут в порядке хранилища: раздел за разделом, внутри — по агрегатам, а не
+ * вперемешку, как в сборщике. Нормировка по агрегату от этого не зависит, но окно массы
+ * леса видит отрезок одного агрегата, а не весь парк в один момент: оценки строк близки
+ * к живым, уровень даёт лишние срабатывания (на модели dynamic4 — ~4 % агрегатов против
+ * 0 у сборщика). Для поиска износа смотрите агрегаты с наибольшим уровнем.
+ *
+ * Сборка:
+ *   gcc -O3 -march=native anomaly_scan.c anomaly.c seg_store.c -lm -o anomaly_scan
+ *
+ * Запуск:
+ *   ./anomaly_scan ../data/store
+ *   ./anomaly_scan ../data/store --from 1756425600000000 --top 50
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "anomaly.h"
+#include "seg_store.h"
+
+#define SCAN_ROWS 65536 // строк за вызов seg_scan_next
+#define MAX_TOP   10000
+
+typedef struct {
+    double   score;
+    int64_t  ts;
+    uint32_t asset;
+    double   vib, temp, press;
+} Hit;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Мин-куча top строк по оценке: корень — наименьшая из лучших
+static void heap_push(Hit *h, size_t *n, size_t cap, const Hit *x) {
+    size_t i;
+    if (*n < cap) {
+        i = (*n)++;
+        while (i > 0 && h[(i - 1) / 2].score > x->score) {
+            h[i] = h[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        h[i] = *x;
+        return;
+    }
+    if (cap == 0 || x->score <= h[0].score)
+        return;
+    i = 0;
+    for (;;) {
+        size_t c = 2 * i + 1;
+        if (c >= *n)
+            break;
+        if (c + 1 < *n && h[c + 1].score < h[c].score)
+            c++;
+        if (h[c].score >= x->score)
+            break;
+        h[i] = h[c];
+        i = c;
+    }
+    h[i] = *x;
+}
+
+static int by_score_desc(const void *a, const void *b) {
+    const double x = ((const Hit *)a)->score, y = ((const Hit *)b)->score;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Использование: %s STORE [--from US] [--to US] [--top K]\n"
+            "  --from/--to  диапазон, микросекунды Unix\n"
+            "  --top K      строк с наибольшей оценкой в отчёте (по умолчанию 20, до %d)\n",
+            prog, MAX_TOP);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char *storeDir = argv[1];
+    int64_t from = INT64_MIN, to = INT64_MAX;
+    unsigned long top = 20;
+    for (int a = 2; a < argc; a++) {
+        if (a + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        const char *opt = argv[a], *val = argv[++a];
+        if (!strcmp(opt, "--from"))      from = strtoll(val, NULL, 10);
+        else if (!strcmp(opt, "--to"))  to = strtoll(val, NULL, 10);
+        else if (!strcmp(opt, "--top")) top = strtoul(val, NULL, 10);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (top > MAX_TOP) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    char err[256];
+    SegReader *r = seg_reader_open(storeDir, err, sizeof(err));
+    if (!r) {
+        fprintf(stderr, "❌ %s\n", err);
+        return 1;
+    }
+
+    int64_t *ts = malloc(SCAN_ROWS * sizeof(int64_t));
+    uint32_t *id = malloc(SCAN_ROWS * sizeof(uint32_t));
+    double *vib = malloc(SCAN_ROWS * sizeof(double));
+    double *temp = malloc(SCAN_ROWS * sizeof(double));
+    double *press = malloc(SCAN_ROWS * sizeof(double));
+    uint8_t *alarm = malloc(SCAN_ROWS);
+    Hit *hits = malloc((top + 1) * sizeof(Hit));
+    if (!ts || !id || !vib || !temp || !press || !alarm || !hits) {
+        fprintf(stderr, "❌ нет памяти\n");
+        return 1;
+    }
+
+    // --- Число агрегатов для состояния детектора: проход только по asset ---
+    uint32_t maxId = 0;
+    SegScan *s = seg_scan_new(r, SEG_ALL_ASSETS, from, to);
+    SegRows ids = { NULL, id, NULL, NULL, NULL, NULL };
+    size_t n;
+    while (s && (n = seg_scan_next(s, &ids, SCAN_ROWS)) > 0)
+        for (size_t i = 0; i < n; i++)
+            maxId = id[i] > maxId ? id[i] : maxId;
+    seg_scan_free(s);
+    const size_t nAssets = (size_t)maxId + 1;
+    AnomalyDetector *d = anomaly_new(nAssets, NULL);
+    int64_t *firstHigh = malloc(nAssets * sizeof(int64_t)); // первый выход уровня за порог, 0 — не было
+    double *maxLevel = calloc(nAssets, sizeof(double));
+    if (!d || !firstHigh || !maxLevel) {
+        fprintf(stderr, "❌ нет памяти под %zu агрегатов\n", nAssets);
+        return 1;
+    }
+    memset(firstHigh, 0, nAssets * sizeof(int64_t));
+
+    // --- Оценка → обучение по каждой строке ---
+    if (!(s = seg_scan_new(r, SEG_ALL_ASSETS, from, to))) {
+        fprintf(stderr, "❌ нет памяти\n");
+        return 1;
+    }
+    SegRows out = { ts, id, vib, temp, press, alarm };
+    unsigned long long rows = 0, high = 0;
+    size_t nHits = 0;
+    double t0 = now_s();
+    while ((n = seg_scan_next(s, &out, SCAN_ROWS)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            const double x[ANOMALY_TAGS] = { vib[i], temp[i], press[i] };
+            AnomalyInfo info;
+            const double score = anomaly_update(d, id[i], x, &info);
+            high += score >= ANOMALY_SCORE_ALERT;
+            if (info.level > maxLevel[id[i]])
+                maxLevel[id[i]] = info.level;
+            if (info.level >= ANOMALY_LEVEL_ALERT && !firstHigh[id[i]])
+                firstHigh[id[i]] = ts[i];
+            if (score > 0.0) {
+                const Hit h = { score, ts[i], id[i], vib[i], temp[i], press[i] };
+                heap_push(hits, &nHits, top, &h);
+            }
+        }
+        rows += n;
+    }
+    double dt = now_s() - t0;
+    seg_scan_free(s);
+
+    printf("Строк: %llu  агрегатов: %zu  выше %.1f: %llu (%.4f%%)\n", rows, nAssets,
+           ANOMALY_SCORE_ALERT, high, rows ? 100.0 * high / rows : 0.0);
+    size_t assetsHigh = 0;
+    for (size_t a = 0; a < nAssets; a++)
+        if (firstHigh[a]) {
+            if (assetsHigh++ < top)
+                printf("  агрегат %zu: уровень выше %.1f с %lld, наибольший %.2f\n", a,
+                       ANOMALY_LEVEL_ALERT, (long long)firstHigh[a], maxLevel[a]);
+        }
+    printf("Агрегатов с уровнем выше %.1f: %zu\n", ANOMALY_LEVEL_ALERT, assetsHigh);
+    qsort(hits, nHits, sizeof(Hit), by_score_desc);
+    for (size_t k = 0; k < nHits; k++)
+        printf("  %.3f  агрегат %u  ts %lld  вибрация %.3f  температура %.2f  давление %.3f\n",
+               hits[k].score, hits[k].asset, (long long)hits[k].ts, hits[k].vib, hits[k].temp,
+               hits[k].press);
+    printf("%llu строк за %.2f с — %.2f млн строк/с\n", rows, dt, dt > 0 ? rows / dt / 1e6 : 0.0);
+
+    anomaly_free(d);
+    seg_reader_close(r);
+    free(firstHigh); free(maxLevel); free(hits);
+    free(ts); free(id); free(vib); free(temp); free(press); free(alarm);
+    return 0;
+}
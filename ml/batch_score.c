@@ -0,0 +1,723 @@
+/*
+ * batch_score.c — многопоточная пакетная оценка истории лесом model_rf_alarm.rff
+ * ---------------------------------------------------------------------------
+ * Замена ml_evaluate.py / pandas + model.predict для больших архивов: вход
+ * читается потоком кусками, каждая строка оценивается лесом (rf_infer.c),
+ * считаются матрица ошибок и precision / recall / F1 по vibration_alarm,
+ * прогнозы пишутся в CSV (--out).
+ *
+ * Вход:
+ *   CSV формата data/sensor_data.csv (колонки ищутся по заголовку; asset_id —
+ *   если есть; "-" — stdin, например из zcat) или каталог хранилища сегментов
+ *   (seg_store.c, collector --store). Parquet без libarrow не читается: его
+ *   переводят в CSV (pandas read_parquet → to_csv) или в сегменты (seg_tool import).
+ *
+ * Потоки:
+ *   главный — читает вход кусками (CSV — 4 МБ по границе строки, сегменты —
+ *   262 144 строки) и раскладывает их по очередям рабочих по кругу;
+ *   рабочие — берут куски из своей очереди, а когда она пуста, крадут самый
+ *   старый кусок из чужих (work stealing): медленный кусок (длинные строки,
+ *   вытесненный поток) не держит остальных. Кусок разбирается и оценивается
+ *   блоками по 1024 строки — признаки и вероятности остаются в L1;
+ *   писатель — выводит готовые куски строго по порядку входа и возвращает
+ *   их в пул.
+ * Память ограничена --mem: кусков в обороте не больше, чем помещается в лимит,
+ * при исчерпании пула чтение ждёт писателя.
+ *
+ * Сборка:
+ *   gcc -O3 -march=native -pthread batch_score.c rf_infer.c seg_store.c -o batch_score
+ *
+ * Запуск:
+ *   ./batch_score model_rf_alarm.rff ../data/sensor_data.csv
+ *   ./batch_score model_rf_alarm.rff ../data/store --threads 32 --out pred.csv
+ *   zcat archive.csv.gz | ./batch_score model_rf_alarm.rff - --mem 256
+ */
+#define _GNU_SOURCE // memrchr()
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "rf_infer.h"
+#include "seg_store.h"
+
+#define CHUNK_BYTES  (4u << 20) // байт CSV в куске
+#define CHUNK_ROWS   262144     // строк хранилища в куске
+#define SUB_ROWS     1024       // строк в блоке разбора и оценки
+#define OUT_ROW_MAX  40         // байт строки вывода сверх ts и asset_id
+#define MAX_THREADS  256
+#define MAX_FIELDS   16
+
+// Кусок входа: текст CSV или колонки хранилища, вывод и матрица ошибок
+typedef struct {
+    uint64_t  seq;
+    int       ready;            // оценён (под sched.lock)
+    char     *text;             // CSV: целые строки
+    size_t    textLen;
+    size_t    rows;             // хранилище: строк в колонках
+    int64_t  *ts;
+    uint32_t *asset;
+    double   *col[3];           // vibration, temperature, pressure
+    uint8_t  *alarm;
+    char     *out;              // готовые строки прогноза
+    size_t    outLen, outCap;
+    uint64_t  cm[4];            // tp, fp, fn, tn
+    uint64_t  scored, bad;
+} Chunk;
+
+// Очередь рабочего: кольцо указателей, владелец и воры берут с головы (самый старый)
+typedef struct {
+    pthread_mutex_t lock;
+    Chunk         **items;
+    size_t          head, count;
+} WorkQueue;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  work, done, freed;
+    WorkQueue       q[MAX_THREADS];
+    size_t          nWorkers, slots;
+    Chunk         **freeList;   // свободные куски
+    size_t          nFree;
+    Chunk         **pending;    // выданные куски по seq % slots — для вывода по порядку
+    uint64_t        produced;   // кусков выдано
+    int             eof;
+    _Atomic size_t  queued;     // кусков в очередях
+    _Atomic uint64_t steals;
+} sched;
+
+// Разбор входа
+static const RfForest *forest;
+static int csvMode;             // 1 — CSV, 0 — хранилище
+static int colTs = -1, colVib = -1, colTemp = -1, colPress = -1, colAlarm = -1, colAsset = -1;
+static int maxCol;
+static int withAsset, withLabels, writeOut;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// === Очереди и пул ===
+
+static void queue_push(size_t w, Chunk *c) {
+    WorkQueue *q = &sched.q[w];
+    pthread_mutex_lock(&q->lock);
+    q->items[(q->head + q->count) % sched.slots] = c;
+    q->count++;
+    pthread_mutex_unlock(&q->lock);
+}
+
+static Chunk *queue_pop(size_t w) {
+    WorkQueue *q = &sched.q[w];
+    Chunk *c = NULL;
+    pthread_mutex_lock(&q->lock);
+    if (q->count) {
+        c = q->items[q->head];
+        q->head = (q->head + 1) % sched.slots;
+        q->count--;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return c;
+}
+
+// Свой кусок или украденный у соседей; NULL — все очереди пусты
+static Chunk *take(size_t self) {
+    Chunk *c = queue_pop(self);
+    for (size_t k = 1; !c && k < sched.nWorkers; k++)
+        if ((c = queue_pop((self + k) % sched.nWorkers)))
+            atomic_fetch_add_explicit(&sched.steals, 1, memory_order_relaxed);
+    if (c)
+        atomic_fetch_sub(&sched.queued, 1);
+    return c;
+}
+
+static int out_reserve(Chunk *c, size_t bytes) {
+    if (c->outLen + bytes <= c->outCap)
+        return 1;
+    size_t cap = c->outCap * 2 + bytes;
+    char *grown = realloc(c->out, cap);
+    if (!grown)
+        return 0;
+    c->out = grown;
+    c->outCap = cap;
+    return 1;
+}
+
+// === Оценка ===
+
+// "0.123456" — без printf, вызывается на каждую строку
+static char *put_prob(char *p, float v) {
+    unsigned u = (unsigned)(v * 1e6f + 0.5f);
+    if (u >= 1000000) {
+        memcpy(p, "1.000000", 8);
+        return p + 8;
+    }
+    *p++ = '0';
+    *p++ = '.';
+    for (int d = 5; d >= 0; d--) {
+        p[d] = (char)('0' + u % 10);
+        u /= 10;
+    }
+    return p + 6;
+}
+
+static char *put_u32(char *p, uint32_t v) {
+    char tmp[10];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n)
+        *p++ = tmp[--n];
+    return p;
+}
+
+// "2025-08-29 15:49:24.588316+00:00"; tsCache — дата последней секунды потока
+static char *put_ts(char *p, int64_t us, int64_t *cacheSec, char cache[20]) {
+    int64_t sec = us / 1000000, frac = us % 1000000;
+    if (frac < 0) {
+        sec--;
+        frac += 1000000;
+    }
+    if (sec != *cacheSec) {
+        time_t t = (time_t)sec;
+        struct tm tm;
+        gmtime_r(&t, &tm);
+        strftime(cache, 20, "%Y-%m-%d %H:%M:%S", &tm);
+        *cacheSec = sec;
+    }
+    memcpy(p, cache, 19);
+    p += 19;
+    *p++ = '.';
+    for (int d = 5; d >= 0; d--) {
+        p[d] = (char)('0' + frac % 10);
+        frac /= 10;
+    }
+    p += 6;
+    memcpy(p, "+00:00", 6);
+    return p + 6;
+}
+
+static int parse_bool(const char *s) {
+    return s[0] == 'T' || s[0] == 't' || s[0] == '1';
+}
+
+// Прогнозы блока из m строк: матрица ошибок и строки вывода
+typedef struct {
+    float       X[SUB_ROWS * 3];
+    float       proba[SUB_ROWS];
+    uint8_t     y[SUB_ROWS];
+    const char *tsText[SUB_ROWS], *idText[SUB_ROWS]; // CSV: поля как есть
+    uint32_t    tsLen[SUB_ROWS], idLen[SUB_ROWS];
+    int64_t     tsUs[SUB_ROWS];                      // хранилище
+    uint32_t    id[SUB_ROWS];
+    int64_t     cacheSec;
+    char        cache[20];
+} Block;
+
+static void score_block(Chunk *c, Block *b, size_t m) {
+    rf_predict_proba(forest, b->X, m, b->proba);
+    for (size_t r = 0; r < m; r++) {
+        const int pred = b->proba[r] > 0.5f, y = b->y[r];
+        c->cm[0] += pred && y;
+        c->cm[1] += pred && !y;
+        c->cm[2] += !pred && y;
+        c->cm[3] += !pred && !y;
+    }
+    c->scored += m;
+    if (!writeOut)
+        return;
+    for (size_t r = 0; r < m; r++) {
+        size_t need = OUT_ROW_MAX + (csvMode ? (size_t)b->tsLen[r] + b->idLen[r] : 32);
+        if (!out_reserve(c, need)) {
+            fprintf(stderr, "❌ нет памяти под вывод\n");
+            exit(1);
+        }
+        char *p = c->out + c->outLen;
+        if (csvMode) {
+            memcpy(p, b->tsText[r], b->tsLen[r]);
+            p += b->tsLen[r];
+        } else {
+            p = put_ts(p, b->tsUs[r], &b->cacheSec, b->cache);
+        }
+        if (withAsset) {
+            *p++ = ',';
+            if (csvMode) {
+                memcpy(p, b->idText[r], b->idLen[r]);
+                p += b->idLen[r];
+            } else {
+                p = put_u32(p, b->id[r]);
+            }
+        }
+        *p++ = ',';
+        p = put_prob(p, b->proba[r]);
+        *p++ = ',';
+        *p++ = b->proba[r] > 0.5f ? '1' : '0';
+        *p++ = '\n';
+        c->outLen = (size_t)(p - c->out);
+    }
+}
+
+static void process_csv(Chunk *c, Block *b) {
+    const char *p = c->text, *end = c->text + c->textLen;
+    size_t m = 0;
+    while (p < end) {
+        const char *line = p;
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        const char *eol = nl ? nl : end;
+        const char *f[MAX_FIELDS];
+        size_t len[MAX_FIELDS];
+        int nf = 0;
+        const char *s = p;
+        while (nf <= maxCol) {
+            const char *comma = memchr(s, ',', (size_t)(eol - s));
+            const char *fe = comma ? comma : eol;
+            f[nf] = s;
+            len[nf] = (size_t)(fe - s);
+            if (len[nf] && fe[-1] == '\r' && !comma)
+                len[nf]--;
+            nf++;
+            if (!comma)
+                break;
+            s = comma + 1;
+        }
+        p = nl ? nl + 1 : end;
+        if (nf <= maxCol) {
+            if (eol - line > 1 || (eol - line == 1 && *line != '\r')) // пустые строки — не ошибка
+                c->bad++;
+            continue;
+        }
+        char *e0, *e1, *e2;
+        b->X[m * 3 + 0] = (float)strtod(f[colVib], &e0);
+        b->X[m * 3 + 1] = (float)strtod(f[colTemp], &e1);
+        b->X[m * 3 + 2] = (float)strtod(f[colPress], &e2);
+        if (e0 == f[colVib] || e1 == f[colTemp] || e2 == f[colPress]) {
+            c->bad++;
+            continue;
+        }
+        b->y[m] = colAlarm >= 0 && parse_bool(f[colAlarm]);
+        b->tsText[m] = colTs >= 0 ? f[colTs] : "";
+        b->tsLen[m] = colTs >= 0 ? (uint32_t)len[colTs] : 0;
+        b->idText[m] = colAsset >= 0 ? f[colAsset] : "";
+        b->idLen[m] = colAsset >= 0 ? (uint32_t)len[colAsset] : 0;
+        if (++m == SUB_ROWS) {
+            score_block(c, b, m);
+            m = 0;
+        }
+    }
+    if (m)
+        score_block(c, b, m);
+}
+
+static void process_store(Chunk *c, Block *b) {
+    for (size_t base = 0; base < c->rows; base += SUB_ROWS) {
+        size_t m = c->rows - base < SUB_ROWS ? c->rows - base : SUB_ROWS;
+        for (size_t r = 0; r < m; r++) {
+            b->X[r * 3 + 0] = (float)c->col[0][base + r];
+            b->X[r * 3 + 1] = (float)c->col[1][base + r];
+            b->X[r * 3 + 2] = (float)c->col[2][base + r];
+            b->y[r] = c->alarm[base + r];
+            b->tsUs[r] = c->ts[base + r];
+            b->id[r] = c->asset[base + r];
+        }
+        score_block(c, b, m);
+    }
+}
+
+static void *worker_main(void *arg) {
+    const size_t self = (size_t)(uintptr_t)arg;
+    Block *b = malloc(sizeof(Block));
+    if (!b) {
+        fprintf(stderr, "❌ нет памяти\n");
+        exit(1);
+    }
+    b->cacheSec = INT64_MIN;
+    for (;;) {
+        Chunk *c = take(self);
+        if (!c) {
+            pthread_mutex_lock(&sched.lock);
+            while (atomic_load(&sched.queued) == 0 && !sched.eof)
+                pthread_cond_wait(&sched.work, &sched.lock);
+            int finished = atomic_load(&sched.queued) == 0 && sched.eof;
+            pthread_mutex_unlock(&sched.lock);
+            if (finished)
+                break;
+            continue;
+        }
+        if (csvMode)
+            process_csv(c, b);
+        else
+            process_store(c, b);
+        pthread_mutex_lock(&sched.lock);
+        c->ready = 1;
+        pthread_cond_broadcast(&sched.done);
+        pthread_mutex_unlock(&sched.lock);
+    }
+    free(b);
+    return NULL;
+}
+
+// === Вывод по порядку ===
+
+static FILE *outFile;
+static uint64_t total[4], totalRows, totalBad;
+static double t0;
+
+static void *writer_main(void *arg) {
+    (void)arg;
+    double lastReport = now_s();
+    for (uint64_t next = 0;; next++) {
+        pthread_mutex_lock(&sched.lock);
+        Chunk *c;
+        while (!((c = sched.pending[next % sched.slots]) && c->seq == next && c->ready) &&
+               !(sched.eof && next == sched.produced))
+            pthread_cond_wait(&sched.done, &sched.lock);
+        if (sched.eof && next == sched.produced) {
+            pthread_mutex_unlock(&sched.lock);
+            break;
+        }
+        sched.pending[next % sched.slots] = NULL;
+        pthread_mutex_unlock(&sched.lock);
+
+        if (outFile && c->outLen && fwrite(c->out, 1, c->outLen, outFile) != c->outLen) {
+            perror("запись прогнозов");
+            exit(1);
+        }
+        for (int k = 0; k < 4; k++)
+            total[k] += c->cm[k];
+        totalRows += c->scored;
+        totalBad += c->bad;
+
+        double now = now_s();
+        if (now - lastReport >= 5.0) {
+            fprintf(stderr, "… %llu строк, %.1f млн строк/с\n", (unsigned long long)totalRows,
+                    totalRows / (now - t0) / 1e6);
+            lastReport = now;
+        }
+
+        pthread_mutex_lock(&sched.lock);
+        sched.freeList[sched.nFree++] = c;
+        pthread_cond_signal(&sched.freed);
+        pthread_mutex_unlock(&sched.lock);
+    }
+    return NULL;
+}
+
+// === Чтение входа ===
+
+static Chunk *get_free(void) {
+    pthread_mutex_lock(&sched.lock);
+    while (sched.nFree == 0)
+        pthread_cond_wait(&sched.freed, &sched.lock);
+    Chunk *c = sched.freeList[--sched.nFree];
+    pthread_mutex_unlock(&sched.lock);
+    c->outLen = 0;
+    c->scored = c->bad = 0;
+    memset(c->cm, 0, sizeof(c->cm));
+    return c;
+}
+
+static void submit(Chunk *c) {
+    pthread_mutex_lock(&sched.lock);
+    c->seq = sched.produced++;
+    c->ready = 0;
+    sched.pending[c->seq % sched.slots] = c;
+    pthread_mutex_unlock(&sched.lock);
+
+    queue_push(c->seq % sched.nWorkers, c);
+    pthread_mutex_lock(&sched.lock);
+    atomic_fetch_add(&sched.queued, 1);
+    pthread_cond_signal(&sched.work);
+    pthread_mutex_unlock(&sched.lock);
+}
+
+// Заголовок CSV → номера колонок
+static int parse_header(char *line) {
+    line[strcspn(line, "\r\n")] = 0;
+    int i = 0;
+    for (char *tok = strtok(line, ","); tok; tok = strtok(NULL, ","), i++) {
+        if (i >= MAX_FIELDS)
+            break;
+        if (!strcmp(tok, "ts"))                   colTs = i;
+        else if (!strcmp(tok, "vibration"))       colVib = i;
+        else if (!strcmp(tok, "temperature"))     colTemp = i;
+        else if (!strcmp(tok, "pressure"))        colPress = i;
+        else if (!strcmp(tok, "vibration_alarm")) colAlarm = i;
+        else if (!strcmp(tok, "asset_id"))        colAsset = i;
+    }
+    if (colVib < 0 || colTemp < 0 || colPress < 0)
+        return 0;
+    const int cols[] = { colTs, colVib, colTemp, colPress, colAlarm, colAsset };
+    for (size_t k = 0; k < sizeof(cols) / sizeof(cols[0]); k++)
+        maxCol = cols[k] > maxCol ? cols[k] : maxCol;
+    withAsset = colAsset >= 0;
+    withLabels = colAlarm >= 0;
+    return 1;
+}
+
+// CSV кусками по границе строки; хвост неполной строки переносится в следующий кусок
+static int read_csv(FILE *in) {
+    char *carry = malloc(CHUNK_BYTES);
+    size_t carryLen = 0;
+    if (!carry)
+        return 0;
+    for (;;) {
+        Chunk *c = get_free();
+        memcpy(c->text, carry, carryLen);
+        size_t len = carryLen + fread(c->text + carryLen, 1, CHUNK_BYTES - carryLen, in);
+        int eof = len < CHUNK_BYTES;
+        if (eof && ferror(in)) {
+            perror("чтение CSV");
+            free(carry);
+            return 0;
+        }
+        size_t cut = len;
+        if (!eof) {
+            const char *nl = memrchr(c->text, '\n', len);
+            if (!nl) {
+                fprintf(stderr, "❌ строка CSV длиннее %u байт\n", CHUNK_BYTES);
+                free(carry);
+                return 0;
+            }
+            cut = (size_t)(nl - c->text) + 1;
+        }
+        carryLen = len - cut;
+        memcpy(carry, c->text + cut, carryLen);
+        c->textLen = cut;
+        c->text[cut] = '\0'; // strtod последнего поля последней строки без '\n' не выйдет за кусок
+        submit(c);
+        if (eof)
+            break;
+    }
+    free(carry);
+    return 1;
+}
+
+static int read_store(const char *dir) {
+    char err[256];
+    SegReader *r = seg_reader_open(dir, err, sizeof(err));
+    if (!r) {
+        fprintf(stderr, "❌ %s\n", err);
+        return 0;
+    }
+    SegScan *s = seg_scan_new(r, SEG_ALL_ASSETS, INT64_MIN, INT64_MAX);
+    if (!s) {
+        seg_reader_close(r);
+        return 0;
+    }
+    for (;;) {
+        Chunk *c = get_free();
+        SegRows rows = { c->ts, c->asset, c->col[0], c->col[1], c->col[2], c->alarm };
+        c->rows = seg_scan_next(s, &rows, CHUNK_ROWS);
+        if (c->rows == 0) { // кусок возвращается в пул невыданным
+            pthread_mutex_lock(&sched.lock);
+            sched.freeList[sched.nFree++] = c;
+            pthread_mutex_unlock(&sched.lock);
+            break;
+        }
+        submit(c);
+    }
+    seg_scan_free(s);
+    seg_reader_close(r);
+    return 1;
+}
+
+// === Запуск ===
+
+static Chunk *chunk_new(void) {
+    Chunk *c = calloc(1, sizeof(Chunk));
+    if (!c)
+        return NULL;
+    int ok;
+    if (csvMode) {
+        c->outCap = CHUNK_BYTES;
+        ok = (c->text = malloc(CHUNK_BYTES + 1)) != NULL; // +1 — завершающий ноль
+    } else {
+        c->outCap = (size_t)CHUNK_ROWS * 48;
+        ok = (c->ts = malloc(CHUNK_ROWS * sizeof(int64_t))) && (c->asset = malloc(CHUNK_ROWS * sizeof(uint32_t))) &&
+             (c->col[0] = malloc(CHUNK_ROWS * sizeof(double))) && (c->col[1] = malloc(CHUNK_ROWS * sizeof(double))) &&
+             (c->col[2] = malloc(CHUNK_ROWS * sizeof(double))) && (c->alarm = malloc(CHUNK_ROWS));
+    }
+    if (!writeOut)
+        c->outCap = 0;
+    else
+        ok = ok && (c->out = malloc(c->outCap));
+    return ok ? c : NULL; // при ошибке программа завершается, память не возвращаем
+}
+
+// Оценка памяти одного куска: вход и вывод
+static size_t chunk_bytes(void) {
+    size_t in = csvMode ? CHUNK_BYTES : (size_t)CHUNK_ROWS * 33;
+    size_t out = writeOut ? (csvMode ? CHUNK_BYTES : (size_t)CHUNK_ROWS * 48) : 0;
+    return in + out;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Использование: %s MODEL.rff INPUT [параметры]\n"
+            "  INPUT            CSV (\"-\" — stdin) или каталог хранилища сегментов\n"
+            "  --threads N      рабочих потоков (по умолчанию — число ядер)\n"
+            "  --mem MB         предел памяти под куски в обороте (по умолчанию 1024)\n"
+            "  --out FILE       прогнозы CSV: ts[,asset_id],alarm_probability,predicted_alarm\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char *modelPath = argv[1], *input = argv[2], *outPath = NULL;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    double memMb = 1024;
+    for (int a = 3; a < argc; a++) {
+        if (a + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        const char *opt = argv[a], *val = argv[++a];
+        if (!strcmp(opt, "--threads"))  threads = strtol(val, NULL, 10);
+        else if (!strcmp(opt, "--mem")) memMb = strtod(val, NULL);
+        else if (!strcmp(opt, "--out")) outPath = val;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (threads < 1 || threads > MAX_THREADS || memMb <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    RfForest *f = rf_load(modelPath);
+    if (!f)
+        return 1;
+    if (rf_num_features(f) != 3) {
+        fprintf(stderr, "❌ %s: нужен лес на 3 признака (vibration, temperature, pressure)\n", modelPath);
+        return 1;
+    }
+    forest = f;
+
+    // --- Вход: CSV или каталог хранилища ---
+    struct stat st;
+    FILE *in = NULL;
+    size_t len = strlen(input);
+    if (len > 8 && !strcmp(input + len - 8, ".parquet")) {
+        fprintf(stderr, "❌ Parquet не поддерживается: переведите в CSV (pandas read_parquet → to_csv)"
+                        " или в сегменты (seg_tool import)\n");
+        return 1;
+    }
+    csvMode = !(stat(input, &st) == 0 && S_ISDIR(st.st_mode));
+    writeOut = outPath != NULL;
+    if (csvMode) {
+        in = strcmp(input, "-") ? fopen(input, "r") : stdin;
+        char header[1024];
+        if (!in) {
+            perror(input);
+            return 1;
+        }
+        if (!fgets(header, sizeof(header), in) || !parse_header(header)) {
+            fprintf(stderr, "❌ %s: в заголовке нет vibration, temperature, pressure\n", input);
+            return 1;
+        }
+    } else {
+        withAsset = withLabels = 1;
+    }
+    if (!withLabels)
+        fprintf(stderr, "⚠️ нет колонки vibration_alarm — матрица ошибок считается против «нет тревоги»\n");
+    if (outPath) {
+        if (!(outFile = fopen(outPath, "w"))) {
+            perror(outPath);
+            return 1;
+        }
+        fprintf(outFile, "ts%s,alarm_probability,predicted_alarm\n", withAsset ? ",asset_id" : "");
+    }
+
+    // --- Пул кусков по лимиту памяти: не меньше двух на рабочего ---
+    sched.nWorkers = (size_t)threads;
+    sched.slots = (size_t)(memMb * 1048576.0 / (double)chunk_bytes());
+    if (sched.slots < 2 * sched.nWorkers) {
+        sched.slots = 2 * sched.nWorkers;
+        fprintf(stderr, "⚠️ --mem мал для %zu потоков: кусков в обороте %zu (~%.0f МБ)\n",
+                sched.nWorkers, sched.slots, sched.slots * (double)chunk_bytes() / 1048576.0);
+    }
+    pthread_mutex_init(&sched.lock, NULL);
+    pthread_cond_init(&sched.work, NULL);
+    pthread_cond_init(&sched.done, NULL);
+    pthread_cond_init(&sched.freed, NULL);
+    sched.freeList = malloc(sched.slots * sizeof(Chunk *));
+    sched.pending = calloc(sched.slots, sizeof(Chunk *));
+    if (!sched.freeList || !sched.pending) {
+        fprintf(stderr, "❌ нет памяти\n");
+        return 1;
+    }
+    for (size_t i = 0; i < sched.slots; i++) {
+        if (!(sched.freeList[i] = chunk_new())) {
+            fprintf(stderr, "❌ нет памяти под %zu кусков\n", sched.slots);
+            return 1;
+        }
+    }
+    sched.nFree = sched.slots;
+    for (size_t w = 0; w < sched.nWorkers; w++) {
+        pthread_mutex_init(&sched.q[w].lock, NULL);
+        if (!(sched.q[w].items = malloc(sched.slots * sizeof(Chunk *)))) {
+            fprintf(stderr, "❌ нет памяти\n");
+            return 1;
+        }
+    }
+
+    // --- Потоки ---
+    t0 = now_s();
+    pthread_t workers[MAX_THREADS], writer;
+    for (size_t w = 0; w < sched.nWorkers; w++)
+        if (pthread_create(&workers[w], NULL, worker_main, (void *)(uintptr_t)w) != 0) {
+            fprintf(stderr, "❌ не удалось запустить поток\n");
+            return 1;
+        }
+    if (pthread_create(&writer, NULL, writer_main, NULL) != 0) {
+        fprintf(stderr, "❌ не удалось запустить поток\n");
+        return 1;
+    }
+
+    int ok = csvMode ? read_csv(in) : read_store(input);
+
+    pthread_mutex_lock(&sched.lock);
+    sched.eof = 1;
+    pthread_cond_broadcast(&sched.work);
+    pthread_cond_broadcast(&sched.done);
+    pthread_mutex_unlock(&sched.lock);
+    for (size_t w = 0; w < sched.nWorkers; w++)
+        pthread_join(workers[w], NULL);
+    pthread_join(writer, NULL);
+    double dt = now_s() - t0;
+
+    if (in && in != stdin)
+        fclose(in);
+    if (outFile && fclose(outFile) != 0) {
+        perror(outPath);
+        ok = 0;
+    }
+
+    // --- Итог: матрица ошибок и метрики (как sklearn с zero_division=0) ---
+    const double tp = (double)total[0], fp = (double)total[1], fn = (double)total[2];
+    const double precision = tp + fp > 0 ? tp / (tp + fp) : 0.0;
+    const double recall = tp + fn > 0 ? tp / (tp + fn) : 0.0;
+    const double f1 = precision + recall > 0 ? 2 * precision * recall / (precision + recall) : 0.0;
+    printf("Строк: %llu (пропущено %llu) за %.2f с — %.1f млн строк/с, %zu потоков, краж %llu\n",
+           (unsigned long long)totalRows, (unsigned long long)totalBad, dt,
+           dt > 0 ? totalRows / dt / 1e6 : 0.0, sched.nWorkers,
+           (unsigned long long)atomic_load(&sched.steals));
+    printf("              прогноз 1   прогноз 0\n");
+    printf("  тревога 1  %10llu  %10llu\n", (unsigned long long)total[0], (unsigned long long)total[2]);
+    printf("  тревога 0  %10llu  %10llu\n", (unsigned long long)total[1], (unsigned long long)total[3]);
+    printf("📊 Precision: %.3f  Recall: %.3f  F1: %.3f\n", precision, recall, f1);
+
+    rf_free(f);
+    return ok ? 0 : 1;
+}
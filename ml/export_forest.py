@@ -0,0 +1,105 @@
+# export_forest.py — выгрузка RandomForest в плоский массив узлов для rf_infer.c
+# -----------------------------------------------------------------------------
+# Загружает ml/model_rf_alarm.pkl (100 деревьев RandomForestClassifier),
+# раскладывает все деревья в один массив узлов по 16 байт в порядке обхода
+# в ширину (дети узла — соседние элементы) и сохраняет в ml/model_rf_alarm.rff.
+#
+# Формат .rff описан в ml/rf_infer.c. Порог округляется вниз до float32:
+# для входов float32 условие x <= thr совпадает со sklearn бит в бит.
+#
+# Запуск:
+#   python ml/export_forest.py [model.pkl] [out.rff]
+#   python ml/export_forest.py --check data/sensor_data.csv   # сверка с model.predict_proba
+
+import struct
+import sys
+
+import joblib
+import numpy as np
+import pandas as pd
+
+FEATURES = ["vibration", "temperature", "pressure"]
+
+# --- Аргументы ---
+args = [a for a in sys.argv[1:] if not a.startswith("--")]
+check_csv = None
+if "--check" in sys.argv:
+    check_csv = sys.argv[sys.argv.index("--check") + 1]
+    args = [a for a in args if a != check_csv]
+model_path = args[0] if len(args) > 0 else "ml/model_rf_alarm.pkl"
+out_path = args[1] if len(args) > 1 else "ml/model_rf_alarm.rff"
+
+# --- Загрузка модели ---
+model = joblib.load(model_path)
+n_features = int(model.n_features_in_)
+positive = list(model.classes_).index(1)  # столбец класса «тревога»
+print(f"✅ Модель загружена: {len(model.estimators_)} деревьев, {n_features} признака")
+
+
+def threshold_down(thr):
+    """Наибольший float32, не превосходящий thr."""
+    t32 = np.float32(thr)
+    if float(t32) > thr:
+        t32 = np.nextafter(t32, np.float32(-np.inf))
+    return t32
+
+
+# --- Раскладка деревьев ---
+# Узел: (thr, left, feat, value). У листа thr = +inf и left указывает на сам лист.
+roots, depths, nodes = [], [], []
+for est in model.estimators_:
+    tree = est.tree_
+    base = len(nodes)
+    roots.append(base)
+    depths.append(int(tree.max_depth))
+
+    order = [0]          # узлы sklearn в порядке обхода в ширину
+    local = {0: 0}       # номер sklearn → номер в плоском массиве дерева
+    pos = 0
+    while pos < len(order):
+        src = order[pos]
+        left, right = tree.children_left[src], tree.children_right[src]
+        if left == -1:
+            counts = tree.value[src][0]
+            value = float(counts[positive] / counts.sum())
+            nodes.append((np.float32(np.inf), base + pos, 0, value))
+        else:
+            local[left], local[right] = len(order), len(order) + 1
+            order += [left, right]
+            nodes.append((threshold_down(tree.threshold[src]), base + local[left],
+                          int(tree.feature[src]), 0.0))
+        pos += 1
+
+# --- Запись файла ---
+with open(out_path, "wb") as fp:
+    fp.write(b"RFF1")
+    fp.write(struct.pack("<III", n_features, len(roots), len(nodes)))
+    fp.write(struct.pack(f"<{len(roots)}I", *roots))
+    fp.write(struct.pack(f"<{len(depths)}I", *depths))
+    for thr, left, feat, value in nodes:
+        fp.write(struct.pack("<fIIf", thr, left, feat, value))
+print(f"📦 Сохранено: {out_path} ({len(nodes)} узлов, {16 * len(nodes) / 1024:.0f} КБ, "
+      f"макс. глубина {max(depths)})")
+
+# --- Сверка плоского леса с sklearn ---
+if check_csv:
+    df = pd.read_csv(check_csv)
+    X = df[FEATURES].to_numpy(dtype=np.float32)
+    thr = np.array([n[0] for n in nodes], dtype=np.float32)
+    left = np.array([n[1] for n in nodes], dtype=np.int64)
+    feat = np.array([n[2] for n in nodes], dtype=np.int64)
+    value = np.array([n[3] for n in nodes], dtype=np.float32)
+
+    acc = np.zeros(len(X))
+    rows = np.arange(len(X))
+    for root, depth in zip(roots, depths):
+        idx = np.full(len(X), root)
+        for _ in range(depth):
+            idx = left[idx] + (X[rows, feat[idx]] > thr[idx])
+        acc += value[idx]
+    proba = acc / len(roots)
+
+    ref = model.predict_proba(X)[:, positive]
+    mismatch = int(((proba > 0.5) != (ref > 0.5)).sum())
+    print(f"🔍 Сверка на {len(X)} строках: макс. расхождение вероятности "
+          f"{np.abs(proba - ref).max():.2e}, расхождений прогноза: {mismatch}")
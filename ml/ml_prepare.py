@@ -3,10 +3,20 @@
 # Извлекает данные из PostgreSQL (sensor_data2),
 # формирует pandas.DataFrame с временным индексом
 # и сохраняет в CSV и Parquet для обучения.
+#
+# С --store DIR данные читаются из сегментов сборщика (collector --store,
+# ml/seg_store.py) вместо SELECT по всей таблице; --from / --to — диапазон:
+#   python ml/ml_prepare.py --store data/store --from 2025-08-01 --to 2025-09-01
+
+import sys
 
-import psycopg2
 import pandas as pd
 
+
+def arg(name):
+    return sys.argv[sys.argv.index(name) + 1] if name in sys.argv else None
+
+
 # --- Конфигурация подключения к PostgreSQL ---
 db_config = {
     "dbname": "postgres",
@@ -23,16 +33,24 @@ query = """
     ORDER BY ts
 """
 
-# --- Подключение и извлечение ---
-print("📡 Подключение к PostgreSQL...")
-conn = psycopg2.connect(**db_config)
-df = pd.read_sql(query, conn)
-conn.close()
-print(f"✅ Загружено {len(df)} строк")
+store_dir = arg("--store")
+if store_dir:
+    # --- Чтение сегментов: уже с временным индексом ---
+    from seg_store import load
+    df = load(store_dir, start=arg("--from"), end=arg("--to"))
+    print(f"✅ Загружено {len(df)} строк из {store_dir}")
+else:
+    # --- Подключение и извлечение ---
+    import psycopg2
+    print("📡 Подключение к PostgreSQL...")
+    conn = psycopg2.connect(**db_config)
+    df = pd.read_sql(query, conn)
+    conn.close()
+    print(f"✅ Загружено {len(df)} строк")
 
-# --- Преобразование: временной индекс ---
-df['ts'] = pd.to_datetime(df['ts'])
-df.set_index('ts', inplace=True)
+    # --- Преобразование: временной индекс ---
+    df['ts'] = pd.to_datetime(df['ts'])
+    df.set_index('ts', inplace=True)
 
 # --- Сохранение в CSV ---
 csv_path = "data/sensor_data.csv"
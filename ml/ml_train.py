@@ -3,6 +3,11 @@
 # Загружает данные из sensor_data.csv,
 # обучает модель предсказания vibration_alarm,
 # сохраняет модель в файл для последующего использования.
+#
+# С --store DIR [--from T] [--to T] данные берутся прямо из сегментов
+# сборщика (ml/seg_store.py), без промежуточного CSV.
+
+import sys
 
 import pandas as pd
 from sklearn.model_selection import train_test_split
@@ -11,8 +16,16 @@ from sklearn.metrics import classification_report
 import joblib
 
 # --- Загрузка данных ---
-df = pd.read_csv("data/sensor_data.csv", parse_dates=["ts"])
-df.set_index("ts", inplace=True)
+if "--store" in sys.argv:
+    from seg_store import load
+
+    def arg(name):
+        return sys.argv[sys.argv.index(name) + 1] if name in sys.argv else None
+
+    df = load(arg("--store"), start=arg("--from"), end=arg("--to"))
+else:
+    df = pd.read_csv("data/sensor_data.csv", parse_dates=["ts"])
+    df.set_index("ts", inplace=True)
 
 # --- Признаки и целевая переменная ---
 X = df[["vibration", "temperature", "pressure"]]
@@ -0,0 +1,249 @@
+/*
+ * online_model.c — реализация online_model.h
+ * ------------------------------------------
+ * Формат файла .olm (little-endian, как .rff):
+ *   char     magic[4] = "OLM1"
+ *   uint32   n_features
+ *   double   lr, l2, decay, fade
+ *   uint64   samples
+ *   double   bias, g_bias, rho_pow
+ *   double   mean[n], var[n], w[n], g[n]
+ *   uint64   tp, fp, fn, tn
+ *   double   ftp, ffp, ffn, ftn
+ */
+#include "online_model.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define RMS_RHO   0.99   // затухание квадратов градиента
+#define Z_CLIP    8.0    // нормированный признак ограничивается ±Z_CLIP (выбросы kurtosis)
+
+struct OnlineModel {
+    uint32_t  n;
+    OlmConfig cfg;
+    uint64_t  samples;
+    double    bias, gBias;       // свободный член и его средний квадрат градиента
+    double    rhoPow;            // RMS_RHO^samples — поправка смещения RMSProp
+    double    mean[OLM_MAX_FEATURES], var[OLM_MAX_FEATURES];
+    double    w[OLM_MAX_FEATURES], g[OLM_MAX_FEATURES];
+    uint64_t  tp, fp, fn, tn;    // за всё время
+    double    ftp, ffp, ffn, ftn; // затухающие
+};
+
+static void set_defaults(OlmConfig *c) {
+    if (!(c->lr > 0))    c->lr = 0.003;
+    if (!(c->l2 > 0))    c->l2 = 1e-5;
+    if (!(c->decay > 1)) c->decay = 1e5;
+    if (!(c->fade > 1))  c->fade = 1e4;
+}
+
+OnlineModel *olm_new(size_t nFeatures, const OlmConfig *cfg) {
+    if (nFeatures == 0 || nFeatures > OLM_MAX_FEATURES)
+        return NULL;
+    OnlineModel *m = calloc(1, sizeof(*m));
+    if (!m)
+        return NULL;
+    m->n = (uint32_t)nFeatures;
+    if (cfg)
+        m->cfg = *cfg;
+    set_defaults(&m->cfg);
+    m->rhoPow = 1.0;
+    for (size_t j = 0; j < nFeatures; j++)
+        m->var[j] = 1.0;
+    return m;
+}
+
+void olm_free(OnlineModel *m) { free(m); }
+
+size_t   olm_num_features(const OnlineModel *m) { return m->n; }
+uint64_t olm_samples(const OnlineModel *m)      { return m->samples; }
+
+// Нормированные признаки по текущим среднему и дисперсии; нечисловые — 0
+static void standardize(const OnlineModel *m, const double *x, double *z) {
+    for (uint32_t j = 0; j < m->n; j++) {
+        double v = isfinite(x[j]) ? (x[j] - m->mean[j]) / sqrt(m->var[j] + 1e-12) : 0.0;
+        z[j] = v > Z_CLIP ? Z_CLIP : v < -Z_CLIP ? -Z_CLIP : v;
+    }
+}
+
+static double sigmoid(double s) {
+    return s >= 0 ? 1.0 / (1.0 + exp(-s)) : exp(s) / (1.0 + exp(s));
+}
+
+static double predict_z(const OnlineModel *m, const double *z) {
+    double s = m->bias;
+    for (uint32_t j = 0; j < m->n; j++)
+        s += m->w[j] * z[j];
+    return sigmoid(s);
+}
+
+double olm_predict(const OnlineModel *m, const double *x) {
+    double z[OLM_MAX_FEATURES];
+    standardize(m, x, z);
+    return predict_z(m, z);
+}
+
+double olm_learn(OnlineModel *m, const double *x, int y) {
+    double z[OLM_MAX_FEATURES];
+    standardize(m, x, z);
+    const double p = predict_z(m, z);
+    y = y != 0;
+
+    // --- Метрики прогноза до обучения ---
+    const int pred = p > 0.5;
+    const int tp = pred && y, fp = pred && !y, fn = !pred && y, tn = !pred && !y;
+    m->tp += tp; m->fp += fp; m->fn += fn; m->tn += tn;
+    const double f = 1.0 - 1.0 / m->cfg.fade;
+    m->ftp = f * m->ftp + tp;
+    m->ffp = f * m->ffp + fp;
+    m->ffn = f * m->ffn + fn;
+    m->ftn = f * m->ftn + tn;
+
+    // --- Шаг RMSProp: масштаб шага по координатам сам подстраивается под признак ---
+    const double err = p - y;
+    m->rhoPow *= RMS_RHO;
+    const double corr = 1.0 / (1.0 - m->rhoPow);
+    const double lr = m->cfg.lr, l2 = m->cfg.l2;
+    for (uint32_t j = 0; j < m->n; j++) {
+        const double gj = err * z[j] + l2 * m->w[j];
+        m->g[j] = RMS_RHO * m->g[j] + (1.0 - RMS_RHO) * gj * gj;
+        m->w[j] -= lr * gj / (sqrt(m->g[j] * corr) + 1e-8);
+    }
+    m->gBias = RMS_RHO * m->gBias + (1.0 - RMS_RHO) * err * err;
+    m->bias -= lr * err / (sqrt(m->gBias * corr) + 1e-8);
+
+    // --- Нормировка: сначала обычное среднее, потом скользящее ---
+    m->samples++;
+    double a = 1.0 / (double)m->samples;
+    if (a < 1.0 / m->cfg.decay)
+        a = 1.0 / m->cfg.decay;
+    for (uint32_t j = 0; j < m->n; j++) {
+        if (!isfinite(x[j]))
+            continue;
+        const double d = x[j] - m->mean[j];
+        m->mean[j] += a * d;
+        m->var[j] = m->samples == 1 ? 1.0 : (1.0 - a) * (m->var[j] + a * d * d);
+    }
+    return p;
+}
+
+void olm_metrics(const OnlineModel *m, int faded, OlmMetrics *out) {
+    if (faded) {
+        out->tp = m->ftp; out->fp = m->ffp; out->fn = m->ffn; out->tn = m->ftn;
+    } else {
+        out->tp = (double)m->tp; out->fp = (double)m->fp;
+        out->fn = (double)m->fn; out->tn = (double)m->tn;
+    }
+    // Как sklearn с zero_division=0
+    out->precision = out->tp + out->fp > 0 ? out->tp / (out->tp + out->fp) : 0.0;
+    out->recall    = out->tp + out->fn > 0 ? out->tp / (out->tp + out->fn) : 0.0;
+    out->f1 = out->precision + out->recall > 0
+                  ? 2.0 * out->precision * out->recall / (out->precision + out->recall) : 0.0;
+}
+
+int olm_save(const OnlineModel *m, const char *path) {
+    char tmp[4096];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    FILE *fp = fopen(tmp, "wb");
+    if (!fp)
+        return -1;
+    const size_t n = m->n;
+    const double cfg[4] = { m->cfg.lr, m->cfg.l2, m->cfg.decay, m->cfg.fade };
+    const double scal[3] = { m->bias, m->gBias, m->rhoPow };
+    const uint64_t cnt[4] = { m->tp, m->fp, m->fn, m->tn };
+    const double fcnt[4] = { m->ftp, m->ffp, m->ffn, m->ftn };
+    int ok = fwrite("OLM1", 1, 4, fp) == 4 &&
+             fwrite(&m->n, sizeof(uint32_t), 1, fp) == 1 &&
+             fwrite(cfg, sizeof(double), 4, fp) == 4 &&
+             fwrite(&m->samples, sizeof(uint64_t), 1, fp) == 1 &&
+             fwrite(scal, sizeof(double), 3, fp) == 3 &&
+             fwrite(m->mean, sizeof(double), n, fp) == n &&
+             fwrite(m->var, sizeof(double), n, fp) == n &&
+             fwrite(m->w, sizeof(double), n, fp) == n &&
+             fwrite(m->g, sizeof(double), n, fp) == n &&
+             fwrite(cnt, sizeof(uint64_t), 4, fp) == 4 &&
+             fwrite(fcnt, sizeof(double), 4, fp) == 4;
+    ok = ok && fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    int saved = errno;
+    if (fclose(fp) != 0 && ok) {
+        ok = 0;
+        saved = errno;
+    }
+    if (!ok || rename(tmp, path) != 0) {
+        if (ok)
+            saved = errno;
+        unlink(tmp);
+        errno = saved;
+        return -1;
+    }
+    return 0;
+}
+
+OnlineModel *olm_load(const char *path, char *err, size_t errLen) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        snprintf(err, errLen, "%s: %s", path, strerror(errno));
+        return NULL;
+    }
+    char magic[4];
+    uint32_t n = 0;
+    OnlineModel *m = NULL;
+    if (fread(magic, 1, 4, fp) != 4 || memcmp(magic, "OLM1", 4) != 0 ||
+        fread(&n, sizeof(uint32_t), 1, fp) != 1 || n == 0 || n > OLM_MAX_FEATURES) {
+        snprintf(err, errLen, "%s: не контрольная точка OLM1", path);
+        fclose(fp);
+        errno = EINVAL;
+        return NULL;
+    }
+    double cfg[4], scal[3], fcnt[4];
+    uint64_t cnt[4];
+    m = calloc(1, sizeof(*m));
+    int ok = m && fread(cfg, sizeof(double), 4, fp) == 4 &&
+             fread(&m->samples, sizeof(uint64_t), 1, fp) == 1 &&
+             fread(scal, sizeof(double), 3, fp) == 3 &&
+             fread(m->mean, sizeof(double), n, fp) == n &&
+             fread(m->var, sizeof(double), n, fp) == n &&
+             fread(m->w, sizeof(double), n, fp) == n &&
+             fread(m->g, sizeof(double), n, fp) == n &&
+             fread(cnt, sizeof(uint64_t), 4, fp) == 4 &&
+             fread(fcnt, sizeof(double), 4, fp) == 4;
+    fclose(fp);
+    if (!ok) {
+        snprintf(err, errLen, "%s: файл обрезан", path);
+        free(m);
+        errno = EINVAL;
+        return NULL;
+    }
+    m->n = n;
+    m->cfg = (OlmConfig){ cfg[0], cfg[1], cfg[2], cfg[3] };
+    set_defaults(&m->cfg);
+    m->bias = scal[0]; m->gBias = scal[1]; m->rhoPow = scal[2];
+    m->tp = cnt[0]; m->fp = cnt[1]; m->fn = cnt[2]; m->tn = cnt[3];
+    m->ftp = fcnt[0]; m->ffp = fcnt[1]; m->ffn = fcnt[2]; m->ftn = fcnt[3];
+    return m;
+}
+
+size_t olm_row(double vib, double temp, double press, const FeatureSet fs[OLM_ROW_TAGS], double *x) {
+    x[0] = vib;
+    x[1] = temp;
+    x[2] = press;
+    if (!fs)
+        return OLM_ROW_TAGS;
+    size_t k = OLM_ROW_TAGS;
+    for (int c = 0; c < OLM_ROW_TAGS; c++) {
+        x[k++] = fs[c].rms;
+        x[k++] = fs[c].peak;
+        x[k++] = fs[c].crest;
+        x[k++] = fs[c].kurtosis;
+        x[k++] = fs[c].ewma;
+        x[k++] = fs[c].slope;
+    }
+    return k;
+}
@@ -0,0 +1,73 @@
+/*
+ * online_model.h — потоковая модель тревоги: онлайн-логистическая регрессия
+ * ------------------------------------------------------------------------
+ * Вместо переобучения RandomForest по всему CSV (ml_train.py) модель
+ * дообучается на каждой размеченной строке: сначала прогноз, потом шаг
+ * градиента (test-then-train). Память — O(признаков), шаг — O(признаков),
+ * без выборок и окон, поэтому модель следует за дрейфом сигналов.
+ *
+ *   нормировка  — скользящие среднее и дисперсия признаков (экспоненциальные,
+ *                 с постоянной cfg.decay строк; первые строки — обычное среднее);
+ *   шаг         — RMSProp по координатам с L2, без весов классов: перевзвешивание
+ *                 редких тревог сдвигает порог и роняет precision;
+ *   метрики     — precision / recall / F1 на прогнозах до обучения:
+ *                 накопленные за всё время и затухающие (последние ~cfg.fade строк).
+ *
+ * Состояние сохраняется в файл .olm (olm_save: запись во временный файл и rename,
+ * оборванная запись не портит прежнюю контрольную точку) и продолжается с него.
+ * Модуль не зависит от open62541: используется в сборщике и в online_train.c.
+ */
+#ifndef ONLINE_MODEL_H
+#define ONLINE_MODEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "window_features.h"
+
+#define OLM_MAX_FEATURES 64
+#define OLM_ROW_TAGS     3   // vibration, temperature, pressure
+#define OLM_ROW_FEATURES (OLM_ROW_TAGS * (1 + FEATURE_COUNT)) // теги + оконные признаки
+
+// Параметры обучения; нулевое поле — значение по умолчанию
+typedef struct {
+    double lr;      // шаг (0.003)
+    double l2;      // L2-регуляризация (1e-5)
+    double decay;   // постоянная скользящей нормировки, строк (1e5)
+    double fade;    // окно затухающих метрик, строк (1e4)
+} OlmConfig;
+
+// Метрики прогноза до обучения (порог 0.5)
+typedef struct {
+    double tp, fp, fn, tn;  // для затухающих — дробные
+    double precision, recall, f1;
+} OlmMetrics;
+
+typedef struct OnlineModel OnlineModel;
+
+// Новая модель на nFeatures (1..OLM_MAX_FEATURES) признаков
+OnlineModel *olm_new(size_t nFeatures, const OlmConfig *cfg);
+void olm_free(OnlineModel *m);
+
+size_t   olm_num_features(const OnlineModel *m);
+uint64_t olm_samples(const OnlineModel *m);
+
+// Вероятность тревоги для строки признаков x
+double olm_predict(const OnlineModel *m, const double *x);
+
+// Прогноз, учёт в метриках, затем шаг обучения по метке y; возвращает прогноз
+double olm_learn(OnlineModel *m, const double *x, int y);
+
+// Метрики: faded = 0 — за всё время, 1 — затухающие
+void olm_metrics(const OnlineModel *m, int faded, OlmMetrics *out);
+
+// Контрольная точка: 0 — успех, -1 — ошибка (errno)
+int olm_save(const OnlineModel *m, const char *path);
+
+// Загрузка контрольной точки; NULL и сообщение в err при ошибке (errno = ENOENT — файла нет)
+OnlineModel *olm_load(const char *path, char *err, size_t errLen);
+
+// Строка признаков сборщика: теги и, если fs != NULL, оконные признаки каждого тега
+// (window_features.c). Возвращает число признаков: OLM_ROW_TAGS или OLM_ROW_FEATURES.
+size_t olm_row(double vib, double temp, double press, const FeatureSet fs[OLM_ROW_TAGS], double *x);
+
+#endif
@@ -0,0 +1,192 @@
+/*
+ * online_train.c — обучение потоковой модели тревоги (online_model.c) по истории
+ * -----------------------------------------------------------------------------
+ * Прогоняет строки хранилища сегментов (seg_store.c) через olm_learn():
+ * прогноз, метрики, шаг обучения — так же, как сборщик с --online делает это
+ * на живом потоке. Используется для начальной модели перед запуском сборщика
+ * и для оценки: precision / recall / F1 считаются на прогнозах до обучения,
+ * отдельная тестовая выборка не нужна.
+ *
+ * Если файл модели уже есть, обучение продолжается с него (контрольная точка
+ * сборщика подходит). --window W — оконные признаки тегов (window_features.c),
+ * как у сборщика с --features W; без него модель видит только сами теги.
+ * Строки идут в порядке хранилища: раздел за разделом, внутри — по агрегатам.
+ *
+ * Сборка:
+ *   gcc -O3 -march=native online_train.c online_model.c window_features.c seg_store.c -lm -o online_train
+ *
+ * Запуск:
+ *   ./online_train ../data/store ../data/alarm.olm --window 60
+ *   ./online_train ../data/store ../data/alarm.olm --from 1756425600000000 --every 1000000
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "online_model.h"
+#include "seg_store.h"
+#include "window_features.h"
+
+#define SCAN_ROWS 65536 // строк за вызов seg_scan_next
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void print_metrics(const OnlineModel *m, const char *what) {
+    OlmMetrics all, recent;
+    olm_metrics(m, 0, &all);
+    olm_metrics(m, 1, &recent);
+    printf("%s: строк %llu  P/R/F1 %.3f / %.3f / %.3f  (последние: %.3f / %.3f / %.3f)\n", what,
+           (unsigned long long)olm_samples(m), all.precision, all.recall, all.f1,
+           recent.precision, recent.recall, recent.f1);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Использование: %s STORE MODEL [--from US] [--to US] [--window W] [--every N]\n"
+            "  --from/--to  диапазон, микросекунды Unix\n"
+            "  --window W   оконные признаки тегов за W строк (как collector --features W)\n"
+            "  --every N    контрольная точка и метрики каждые N строк (по умолчанию 1000000)\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char *storeDir = argv[1], *modelPath = argv[2];
+    int64_t from = INT64_MIN, to = INT64_MAX;
+    unsigned long window = 0;
+    unsigned long long every = 1000000;
+    for (int a = 3; a < argc; a++) {
+        if (a + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        const char *opt = argv[a], *val = argv[++a];
+        if (!strcmp(opt, "--from"))        from = strtoll(val, NULL, 10);
+        else if (!strcmp(opt, "--to"))     to = strtoll(val, NULL, 10);
+        else if (!strcmp(opt, "--window")) window = strtoul(val, NULL, 10);
+        else if (!strcmp(opt, "--every"))  every = strtoull(val, NULL, 10);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (window == 1 || every == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    char err[256];
+    SegReader *r = seg_reader_open(storeDir, err, sizeof(err));
+    if (!r) {
+        fprintf(stderr, "❌ %s\n", err);
+        return 1;
+    }
+
+    // --- Модель: продолжение контрольной точки или новая ---
+    const size_t nFeatures = window ? OLM_ROW_FEATURES : OLM_ROW_TAGS;
+    OnlineModel *m = olm_load(modelPath, err, sizeof(err));
+    if (m && olm_num_features(m) != nFeatures) {
+        fprintf(stderr, "❌ %s: модель на %zu признаков, а с --window %lu их %zu\n", modelPath,
+                olm_num_features(m), window, nFeatures);
+        return 1;
+    }
+    if (!m && errno != ENOENT) {
+        fprintf(stderr, "❌ %s\n", err);
+        return 1;
+    }
+    if (!m) {
+        m = olm_new(nFeatures, NULL);
+    } else {
+        print_metrics(m, "Продолжение");
+    }
+
+    int64_t *ts = malloc(SCAN_ROWS * sizeof(int64_t));
+    uint32_t *id = malloc(SCAN_ROWS * sizeof(uint32_t));
+    double *vib = malloc(SCAN_ROWS * sizeof(double));
+    double *temp = malloc(SCAN_ROWS * sizeof(double));
+    double *press = malloc(SCAN_ROWS * sizeof(double));
+    uint8_t *alarm = malloc(SCAN_ROWS);
+    if (!m || !ts || !id || !vib || !temp || !press || !alarm) {
+        fprintf(stderr, "❌ нет памяти\n");
+        return 1;
+    }
+
+    // --- Число агрегатов для каналов оконных признаков: проход только по asset ---
+    FeatureEngine *fe = NULL;
+    if (window) {
+        uint32_t maxId = 0;
+        SegScan *s = seg_scan_new(r, SEG_ALL_ASSETS, from, to);
+        SegRows ids = { NULL, id, NULL, NULL, NULL, NULL };
+        size_t n;
+        while (s && (n = seg_scan_next(s, &ids, SCAN_ROWS)) > 0)
+            for (size_t i = 0; i < n; i++)
+                maxId = id[i] > maxId ? id[i] : maxId;
+        seg_scan_free(s);
+        if (!(fe = features_new(((size_t)maxId + 1) * OLM_ROW_TAGS, window, 0.0))) {
+            fprintf(stderr, "❌ нет памяти под признаки %u агрегатов\n", maxId + 1);
+            return 1;
+        }
+    }
+
+    // --- Прогноз → метрики → обучение по каждой строке ---
+    SegScan *s = seg_scan_new(r, SEG_ALL_ASSETS, from, to);
+    if (!s) {
+        fprintf(stderr, "❌ нет памяти\n");
+        return 1;
+    }
+    SegRows out = { ts, id, vib, temp, press, alarm };
+    unsigned long long rows = 0, nextCheckpoint = every;
+    double t0 = now_s();
+    size_t n;
+    int rc = 0;
+    while ((n = seg_scan_next(s, &out, SCAN_ROWS)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            double x[OLM_ROW_FEATURES];
+            FeatureSet fs[OLM_ROW_TAGS];
+            if (fe) {
+                const double t = (double)ts[i] / 1e6, v[OLM_ROW_TAGS] = { vib[i], temp[i], press[i] };
+                for (int c = 0; c < OLM_ROW_TAGS; c++) {
+                    features_push(fe, (size_t)id[i] * OLM_ROW_TAGS + c, t, v[c]);
+                    features_get(fe, (size_t)id[i] * OLM_ROW_TAGS + c, &fs[c]);
+                }
+            }
+            olm_row(vib[i], temp[i], press[i], fe ? fs : NULL, x);
+            olm_learn(m, x, alarm[i]);
+        }
+        rows += n;
+        if (rows >= nextCheckpoint) {
+            nextCheckpoint = rows + every;
+            print_metrics(m, "Обучение");
+            if (olm_save(m, modelPath) != 0) {
+                perror(modelPath);
+                rc = 1;
+                break;
+            }
+        }
+    }
+    double dt = now_s() - t0;
+    seg_scan_free(s);
+
+    if (rc == 0 && olm_save(m, modelPath) != 0) {
+        perror(modelPath);
+        rc = 1;
+    }
+    print_metrics(m, "Итог");
+    printf("%llu строк за %.2f с — %.1f млн строк/с\n", rows, dt, dt > 0 ? rows / dt / 1e6 : 0.0);
+    if (rc == 0)
+        printf("✅ Модель сохранена: %s\n", modelPath);
+
+    olm_free(m);
+    features_free(fe);
+    seg_reader_close(r);
+    free(ts); free(id); free(vib); free(temp); free(press); free(alarm);
+    return rc;
+}
@@ -2,11 +2,17 @@
 # ---------------------------------------------------------------------
 # Загружает модель, периодически читает данные из sensor_data2,
 # делает прогноз vibration_alarm и записывает результат в sensor_predictions.
+#
+# Если сборщик пишет трассу (collector --trace: колонки seq и gen_ns), в прогноз
+# попадают номер тика и его возраст age_ms — от начала генерации на сервере до
+# записи прогноза (CLOCK_MONOTONIC, как у сервера — процессы на одном хосте).
+# Раз в 30 прогнозов печатаются p50/p99 возраста и число тиков без прогноза.
 
 import psycopg2
 import pandas as pd
 import joblib
-from time import sleep
+from collections import deque
+from time import sleep, monotonic_ns
 
 # --- Конфигурация PostgreSQL ---
 db_config = {
@@ -37,6 +43,24 @@ cur.execute("""
     )
 """)
 
+# --- Трасса тиков (collector --trace) ---
+cur.execute("""
+    SELECT count(*) FROM information_schema.columns
+    WHERE table_schema = 'public' AND table_name = 'sensor_data2' AND column_name IN ('seq', 'gen_ns')
+""")
+traced = cur.fetchone()[0] == 2
+if traced:
+    cur.execute("""
+        ALTER TABLE public.sensor_predictions
+            ADD COLUMN IF NOT EXISTS seq BIGINT,
+            ADD COLUMN IF NOT EXISTS gen_ns BIGINT,
+            ADD COLUMN IF NOT EXISTS age_ms DOUBLE PRECISION
+    """)
+    print("📡 Трасса тиков: seq, gen_ns, age_ms")
+ages = deque(maxlen=1000)  # возраст последних прогнозов, мс
+last_seq = 0
+scored = skipped = repeated = 0
+
 # --- Основной цикл ---
 print("🔁 Запуск потокового прогнозирования...")
 last_ts = None
@@ -45,11 +69,11 @@ try:
     while True:
         # --- Чтение последней строки ---
         df = pd.read_sql("""
-            SELECT ts, vibration, temperature, pressure
+            SELECT ts, vibration, temperature, pressure{}
             FROM public.sensor_data2
             ORDER BY ts DESC
             LIMIT 1
-        """, conn)
+        """.format(", seq, gen_ns" if traced else ""), conn)
 
         if df.empty:
             print("⚠️ Нет данных в sensor_data2")
@@ -71,10 +95,32 @@ try:
         print(f"[{ts}] Прогноз тревоги: {bool(pred)}")
 
         # --- Запись результата ---
-        cur.execute("""
-            INSERT INTO public.sensor_predictions (ts, vibration, temperature, pressure, predicted_alarm)
-            VALUES (%s, %s, %s, %s, %s)
-        """, (ts, row["vibration"], row["temperature"], row["pressure"], bool(pred)))
+        if traced and not pd.isna(row["seq"]) and row["seq"] > 0:
+            seq, gen_ns = int(row["seq"]), int(row["gen_ns"])
+            age_ms = (monotonic_ns() - gen_ns) / 1e6
+            cur.execute("""
+                INSERT INTO public.sensor_predictions
+                    (ts, vibration, temperature, pressure, predicted_alarm, seq, gen_ns, age_ms)
+                VALUES (%s, %s, %s, %s, %s, %s, %s, %s)
+            """, (ts, row["vibration"], row["temperature"], row["pressure"], bool(pred), seq, gen_ns, age_ms))
+
+            # Прогноз берёт последнюю строку раз в 2 с — тики между ними пропускаются
+            if last_seq and seq <= last_seq:
+                repeated += 1  # или перезапуск сервера
+            elif last_seq:
+                skipped += seq - last_seq - 1
+            last_seq = seq
+            ages.append(age_ms)
+            scored += 1
+            if scored % 30 == 0:
+                q = sorted(ages)
+                print(f"Возраст тика p50/p99: {q[len(q) // 2]:.1f} / {q[int(len(q) * 0.99)]:.1f} мс"
+                      f"  тиков без прогноза: {skipped}  повторно: {repeated}")
+        else:
+            cur.execute("""
+                INSERT INTO public.sensor_predictions (ts, vibration, temperature, pressure, predicted_alarm)
+                VALUES (%s, %s, %s, %s, %s)
+            """, (ts, row["vibration"], row["temperature"], row["pressure"], bool(pred)))
 
         sleep(2)
 
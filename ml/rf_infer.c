@@ -0,0 +1,148 @@
+/*
+ * rf_infer.c — реализация rf_infer.h
+ * ----------------------------------
+ * Формат файла .rff (little-endian), пишет ml/export_forest.py:
+ *   char     magic[4] = "RFF1"
+ *   uint32   n_features, n_trees, n_nodes
+ *   uint32   root[n_trees]    — индекс корня дерева в общем массиве узлов
+ *   uint32   depth[n_trees]   — глубина дерева (шагов обхода)
+ *   RfNode   nodes[n_nodes]   — {float thr; uint32 left; uint32 feat; float value}
+ */
+#include "rf_infer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    float    thr;   // порог; у листа +inf, чтобы обход оставался на месте
+    uint32_t left;  // левый ребёнок (правый = left + 1); у листа — сам узел
+    uint32_t feat;  // номер признака
+    float    value; // у листа — доля класса «тревога»
+} RfNode;
+
+struct RfForest {
+    uint32_t  nFeatures;
+    uint32_t  nTrees;
+    uint32_t  nNodes;
+    uint32_t *root;
+    uint32_t *depth;
+    RfNode   *nodes;
+};
+
+static int read_u32(FILE *fp, uint32_t *out, size_t n) {
+    return fread(out, sizeof(uint32_t), n, fp) == n;
+}
+
+RfForest *rf_load(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        perror(path);
+        return NULL;
+    }
+    RfForest *f = calloc(1, sizeof(RfForest));
+    char magic[4];
+    uint32_t hdr[3];
+    if (!f || fread(magic, 1, 4, fp) != 4 || memcmp(magic, "RFF1", 4) != 0 || !read_u32(fp, hdr, 3)) {
+        fprintf(stderr, "%s: не файл леса RFF1\n", path);
+        goto fail;
+    }
+    f->nFeatures = hdr[0];
+    f->nTrees    = hdr[1];
+    f->nNodes    = hdr[2];
+    if (f->nFeatures == 0 || f->nTrees == 0 || f->nNodes == 0) {
+        fprintf(stderr, "%s: пустой лес\n", path);
+        goto fail;
+    }
+    f->root  = malloc(f->nTrees * sizeof(uint32_t));
+    f->depth = malloc(f->nTrees * sizeof(uint32_t));
+    f->nodes = malloc(f->nNodes * sizeof(RfNode));
+    if (!f->root || !f->depth || !f->nodes ||
+        !read_u32(fp, f->root, f->nTrees) || !read_u32(fp, f->depth, f->nTrees) ||
+        fread(f->nodes, sizeof(RfNode), f->nNodes, fp) != f->nNodes) {
+        fprintf(stderr, "%s: файл обрезан\n", path);
+        goto fail;
+    }
+
+    // Проверка ссылок: обход не должен выйти за массив
+    for (uint32_t t = 0; t < f->nTrees; t++)
+        if (f->root[t] >= f->nNodes) {
+            fprintf(stderr, "%s: неверный корень дерева %u\n", path, t);
+            goto fail;
+        }
+    // Порог — по битам: с -ffast-math isnan/isinf могут свернуться в 0
+    for (uint32_t i = 0; i < f->nNodes; i++) {
+        uint32_t l = f->nodes[i].left, bits;
+        memcpy(&bits, &f->nodes[i].thr, sizeof(bits));
+        int badThr = (bits & 0x7fffffffu) > 0x7f800000u;        // NaN
+        if (l == i)
+            badThr |= bits != 0x7f800000u;                      // лист — только с порогом +inf
+        if (f->nodes[i].feat >= f->nFeatures || badThr || (l != i && (uint64_t)l + 1 >= f->nNodes)) {
+            fprintf(stderr, "%s: неверный узел %u\n", path, i);
+            goto fail;
+        }
+    }
+    fclose(fp);
+    return f;
+
+fail:
+    fclose(fp);
+    rf_free(f);
+    return NULL;
+}
+
+void rf_free(RfForest *f) {
+    if (!f)
+        return;
+    free(f->root);
+    free(f->depth);
+    free(f->nodes);
+    free(f);
+}
+
+size_t rf_num_features(const RfForest *f) { return f->nFeatures; }
+size_t rf_num_trees(const RfForest *f)    { return f->nTrees; }
+
+// Блок из m <= RF_BLOCK строк: все деревья, для каждого — depth шагов по всем строкам блока.
+// Внутренний цикл по строкам не содержит ветвлений и зависимостей между итерациями.
+static void predict_block(const RfForest *f, const float *x, size_t m, float *proba) {
+    const RfNode *nodes = f->nodes;
+    const size_t nf = f->nFeatures;
+    double acc[RF_BLOCK] = {0};
+    uint32_t idx[RF_BLOCK];
+
+    for (uint32_t t = 0; t < f->nTrees; t++) {
+        for (size_t r = 0; r < m; r++)
+            idx[r] = f->root[t];
+        for (uint32_t d = 0; d < f->depth[t]; d++)
+            for (size_t r = 0; r < m; r++) {
+                const RfNode *nd = &nodes[idx[r]];
+                idx[r] = nd->left + (x[r * nf + nd->feat] > nd->thr);
+            }
+        for (size_t r = 0; r < m; r++)
+            acc[r] += nodes[idx[r]].value;
+    }
+    const double inv = 1.0 / f->nTrees;
+    for (size_t r = 0; r < m; r++)
+        proba[r] = (float)(acc[r] * inv);
+}
+
+void rf_predict_proba(const RfForest *f, const float *X, size_t n, float *proba) {
+    for (size_t base = 0; base < n; base += RF_BLOCK) {
+        size_t m = n - base < RF_BLOCK ? n - base : RF_BLOCK;
+        predict_block(f, X + base * f->nFeatures, m, proba + base);
+    }
+}
+
+size_t rf_predict(const RfForest *f, const float *X, size_t n, uint8_t *alarm) {
+    float proba[RF_BLOCK];
+    size_t positives = 0;
+    for (size_t base = 0; base < n; base += RF_BLOCK) {
+        size_t m = n - base < RF_BLOCK ? n - base : RF_BLOCK;
+        predict_block(f, X + base * f->nFeatures, m, proba);
+        for (size_t r = 0; r < m; r++) {
+            alarm[base + r] = proba[r] > 0.5f;
+            positives += alarm[base + r];
+        }
+    }
+    return positives;
+}
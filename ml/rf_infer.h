@@ -0,0 +1,45 @@
+/*
+ * rf_infer.h — нативный инференс RandomForest (model_rf_alarm.pkl) на C
+ * --------------------------------------------------------------------
+ * Лес выгружается скриптом ml/export_forest.py в компактный файл .rff:
+ * все узлы всех деревьев лежат в одном массиве по 16 байт, дети узла —
+ * соседние элементы (left и left + 1), листья ссылаются сами на себя.
+ * Поэтому обход дерева — фиксированное число шагов без ветвлений:
+ *     idx = node[idx].left + (x[node[idx].feat] > node[idx].thr)
+ * а строки пачки обходятся блоками по RF_BLOCK, чтобы независимые цепочки
+ * загрузок шли параллельно (и при -O3 -mavx2 разворачивались в gather).
+ *
+ * Порог хранится как float32, округлённый вниз, — для входов float32
+ * сравнение совпадает со sklearn бит в бит. Вероятность тревоги — среднее
+ * по деревьям, прогноз = вероятность > 0.5 (как model.predict).
+ *
+ * Модуль не зависит от open62541 и встраивается в update_cb сервера или в сборщик.
+ *
+ * Сборка вместе с программой:
+ *   gcc -O3 -march=native prog.c ../ml/rf_infer.c -lm
+ */
+#ifndef RF_INFER_H
+#define RF_INFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define RF_BLOCK 16 // строк, обходимых одновременно
+
+typedef struct RfForest RfForest;
+
+// Загрузка леса из файла .rff; NULL при ошибке (сообщение в stderr)
+RfForest *rf_load(const char *path);
+void rf_free(RfForest *f);
+
+size_t rf_num_features(const RfForest *f);
+size_t rf_num_trees(const RfForest *f);
+
+// Вероятность тревоги для n строк. X — строки подряд по rf_num_features() признаков
+// (vibration, temperature, pressure), proba — n значений [0..1].
+void rf_predict_proba(const RfForest *f, const float *X, size_t n, float *proba);
+
+// Прогноз тревоги (0/1) для n строк; возвращает число строк с тревогой
+size_t rf_predict(const RfForest *f, const float *X, size_t n, uint8_t *alarm);
+
+#endif
@@ -0,0 +1,817 @@
+/*
+ * seg_store.c — реализация seg_store.h
+ * -----------------------------------
+ * Битовые потоки пишутся старшим битом вперёд. Кодирование — как в Gorilla
+ * (Pelkonen et al., VLDB 2015), с корзинами дельты от дельты под микросекунды:
+ *   dod = 0                    '0'
+ *   dod в [-2^6, 2^6)          '10'   + 7 бит
+ *   dod в [-2^13, 2^13)        '110'  + 14 бит   (±8 мс)
+ *   dod в [-2^19, 2^19)        '1110' + 20 бит   (±0.5 с)
+ *   иначе                      '1111' + 64 бита
+ * Значения: XOR = 0 — '0'; значащие биты внутри прошлого окна — '10' + биты;
+ * иначе '11' + 5 бит ведущих нулей + 6 бит длины - 1 + биты.
+ */
+#define _GNU_SOURCE // strdup()
+#include "seg_store.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SEG_MAGIC       "PMSEG001"
+#define SEG_END_MAGIC   "PMSEGEND"
+#define SEG_BLOCK_MAGIC 0x314B4C42u // "BLK1"
+#define SEG_COLUMNS     5           // ts, vib, temp, press, alarm
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t blockRows;
+    int64_t  partitionStart;        // мкс Unix
+    int64_t  partitionUs;
+} SegFileHeader;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t asset;
+    uint32_t count;
+    uint32_t bytes[SEG_COLUMNS];    // длины колонок
+    int64_t  tMin, tMax;
+} SegBlockHeader;
+
+typedef struct {
+    uint32_t asset;
+    uint32_t count;
+    int64_t  tMin, tMax;
+    uint64_t offset;                // заголовок блока от начала файла
+} SegIndexEntry;
+
+typedef struct {
+    uint64_t nBlocks;
+    uint64_t indexOffset;
+    char     magic[8];
+} SegTrailer;
+
+_Static_assert(sizeof(SegFileHeader) == 32, "формат заголовка");
+_Static_assert(sizeof(SegBlockHeader) == 48, "формат блока");
+_Static_assert(sizeof(SegIndexEntry) == 32, "формат индекса");
+_Static_assert(sizeof(SegTrailer) == 24, "формат хвоста");
+
+static size_t pad8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+static int cmp_entry(const void *a, const void *b) {
+    const SegIndexEntry *x = a, *y = b;
+    if (x->asset != y->asset)
+        return x->asset < y->asset ? -1 : 1;
+    return (x->tMin > y->tMin) - (x->tMin < y->tMin);
+}
+
+// Индекс сегмента: из хвоста закрытого файла или обходом блоков незакрытого.
+// *entries указывает в map (закрытый) или в malloc (*owned = 1); *dataEnd — конец блоков
+static int load_index(const uint8_t *map, size_t size, const SegIndexEntry **entries, size_t *n,
+                      int *owned, size_t *dataEnd) {
+    SegFileHeader fh;
+    if (size < sizeof(fh))
+        return -1;
+    memcpy(&fh, map, sizeof(fh));
+    if (memcmp(fh.magic, SEG_MAGIC, 8) != 0 || fh.blockRows == 0 || fh.blockRows > SEG_BLOCK_ROWS)
+        return -1;
+
+    SegTrailer tr;
+    if (size >= sizeof(fh) + sizeof(tr)) {
+        memcpy(&tr, map + size - sizeof(tr), sizeof(tr));
+        if (memcmp(tr.magic, SEG_END_MAGIC, 8) == 0 && tr.indexOffset % 8 == 0 &&
+            tr.indexOffset >= sizeof(fh) &&
+            tr.indexOffset + tr.nBlocks * sizeof(SegIndexEntry) + sizeof(tr) == size) {
+            *entries = (const SegIndexEntry *)(map + tr.indexOffset);
+            *n = (size_t)tr.nBlocks;
+            *owned = 0;
+            *dataEnd = (size_t)tr.indexOffset;
+            return 0;
+        }
+    }
+
+    // Незакрытый сегмент: идём по заголовкам, пока блоки целые
+    SegIndexEntry *out = NULL;
+    size_t cnt = 0, cap = 0, off = sizeof(fh);
+    for (;;) {
+        SegBlockHeader bh;
+        if (size - off < sizeof(bh))
+            break;
+        memcpy(&bh, map + off, sizeof(bh));
+        if (bh.magic != SEG_BLOCK_MAGIC || bh.count == 0 || bh.count > fh.blockRows)
+            break;
+        size_t len = sizeof(bh);
+        for (int c = 0; c < SEG_COLUMNS; c++)
+            len += bh.bytes[c];
+        len = pad8(len);
+        if (len > size - off)
+            break;
+        if (cnt == cap) {
+            cap = cap ? cap * 2 : 256;
+            SegIndexEntry *grown = realloc(out, cap * sizeof(SegIndexEntry));
+            if (!grown) {
+                free(out);
+                return -1;
+            }
+            out = grown;
+        }
+        out[cnt++] = (SegIndexEntry){ bh.asset, bh.count, bh.tMin, bh.tMax, off };
+        off += len;
+    }
+    if (cnt > 1)
+        qsort(out, cnt, sizeof(SegIndexEntry), cmp_entry);
+    *entries = out;
+    *n = cnt;
+    *owned = 1;
+    *dataEnd = off;
+    return 0;
+}
+
+// === Запись ===
+
+typedef struct {
+    uint8_t *buf;
+    size_t   len, cap;
+    uint64_t acc;                   // несброшенные биты (младшие nbits)
+    unsigned nbits;
+} BitWriter;
+
+// До 32 бит за вызов: после него в acc меньше 8 бит, переполнения нет
+static int bw_put(BitWriter *w, uint64_t v, unsigned n) {
+    w->acc = (w->acc << n) | (v & ((1ull << n) - 1));
+    w->nbits += n;
+    if (w->len + 8 > w->cap) {
+        size_t cap = w->cap ? w->cap * 2 : 256;
+        uint8_t *grown = realloc(w->buf, cap);
+        if (!grown)
+            return -1;
+        w->buf = grown;
+        w->cap = cap;
+    }
+    while (w->nbits >= 8) {
+        w->nbits -= 8;
+        w->buf[w->len++] = (uint8_t)(w->acc >> w->nbits);
+    }
+    return 0;
+}
+
+static int bw_put64(BitWriter *w, uint64_t v) {
+    return bw_put(w, v >> 32, 32) | bw_put(w, v, 32);
+}
+
+// Добить последний байт нулями; возвращает длину
+static size_t bw_finish(BitWriter *w) {
+    if (w->nbits > 0)
+        bw_put(w, 0, 8 - w->nbits);
+    return w->len;
+}
+
+static void bw_reset(BitWriter *w) {
+    w->len = 0;
+    w->acc = 0;
+    w->nbits = 0;
+}
+
+// Открытый блок агрегата
+typedef struct {
+    uint32_t  count;
+    int64_t   tMin, tMax, lastTs, lastDelta;
+    BitWriter ts, col[3];
+    uint64_t  prev[3];
+    int       lead[3], trail[3];    // окно значащих бит прошлого XOR; lead < 0 — окна нет
+    uint8_t   alarm[SEG_BLOCK_ROWS / 8];
+} BlockEnc;
+
+struct SegWriter {
+    char     *dir;
+    int64_t   partitionUs;
+    int       fd;
+    int64_t   partition;            // начало открытого раздела, мкс
+    uint64_t  offset;               // конец данных файла
+    SegIndexEntry *index;
+    size_t    nIndex, capIndex;
+    BlockEnc **enc;                 // [capEnc], по номеру агрегата, создаются при первой строке
+    size_t    capEnc;
+    uint8_t  *out;                  // собранный блок перед записью
+    size_t    capOut;
+};
+
+static int enc_ts(BitWriter *w, int64_t dod) {
+    if (dod == 0)
+        return bw_put(w, 0, 1);
+    if (dod >= -(1 << 6) && dod < (1 << 6))
+        return bw_put(w, 0x2, 2) | bw_put(w, (uint64_t)dod, 7);
+    if (dod >= -(1 << 13) && dod < (1 << 13))
+        return bw_put(w, 0x6, 3) | bw_put(w, (uint64_t)dod, 14);
+    if (dod >= -(1 << 19) && dod < (1 << 19))
+        return bw_put(w, 0xE, 4) | bw_put(w, (uint64_t)dod, 20);
+    return bw_put(w, 0xF, 4) | bw_put64(w, (uint64_t)dod);
+}
+
+static int enc_value(BlockEnc *e, int c, double x) {
+    uint64_t v;
+    memcpy(&v, &x, sizeof(v));
+    BitWriter *w = &e->col[c];
+    if (e->count == 0) {
+        e->prev[c] = v;
+        e->lead[c] = -1;
+        return bw_put64(w, v);
+    }
+    uint64_t xr = v ^ e->prev[c];
+    e->prev[c] = v;
+    if (xr == 0)
+        return bw_put(w, 0, 1);
+    int lead = __builtin_clzll(xr), trail = __builtin_ctzll(xr);
+    if (lead > 31)
+        lead = 31;
+    if (e->lead[c] >= 0 && lead >= e->lead[c] && trail >= e->trail[c]) {
+        unsigned sig = 64u - (unsigned)e->lead[c] - (unsigned)e->trail[c];
+        xr >>= e->trail[c];
+        int rc = bw_put(w, 0x2, 2);
+        return sig > 32 ? rc | bw_put(w, xr >> 32, sig - 32) | bw_put(w, xr, 32) : rc | bw_put(w, xr, sig);
+    }
+    unsigned sig = 64u - (unsigned)lead - (unsigned)trail;
+    e->lead[c] = lead;
+    e->trail[c] = trail;
+    xr >>= trail;
+    int rc = bw_put(w, 0x3, 2) | bw_put(w, (uint64_t)lead, 5) | bw_put(w, sig - 1, 6);
+    return sig > 32 ? rc | bw_put(w, xr >> 32, sig - 32) | bw_put(w, xr, 32) : rc | bw_put(w, xr, sig);
+}
+
+static int write_all(int fd, const void *buf, size_t len) {
+    const uint8_t *p = buf;
+    while (len > 0) {
+        ssize_t k = write(fd, p, len);
+        if (k < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        p += k;
+        len -= (size_t)k;
+    }
+    return 0;
+}
+
+// Блок агрегата asset — в файл одним write(), запись в индекс
+static int write_block(SegWriter *w, uint32_t asset, BlockEnc *e) {
+    if (e->count == 0)
+        return 0;
+    SegBlockHeader bh = { SEG_BLOCK_MAGIC, asset, e->count, { 0 }, e->tMin, e->tMax };
+    BitWriter *cols[4] = { &e->ts, &e->col[0], &e->col[1], &e->col[2] };
+    for (int c = 0; c < 4; c++)
+        bh.bytes[c] = (uint32_t)bw_finish(cols[c]);
+    bh.bytes[4] = (e->count + 7) / 8;
+    size_t len = sizeof(bh);
+    for (int c = 0; c < SEG_COLUMNS; c++)
+        len += bh.bytes[c];
+    size_t total = pad8(len);
+    if (total > w->capOut) {
+        uint8_t *grown = realloc(w->out, total);
+        if (!grown)
+            return -1;
+        w->out = grown;
+        w->capOut = total;
+    }
+    uint8_t *p = w->out;
+    memcpy(p, &bh, sizeof(bh));
+    p += sizeof(bh);
+    for (int c = 0; c < 4; c++) {
+        memcpy(p, cols[c]->buf, bh.bytes[c]);
+        p += bh.bytes[c];
+    }
+    memcpy(p, e->alarm, bh.bytes[4]);
+    memset(p + bh.bytes[4], 0, total - len);
+    if (write_all(w->fd, w->out, total) != 0)
+        return -1;
+
+    if (w->nIndex == w->capIndex) {
+        size_t cap = w->capIndex ? w->capIndex * 2 : 1024;
+        SegIndexEntry *grown = realloc(w->index, cap * sizeof(SegIndexEntry));
+        if (!grown)
+            return -1;
+        w->index = grown;
+        w->capIndex = cap;
+    }
+    w->index[w->nIndex++] = (SegIndexEntry){ asset, e->count, e->tMin, e->tMax, w->offset };
+    w->offset += total;
+
+    for (int c = 0; c < 4; c++)
+        bw_reset(cols[c]);
+    memset(e->alarm, 0, sizeof(e->alarm));
+    e->count = 0;
+    return 0;
+}
+
+static int flush_blocks(SegWriter *w) {
+    int rc = 0;
+    for (size_t a = 0; a < w->capEnc; a++)
+        if (w->enc[a])
+            rc |= write_block(w, (uint32_t)a, w->enc[a]);
+    return rc;
+}
+
+// Индекс и хвост в конец, закрытие файла раздела
+static int seal_segment(SegWriter *w) {
+    if (w->fd < 0)
+        return 0;
+    int rc = flush_blocks(w);
+    if (w->nIndex > 1)
+        qsort(w->index, w->nIndex, sizeof(SegIndexEntry), cmp_entry);
+    SegTrailer tr = { w->nIndex, w->offset, { 0 } };
+    memcpy(tr.magic, SEG_END_MAGIC, 8);
+    rc |= write_all(w->fd, w->index, w->nIndex * sizeof(SegIndexEntry));
+    rc |= write_all(w->fd, &tr, sizeof(tr));
+    rc |= fdatasync(w->fd);
+    rc |= close(w->fd);
+    w->fd = -1;
+    w->nIndex = 0;
+    return rc ? -1 : 0;
+}
+
+// Открыть (или продолжить) файл раздела, начинающегося в partition
+static int open_segment(SegWriter *w, int64_t partition) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%012lld.seg", w->dir, (long long)(partition / 1000000));
+    w->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (w->fd < 0)
+        return -1;
+    w->partition = partition;
+    w->nIndex = 0;
+    struct stat st;
+    if (fstat(w->fd, &st) != 0)
+        return -1;
+
+    size_t dataEnd = 0;
+    if (st.st_size > 0) {
+        // Продолжение: старый индекс — в память, хвост и недописанный блок — прочь
+        void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, w->fd, 0);
+        if (map == MAP_FAILED)
+            return -1;
+        const SegIndexEntry *entries;
+        size_t n;
+        int owned;
+        int rc = load_index(map, (size_t)st.st_size, &entries, &n, &owned, &dataEnd);
+        if (rc == 0 && n > 0) {
+            w->index = realloc(w->index, (n + 1024) * sizeof(SegIndexEntry));
+            if (w->index) {
+                memcpy(w->index, entries, n * sizeof(SegIndexEntry));
+                w->nIndex = n;
+                w->capIndex = n + 1024;
+            } else {
+                w->capIndex = 0;
+                rc = -1;
+            }
+        }
+        if (owned)
+            free((void *)entries);
+        munmap(map, (size_t)st.st_size);
+        if (rc != 0) {
+            errno = EINVAL; // не сегмент — не трогаем
+            return -1;
+        }
+    }
+    if (dataEnd == 0) {
+        SegFileHeader fh = { SEG_MAGIC, 1, SEG_BLOCK_ROWS, partition, w->partitionUs };
+        if (ftruncate(w->fd, 0) != 0 || write_all(w->fd, &fh, sizeof(fh)) != 0)
+            return -1;
+        dataEnd = sizeof(fh);
+    }
+    if (ftruncate(w->fd, (off_t)dataEnd) != 0 || lseek(w->fd, (off_t)dataEnd, SEEK_SET) < 0)
+        return -1;
+    w->offset = dataEnd;
+    return 0;
+}
+
+SegWriter *seg_writer_open(const char *dir, int64_t partitionUs, char *err, size_t errLen) {
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        snprintf(err, errLen, "%s: %s", dir, strerror(errno));
+        return NULL;
+    }
+    SegWriter *w = calloc(1, sizeof(*w));
+    if (!w || !(w->dir = strdup(dir))) {
+        snprintf(err, errLen, "нет памяти");
+        free(w);
+        return NULL;
+    }
+    w->partitionUs = partitionUs > 0 ? partitionUs : SEG_DEFAULT_PARTITION;
+    w->fd = -1;
+    return w;
+}
+
+int seg_writer_append(SegWriter *w, uint32_t asset, int64_t ts, double vib, double temp,
+                      double press, int alarm) {
+    if (asset == SEG_ALL_ASSETS)
+        return -1;
+    int64_t part = ts - ((ts % w->partitionUs) + w->partitionUs) % w->partitionUs;
+    if (w->fd < 0 || part > w->partition) {
+        if (seal_segment(w) != 0)
+            return -1;
+        if (open_segment(w, part) != 0) {
+            if (w->fd >= 0)
+                close(w->fd);
+            w->fd = -1;
+            return -1;
+        }
+    }
+    if (asset >= w->capEnc) {
+        size_t cap = w->capEnc ? w->capEnc : 64;
+        while (cap <= asset)
+            cap *= 2;
+        BlockEnc **grown = realloc(w->enc, cap * sizeof(BlockEnc *));
+        if (!grown)
+            return -1;
+        memset(grown + w->capEnc, 0, (cap - w->capEnc) * sizeof(BlockEnc *));
+        w->enc = grown;
+        w->capEnc = cap;
+    }
+    BlockEnc *e = w->enc[asset];
+    if (!e && !(e = w->enc[asset] = calloc(1, sizeof(BlockEnc))))
+        return -1;
+
+    int rc;
+    if (e->count == 0) {
+        e->tMin = e->tMax = ts;
+        e->lastDelta = 0;
+        rc = bw_put64(&e->ts, (uint64_t)ts);
+    } else {
+        int64_t delta = ts - e->lastTs;
+        rc = enc_ts(&e->ts, delta - e->lastDelta);
+        e->lastDelta = delta;
+        if (ts < e->tMin) e->tMin = ts;
+        if (ts > e->tMax) e->tMax = ts;
+    }
+    e->lastTs = ts;
+    rc |= enc_value(e, 0, vib) | enc_value(e, 1, temp) | enc_value(e, 2, press);
+    if (alarm)
+        e->alarm[e->count / 8] |= (uint8_t)(1u << (e->count % 8));
+    if (rc != 0)
+        return -1;
+    if (++e->count == SEG_BLOCK_ROWS)
+        return write_block(w, asset, e);
+    return 0;
+}
+
+int seg_writer_flush(SegWriter *w) {
+    if (w->fd < 0)
+        return 0;
+    return flush_blocks(w) | fdatasync(w->fd) ? -1 : 0;
+}
+
+int seg_writer_close(SegWriter *w) {
+    if (!w)
+        return 0;
+    int rc = seal_segment(w);
+    for (size_t a = 0; a < w->capEnc; a++) {
+        BlockEnc *e = w->enc[a];
+        if (!e)
+            continue;
+        free(e->ts.buf);
+        for (int c = 0; c < 3; c++)
+            free(e->col[c].buf);
+        free(e);
+    }
+    free(w->enc);
+    free(w->index);
+    free(w->out);
+    free(w->dir);
+    free(w);
+    return rc;
+}
+
+// === Чтение ===
+
+typedef struct {
+    const uint8_t *map;
+    size_t size;
+    const SegIndexEntry *index;
+    size_t nIndex;
+    int    ownedIndex;
+    int64_t tMin, tMax;
+    uint64_t rows;
+} Segment;
+
+struct SegReader {
+    Segment *seg;
+    size_t   nSeg;
+};
+
+static int cmp_name(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+SegReader *seg_reader_open(const char *dir, char *err, size_t errLen) {
+    DIR *d = opendir(dir);
+    if (!d) {
+        snprintf(err, errLen, "%s: %s", dir, strerror(errno));
+        return NULL;
+    }
+    char **names = NULL;
+    size_t n = 0, cap = 0;
+    struct dirent *de;
+    while ((de = readdir(d)) != NULL) {
+        size_t len = strlen(de->d_name);
+        if (len < 5 || strcmp(de->d_name + len - 4, ".seg") != 0)
+            continue;
+        if (n == cap) {
+            cap = cap ? cap * 2 : 64;
+            char **grown = realloc(names, cap * sizeof(char *));
+            if (!grown)
+                break;
+            names = grown;
+        }
+        names[n++] = strdup(de->d_name);
+    }
+    closedir(d);
+    if (n > 1)
+        qsort(names, n, sizeof(char *), cmp_name); // имя — начало раздела с ведущими нулями
+
+    SegReader *r = calloc(1, sizeof(*r));
+    if (r && n)
+        r->seg = calloc(n, sizeof(Segment));
+    if (!r || (n && !r->seg)) {
+        snprintf(err, errLen, "нет памяти");
+        free(r);
+        r = NULL;
+    }
+    for (size_t i = 0; r && i < n; i++) {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s", dir, names[i] ? names[i] : "");
+        int fd = open(path, O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+            if (fd >= 0)
+                close(fd);
+            continue;
+        }
+        void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED)
+            continue;
+        madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+        Segment *s = &r->seg[r->nSeg];
+        size_t dataEnd;
+        if (load_index(map, (size_t)st.st_size, &s->index, &s->nIndex, &s->ownedIndex, &dataEnd) != 0) {
+            fprintf(stderr, "seg_store: %s — не сегмент, пропущен\n", path);
+            munmap(map, (size_t)st.st_size);
+            continue;
+        }
+        s->map = map;
+        s->size = (size_t)st.st_size;
+        for (size_t k = 0; k < s->nIndex; k++) {
+            const SegIndexEntry *e = &s->index[k];
+            if (k == 0 || e->tMin < s->tMin) s->tMin = e->tMin;
+            if (k == 0 || e->tMax > s->tMax) s->tMax = e->tMax;
+            s->rows += e->count;
+        }
+        r->nSeg++;
+    }
+    for (size_t i = 0; i < n; i++)
+        free(names[i]);
+    free(names);
+    return r;
+}
+
+void seg_reader_close(SegReader *r) {
+    if (!r)
+        return;
+    for (size_t i = 0; i < r->nSeg; i++) {
+        if (r->seg[i].ownedIndex)
+            free((void *)r->seg[i].index);
+        munmap((void *)r->seg[i].map, r->seg[i].size);
+    }
+    free(r->seg);
+    free(r);
+}
+
+void seg_reader_stat(const SegReader *r, SegStat *st) {
+    memset(st, 0, sizeof(*st));
+    st->segments = r->nSeg;
+    for (size_t i = 0; i < r->nSeg; i++) {
+        const Segment *s = &r->seg[i];
+        if (s->nIndex == 0)
+            continue;
+        if (st->rows == 0 || s->tMin < st->tMin) st->tMin = s->tMin;
+        if (st->rows == 0 || s->tMax > st->tMax) st->tMax = s->tMax;
+        st->blocks += s->nIndex;
+        st->rows += s->rows;
+        st->bytes += s->size;
+    }
+}
+
+// Первая запись индекса агрегата asset (индекс отсортирован по агрегату)
+static size_t first_entry(const Segment *s, uint32_t asset) {
+    if (asset == SEG_ALL_ASSETS)
+        return 0;
+    size_t lo = 0, hi = s->nIndex;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (s->index[mid].asset < asset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+uint64_t seg_reader_count(const SegReader *r, uint32_t asset, int64_t from, int64_t to) {
+    uint64_t n = 0;
+    for (size_t i = 0; i < r->nSeg; i++) {
+        const Segment *s = &r->seg[i];
+        if (s->nIndex == 0 || s->tMax < from || s->tMin >= to)
+            continue;
+        for (size_t k = first_entry(s, asset); k < s->nIndex; k++) {
+            const SegIndexEntry *e = &s->index[k];
+            if (asset != SEG_ALL_ASSETS && e->asset != asset)
+                break;
+            if (e->tMax >= from && e->tMin < to)
+                n += e->count;
+        }
+    }
+    return n;
+}
+
+typedef struct {
+    const uint8_t *p, *end;
+    uint64_t acc;
+    unsigned nbits;
+} BitReader;
+
+// До 32 бит за вызов; за концом потока — нули
+static inline uint64_t br_get(BitReader *r, unsigned n) {
+    while (r->nbits < n) {
+        r->acc = (r->acc << 8) | (r->p < r->end ? *r->p++ : 0);
+        r->nbits += 8;
+    }
+    r->nbits -= n;
+    return (r->acc >> r->nbits) & ((1ull << n) - 1);
+}
+
+static inline uint64_t br_get64(BitReader *r) {
+    uint64_t hi = br_get(r, 32);
+    return hi << 32 | br_get(r, 32);
+}
+
+static inline int64_t sign_extend(uint64_t v, unsigned n) {
+    return (int64_t)(v << (64 - n)) >> (64 - n);
+}
+
+// Возвращает 1, если время в блоке не убывает
+static int dec_ts(const uint8_t *p, size_t len, uint32_t count, int64_t *out) {
+    BitReader r = { p, p + len, 0, 0 };
+    int64_t ts = (int64_t)br_get64(&r), delta = 0;
+    int sorted = 1;
+    out[0] = ts;
+    for (uint32_t i = 1; i < count; i++) {
+        int64_t dod;
+        if (!br_get(&r, 1))      dod = 0;
+        else if (!br_get(&r, 1)) dod = sign_extend(br_get(&r, 7), 7);
+        else if (!br_get(&r, 1)) dod = sign_extend(br_get(&r, 14), 14);
+        else if (!br_get(&r, 1)) dod = sign_extend(br_get(&r, 20), 20);
+        else                     dod = (int64_t)br_get64(&r);
+        delta += dod;
+        ts += delta;
+        sorted &= delta >= 0;
+        out[i] = ts;
+    }
+    return sorted;
+}
+
+static inline uint64_t br_bits(BitReader *r, unsigned n) {
+    return n > 32 ? br_get(r, n - 32) << 32 | br_get(r, 32) : br_get(r, n);
+}
+
+static void dec_values(const uint8_t *p, size_t len, uint32_t count, double *out) {
+    BitReader r = { p, p + len, 0, 0 };
+    uint64_t v = br_get64(&r);
+    unsigned lead = 0, trail = 0;
+    memcpy(&out[0], &v, sizeof(v));
+    for (uint32_t i = 1; i < count; i++) {
+        if (br_get(&r, 1)) {
+            if (br_get(&r, 1)) {
+                lead = (unsigned)br_get(&r, 5);
+                unsigned sig = (unsigned)br_get(&r, 6) + 1;
+                trail = 64 - lead - sig;
+            }
+            v ^= br_bits(&r, 64 - lead - trail) << trail;
+        }
+        memcpy(&out[i], &v, sizeof(v));
+    }
+}
+
+struct SegScan {
+    const SegReader *r;
+    uint32_t asset;
+    int64_t  from, to;
+    size_t   seg, entry;            // следующая запись индекса
+    // Распакованный текущий блок
+    uint32_t blkAsset, blkRows, blkPos;
+    int      blkSorted;
+    int64_t  ts[SEG_BLOCK_ROWS];
+    double   col[3][SEG_BLOCK_ROWS];
+    uint8_t  alarm[SEG_BLOCK_ROWS];
+};
+
+SegScan *seg_scan_new(const SegReader *r, uint32_t asset, int64_t from, int64_t to) {
+    SegScan *s = malloc(sizeof(*s));
+    if (!s)
+        return NULL;
+    s->r = r;
+    s->asset = asset;
+    s->from = from;
+    s->to = to;
+    s->seg = 0;
+    s->entry = r->nSeg ? first_entry(&r->seg[0], asset) : 0;
+    s->blkRows = s->blkPos = 0;
+    return s;
+}
+
+void seg_scan_free(SegScan *s) { free(s); }
+
+// Следующий блок, пересекающий диапазон; 0 — блоков больше нет
+static int next_block(SegScan *s, const SegIndexEntry **entry, const Segment **seg) {
+    const SegReader *r = s->r;
+    while (s->seg < r->nSeg) {
+        const Segment *sg = &r->seg[s->seg];
+        int skipSeg = sg->nIndex == 0 || sg->tMax < s->from || sg->tMin >= s->to;
+        while (!skipSeg && s->entry < sg->nIndex) {
+            const SegIndexEntry *e = &sg->index[s->entry];
+            if (s->asset != SEG_ALL_ASSETS && e->asset != s->asset)
+                break;
+            s->entry++;
+            if (e->tMax >= s->from && e->tMin < s->to) {
+                *entry = e;
+                *seg = sg;
+                return 1;
+            }
+        }
+        if (++s->seg < r->nSeg)
+            s->entry = first_entry(&r->seg[s->seg], s->asset);
+    }
+    return 0;
+}
+
+size_t seg_scan_next(SegScan *s, const SegRows *out, size_t cap) {
+    size_t n = 0;
+    while (n < cap) {
+        if (s->blkPos == s->blkRows) {
+            const SegIndexEntry *e;
+            const Segment *sg;
+            if (!next_block(s, &e, &sg))
+                break;
+            SegBlockHeader bh;
+            memcpy(&bh, sg->map + e->offset, sizeof(bh));
+            const uint8_t *p = sg->map + e->offset + sizeof(bh);
+            // Колонки, которые не просили, не распаковываются; ts нужен для фильтра
+            s->blkSorted = dec_ts(p, bh.bytes[0], bh.count, s->ts);
+            p += bh.bytes[0];
+            double *const want[3] = { out->vib, out->temp, out->press };
+            for (int c = 0; c < 3; c++) {
+                if (want[c])
+                    dec_values(p, bh.bytes[1 + c], bh.count, s->col[c]);
+                p += bh.bytes[1 + c];
+            }
+            if (out->alarm)
+                for (uint32_t i = 0; i < bh.count; i++)
+                    s->alarm[i] = (p[i / 8] >> (i % 8)) & 1;
+            s->blkAsset = bh.asset;
+            s->blkRows = bh.count;
+            s->blkPos = 0;
+        }
+        // Блок целиком в диапазоне — копируем колонками, иначе построчно с фильтром
+        size_t avail = s->blkRows - s->blkPos, take = avail < cap - n ? avail : cap - n;
+        const uint32_t b = s->blkPos;
+        if (s->blkSorted && s->ts[b] >= s->from && s->ts[b + take - 1] < s->to) {
+            if (out->ts)    memcpy(out->ts + n, s->ts + b, take * sizeof(int64_t));
+            if (out->vib)   memcpy(out->vib + n, s->col[0] + b, take * sizeof(double));
+            if (out->temp)  memcpy(out->temp + n, s->col[1] + b, take * sizeof(double));
+            if (out->press) memcpy(out->press + n, s->col[2] + b, take * sizeof(double));
+            if (out->alarm) memcpy(out->alarm + n, s->alarm + b, take);
+            if (out->asset)
+                for (size_t k = 0; k < take; k++)
+                    out->asset[n + k] = s->blkAsset;
+            n += take;
+            s->blkPos += (uint32_t)take;
+            continue;
+        }
+        for (; s->blkPos < s->blkRows && n < cap; s->blkPos++) {
+            const uint32_t i = s->blkPos;
+            if (s->ts[i] < s->from || s->ts[i] >= s->to)
+                continue;
+            if (out->ts)    out->ts[n] = s->ts[i];
+            if (out->asset) out->asset[n] = s->blkAsset;
+            if (out->vib)   out->vib[n] = s->col[0][i];
+            if (out->temp)  out->temp[n] = s->col[1][i];
+            if (out->press) out->press[n] = s->col[2][i];
+            if (out->alarm) out->alarm[n] = s->alarm[i];
+            n++;
+        }
+    }
+    return n;
+}
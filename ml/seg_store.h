@@ -0,0 +1,90 @@
+/*
+ * seg_store.h — локальное хранилище телеметрии: сжатые колоночные сегменты
+ * ------------------------------------------------------------------------
+ * Замена выгрузки всей sensor_data2 через SELECT ... ORDER BY ts для обучения
+ * и оценки: сборщик дописывает строки в сегменты на диске, а чтение диапазона
+ * времени отображает сегменты в память и распаковывает только нужные блоки.
+ *
+ * Раскладка:
+ *   каталог/<начало раздела, Unix с>.seg — один файл на раздел времени
+ *   (по умолчанию сутки). Файл — заголовок, блоки, индекс блоков в конце.
+ *   Блок — до SEG_BLOCK_ROWS строк одного агрегата, колонки лежат подряд:
+ *     ts           — дельта от дельты (Gorilla): ровный период — 1 бит на строку;
+ *     vib/temp/press — XOR с предыдущим значением (Gorilla): повтор — 1 бит,
+ *                    иначе только значащие биты XOR;
+ *     alarm        — битовая упаковка, 1 бит на строку.
+ *   Индекс — (агрегат, строк, tMin, tMax, смещение) на блок, отсортирован по
+ *   (агрегат, tMin): поиск диапазона — двоичный поиск без чтения блоков.
+ *   Незакрытый сегмент (сборщик упал) читается по заголовкам блоков, а недописанный
+ *   последний блок отбрасывается; писатель при повторном открытии обрезает его.
+ *
+ * Время — микросекунды Unix (int64). Внутри агрегата строки должны идти по
+ * неубыванию времени; строки старше текущего раздела дописываются в текущий.
+ * Формат — little-endian, как у всех целевых машин.
+ *
+ * Модуль не зависит от open62541 и libpq: пишет collector.c (--store), читают
+ * seg_tool.c и seg_store.py (ctypes, библиотека libseg_store.so).
+ */
+#ifndef SEG_STORE_H
+#define SEG_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SEG_BLOCK_ROWS       1024
+#define SEG_ALL_ASSETS       UINT32_MAX
+#define SEG_DEFAULT_PARTITION (86400LL * 1000000) // сутки, мкс
+
+// --- Запись ---
+
+typedef struct SegWriter SegWriter;
+
+// Каталог dir (создаётся); partitionUs — длина раздела, мкс (0 — сутки)
+SegWriter *seg_writer_open(const char *dir, int64_t partitionUs, char *err, size_t errLen);
+
+// Строка агрегата asset в момент ts (мкс Unix). 0 — успех, -1 — ошибка записи
+int seg_writer_append(SegWriter *w, uint32_t asset, int64_t ts, double vib, double temp,
+                      double press, int alarm);
+
+// Недописанные блоки — на диск (fdatasync); сегмент остаётся открытым
+int seg_writer_flush(SegWriter *w);
+
+// flush, индекс в конец сегмента, закрытие. 0 — успех
+int seg_writer_close(SegWriter *w);
+
+// --- Чтение ---
+
+typedef struct SegReader SegReader;
+typedef struct SegScan SegScan;
+
+// Колонки результата; NULL — колонка не нужна и не распаковывается
+typedef struct {
+    int64_t  *ts;
+    uint32_t *asset;
+    double   *vib, *temp, *press;
+    uint8_t  *alarm;
+} SegRows;
+
+typedef struct {
+    size_t   segments, blocks;
+    uint64_t rows, bytes;  // строк и байт на диске
+    int64_t  tMin, tMax;   // мкс Unix; 0, если строк нет
+} SegStat;
+
+// Все сегменты каталога, отображённые в память. NULL при ошибке, текст — в err
+SegReader *seg_reader_open(const char *dir, char *err, size_t errLen);
+void seg_reader_close(SegReader *r);
+void seg_reader_stat(const SegReader *r, SegStat *st);
+
+// Верхняя оценка числа строк в [from, to) по индексу — для выделения буферов
+uint64_t seg_reader_count(const SegReader *r, uint32_t asset, int64_t from, int64_t to);
+
+// Просмотр строк агрегата asset (SEG_ALL_ASSETS — всех) в [from, to).
+// Порядок: разделы по времени, внутри раздела — по агрегату, затем по времени
+SegScan *seg_scan_new(const SegReader *r, uint32_t asset, int64_t from, int64_t to);
+void seg_scan_free(SegScan *s);
+
+// Следующие до cap строк в буферы out; 0 — просмотр закончен
+size_t seg_scan_next(SegScan *s, const SegRows *out, size_t cap);
+
+#endif
@@ -0,0 +1,96 @@
+# seg_store.py — чтение хранилища сегментов (ml/seg_store.c) в pandas
+# -------------------------------------------------------------------
+# Обёртка ctypes над libseg_store.so: seg_scan_next() распаковывает блоки
+# прямо в буферы numpy, без CSV и без SELECT по всей sensor_data2.
+# Результат — DataFrame в формате ml_prepare.py: индекс ts (UTC),
+# колонки vibration, temperature, pressure, vibration_alarm (+ asset_id).
+#
+# Сборка библиотеки:
+#   gcc -O3 -march=native -shared -fPIC ml/seg_store.c -o ml/libseg_store.so
+#
+# Использование:
+#   from seg_store import load
+#   df = load("data/store", start="2025-08-01", end="2025-09-01", asset=None)
+
+import ctypes
+import os
+
+import numpy as np
+import pandas as pd
+
+ALL_ASSETS = 0xFFFFFFFF
+INT64_MIN, INT64_MAX = -(2 ** 63), 2 ** 63 - 1
+
+
+class _SegRows(ctypes.Structure):
+    _fields_ = [("ts", ctypes.c_void_p), ("asset", ctypes.c_void_p),
+                ("vib", ctypes.c_void_p), ("temp", ctypes.c_void_p),
+                ("press", ctypes.c_void_p), ("alarm", ctypes.c_void_p)]
+
+
+def _lib():
+    path = os.environ.get("SEG_STORE_LIB",
+                          os.path.join(os.path.dirname(os.path.abspath(__file__)), "libseg_store.so"))
+    lib = ctypes.CDLL(path)
+    lib.seg_reader_open.restype = ctypes.c_void_p
+    lib.seg_reader_open.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_size_t]
+    lib.seg_reader_close.argtypes = [ctypes.c_void_p]
+    lib.seg_reader_count.restype = ctypes.c_uint64
+    lib.seg_reader_count.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_int64, ctypes.c_int64]
+    lib.seg_scan_new.restype = ctypes.c_void_p
+    lib.seg_scan_new.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_int64, ctypes.c_int64]
+    lib.seg_scan_free.argtypes = [ctypes.c_void_p]
+    lib.seg_scan_next.restype = ctypes.c_size_t
+    lib.seg_scan_next.argtypes = [ctypes.c_void_p, ctypes.POINTER(_SegRows), ctypes.c_size_t]
+    return lib
+
+
+def _to_us(t, default):
+    if t is None:
+        return default
+    ts = pd.Timestamp(t)
+    if ts.tzinfo is None:
+        ts = ts.tz_localize("UTC")
+    return ts.value // 1000
+
+
+def load(store_dir, start=None, end=None, asset=None):
+    """Строки [start, end) одного агрегата (asset) или всех, отсортированные по ts."""
+    lib = _lib()
+    err = ctypes.create_string_buffer(256)
+    reader = lib.seg_reader_open(store_dir.encode(), err, len(err))
+    if not reader:
+        raise OSError(err.value.decode())
+    try:
+        a = ALL_ASSETS if asset is None else int(asset)
+        t0, t1 = _to_us(start, INT64_MIN), _to_us(end, INT64_MAX)
+        cap = int(lib.seg_reader_count(reader, a, t0, t1))
+        ts = np.empty(cap, dtype=np.int64)
+        ids = np.empty(cap, dtype=np.uint32)
+        cols = [np.empty(cap, dtype=np.float64) for _ in range(3)]
+        alarm = np.empty(cap, dtype=np.uint8)
+        scan = lib.seg_scan_new(reader, a, t0, t1)
+        rows = _SegRows(ts.ctypes.data, ids.ctypes.data, cols[0].ctypes.data,
+                        cols[1].ctypes.data, cols[2].ctypes.data, alarm.ctypes.data)
+        n = lib.seg_scan_next(scan, ctypes.byref(rows), cap) if cap else 0
+        lib.seg_scan_free(scan)
+    finally:
+        lib.seg_reader_close(reader)
+
+    # Сегмент хранит блоки по агрегатам — строки всего парка упорядочиваем по времени
+    ts, ids, alarm = ts[:n], ids[:n], alarm[:n]
+    cols = [c[:n] for c in cols]
+    if n > 1 and (ts[1:] < ts[:-1]).any():
+        order = np.argsort(ts, kind="stable")
+        ts, ids, alarm = ts[order], ids[order], alarm[order]
+        cols = [c[order] for c in cols]
+
+    df = pd.DataFrame({
+        "vibration": cols[0],
+        "temperature": cols[1],
+        "pressure": cols[2],
+        "vibration_alarm": alarm.view(bool),
+    }, index=pd.DatetimeIndex(pd.to_datetime(ts, unit="us", utc=True), name="ts"))
+    if asset is None and n and ids.max() > 0:
+        df["asset_id"] = ids
+    return df
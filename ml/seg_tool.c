@@ -0,0 +1,246 @@
+/*
+ * seg_tool.c — работа с хранилищем сегментов (seg_store.c) из командной строки
+ * ---------------------------------------------------------------------------
+ *   import CSV DIR   — CSV формата data/sensor_data.csv (ts,vibration,temperature,
+ *                      pressure,vibration_alarm[,asset_id]) → сегменты в DIR;
+ *   export DIR       — строки диапазона в CSV того же формата (stdout);
+ *   stat DIR         — сегменты, блоки, строки, байт на строку и скорость чтения.
+ *
+ * Диапазон (--from / --to) — "YYYY-MM-DD[ HH:MM:SS]" UTC или микросекунды Unix;
+ * --asset N — один агрегат. --partition H — длина раздела при импорте, часов (24).
+ *
+ * Сборка:
+ *   gcc -O3 -march=native seg_tool.c seg_store.c -o seg_tool
+ *
+ * Запуск:
+ *   ./seg_tool import data/sensor_data.csv data/store
+ *   ./seg_tool stat data/store
+ *   ./seg_tool export data/store --from "2025-08-29 16:00:00" --to 2025-08-30 > day.csv
+ */
+#define _GNU_SOURCE // timegm()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "seg_store.h"
+
+#define SCAN_ROWS 65536 // строк за вызов seg_scan_next
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// "2025-08-29 15:49:24.588316+00:00" → мкс Unix; -1 при ошибке
+static int parse_time(const char *s, int64_t *out) {
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    double sec = 0;
+    int used = 0, oh = 0, om = 0;
+    char sign = 0;
+    int n = sscanf(s, "%d-%d-%d%*[ T]%d:%d:%lf%n", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                   &tm.tm_hour, &tm.tm_min, &sec, &used);
+    if (n < 3) {
+        char *end;
+        long long us = strtoll(s, &end, 10);
+        if (end == s)
+            return -1;
+        *out = us;
+        return 0;
+    }
+    if (n < 6) {
+        tm.tm_hour = tm.tm_min = 0;
+        sec = 0;
+        used = 0;
+    } else if (sscanf(s + used, "%c%d:%d", &sign, &oh, &om) == 3 && (sign == '+' || sign == '-')) {
+        int off = (oh * 60 + om) * 60;
+        tm.tm_sec = sign == '+' ? -off : off; // timegm нормализует
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    int64_t whole = (int64_t)sec;
+    tm.tm_sec += (int)whole;
+    *out = (int64_t)timegm(&tm) * 1000000 + (int64_t)((sec - (double)whole) * 1e6 + 0.5);
+    return 0;
+}
+
+static void print_time(FILE *f, int64_t us) {
+    time_t sec = (time_t)(us / 1000000);
+    long frac = (long)(us % 1000000);
+    if (frac < 0) {
+        sec--;
+        frac += 1000000;
+    }
+    struct tm tm;
+    gmtime_r(&sec, &tm);
+    char buf[32];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    fprintf(f, "%s.%06ld+00:00", buf, frac);
+}
+
+static int cmd_import(const char *csv, const char *dir, int64_t partitionUs) {
+    FILE *f = fopen(csv, "r");
+    if (!f) {
+        perror(csv);
+        return 1;
+    }
+    char err[256];
+    SegWriter *w = seg_writer_open(dir, partitionUs, err, sizeof(err));
+    if (!w) {
+        fprintf(stderr, "❌ %s\n", err);
+        fclose(f);
+        return 1;
+    }
+    char line[512];
+    uint64_t rows = 0, bad = 0;
+    int assetCol = 0;
+    if (fgets(line, sizeof(line), f))
+        assetCol = strstr(line, "asset_id") != NULL;
+    while (fgets(line, sizeof(line), f)) {
+        char *fields[6] = { 0 };
+        int nf = 0;
+        for (char *tok = strtok(line, ",\r\n"); tok && nf < 6; tok = strtok(NULL, ",\r\n"))
+            fields[nf++] = tok;
+        int64_t ts;
+        if (nf < 5 + assetCol || parse_time(fields[0], &ts) != 0) {
+            bad++;
+            continue;
+        }
+        int alarm = fields[4][0] == 'T' || fields[4][0] == 't' || fields[4][0] == '1';
+        uint32_t asset = assetCol ? (uint32_t)strtoul(fields[5], NULL, 10) : 0;
+        if (seg_writer_append(w, asset, ts, strtod(fields[1], NULL), strtod(fields[2], NULL),
+                              strtod(fields[3], NULL), alarm) != 0) {
+            perror("запись сегмента");
+            break;
+        }
+        rows++;
+    }
+    fclose(f);
+    int rc = seg_writer_close(w);
+    fprintf(stderr, "✅ Импортировано %llu строк (пропущено %llu) в %s\n",
+            (unsigned long long)rows, (unsigned long long)bad, dir);
+    return rc != 0;
+}
+
+static int cmd_export(SegReader *r, uint32_t asset, int64_t from, int64_t to) {
+    int64_t *ts = malloc(SCAN_ROWS * sizeof(int64_t));
+    uint32_t *id = malloc(SCAN_ROWS * sizeof(uint32_t));
+    double *vib = malloc(SCAN_ROWS * sizeof(double));
+    double *temp = malloc(SCAN_ROWS * sizeof(double));
+    double *press = malloc(SCAN_ROWS * sizeof(double));
+    uint8_t *alarm = malloc(SCAN_ROWS);
+    SegScan *s = seg_scan_new(r, asset, from, to);
+    if (!ts || !id || !vib || !temp || !press || !alarm || !s) {
+        fprintf(stderr, "❌ нет памяти\n");
+        return 1;
+    }
+    SegRows out = { ts, id, vib, temp, press, alarm };
+    printf("ts,vibration,temperature,pressure,vibration_alarm,asset_id\n");
+    size_t n;
+    while ((n = seg_scan_next(s, &out, SCAN_ROWS)) > 0)
+        for (size_t i = 0; i < n; i++) {
+            print_time(stdout, ts[i]);
+            printf(",%.17g,%.17g,%.17g,%s,%u\n", vib[i], temp[i], press[i],
+                   alarm[i] ? "True" : "False", id[i]);
+        }
+    seg_scan_free(s);
+    free(ts); free(id); free(vib); free(temp); free(press); free(alarm);
+    return 0;
+}
+
+static int cmd_stat(SegReader *r) {
+    SegStat st;
+    seg_reader_stat(r, &st);
+    printf("сегментов %zu, блоков %zu, строк %llu, %.1f МБ, %.2f байт/строку (без сжатия 33)\n",
+           st.segments, st.blocks, (unsigned long long)st.rows, st.bytes / 1048576.0,
+           st.rows ? (double)st.bytes / (double)st.rows : 0.0);
+    if (st.rows) {
+        printf("с ");
+        print_time(stdout, st.tMin);
+        printf(" по ");
+        print_time(stdout, st.tMax);
+        printf("\n");
+    }
+
+    // Полный просмотр всех колонок — скорость распаковки
+    double *col = malloc(SCAN_ROWS * sizeof(double) * 3);
+    int64_t *ts = malloc(SCAN_ROWS * sizeof(int64_t));
+    uint8_t *alarm = malloc(SCAN_ROWS);
+    SegScan *s = seg_scan_new(r, SEG_ALL_ASSETS, INT64_MIN, INT64_MAX);
+    if (!col || !ts || !alarm || !s) {
+        fprintf(stderr, "❌ нет памяти\n");
+        return 1;
+    }
+    SegRows out = { ts, NULL, col, col + SCAN_ROWS, col + 2 * SCAN_ROWS, alarm };
+    uint64_t rows = 0;
+    size_t n;
+    double t0 = now_s();
+    while ((n = seg_scan_next(s, &out, SCAN_ROWS)) > 0)
+        rows += n;
+    double dt = now_s() - t0;
+    printf("чтение: %llu строк за %.3f с — %.1f млн строк/с, %.0f МБ/с несжатых\n",
+           (unsigned long long)rows, dt, rows / dt / 1e6, rows * 33.0 / dt / 1048576.0);
+    seg_scan_free(s);
+    free(col); free(ts); free(alarm);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Использование:\n"
+            "  %s import CSV DIR [--partition H]\n"
+            "  %s export DIR [--from T] [--to T] [--asset N]\n"
+            "  %s stat DIR\n"
+            "  T — \"YYYY-MM-DD[ HH:MM:SS]\" UTC или микросекунды Unix\n",
+            prog, prog, prog);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char *cmd = argv[1];
+    int64_t from = INT64_MIN, to = INT64_MAX;
+    uint32_t asset = SEG_ALL_ASSETS;
+    double partitionH = 24;
+    int first = !strcmp(cmd, "import") ? 4 : 3;
+    if (first > argc) {
+        usage(argv[0]);
+        return 1;
+    }
+    for (int a = first; a < argc; a++) {
+        if (a + 1 >= argc) {
+            usage(argv[0]);
+            return 1;
+        }
+        const char *opt = argv[a], *val = argv[++a];
+        int ok = 1;
+        if (!strcmp(opt, "--from"))           ok = parse_time(val, &from) == 0;
+        else if (!strcmp(opt, "--to"))        ok = parse_time(val, &to) == 0;
+        else if (!strcmp(opt, "--asset"))     asset = (uint32_t)strtoul(val, NULL, 10);
+        else if (!strcmp(opt, "--partition")) ok = (partitionH = strtod(val, NULL)) > 0;
+        else ok = 0;
+        if (!ok) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!strcmp(cmd, "import"))
+        return cmd_import(argv[2], argv[3], (int64_t)(partitionH * 3600e6));
+    if (strcmp(cmd, "export") != 0 && strcmp(cmd, "stat") != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    char err[256];
+    SegReader *r = seg_reader_open(argv[2], err, sizeof(err));
+    if (!r) {
+        fprintf(stderr, "❌ %s\n", err);
+        return 1;
+    }
+    int rc = !strcmp(cmd, "export") ? cmd_export(r, asset, from, to) : cmd_stat(r);
+    seg_reader_close(r);
+    return rc;
+}
@@ -0,0 +1,159 @@
+/*
+ * window_features.c — реализация window_features.h
+ * -----------------------------------------------
+ * Состояние канала: кольцо значений и меток времени, монотонная очередь
+ * позиций для пика и суммы Σx, Σx², Σx³, Σx⁴, Σt, Σt², Σtx по окну,
+ * где x и t взяты относительно опорных kx, kt (центрирование против
+ * потери точности, например для температуры около 60 °C).
+ */
+#include "window_features.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+const char *const feature_names[FEATURE_COUNT] = {
+    "rms", "peak", "crest", "kurtosis", "ewma", "slope"
+};
+
+typedef struct {
+    uint64_t pushed;            // всего отсчётов в канале
+    uint64_t dqHead, dqTail;    // монотонная очередь пика: [dqHead, dqTail)
+    double   kx, kt;            // опорные точки сумм
+    double   s1, s2, s3, s4;    // суммы степеней (x - kx)
+    double   st, stt, stx;      // суммы для регрессии по (t - kt)
+    double   ewma;
+} Channel;
+
+struct FeatureEngine {
+    size_t    nChannels;
+    size_t    window;
+    double    alpha;
+    Channel  *ch;
+    double   *xs;    // кольцо значений [nChannels * window]
+    double   *ts;    // кольцо меток времени [nChannels * window]
+    uint64_t *dq;    // очередь позиций для пика [nChannels * window]
+};
+
+FeatureEngine *features_new(size_t nChannels, size_t window, double alpha) {
+    if (nChannels == 0 || window < 2)
+        return NULL;
+    FeatureEngine *e = calloc(1, sizeof(FeatureEngine));
+    if (!e)
+        return NULL;
+    e->nChannels = nChannels;
+    e->window    = window;
+    e->alpha     = alpha > 0.0 ? alpha : 2.0 / (window + 1.0);
+    e->ch = calloc(nChannels, sizeof(Channel));
+    e->xs = calloc(nChannels * window, sizeof(double));
+    e->ts = calloc(nChannels * window, sizeof(double));
+    e->dq = calloc(nChannels * window, sizeof(uint64_t));
+    if (!e->ch || !e->xs || !e->ts || !e->dq) {
+        features_free(e);
+        return NULL;
+    }
+    return e;
+}
+
+void features_free(FeatureEngine *e) {
+    if (!e)
+        return;
+    free(e->ch);
+    free(e->xs);
+    free(e->ts);
+    free(e->dq);
+    free(e);
+}
+
+// Пересчёт сумм по окну с новыми опорными точками (средними окна)
+static void recenter(Channel *c, const double *xs, const double *ts, size_t n) {
+    double mx = 0.0, mt = 0.0;
+    for (size_t k = 0; k < n; k++) {
+        mx += xs[k];
+        mt += ts[k];
+    }
+    c->kx = mx / n;
+    c->kt = mt / n;
+    c->s1 = c->s2 = c->s3 = c->s4 = c->st = c->stt = c->stx = 0.0;
+    for (size_t k = 0; k < n; k++) {
+        double d = xs[k] - c->kx, dt = ts[k] - c->kt, d2 = d * d;
+        c->s1 += d;  c->s2 += d2;  c->s3 += d2 * d;  c->s4 += d2 * d2;
+        c->st += dt; c->stt += dt * dt; c->stx += dt * d;
+    }
+}
+
+void features_push(FeatureEngine *e, size_t chIdx, double t, double x) {
+    Channel *c = &e->ch[chIdx];
+    const size_t W = e->window;
+    double   *xs = e->xs + chIdx * W;
+    double   *ts = e->ts + chIdx * W;
+    uint64_t *dq = e->dq + chIdx * W;
+    const uint64_t p = c->pushed;
+    const size_t slot = (size_t)(p % W);
+
+    if (p == 0) { // первый отсчёт задаёт опорные точки и EWMA
+        c->kx = x;
+        c->kt = t;
+        c->ewma = x;
+    }
+
+    // 1. Вытесняемый отсчёт уходит из сумм
+    if (p >= W) {
+        double d = xs[slot] - c->kx, dt = ts[slot] - c->kt, d2 = d * d;
+        c->s1 -= d;  c->s2 -= d2;  c->s3 -= d2 * d;  c->s4 -= d2 * d2;
+        c->st -= dt; c->stt -= dt * dt; c->stx -= dt * d;
+    }
+
+    // 2. Новый отсчёт
+    xs[slot] = x;
+    ts[slot] = t;
+    {
+        double d = x - c->kx, dt = t - c->kt, d2 = d * d;
+        c->s1 += d;  c->s2 += d2;  c->s3 += d2 * d;  c->s4 += d2 * d2;
+        c->st += dt; c->stt += dt * dt; c->stx += dt * d;
+    }
+    c->ewma += e->alpha * (x - c->ewma);
+
+    // 3. Пик: из головы уходят позиции, вышедшие из окна, из хвоста — с |x| не больше нового
+    const double ax = fabs(x);
+    while (c->dqTail > c->dqHead && dq[c->dqHead % W] + W <= p)
+        c->dqHead++;
+    while (c->dqTail > c->dqHead && fabs(xs[dq[(c->dqTail - 1) % W] % W]) <= ax)
+        c->dqTail--;
+    dq[c->dqTail % W] = p;
+    c->dqTail++;
+
+    c->pushed = p + 1;
+
+    // 4. Раз в окно — точный пересчёт сумм (кольцо заполнено целиком)
+    if (c->pushed >= W && c->pushed % W == 0)
+        recenter(c, xs, ts, W);
+}
+
+void features_get(const FeatureEngine *e, size_t chIdx, FeatureSet *out) {
+    const Channel *c = &e->ch[chIdx];
+    const size_t W = e->window;
+    const size_t n = c->pushed < W ? (size_t)c->pushed : W;
+    if (n == 0) {
+        *out = (FeatureSet){0};
+        return;
+    }
+    const double *xs = e->xs + chIdx * W;
+    const uint64_t *dq = e->dq + chIdx * W;
+
+    // Моменты относительно kx → центральные моменты и средний квадрат
+    const double inv = 1.0 / n;
+    const double m1 = c->s1 * inv, m2r = c->s2 * inv, m3r = c->s3 * inv, m4r = c->s4 * inv;
+    const double var = m2r - m1 * m1;
+    const double m4  = m4r - 4.0 * m1 * m3r + 6.0 * m1 * m1 * m2r - 3.0 * m1 * m1 * m1 * m1;
+    const double mean = c->kx + m1;
+    const double msq  = var + mean * mean;
+
+    out->rms      = sqrt(msq > 0.0 ? msq : 0.0);
+    out->peak     = fabs(xs[dq[c->dqHead % W] % W]);
+    out->crest    = out->rms > 0.0 ? out->peak / out->rms : 0.0;
+    out->kurtosis = var > 1e-12 ? m4 / (var * var) : 0.0;
+    out->ewma     = c->ewma;
+
+    const double den = n * c->stt - c->st * c->st;
+    out->slope = den > 1e-12 ? (n * c->stx - c->st * c->s1) / den : 0.0;
+}
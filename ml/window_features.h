@@ -0,0 +1,48 @@
+/*
+ * window_features.h — потоковые оконные признаки вибродиагностики (O(1) на отсчёт)
+ * -------------------------------------------------------------------------------
+ * Для каждого канала (тег агрегата) держит последние W отсчётов в кольцевом
+ * буфере и инкрементально обновляет признаки окна:
+ *   rms       — среднеквадратичное значение
+ *   peak      — максимум |x| (монотонная очередь, амортизированно O(1))
+ *   crest     — пик-фактор peak / rms
+ *   kurtosis  — эксцесс m4 / m2² (3 для нормального шума, растёт на ударах)
+ *   ewma      — экспоненциальное скользящее среднее
+ *   slope     — наклон линейной регрессии x(t) по окну, единиц в секунду
+ * Суммы степеней хранятся относительно опорной точки и раз в W отсчётов
+ * пересчитываются заново — ошибка округления не накапливается.
+ *
+ * Вся память выделяется в features_new(): каналов × W × 24 байта.
+ * Модуль не зависит от open62541: используется в update_cb сервера и в сборщике.
+ */
+#ifndef WINDOW_FEATURES_H
+#define WINDOW_FEATURES_H
+
+#include <stddef.h>
+
+// Признаки окна одного канала
+typedef struct {
+    double rms;
+    double peak;
+    double crest;
+    double kurtosis;
+    double ewma;
+    double slope;
+} FeatureSet;
+
+#define FEATURE_COUNT 6
+extern const char *const feature_names[FEATURE_COUNT]; // "rms", "peak", ... в порядке FeatureSet
+
+typedef struct FeatureEngine FeatureEngine;
+
+// nChannels каналов по window отсчётов; alpha — коэффициент EWMA (0 — 2 / (window + 1))
+FeatureEngine *features_new(size_t nChannels, size_t window, double alpha);
+void features_free(FeatureEngine *e);
+
+// Новый отсчёт x канала ch в момент t (секунды, не убывают)
+void features_push(FeatureEngine *e, size_t ch, double t, double x);
+
+// Текущие признаки канала ch
+void features_get(const FeatureEngine *e, size_t ch, FeatureSet *out);
+
+#endif
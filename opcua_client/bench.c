@@ -0,0 +1,433 @@
+/*
+ * bench.c — нагрузочный тест OPC UA сервера: подписки, пропускная способность, задержка
+ * ------------------------------------------------------------------------------------
+ * Открывает K сессий (по потоку на сессию), в каждой — подписку с M MonitoredItems
+ * на заданные узлы, и в течение --duration секунд (после --warmup) считает:
+ *   — уведомления в секунду (всего и на сессию);
+ *   — задержку SourceTimestamp → приём клиентом: p50 / p99 / p999 / max
+ *     (гистограмма с 16 поддиапазонами на октаву, погрешность ~3 %);
+ *   — потерянные уведомления: значения с битом Overflow (очередь MonitoredItem
+ *     переполнилась и сервер выбросил отсчёты) и отключения сессий;
+ *   — CPU и RSS процесса сервера по /proc/<pid> (--pid), если сервер на той же машине.
+ * Результат — один JSON-объект (stdout или --json FILE) для отслеживания регрессий.
+ *
+ * Узлы:
+ *   --nodes a,b,c      строковые NodeId ns=1, item j сессии берёт узел j % количество
+ *                      (по умолчанию узлы dynamic4/dynamic3: equipment.bearing.vibration, ...);
+ *   --fleet N          узлы парка dynamic4 --assets N: equipment.<id>.<тег>, без повторов.
+ *   Для других серверов: dynamic.c — equipment.temperature,equipment.pressure,
+ *   static.c — my.variable.
+ *
+ * Задержка осмысленна только на одной машине (общие часы); через loopback это
+ * время публикации + очередь подписки + доставка.
+ *
+ * Сборка:
+ *   gcc -O2 -pthread bench.c -lopen62541 -o bench
+ *
+ * Запуск:
+ *   ./bench --sessions 8 --items 1000 --fleet 10000 --pid $(pidof dynamic4) --json run.json
+ *   ./bench --url opc.tcp://localhost:4840 --sampling 50 --publish 100 --duration 60
+ */
+#include <open62541/client_config_default.h> // Конфигурация клиента по умолчанию
+#include <open62541/client_highlevel.h>      // UA_Client_connect и т.п.
+#include <open62541/client_subscriptions.h>  // Subscriptions / MonitoredItems
+#include <open62541/plugin/log_stdout.h>     // Лог в stdout
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>                          // sysconf()
+
+#define MAX_SESSIONS   256
+#define MAX_NODES      64
+#define ITEMS_PER_CALL 1000      // MonitoredItems в одном запросе CreateMonitoredItems
+#define HIST_SUB       16        // поддиапазонов на октаву
+#define HIST_BUCKETS   (61 * HIST_SUB)
+
+// Бит Overflow в InfoBits статуса DataValue (Part 4, 7.34.1)
+#define STATUS_OVERFLOW 0x480u
+
+// === Настройки ===
+static const char *opc_url   = "opc.tcp://localhost:4840";
+static int     n_sessions    = 4;
+static size_t  n_items       = 100;       // MonitoredItems на сессию
+static double  sampling_ms   = 100.0;
+static double  publish_ms    = 100.0;
+static UA_UInt32 queue_size  = 10;
+static double  duration_s    = 30.0;
+static double  warmup_s      = 5.0;
+static size_t  fleet_assets  = 0;         // > 0 — узлы equipment.<id>.<тег>
+static long    server_pid    = 0;
+static const char *json_path = NULL;
+static const char *node_ids[MAX_NODES] = {
+    "equipment.bearing.vibration", "equipment.temperature", "equipment.pressure"
+};
+static size_t  n_node_ids    = 3;
+
+// === Состояние сессии (пишет только её поток) ===
+typedef struct {
+    int        index;
+    pthread_t  thread;
+    size_t     itemsOk;
+    uint64_t   notifications;     // за время измерения
+    uint64_t   overflows;
+    uint64_t   negative;          // SourceTimestamp позже приёма (рассинхрон часов)
+    uint64_t   noTimestamp;
+    int        disconnects;
+    int        connected;
+    uint64_t   hist[HIST_BUCKETS]; // задержка, мкс
+} Session;
+
+static Session sessions[MAX_SESSIONS];
+static atomic_int phase_flag;          // 0 — прогрев, 1 — измерение, 2 — стоп
+static volatile sig_atomic_t interrupted = 0;
+
+static void stopHandler(int sig) {
+    interrupted = 1;
+}
+
+// --- Гистограмма: до 16 мкс — точно, дальше 16 поддиапазонов на степень двойки ---
+static unsigned hist_index(uint64_t us) {
+    if (us < HIST_SUB)
+        return (unsigned)us;
+    unsigned e = 63u - (unsigned)__builtin_clzll(us); // e >= 4
+    unsigned idx = (e - 3) * HIST_SUB + (unsigned)((us >> (e - 4)) & (HIST_SUB - 1));
+    return idx < HIST_BUCKETS ? idx : HIST_BUCKETS - 1;
+}
+
+// Середина диапазона корзины, мкс
+static double hist_value(unsigned idx) {
+    if (idx < HIST_SUB)
+        return idx;
+    unsigned e = idx / HIST_SUB + 3, sub = idx % HIST_SUB;
+    double low = (double)((uint64_t)(HIST_SUB + sub) << (e - 4));
+    return low + (double)((uint64_t)1 << (e - 4)) / 2.0;
+}
+
+static double hist_percentile(const uint64_t *h, uint64_t total, double q) {
+    if (total == 0)
+        return 0.0;
+    uint64_t rank = (uint64_t)(q * (double)(total - 1)) + 1, acc = 0;
+    for (unsigned i = 0; i < HIST_BUCKETS; i++) {
+        acc += h[i];
+        if (acc >= rank)
+            return hist_value(i);
+    }
+    return hist_value(HIST_BUCKETS - 1);
+}
+
+// Колбэк уведомления: контекст подписки — Session
+static void onDataChange(UA_Client *client, UA_UInt32 subId, void *subContext,
+                         UA_UInt32 monId, void *monContext, UA_DataValue *value) {
+    Session *s = subContext;
+    if (atomic_load_explicit(&phase_flag, memory_order_relaxed) != 1)
+        return;
+    UA_DateTime now = UA_DateTime_now();
+    s->notifications++;
+    if (value->hasStatus && (value->status & STATUS_OVERFLOW) == STATUS_OVERFLOW)
+        s->overflows++;
+
+    UA_DateTime src = value->hasSourceTimestamp ? value->sourceTimestamp
+                    : value->hasServerTimestamp ? value->serverTimestamp : 0;
+    if (src == 0) {
+        s->noTimestamp++;
+        return;
+    }
+    if (now < src) {
+        s->negative++;
+        src = now;
+    }
+    s->hist[hist_index((uint64_t)((now - src) / UA_DATETIME_USEC))]++;
+}
+
+// Строковый NodeId item j сессии s
+static UA_NodeId item_node(int s, size_t j) {
+    static const char *tags[3] = { "bearing.vibration", "temperature", "pressure" };
+    char buf[128];
+    if (fleet_assets > 0) {
+        size_t k = (size_t)s * n_items + j; // сквозной номер item по всем сессиям
+        snprintf(buf, sizeof(buf), "equipment.%zu.%s", (k / 3) % fleet_assets, tags[k % 3]);
+        return UA_NODEID_STRING_ALLOC(1, buf);
+    }
+    return UA_NODEID_STRING_ALLOC(1, node_ids[j % n_node_ids]);
+}
+
+// Создание MonitoredItems сессии пачками; возвращает число созданных
+static size_t subscribe_items(UA_Client *client, Session *s, UA_UInt32 subId) {
+    UA_MonitoredItemCreateRequest items[ITEMS_PER_CALL];
+    UA_Client_DataChangeNotificationCallback callbacks[ITEMS_PER_CALL];
+    void *contexts[ITEMS_PER_CALL];
+    size_t created = 0;
+
+    for (size_t base = 0; base < n_items; base += ITEMS_PER_CALL) {
+        size_t cnt = n_items - base < ITEMS_PER_CALL ? n_items - base : ITEMS_PER_CALL;
+        for (size_t k = 0; k < cnt; k++) {
+            items[k] = UA_MonitoredItemCreateRequest_default(item_node(s->index, base + k));
+            items[k].requestedParameters.samplingInterval = sampling_ms;
+            items[k].requestedParameters.queueSize = queue_size;
+            items[k].requestedParameters.discardOldest = true;
+            contexts[k] = NULL;
+            callbacks[k] = onDataChange;
+        }
+        UA_CreateMonitoredItemsRequest req;
+        UA_CreateMonitoredItemsRequest_init(&req);
+        req.subscriptionId = subId;
+        req.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+        req.itemsToCreate = items;
+        req.itemsToCreateSize = cnt;
+        UA_CreateMonitoredItemsResponse resp =
+            UA_Client_MonitoredItems_createDataChanges(client, req, contexts, callbacks, NULL);
+        if (resp.responseHeader.serviceResult == UA_STATUSCODE_GOOD)
+            for (size_t k = 0; k < resp.resultsSize; k++)
+                created += resp.results[k].statusCode == UA_STATUSCODE_GOOD;
+        UA_CreateMonitoredItemsResponse_clear(&resp);
+        for (size_t k = 0; k < cnt; k++)
+            UA_NodeId_clear(&items[k].itemToMonitor.nodeId);
+    }
+    return created;
+}
+
+static UA_Client *open_session(Session *s) {
+    UA_ClientConfig cc;
+    memset(&cc, 0, sizeof(cc));
+    cc.logging = UA_Log_Stdout_new(UA_LOGLEVEL_WARNING); // INFO-лог клиента не смешивается с JSON
+    UA_ClientConfig_setDefault(&cc);
+    UA_Client *client = UA_Client_newWithConfig(&cc);
+    if (UA_Client_connect(client, opc_url) != UA_STATUSCODE_GOOD) {
+        UA_Client_delete(client);
+        return NULL;
+    }
+    UA_CreateSubscriptionRequest sreq = UA_CreateSubscriptionRequest_default();
+    sreq.requestedPublishingInterval = publish_ms;
+    sreq.maxNotificationsPerPublish = 0; // без ограничения
+    UA_CreateSubscriptionResponse sresp = UA_Client_Subscriptions_create(client, sreq, s, NULL, NULL);
+    if (sresp.responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+        return NULL;
+    }
+    s->itemsOk = subscribe_items(client, s, sresp.subscriptionId);
+    return client;
+}
+
+// Поток сессии: подключение, подписка, цикл уведомлений до стопа
+static void *session_main(void *arg) {
+    Session *s = arg;
+    UA_Client *client = open_session(s);
+    s->connected = client != NULL;
+    while (client && atomic_load(&phase_flag) != 2) {
+        if (UA_Client_run_iterate(client, 20) != UA_STATUSCODE_GOOD) {
+            s->disconnects++;
+            break;
+        }
+    }
+    if (client) {
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+    }
+    return NULL;
+}
+
+// --- Процесс сервера: CPU (utime + stime, тиков) и RSS (кБ) из /proc ---
+static int proc_cpu_ticks(long pid, uint64_t *ticks) {
+    char path[64], buf[1024];
+    snprintf(path, sizeof(path), "/proc/%ld/stat", pid);
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return 0;
+    size_t len = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    buf[len] = '\0';
+    char *p = strrchr(buf, ')'); // имя процесса может содержать пробелы
+    unsigned long long ut, st;
+    if (!p || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &ut, &st) != 2)
+        return 0;
+    *ticks = ut + st;
+    return 1;
+}
+
+static long proc_rss_kb(long pid) {
+    char path[64], line[256];
+    snprintf(path, sizeof(path), "/proc/%ld/status", pid);
+    FILE *fp = fopen(path, "r");
+    long kb = -1;
+    if (!fp)
+        return -1;
+    while (fgets(line, sizeof(line), fp))
+        if (sscanf(line, "VmRSS: %ld kB", &kb) == 1)
+            break;
+    fclose(fp);
+    return kb;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void sleep_s(double s) {
+    struct timespec ts = { (time_t)s, (long)((s - (time_t)s) * 1e9) };
+    nanosleep(&ts, NULL);
+}
+
+// Строка JSON в кавычках: ", \ и управляющие символы экранируются
+static void json_string(FILE *out, const char *str) {
+    fputc('"', out);
+    for (const unsigned char *p = (const unsigned char *)str; *p; p++) {
+        if (*p == '"' || *p == '\\')
+            fprintf(out, "\\%c", *p);
+        else if (*p < 0x20)
+            fprintf(out, "\\u%04x", *p);
+        else
+            fputc(*p, out);
+    }
+    fputc('"', out);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Использование: %s [параметры]\n"
+            "  --url URL        OPC UA сервер (по умолчанию %s)\n"
+            "  --sessions K     параллельных сессий (1..%d, по умолчанию %d)\n"
+            "  --items M        MonitoredItems на сессию (по умолчанию %zu)\n"
+            "  --nodes A,B,...  строковые NodeId ns=1 (по умолчанию узлы dynamic4)\n"
+            "  --fleet N        узлы парка equipment.<id>.<тег> для dynamic4 --assets N\n"
+            "  --sampling MS    samplingInterval (по умолчанию %.0f)\n"
+            "  --publish MS     publishingInterval (по умолчанию %.0f)\n"
+            "  --queue N        очередь MonitoredItem (по умолчанию %u)\n"
+            "  --duration S     длительность измерения, с (по умолчанию %.0f)\n"
+            "  --warmup S       прогрев без учёта, с (по умолчанию %.0f)\n"
+            "  --pid PID        процесс сервера для CPU/RSS\n"
+            "  --json FILE      куда записать результат (по умолчанию stdout)\n",
+            prog, opc_url, MAX_SESSIONS, n_sessions, n_items, sampling_ms, publish_ms,
+            queue_size, duration_s, warmup_s);
+}
+
+static int parse_nodes(char *list) {
+    n_node_ids = 0;
+    for (char *tok = strtok(list, ","); tok && n_node_ids < MAX_NODES; tok = strtok(NULL, ","))
+        node_ids[n_node_ids++] = tok;
+    return n_node_ids > 0;
+}
+
+static int parse_args(int argc, char **argv) {
+    for (int a = 1; a < argc; a++) {
+        const char *opt = argv[a];
+        if (a + 1 >= argc)
+            return 0;
+        char *val = argv[++a];
+        if (!strcmp(opt, "--url"))            opc_url = val;
+        else if (!strcmp(opt, "--sessions"))  n_sessions = atoi(val);
+        else if (!strcmp(opt, "--items"))     n_items = strtoul(val, NULL, 10);
+        else if (!strcmp(opt, "--nodes"))     { if (!parse_nodes(val)) return 0; }
+        else if (!strcmp(opt, "--fleet"))     fleet_assets = strtoul(val, NULL, 10);
+        else if (!strcmp(opt, "--sampling"))  sampling_ms = strtod(val, NULL);
+        else if (!strcmp(opt, "--publish"))   publish_ms = strtod(val, NULL);
+        else if (!strcmp(opt, "--queue"))     queue_size = (UA_UInt32)strtoul(val, NULL, 10);
+        else if (!strcmp(opt, "--duration"))  duration_s = strtod(val, NULL);
+        else if (!strcmp(opt, "--warmup"))    warmup_s = strtod(val, NULL);
+        else if (!strcmp(opt, "--pid"))       server_pid = strtol(val, NULL, 10);
+        else if (!strcmp(opt, "--json"))      json_path = val;
+        else return 0;
+    }
+    return n_sessions >= 1 && n_sessions <= MAX_SESSIONS && n_items >= 1 &&
+           duration_s > 0 && warmup_s >= 0;
+}
+
+int main(int argc, char **argv) {
+    if (!parse_args(argc, argv)) {
+        usage(argv[0]);
+        return 1;
+    }
+    signal(SIGINT, stopHandler);
+    signal(SIGTERM, stopHandler);
+
+    // --- Сессии ---
+    for (int s = 0; s < n_sessions; s++) {
+        sessions[s].index = s;
+        pthread_create(&sessions[s].thread, NULL, session_main, &sessions[s]);
+    }
+    fprintf(stderr, "⏳ Прогрев %.0f с: %d сессий × %zu MonitoredItems\n", warmup_s, n_sessions, n_items);
+    sleep_s(warmup_s);
+
+    // --- Измерение: раз в секунду — пик RSS сервера ---
+    const long clk = sysconf(_SC_CLK_TCK);
+    uint64_t cpu0 = 0, cpu1 = 0;
+    int haveCpu = server_pid > 0 && proc_cpu_ticks(server_pid, &cpu0);
+    long rssPeak = server_pid > 0 ? proc_rss_kb(server_pid) : -1;
+    double t0 = now_s();
+    atomic_store(&phase_flag, 1);
+    while (!interrupted && now_s() - t0 < duration_s) {
+        sleep_s(duration_s - (now_s() - t0) < 1.0 ? duration_s - (now_s() - t0) : 1.0);
+        long rss = server_pid > 0 ? proc_rss_kb(server_pid) : -1;
+        rssPeak = rss > rssPeak ? rss : rssPeak;
+    }
+    atomic_store(&phase_flag, 2);
+    double elapsed = now_s() - t0;
+    haveCpu = haveCpu && proc_cpu_ticks(server_pid, &cpu1);
+    long rssEnd = server_pid > 0 ? proc_rss_kb(server_pid) : -1;
+    for (int s = 0; s < n_sessions; s++)
+        pthread_join(sessions[s].thread, NULL);
+
+    // --- Сводка по всем сессиям ---
+    static uint64_t hist[HIST_BUCKETS];
+    uint64_t notif = 0, overflows = 0, negative = 0, noTs = 0, samples = 0;
+    size_t itemsOk = 0;
+    int connected = 0, disconnects = 0;
+    double maxLatency = 0;
+    for (int s = 0; s < n_sessions; s++) {
+        const Session *ss = &sessions[s];
+        notif += ss->notifications;
+        overflows += ss->overflows;
+        negative += ss->negative;
+        noTs += ss->noTimestamp;
+        itemsOk += ss->itemsOk;
+        connected += ss->connected;
+        disconnects += ss->disconnects;
+        for (unsigned i = 0; i < HIST_BUCKETS; i++) {
+            hist[i] += ss->hist[i];
+            samples += ss->hist[i];
+            if (ss->hist[i] && hist_value(i) > maxLatency)
+                maxLatency = hist_value(i);
+        }
+    }
+
+    FILE *out = json_path ? fopen(json_path, "w") : stdout;
+    if (!out) {
+        perror(json_path);
+        return 1;
+    }
+    fputs("{\"url\": ", out);
+    json_string(out, opc_url);
+    fprintf(out,
+            ", \"sessions\": %d, \"sessions_connected\": %d, "
+            "\"items_per_session\": %zu, \"items_created\": %zu, "
+            "\"sampling_ms\": %.3f, \"publish_ms\": %.3f, \"queue_size\": %u, "
+            "\"duration_s\": %.3f, \"notifications\": %llu, \"notifications_per_s\": %.1f, "
+            "\"latency_us\": {\"samples\": %llu, \"p50\": %.0f, \"p99\": %.0f, \"p999\": %.0f, \"max\": %.0f}, "
+            "\"dropped\": {\"overflow\": %llu, \"disconnects\": %d}, "
+            "\"clock_skew_samples\": %llu, \"no_timestamp\": %llu, ",
+            n_sessions, connected, n_items, itemsOk, sampling_ms, publish_ms, queue_size,
+            elapsed, (unsigned long long)notif, notif / elapsed,
+            (unsigned long long)samples, hist_percentile(hist, samples, 0.50),
+            hist_percentile(hist, samples, 0.99), hist_percentile(hist, samples, 0.999), maxLatency,
+            (unsigned long long)overflows, disconnects,
+            (unsigned long long)negative, (unsigned long long)noTs);
+    if (server_pid > 0 && haveCpu && rssEnd >= 0)
+        fprintf(out, "\"server\": {\"pid\": %ld, \"cpu_percent\": %.1f, \"rss_kb\": %ld, \"rss_peak_kb\": %ld}}\n",
+                server_pid, 100.0 * (double)(cpu1 - cpu0) / clk / elapsed, rssEnd, rssPeak);
+    else
+        fprintf(out, "\"server\": null}\n");
+    if (json_path)
+        fclose(out);
+
+    fprintf(stderr, "✅ %.0f уведомлений/с, p50 %.0f мкс, p99 %.0f мкс, переполнений %llu\n",
+            notif / elapsed, hist_percentile(hist, samples, 0.50), hist_percentile(hist, samples, 0.99),
+            (unsigned long long)overflows);
+    return connected == n_sessions ? 0 : 2;
+}
@@ -0,0 +1,1520 @@
+/*
+ * collector.c — нативный сборщик телеметрии для dynamic4.c (замена reader4.py)
+ * ---------------------------------------------------------------------------
+ * Вместо опроса узлов каждые 2 с (get_value() × 4 + INSERT одной строки)
+ * сборщик подписывается на узлы ns=1;s=equipment.* через Subscriptions /
+ * MonitoredItems, собирает уведомления в строки и пачками загружает их
+ * в public.sensor_data2 командой COPY ... FROM STDIN (FORMAT binary) через libpq.
+ *
+ * Сборка строки:
+ *   Для каждого агрегата копятся последние значения вибрации, температуры и давления.
+ *   Как только пришли все три — строка уходит в буфер COPY. Если тег приходит
+ *   повторно раньше остальных (очередь MonitoredItem отдала несколько отсчётов),
+ *   текущая строка дописывается последними известными значениями и сбрасывается.
+ *   Тревога пишется сервером только при смене состояния, поэтому в строку
+ *   попадает её последнее значение. ts — наибольшая метка источника в строке.
+ *
+ * Буфер COPY уходит в базу, когда набралось --batch строк или прошло --flush мс.
+ *
+ * Оконные признаки (--features W):
+ *   По каждой собранной строке обновляются признаки последних W строк агрегата
+ *   (ml/window_features.c: rms, peak, crest, kurtosis, ewma, slope по ts) и пишутся
+ *   в ту же строку колонками <тег>_<признак>: vibration_rms, temperature_slope, ...
+ *   Колонки добавляются при старте через ADD COLUMN IF NOT EXISTS.
+ *
+ * Локальное хранилище (--store DIR):
+ *   Каждая строка дополнительно дописывается в сжатые сегменты ml/seg_store.c
+ *   (раздел — сутки, блоки по агрегату, Gorilla-сжатие) — для обучения и оценки
+ *   без выгрузки всей sensor_data2. Недописанные блоки уходят на диск при
+ *   завершении; после аварии теряются только они, сегменты читаются.
+ *
+ * Агрегаты для дашбордов (--rollup):
+ *   Каждая строка сразу добавляется в корзины 1 с, 1 мин и 1 ч своего агрегата
+ *   (rollup.c: count, min, max, avg, last по тегам и число строк с тревогой).
+ *   Закрытые корзины раз в --flush мс уходят бинарным COPY во временную таблицу
+ *   и сливаются в public.sensor_rollup_<1s|1m|1h> через INSERT ... ON CONFLICT:
+ *   корзина, записанная по частям (перезапуск сборщика), складывается в одну строку.
+ *   Корзины затихших агрегатов закрываются по часам с запасом на задержку доставки.
+ *   Запросы дашборда — grafana/rollup_lttb.sql: LTTB по подходящему уровню.
+ *
+ * Потоковая модель тревоги (--online FILE):
+ *   Каждая строка сначала оценивается моделью ../ml/online_model.c (теги и, с --features,
+ *   оконные признаки), затем модель дообучается на её vibration_alarm. Раз в минуту и при
+ *   выходе состояние пишется в FILE (продолжение с него при следующем запуске), а
+ *   precision / recall / F1 последних строк — в public.model_metrics, как ml_evaluate_loop.py.
+ *
+ * Аномалии без учителя (--anomaly):
+ *   Каждая строка оценивается детектором ../ml/anomaly.c (нормировка по агрегату и общий
+ *   для парка лес полупространственных деревьев, O(1) памяти на агрегат и O(деревьев ×
+ *   глубина) на строку), затем он дообучается на ней же — без меток и проходов по
+ *   sensor_data2. В строку пишутся колонки anomaly_score (неожиданность строки в битах:
+ *   выброс вроде перегрева) и anomaly_level (её сглаженное среднее по агрегату: затяжной
+ *   дрейф вроде износа); с --sdt колонки не пишутся. В лог — строки и агрегаты выше
+ *   порогов ANOMALY_*_ALERT.
+ *   Состояние не сохраняется: после запуска ~slow / 2 строк агрегата оценка равна 0.
+ *
+ * Спектр огибающей (--envelope):
+ *   Сборщик подписывается и на полосы огибающей dynamic4 --spectrum
+ *   (equipment[.<id>].bearing.envelope.<ftf|bpfo|bpfi|bsf>, СКЗ в мм/с) и пишет их
+ *   последние значения в колонки envelope_ftf, envelope_bpfo, envelope_bpfi, envelope_bsf.
+ *   Полосы обновляются раз в кадр спектра, а не каждый тик, поэтому, как и тревога,
+ *   строку не завершают; до первого значения колонка — NULL. С --sdt не сочетается.
+ *
+ * Зона нечувствительности (--deadband vibration=0.05,pressure=1%,...):
+ *   MonitoredItem тега создаётся с DataChangeFilter: сервер шлёт значение, только если
+ *   оно ушло от последнего отправленного больше чем на порог — абсолютный или в % от
+ *   EURange узла (у dynamic4 оно есть у вибрации, температуры и давления). Шум ниже
+ *   порога не доходит до сборщика; строка собирается из последних известных значений.
+ *
+ * Сжатие «вращающейся дверью» (--sdt vibration=0.2,temperature=0.5,pressure=0.02):
+ *   Вместо строк sensor_data2 пишутся точки излома каждого тега в public.sensor_sdt
+ *   (ts, asset_id, tag, value; tag 0..2 — вибрация, температура, давление, 3 — тревога),
+ *   sdt.c: отсчёты, лежащие в пределах заданной погрешности от прямой между точками,
+ *   не сохраняются; тревога пишется при смене. Точка тега — не реже раза в --sdt-max с.
+ *   Восстановление — линейная интерполяция (grafana/sdt_interp.sql), отклонение от
+ *   принятого отсчёта не больше погрешности тега. Признаки, агрегаты, сегменты и
+ *   потоковая модель по-прежнему считаются по полным строкам; колонки признаков
+ *   в базу в этом режиме не пишутся.
+ *
+ * Дисковая очередь (--spool FILE, --spool-mb N):
+ *   Основной поток не ходит в базу: пачки строк, корзин и метрик дописываются в кольцевой
+ *   файл spool.c (mmap, CRC записей, место выделено сразу — не больше N МБ), а поток
+ *   выгрузки переносит их в базу большими COPY (до 32 МБ). Перезапуск или медленный ответ
+ *   PostgreSQL не тормозит приём: очередь копится на диске, соединение восстанавливается
+ *   с паузой 1..30 с, и накопленное уходит по порядку. Пачку, которую база отвергает при
+ *   живом соединении (3 попытки), поток пропускает с сообщением. Переполненная очередь
+ *   отклоняет новые строки (считаются потерянными), а не затирает старые. Доставка —
+ *   не менее одного раза: после аварии последняя пачка может записаться повторно.
+ *   Очередь переживает перезапуск сборщика; перед сменой --assets/--features/--sdt/--trace/--anomaly/--envelope её
+ *   стоит выгрузить — строки старого формата база не примет.
+ *
+ * Трассировка задержки (--trace):
+ *   Сборщик подписывается и на diagnostics.trace сервера (номер тика, начало генерации и
+ *   конец публикации по CLOCK_MONOTONIC) и запоминает последние тики по их метке источника.
+ *   При отправке буфера строка находит свой тик по ts и получает колонки seq (номер тика)
+ *   и gen_ns (начало генерации); 0 — тик не пришёл (счётчик «без тика»). Раз в 10 с в лог
+ *   идут квантили возраста тика на этапах: публикация (сервер), приём (уведомление трассы
+ *   дошло до сборщика), запись (база подтвердила COPY строки; с --spool — из потока
+ *   выгрузки), а также пропуски и повторы номеров тиков — в потоке трассы и в строках
+ *   агрегата. Прогноз — этап ml/predictor_loop.py (age_ms в sensor_predictions). Все этапы
+ *   меряют одни часы, поэтому сервер, сборщик и прогноз должны работать на одном хосте.
+ *   С --sdt не сочетается: точки излома не привязаны к тикам.
+ *
+ * Сборка:
+ *   gcc -O2 collector.c rollup.c spool.c sdt.c ../open62541/perf_timer.c ../ml/window_features.c ../ml/seg_store.c ../ml/online_model.c ../ml/anomaly.c -I/usr/include/postgresql -lopen62541 -lpq -lm -pthread -o collector
+ *
+ * Запуск:
+ *   ./collector                                # один агрегат, узлы equipment.*
+ *   ./collector --assets 10000 --batch 20000   # парк dynamic4 --assets 10000
+ *   ./collector --features 60                  # + признаки за последние 60 строк
+ *   ./collector --store ../data/store          # + копия строк в сегменты для ML
+ *   ./collector --assets 10000 --rollup        # + агрегаты 1 с / 1 мин / 1 ч для Grafana
+ *   ./collector --features 60 --online ../data/alarm.olm  # + дообучение модели тревоги
+ *   ./collector --assets 10000 --anomaly     # + оценка аномалий по каждой строке
+ *   ./collector --assets 1000 --envelope     # + полосы огибающей dynamic4 --spectrum
+ *   ./collector --assets 10000 --spool /var/lib/collector/spool --spool-mb 4096  # через очередь
+ *   ./collector --deadband pressure=0.005 --sdt vibration=0.2,temperature=0.5,pressure=0.02
+ *   ./collector --trace                        # + seq/gen_ns в строках и задержки по этапам
+ *
+ * В режиме парка в таблицу добавляется колонка asset_id:
+ *   ALTER TABLE public.sensor_data2 ADD COLUMN IF NOT EXISTS asset_id INTEGER;
+ */
+#include <open62541/client_config_default.h> // Конфигурация клиента по умолчанию
+#include <open62541/client_highlevel.h>      // UA_Client_connect и т.п.
+#include <open62541/client_subscriptions.h>  // Subscriptions / MonitoredItems
+#include <open62541/plugin/log_stdout.h>     // Лог в stdout
+#include <libpq-fe.h>                        // Клиент PostgreSQL
+#include <endian.h>                          // htobe16/32/64 для бинарного COPY
+#include <errno.h>
+#include <math.h>                            // NAN — полоса огибающей ещё не пришла
+#include <pthread.h>                         // Поток выгрузки очереди
+#include <signal.h>                          // Обработка Ctrl+C
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>                            // clock_gettime()
+#include "../ml/window_features.h"           // Оконные признаки rms/kurtosis/...
+#include "../ml/seg_store.h"                 // Локальное хранилище сегментов
+#include "rollup.h"                          // Агрегаты 1 с / 1 мин / 1 ч
+#include "../ml/online_model.h"              // Потоковая модель тревоги
+#include "../ml/anomaly.h"                   // Детектор аномалий без учителя
+#include "spool.h"                           // Дисковая очередь store-and-forward
+#include "sdt.h"                             // Сжатие «вращающейся дверью»
+#include "../open62541/perf_timer.h"         // Гистограммы задержек (--trace)
+
+#define MAX_ASSETS       100000
+#define ITEMS_PER_CALL   1000      // MonitoredItems в одном запросе CreateMonitoredItems
+#define ROW_BYTES_MAX    88        // размер строки бинарного COPY с asset_id и seq/gen_ns, без признаков
+#define ROLLUP_ROW_BYTES (2 + 2 * 12 + 2 * 8 + ROLLUP_TAGS * 4 * 12) // строка корзины в COPY
+#define FEATURE_TAGS     3         // теги с признаками: вибрация, температура, давление
+#define MAX_FEATURE_WINDOW 86400
+#define PG_EPOCH_USEC    946684800000000LL // 2000-01-01 в микросекундах Unix-времени
+#define COPY_HEADER      19        // сигнатура, флаги и длина расширения бинарного COPY
+#define SDT_POINT_BYTES  (2 + 12 + 8 + 6 + 12)  // точка sensor_sdt в COPY
+#define SDT_TAG_ALARM    3         // tag тревоги в sensor_sdt
+
+// Теги агрегата; номер тега — младшие биты контекста MonitoredItem
+enum { TAG_VIB = 0, TAG_TEMP, TAG_PRESS, TAG_ALARM, TAG_COUNT };
+#define HAVE_ALL ((1u << TAG_VIB) | (1u << TAG_TEMP) | (1u << TAG_PRESS))
+#define ENVELOPE_BANDS 4           // полосы огибающей dynamic4: ftf, bpfo, bpfi, bsf
+
+// === Настройки (заполняются из командной строки) ===
+static const char *opc_url  = "opc.tcp://localhost:4840";
+static const char *db_conninfo =
+    "dbname=postgres user=postgres password=postgres host=localhost port=5432";
+static size_t  n_assets     = 1;       // число агрегатов
+static int     fleet_mode   = 0;       // узлы equipment.<id>.* вместо equipment.*
+static size_t  batch_rows   = 10000;   // строк в одном COPY
+static double  flush_ms     = 1000.0;  // максимальная задержка строки в буфере
+static double  sampling_ms  = 100.0;   // samplingInterval MonitoredItem
+static double  publish_ms   = 500.0;   // publishingInterval подписки
+static UA_UInt32 queue_size = 32;      // очередь отсчётов на MonitoredItem
+static size_t  feat_window  = 0;       // окно признаков, строк; 0 — без признаков
+static const char *store_dir = NULL;   // каталог сегментов (--store), NULL — не писать
+static int     rollup_mode  = 0;       // агрегаты в sensor_rollup_* (--rollup)
+static const char *online_path = NULL; // контрольная точка потоковой модели (--online)
+static const char *spool_path = NULL;  // дисковая очередь (--spool), NULL — COPY напрямую
+static uint64_t spool_mb    = 1024;    // ёмкость очереди, МБ
+static UA_UInt32 deadband_type[FEATURE_TAGS];  // UA_DEADBANDTYPE_* по тегам (--deadband)
+static double  deadband_value[FEATURE_TAGS];
+static int     sdt_mode     = 0;       // точки излома в sensor_sdt вместо строк (--sdt)
+static double  sdt_dev[SDT_TAGS];      // погрешность тегов
+static double  sdt_max_s    = 600.0;   // наибольший интервал между точками тега, с
+static int     trace_mode   = 0;       // seq/gen_ns в строках и задержки по этапам (--trace)
+static int     anomaly_mode = 0;       // anomaly_score/anomaly_level в строках (--anomaly)
+static int     envelope_mode = 0;      // полосы огибающей в строках (--envelope)
+
+static const char *const feat_tags[FEATURE_TAGS] = { "vibration", "temperature", "pressure" };
+static const char *const envelope_bands[ENVELOPE_BANDS] = { "ftf", "bpfo", "bpfi", "bsf" };
+
+// === Последние значения агрегатов (struct-of-arrays) ===
+static double      *cur_vib, *cur_temp, *cur_press;
+static uint8_t     *cur_alarm;
+static UA_DateTime *cur_ts;            // наибольшая метка источника текущей строки
+static uint8_t     *have;              // какие теги уже пришли в текущую строку
+static double      *cur_env;           // [i * ENVELOPE_BANDS + f] полосы огибающей, NAN — ещё не было
+
+// === Буферы бинарного COPY ===
+typedef struct {
+    char   *data;
+    size_t  len, cap;
+    size_t  rows;
+} CopyBuf;
+
+static CopyBuf copy;                   // строки sensor_data2
+static PGconn *pg;
+static char    copy_sql[1024];         // COPY ... FROM STDIN со списком колонок
+
+// === Агрегаты (--rollup): буфер и запросы на уровень ===
+static Rollup *rollup;
+static CopyBuf rollup_buf[ROLLUP_LEVELS];
+static char    rollup_copy_sql[ROLLUP_LEVELS][128];  // COPY во временную таблицу
+static char    rollup_merge_sql[ROLLUP_LEVELS][2048]; // слияние в sensor_rollup_<уровень>
+static int     rollup_stage_ready;     // временные таблицы есть в текущем соединении
+
+// === Оконные признаки (--features), канал агрегата i, тега c — i * FEATURE_TAGS + c ===
+static FeatureEngine *features;
+
+// === Хранилище сегментов (--store) ===
+static SegWriter *store;
+
+// === Потоковая модель тревоги (--online) ===
+#define ONLINE_CHECKPOINT_MS 60000.0
+static OnlineModel *online;
+
+// === Детектор аномалий (--anomaly) ===
+static AnomalyDetector *anomaly;
+static uint8_t  *anomaly_high;         // уровень агрегата выше ANOMALY_LEVEL_ALERT
+static uint64_t  stat_anomaly_rows;    // строк с оценкой выше ANOMALY_SCORE_ALERT
+static uint64_t  stat_anomaly_assets;  // переходов уровня агрегата через ANOMALY_LEVEL_ALERT
+static size_t    anomaly_assets_high;  // агрегатов с уровнем выше порога сейчас
+
+// === Сжатие (--sdt) ===
+static Sdt     *sdt;
+static uint8_t *sdt_alarm;             // последнее записанное состояние тревоги, 0xFF — не было
+
+// === Трассировка задержки (--trace) ===
+#define TRACE_RING    4096             // последних тиков сервера для поиска тика строки
+#define ROW_TS_OFF    6                // ts в строке COPY: после числа колонок и длины поля
+#define ROW_SEQ_OFF   (ROW_TS_OFF + 12)
+#define ROW_GEN_OFF   (ROW_SEQ_OFF + 12)
+#define ROW_ASSET_OFF (ROW_GEN_OFF + 8 + 3 * 12 + 5 + 4) // asset_id — после тегов и тревоги
+typedef struct {
+    uint64_t seq;                      // номер тика
+    int64_t  ts;                       // метка источника тика — в шкале ts строки COPY
+    uint64_t gen_ns;                   // начало генерации, CLOCK_MONOTONIC нс
+} TraceTick;
+static TraceTick trace_ring[TRACE_RING];
+static uint64_t  trace_pos;            // тиков принято всего; новейший — trace_pos - 1
+static uint64_t *trace_seq;            // последний тик в строке агрегата
+static PerfHist  hist_publish, hist_collect, hist_commit; // возраст тика на этапе, нс
+static pthread_mutex_t hist_commit_lock = PTHREAD_MUTEX_INITIALIZER; // запись отмечает и поток выгрузки
+static uint64_t  stat_tick_gaps, stat_tick_dups;          // в потоке трассы
+static uint64_t  stat_row_gaps, stat_row_dups, stat_untraced; // в строках агрегатов
+
+// === Дисковая очередь (--spool): основной поток пишет, поток выгрузки читает и владеет pg ===
+#define SPOOL_ROWS         0                              // строки sensor_data2
+#define SPOOL_ROLLUP       1                              // корзины уровня (вид - SPOOL_ROLLUP)
+#define SPOOL_SQL          (SPOOL_ROLLUP + ROLLUP_LEVELS) // запрос с завершающим нулём
+#define DRAIN_RECORDS      4096
+#define DRAIN_BATCH_BYTES  (32u << 20)   // данных в одном COPY выгрузки
+#define DRAIN_RETRIES      3             // отказов пачки при живом соединении до её пропуска
+#define DRAIN_EXIT_MS      5000.0        // выгрузка при завершении; остальное — при следующем запуске
+static Spool     *spool;
+static pthread_t  drain_tid;
+static atomic_int drain_stop, db_up;
+
+// === Статистика ===
+static uint64_t stat_samples, stat_rows, stat_flushes, stat_dropped;
+static uint64_t stat_rollup_rows, stat_rollup_dropped;
+static _Atomic uint64_t stat_drained, stat_poisoned; // строк выгружено / пропущено потоком выгрузки
+static uint64_t stat_sdt_rows;         // строк, прошедших через сжатие
+
+static volatile sig_atomic_t running = 1;
+
+static void stopHandler(int sig) {
+    running = 0;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Настенное время, мкс Unix — в той же шкале, что метки строк
+static int64_t unix_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// --- Запись полей бинарного COPY (сетевой порядок байт) ---
+static inline void put_i16(CopyBuf *b, int16_t v) {
+    uint16_t x = htobe16((uint16_t)v);
+    memcpy(b->data + b->len, &x, 2); b->len += 2;
+}
+static inline void put_i32(CopyBuf *b, int32_t v) {
+    uint32_t x = htobe32((uint32_t)v);
+    memcpy(b->data + b->len, &x, 4); b->len += 4;
+}
+static inline void put_i64(CopyBuf *b, int64_t v) {
+    uint64_t x = htobe64((uint64_t)v);
+    memcpy(b->data + b->len, &x, 8); b->len += 8;
+}
+static inline void put_f64(CopyBuf *b, double v) {
+    uint64_t u;
+    memcpy(&u, &v, 8);
+    put_i64(b, (int64_t)u);
+}
+
+// Заголовок бинарного COPY: сигнатура, флаги, длина расширения
+static void copy_begin(CopyBuf *b) {
+    static const char sig[11] = "PGCOPY\n\377\r\n\0";
+    memcpy(b->data, sig, 11);
+    b->len = 11;
+    put_i32(b, 0);
+    put_i32(b, 0);
+    b->rows = 0;
+}
+
+// Место ещё под bytes байт (буферы агрегатов растут, буфер строк выделен под --batch)
+static int copy_reserve(CopyBuf *b, size_t bytes) {
+    if (b->len + bytes + 2 <= b->cap) // +2 — признак конца данных
+        return 1;
+    size_t cap = (b->cap ? b->cap * 2 : 65536) + bytes;
+    char *grown = realloc(b->data, cap);
+    if (!grown)
+        return 0;
+    b->data = grown;
+    b->cap = cap;
+    return 1;
+}
+
+// UA_DateTime (100 нс от 1601 г.) → timestamptz (мкс от 2000 г.)
+static inline int64_t to_pg_ts(UA_DateTime dt) {
+    return (dt - UA_DATETIME_UNIX_EPOCH) / UA_DATETIME_USEC - PG_EPOCH_USEC;
+}
+
+// Закрытая корзина → буфер COPY своего уровня; порядок колонок — как в prepare_rollups()
+static void emit_rollup(void *ctx, unsigned level, const RollupRow *row) {
+    CopyBuf *b = &rollup_buf[level];
+    if (!copy_reserve(b, ROLLUP_ROW_BYTES)) {
+        stat_rollup_dropped++;
+        return;
+    }
+    put_i16(b, 4 + ROLLUP_TAGS * 4);
+    put_i32(b, 8); put_i64(b, row->bucket - PG_EPOCH_USEC);
+    put_i32(b, 4); put_i32(b, (int32_t)row->asset);
+    put_i32(b, 4); put_i32(b, (int32_t)row->n);
+    put_i32(b, 4); put_i32(b, (int32_t)row->alarms);
+    for (int t = 0; t < ROLLUP_TAGS; t++) {
+        put_i32(b, 8); put_f64(b, row->min[t]);
+        put_i32(b, 8); put_f64(b, row->max[t]);
+        put_i32(b, 8); put_f64(b, row->avg[t]);
+        put_i32(b, 8); put_f64(b, row->last[t]);
+    }
+    b->rows++;
+}
+
+// Точка излома тега → буфер COPY sensor_sdt (ts, asset_id, tag, value); буфер при нужде растёт
+static void emit_sdt_point(void *ctx, size_t asset, unsigned tag, int64_t ts, double v) {
+    CopyBuf *b = &copy;
+    if (!copy_reserve(b, SDT_POINT_BYTES)) {
+        stat_dropped++;
+        return;
+    }
+    put_i16(b, 4);
+    put_i32(b, 8); put_i64(b, ts - PG_EPOCH_USEC);
+    put_i32(b, 4); put_i32(b, (int32_t)asset);
+    put_i32(b, 2); put_i16(b, (int16_t)tag);
+    put_i32(b, 8); put_f64(b, v);
+    b->rows++;
+}
+
+// Строка агрегата i → буфер COPY (с --sdt — в сжатие, в буфер уходят только точки излома)
+static void emit_row(size_t i) {
+    CopyBuf *b = &copy;
+    const int64_t ts_us = (cur_ts[i] - UA_DATETIME_UNIX_EPOCH) / UA_DATETIME_USEC;
+    FeatureSet fs[FEATURE_TAGS];
+    if (features) {
+        const double t = (double)(cur_ts[i] - UA_DATETIME_UNIX_EPOCH) / UA_DATETIME_SEC;
+        const double x[FEATURE_TAGS] = { cur_vib[i], cur_temp[i], cur_press[i] };
+        for (size_t c = 0; c < FEATURE_TAGS; c++) {
+            features_push(features, i * FEATURE_TAGS + c, t, x[c]);
+            features_get(features, i * FEATURE_TAGS + c, &fs[c]);
+        }
+    }
+    if (sdt) {
+        const double v[SDT_TAGS] = { cur_vib[i], cur_temp[i], cur_press[i] };
+        sdt_add(sdt, i, ts_us, v, emit_sdt_point, NULL);
+        if (sdt_alarm[i] != cur_alarm[i]) { // тревога — ступенька, пишется при смене
+            emit_sdt_point(NULL, i, SDT_TAG_ALARM, ts_us, cur_alarm[i]);
+            sdt_alarm[i] = cur_alarm[i];
+        }
+        stat_sdt_rows++;
+    }
+    double score = 0.0;
+    AnomalyInfo ai = { 0 };
+    if (anomaly) {
+        const double x[ANOMALY_TAGS] = { cur_vib[i], cur_temp[i], cur_press[i] };
+        score = anomaly_update(anomaly, i, x, &ai);
+        stat_anomaly_rows += score >= ANOMALY_SCORE_ALERT;
+        const uint8_t high = ai.level >= ANOMALY_LEVEL_ALERT;
+        if (high != anomaly_high[i]) {
+            stat_anomaly_assets += high;
+            anomaly_assets_high += high ? 1 : (size_t)-1;
+            anomaly_high[i] = high;
+        }
+    }
+    if (!sdt) {
+        put_i16(b, (fleet_mode ? 6 : 5) + (trace_mode ? 2 : 0) + (features ? FEATURE_TAGS * FEATURE_COUNT : 0) +
+                   (anomaly ? 2 : 0) + (cur_env ? ENVELOPE_BANDS : 0));
+        put_i32(b, 8); put_i64(b, to_pg_ts(cur_ts[i]));
+        if (trace_mode) { // тик строки — при отправке буфера, trace_patch()
+            put_i32(b, 8); put_i64(b, 0);
+            put_i32(b, 8); put_i64(b, 0);
+        }
+        put_i32(b, 8); put_f64(b, cur_vib[i]);
+        put_i32(b, 8); put_f64(b, cur_temp[i]);
+        put_i32(b, 8); put_f64(b, cur_press[i]);
+        put_i32(b, 1); b->data[b->len++] = (char)cur_alarm[i];
+        if (fleet_mode) { put_i32(b, 4); put_i32(b, (int32_t)i); }
+        for (size_t c = 0; features && c < FEATURE_TAGS; c++) {
+            put_i32(b, 8); put_f64(b, fs[c].rms);
+            put_i32(b, 8); put_f64(b, fs[c].peak);
+            put_i32(b, 8); put_f64(b, fs[c].crest);
+            put_i32(b, 8); put_f64(b, fs[c].kurtosis);
+            put_i32(b, 8); put_f64(b, fs[c].ewma);
+            put_i32(b, 8); put_f64(b, fs[c].slope);
+        }
+        if (anomaly) {
+            put_i32(b, 8); put_f64(b, score);
+            put_i32(b, 8); put_f64(b, ai.level);
+        }
+        for (size_t f = 0; cur_env && f < ENVELOPE_BANDS; f++) {
+            const double v = cur_env[i * ENVELOPE_BANDS + f];
+            if (isnan(v)) {
+                put_i32(b, -1); // NULL: кадр спектра ещё не пришёл
+            } else {
+                put_i32(b, 8); put_f64(b, v);
+            }
+        }
+        b->rows++;
+    }
+    if (online) {
+        double x[OLM_ROW_FEATURES];
+        olm_row(cur_vib[i], cur_temp[i], cur_press[i], features ? fs : NULL, x);
+        olm_learn(online, x, cur_alarm[i]);
+    }
+    if (store && seg_writer_append(store, (uint32_t)i, ts_us, cur_vib[i], cur_temp[i], cur_press[i],
+                                   cur_alarm[i]) != 0) {
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                     "Запись в %s не удалась, хранилище отключено", store_dir);
+        seg_writer_close(store);
+        store = NULL;
+    }
+    if (rollup) {
+        const double v[ROLLUP_TAGS] = { cur_vib[i], cur_temp[i], cur_press[i] };
+        rollup_add(rollup, i, ts_us, v, cur_alarm[i], emit_rollup, NULL);
+    }
+    have[i] = 0;
+    cur_ts[i] = 0;
+}
+
+// Буфер b — одной командой COPY (sql); 1 — успех. Буфер начинается заново
+static int copy_send(const char *sql, CopyBuf *b) {
+    put_i16(b, -1); // признак конца данных
+
+    int ok = 0;
+    PGresult *res = PQexec(pg, sql);
+    if (PQresultStatus(res) == PGRES_COPY_IN) {
+        PQclear(res);
+        if (PQputCopyData(pg, b->data, (int)b->len) == 1 && PQputCopyEnd(pg, NULL) == 1) {
+            res = PQgetResult(pg);
+            ok = (PQresultStatus(res) == PGRES_COMMAND_OK);
+        } else {
+            res = PQgetResult(pg);
+        }
+    }
+    if (!ok)
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                     "COPY не выполнен (%zu строк потеряно): %s", b->rows, PQerrorMessage(pg));
+    PQclear(res);
+    while ((res = PQgetResult(pg)) != NULL)
+        PQclear(res);
+    if (PQstatus(pg) != CONNECTION_OK) {
+        PQreset(pg);
+        rollup_stage_ready = 0; // временные таблицы пропали вместе с соединением
+    }
+    copy_begin(b);
+    return ok;
+}
+
+// Буфер b → записи очереди вида kind: строки без заголовка COPY, частями не длиннее
+// записи очереди (строки одного буфера — одной длины). Возвращает строк в очереди
+static size_t spool_put(uint32_t kind, CopyBuf *b) {
+    const size_t rows = b->rows, row = (b->len - COPY_HEADER) / rows;
+    const size_t per = spool_max_record(spool) / row;
+    size_t done = 0;
+    while (done < rows) {
+        const size_t n = rows - done < per ? rows - done : per;
+        if (spool_append(spool, kind, b->data + COPY_HEADER + done * row, n * row, (uint32_t)n) != 0)
+            break; // очередь полна — строки отклоняются, накопленное не затирается
+        done += n;
+    }
+    copy_begin(b);
+    return done;
+}
+
+// Тик с меткой источника ts (в шкале строки COPY) среди последних TRACE_RING или NULL
+static const TraceTick *trace_find(int64_t ts) {
+    const uint64_t oldest = trace_pos > TRACE_RING ? trace_pos - TRACE_RING : 0;
+    for (uint64_t k = trace_pos; k > oldest; k--) { // строки обычно из последних тиков
+        const TraceTick *t = &trace_ring[(k - 1) % TRACE_RING];
+        if (t->ts == ts)
+            return t;
+        if (t->ts < ts)
+            return NULL;
+    }
+    return NULL;
+}
+
+// --- Чтение полей строки COPY ---
+static inline int32_t get_i32(const char *p) {
+    uint32_t x;
+    memcpy(&x, p, 4);
+    return (int32_t)be32toh(x);
+}
+static inline int64_t get_i64(const char *p) {
+    uint64_t x;
+    memcpy(&x, p, 8);
+    return (int64_t)be64toh(x);
+}
+
+// Номер и начало генерации тика — в строки буфера: к отправке тик строки обычно уже пришёл,
+// хотя в уведомлении он может идти после её тегов. Заодно — пропуски и повторы по агрегату
+static void trace_patch(CopyBuf *b) {
+    const size_t row = (b->len - COPY_HEADER) / b->rows;
+    for (size_t r = 0; r < b->rows; r++) {
+        char *p = b->data + COPY_HEADER + r * row;
+        const TraceTick *t = trace_find(get_i64(p + ROW_TS_OFF));
+        if (!t) {
+            stat_untraced++;
+            continue;
+        }
+        const uint64_t seq = htobe64(t->seq), gen = htobe64(t->gen_ns);
+        memcpy(p + ROW_SEQ_OFF, &seq, 8);
+        memcpy(p + ROW_GEN_OFF, &gen, 8);
+        const size_t i = fleet_mode ? (uint32_t)get_i32(p + ROW_ASSET_OFF) : 0;
+        if (i >= n_assets)
+            continue;
+        if (trace_seq[i] && t->seq == trace_seq[i])
+            stat_row_dups++;  // строка разбита повторным отсчётом тега
+        else if (trace_seq[i] && t->seq > trace_seq[i] + 1)
+            stat_row_gaps += t->seq - trace_seq[i] - 1; // с --deadband тики без изменений — норма
+        trace_seq[i] = t->seq;
+    }
+}
+
+// Возраст тика строк на записи в базу: rows строк по row байт подтверждены
+static void trace_commit(const char *data, size_t rows, size_t row) {
+    const uint64_t now = mono_ns();
+    pthread_mutex_lock(&hist_commit_lock);
+    for (size_t r = 0; r < rows; r++) {
+        const uint64_t gen = (uint64_t)get_i64(data + r * row + ROW_GEN_OFF);
+        if (gen && gen <= now)
+            perf_hist_add(&hist_commit, now - gen);
+    }
+    pthread_mutex_unlock(&hist_commit_lock);
+}
+
+// Отправка накопленного буфера строк
+static void flush_copy(void) {
+    if (copy.rows == 0)
+        return;
+    size_t rows = copy.rows;
+    if (trace_mode)
+        trace_patch(&copy);
+    if (spool) {
+        const size_t queued = spool_put(SPOOL_ROWS, &copy);
+        stat_rows += queued;
+        stat_dropped += rows - queued;
+        stat_flushes++;
+        return;
+    }
+    const size_t row = (copy.len - COPY_HEADER) / rows;
+    if (copy_send(copy_sql, &copy)) {
+        stat_rows += rows;
+        stat_flushes++;
+        if (trace_mode) // данные буфера целы до следующей строки
+            trace_commit(copy.data + COPY_HEADER, rows, row);
+    } else {
+        stat_dropped += rows;
+    }
+}
+
+// Временные таблицы для COPY корзин (живут до конца соединения)
+static int prepare_rollup_stage(void) {
+    for (int l = 0; l < ROLLUP_LEVELS; l++) {
+        char sql[256];
+        snprintf(sql, sizeof(sql),
+                 "CREATE TEMP TABLE IF NOT EXISTS rollup_stage_%s (LIKE public.sensor_rollup_%s)",
+                 rollup_suffix[l], rollup_suffix[l]);
+        PGresult *res = PQexec(pg, sql);
+        int ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+        PQclear(res);
+        if (!ok)
+            return 0;
+    }
+    return rollup_stage_ready = 1;
+}
+
+// Закрытые корзины: COPY во временную таблицу и слияние с уже записанными
+static void flush_rollup(void) {
+    if (spool) {
+        for (int l = 0; l < ROLLUP_LEVELS; l++) {
+            const size_t rows = rollup_buf[l].rows;
+            if (rows == 0)
+                continue;
+            const size_t queued = spool_put(SPOOL_ROLLUP + l, &rollup_buf[l]);
+            stat_rollup_rows += queued;
+            stat_rollup_dropped += rows - queued;
+        }
+        return;
+    }
+    if (!rollup_stage_ready && !prepare_rollup_stage()) {
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                     "Временные таблицы агрегатов: %s", PQerrorMessage(pg));
+        for (int l = 0; l < ROLLUP_LEVELS; l++) {
+            stat_rollup_dropped += rollup_buf[l].rows;
+            copy_begin(&rollup_buf[l]);
+        }
+        if (PQstatus(pg) != CONNECTION_OK)
+            PQreset(pg);
+        return;
+    }
+    for (int l = 0; l < ROLLUP_LEVELS; l++) {
+        size_t rows = rollup_buf[l].rows;
+        if (rows == 0)
+            continue;
+        int ok = copy_send(rollup_copy_sql[l], &rollup_buf[l]);
+        if (ok) {
+            PGresult *res = PQexec(pg, rollup_merge_sql[l]);
+            ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+            if (!ok)
+                UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                             "Слияние sensor_rollup_%s: %s", rollup_suffix[l], PQerrorMessage(pg));
+            PQclear(res);
+        }
+        if (ok) {
+            stat_rollup_rows += rows;
+        } else {
+            stat_rollup_dropped += rows;
+            rollup_stage_ready = 0; // пересоздать и очистить временные таблицы
+            PQclear(PQexec(pg, "DISCARD TEMP"));
+        }
+    }
+}
+
+// Таблицы агрегатов и запросы слияния: повторная корзина (запись по частям,
+// перезапуск сборщика) складывается с записанной — count и тревоги суммой,
+// min/max — LEAST/GREATEST, avg — взвешенно по count, last — из новой части
+static void prepare_rollups(void) {
+    static const char *tags[ROLLUP_TAGS] = { "vibration", "temperature", "pressure" };
+    for (int l = 0; l < ROLLUP_LEVELS; l++) {
+        const char *sfx = rollup_suffix[l];
+        char create[2048], cols[1024] = "", merge[1024] = "";
+        size_t clen = 0, mlen = 0;
+        for (int t = 0; t < ROLLUP_TAGS; t++) {
+            const char *g = tags[t];
+            clen += (size_t)snprintf(cols + clen, sizeof(cols) - clen,
+                ", %s_min DOUBLE PRECISION, %s_max DOUBLE PRECISION,"
+                " %s_avg DOUBLE PRECISION, %s_last DOUBLE PRECISION", g, g, g, g);
+            mlen += (size_t)snprintf(merge + mlen, sizeof(merge) - mlen,
+                ", %s_min = LEAST(r.%s_min, excluded.%s_min)"
+                ", %s_max = GREATEST(r.%s_max, excluded.%s_max)"
+                ", %s_avg = (r.%s_avg * r.n + excluded.%s_avg * excluded.n) / (r.n + excluded.n)"
+                ", %s_last = excluded.%s_last",
+                g, g, g, g, g, g, g, g, g, g, g);
+        }
+        snprintf(create, sizeof(create),
+                 "CREATE TABLE IF NOT EXISTS public.sensor_rollup_%s ("
+                 " bucket TIMESTAMPTZ NOT NULL, asset_id INTEGER NOT NULL,"
+                 " n INTEGER NOT NULL, alarm_count INTEGER NOT NULL%s,"
+                 " PRIMARY KEY (asset_id, bucket))", sfx, cols);
+        PQclear(PQexec(pg, create));
+        snprintf(rollup_copy_sql[l], sizeof(rollup_copy_sql[l]),
+                 "COPY rollup_stage_%s FROM STDIN (FORMAT binary)", sfx);
+        snprintf(rollup_merge_sql[l], sizeof(rollup_merge_sql[l]),
+                 "INSERT INTO public.sensor_rollup_%s AS r SELECT * FROM rollup_stage_%s"
+                 " ON CONFLICT (asset_id, bucket) DO UPDATE SET"
+                 " n = r.n + excluded.n, alarm_count = r.alarm_count + excluded.alarm_count%s;"
+                 " TRUNCATE rollup_stage_%s", sfx, sfx, merge, sfx);
+    }
+    prepare_rollup_stage();
+}
+
+// Контрольная точка потоковой модели и метрики последних строк в model_metrics
+static void checkpoint_online(void) {
+    if (olm_save(online, online_path) != 0)
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                     "Контрольная точка %s: %s", online_path, strerror(errno));
+    OlmMetrics mt;
+    olm_metrics(online, 1, &mt);
+    char sql[256];
+    snprintf(sql, sizeof(sql),
+             "INSERT INTO public.model_metrics (ts, precision, recall, f1) VALUES (now(), %.6f, %.6f, %.6f)",
+             mt.precision, mt.recall, mt.f1);
+    if (spool)
+        spool_append(spool, SPOOL_SQL, sql, strlen(sql) + 1, 0); // полная очередь — метрика пропускается
+    else
+        PQclear(PQexec(pg, sql));
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                "Модель: строк %llu  P/R/F1 %.3f / %.3f / %.3f",
+                (unsigned long long)olm_samples(online), mt.precision, mt.recall, mt.f1);
+}
+
+// Текст COPY и колонки признаков: порядок колонок совпадает с emit_row() (с --sdt — с emit_sdt_point())
+static void prepare_schema(void) {
+    if (sdt_mode) {
+        snprintf(copy_sql, sizeof(copy_sql),
+                 "COPY public.sensor_sdt (ts, asset_id, tag, value) FROM STDIN (FORMAT binary)");
+        PQclear(PQexec(pg,
+            "CREATE TABLE IF NOT EXISTS public.sensor_sdt ("
+            " ts TIMESTAMPTZ NOT NULL, asset_id INTEGER NOT NULL, tag SMALLINT NOT NULL,"
+            " value DOUBLE PRECISION NOT NULL)"));
+        PQclear(PQexec(pg,
+            "CREATE INDEX IF NOT EXISTS sensor_sdt_asset_tag_ts ON public.sensor_sdt (asset_id, tag, ts)"));
+    } else {
+        size_t len = (size_t)snprintf(copy_sql, sizeof(copy_sql),
+            "COPY public.sensor_data2 (ts%s, vibration, temperature, pressure, vibration_alarm%s",
+            trace_mode ? ", seq, gen_ns" : "", fleet_mode ? ", asset_id" : "");
+        char alter[2048];
+        size_t alen = (size_t)snprintf(alter, sizeof(alter), "ALTER TABLE public.sensor_data2");
+        for (size_t c = 0; features && c < FEATURE_TAGS; c++)
+            for (size_t k = 0; k < FEATURE_COUNT; k++) {
+                len += (size_t)snprintf(copy_sql + len, sizeof(copy_sql) - len, ", %s_%s",
+                                        feat_tags[c], feature_names[k]);
+                alen += (size_t)snprintf(alter + alen, sizeof(alter) - alen,
+                                         "%s ADD COLUMN IF NOT EXISTS %s_%s DOUBLE PRECISION",
+                                         c + k ? "," : "", feat_tags[c], feature_names[k]);
+            }
+        snprintf(copy_sql + len, sizeof(copy_sql) - len, "%s%s) FROM STDIN (FORMAT binary)",
+                 anomaly ? ", anomaly_score, anomaly_level" : "",
+                 cur_env ? ", envelope_ftf, envelope_bpfo, envelope_bpfi, envelope_bsf" : "");
+
+        PQclear(PQexec(pg,
+            "CREATE TABLE IF NOT EXISTS public.sensor_data2 ("
+            " ts TIMESTAMPTZ NOT NULL, vibration DOUBLE PRECISION, temperature DOUBLE PRECISION,"
+            " pressure DOUBLE PRECISION, vibration_alarm BOOLEAN)"));
+        if (fleet_mode)
+            PQclear(PQexec(pg, "ALTER TABLE public.sensor_data2 ADD COLUMN IF NOT EXISTS asset_id INTEGER"));
+        if (trace_mode)
+            PQclear(PQexec(pg, "ALTER TABLE public.sensor_data2 ADD COLUMN IF NOT EXISTS seq BIGINT,"
+                               " ADD COLUMN IF NOT EXISTS gen_ns BIGINT"));
+        if (features)
+            PQclear(PQexec(pg, alter));
+        if (anomaly)
+            PQclear(PQexec(pg, "ALTER TABLE public.sensor_data2 ADD COLUMN IF NOT EXISTS anomaly_score DOUBLE PRECISION,"
+                               " ADD COLUMN IF NOT EXISTS anomaly_level DOUBLE PRECISION"));
+        if (cur_env)
+            PQclear(PQexec(pg, "ALTER TABLE public.sensor_data2 ADD COLUMN IF NOT EXISTS envelope_ftf DOUBLE PRECISION,"
+                               " ADD COLUMN IF NOT EXISTS envelope_bpfo DOUBLE PRECISION,"
+                               " ADD COLUMN IF NOT EXISTS envelope_bpfi DOUBLE PRECISION,"
+                               " ADD COLUMN IF NOT EXISTS envelope_bsf DOUBLE PRECISION"));
+    }
+    if (online)
+        PQclear(PQexec(pg,
+            "CREATE TABLE IF NOT EXISTS public.model_metrics ("
+            " ts TIMESTAMPTZ NOT NULL, precision DOUBLE PRECISION,"
+            " recall DOUBLE PRECISION, f1 DOUBLE PRECISION)"));
+}
+
+// === Поток выгрузки очереди ===
+
+// Сброс очереди на диск не чаще раза в секунду — граница потерь при отключении питания
+static void drain_sync(void) {
+    static double last_sync;
+    const double now = now_ms();
+    if (now - last_sync >= 1000.0) {
+        spool_sync(spool);
+        last_sync = now;
+    }
+}
+
+// Пауза до ms мс, прерывается завершением
+static void drain_sleep(double ms) {
+    const double until = now_ms() + ms;
+    while (now_ms() < until && !atomic_load(&drain_stop)) {
+        drain_sync();
+        struct timespec ts = { 0, 20 * 1000000L };
+        nanosleep(&ts, NULL);
+    }
+}
+
+// Соединение с базой и схема; pg == NULL — база недоступна
+static int drain_connect(void) {
+    static const char *const keys[] = { "connect_timeout", "dbname", NULL };
+    const char *const vals[] = { "5", db_conninfo, NULL }; // параметры из --db важнее
+    pg = PQconnectdbParams(keys, vals, 1);
+    if (PQstatus(pg) != CONNECTION_OK) {
+        UA_LOG_WARNING(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                       "⚠️ PostgreSQL недоступна, строки копятся в %s: %s", spool_path, PQerrorMessage(pg));
+        PQfinish(pg);
+        pg = NULL;
+        return 0;
+    }
+    rollup_stage_ready = 0;
+    prepare_schema();
+    if (rollup)
+        prepare_rollups();
+    atomic_store(&db_up, 1);
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "✅ Подключено к PostgreSQL");
+    return 1;
+}
+
+// Записи r[0..n) — одной командой COPY (sql): данные идут прямо из отображения файла очереди
+static int spool_copy(const char *sql, const SpoolRecord *r, size_t n) {
+    static const char header[COPY_HEADER] = "PGCOPY\n\377\r\n\0"; // флаги и расширение — нули
+    static const char trailer[2] = { -1, -1 };                     // признак конца данных
+    int ok = 0;
+    PGresult *res = PQexec(pg, sql);
+    if (PQresultStatus(res) == PGRES_COPY_IN) {
+        PQclear(res);
+        int sent = PQputCopyData(pg, header, COPY_HEADER) == 1;
+        for (size_t k = 0; sent && k < n; k++)
+            sent = PQputCopyData(pg, r[k].data, (int)r[k].len) == 1;
+        sent = sent && PQputCopyData(pg, trailer, 2) == 1;
+        sent = PQputCopyEnd(pg, sent ? NULL : "выгрузка прервана") == 1 && sent;
+        res = PQgetResult(pg);
+        ok = sent && PQresultStatus(res) == PGRES_COMMAND_OK;
+    }
+    if (!ok)
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                     "COPY из очереди не выполнен: %s", PQerrorMessage(pg));
+    PQclear(res);
+    while ((res = PQgetResult(pg)) != NULL)
+        PQclear(res);
+    return ok;
+}
+
+// Пачка записей одного вида в базу: 1 — записана, 0 — отказ, -1 — вид не включён в этом запуске
+static int drain_batch(const SpoolRecord *r, size_t n) {
+    const uint32_t kind = r[0].kind;
+    if (kind == SPOOL_ROWS) {
+        const int ok = spool_copy(copy_sql, r, n);
+        for (size_t k = 0; ok && trace_mode && k < n; k++)
+            trace_commit(r[k].data, r[k].rows, r[k].len / r[k].rows);
+        return ok;
+    }
+    if (kind == SPOOL_SQL) {
+        if (!online)
+            return -1;
+        PGresult *res = PQexec(pg, (const char *)r[0].data);
+        const int ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+        if (!ok)
+            UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "Запрос из очереди: %s", PQerrorMessage(pg));
+        PQclear(res);
+        return ok;
+    }
+    const uint32_t l = kind - SPOOL_ROLLUP;
+    if (l >= ROLLUP_LEVELS || !rollup)
+        return -1;
+    if (!rollup_stage_ready && !prepare_rollup_stage()) {
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                     "Временные таблицы агрегатов: %s", PQerrorMessage(pg));
+        return 0;
+    }
+    int ok = spool_copy(rollup_copy_sql[l], r, n);
+    if (ok) {
+        PGresult *res = PQexec(pg, rollup_merge_sql[l]);
+        ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+        if (!ok)
+            UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                         "Слияние sensor_rollup_%s: %s", rollup_suffix[l], PQerrorMessage(pg));
+        PQclear(res);
+    }
+    if (!ok) {
+        rollup_stage_ready = 0;
+        PQclear(PQexec(pg, "DISCARD TEMP"));
+    }
+    return ok;
+}
+
+// Очередь → база, пока не выставлен drain_stop; после него — ещё до DRAIN_EXIT_MS,
+// пока очередь не пуста и база на связи
+static void *drain_main(void *arg) {
+    static SpoolRecord recs[DRAIN_RECORDS];
+    double backoff = 1000.0, deadline = 0.0;
+    int fails = 0;
+    for (;;) {
+        drain_sync();
+        if (atomic_load(&drain_stop)) {
+            if (deadline == 0.0)
+                deadline = now_ms() + DRAIN_EXIT_MS;
+            if (!pg || now_ms() >= deadline)
+                break;
+        }
+        if (!pg) {
+            if (drain_connect()) {
+                backoff = 1000.0;
+            } else {
+                drain_sleep(backoff);
+                backoff = backoff * 2 < 30000.0 ? backoff * 2 : 30000.0;
+            }
+            continue;
+        }
+        const size_t n = spool_peek(spool, recs, DRAIN_RECORDS, DRAIN_BATCH_BYTES);
+        if (n == 0) {
+            if (atomic_load(&drain_stop))
+                break;
+            drain_sleep(20.0);
+            continue;
+        }
+        // Строки — все подряд идущие записи одним COPY; корзины и запросы — по записи,
+        // как их слил бы основной поток: одна корзина дважды в одном слиянии — ошибка
+        size_t k = 1;
+        while (recs[0].kind == SPOOL_ROWS && k < n && recs[k].kind == SPOOL_ROWS)
+            k++;
+        uint64_t rows = 0;
+        for (size_t j = 0; j < k; j++)
+            rows += recs[j].rows;
+
+        const int rc = drain_batch(recs, k);
+        if (rc == 0 && PQstatus(pg) != CONNECTION_OK) {
+            UA_LOG_WARNING(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                           "⚠️ Соединение с PostgreSQL потеряно, строки копятся в %s", spool_path);
+            PQfinish(pg);
+            pg = NULL;
+            atomic_store(&db_up, 0);
+            fails = 0;
+            continue;
+        }
+        if (rc == 0 && ++fails < DRAIN_RETRIES) {
+            drain_sleep(1000.0);
+            continue;
+        }
+        if (rc == 1) {
+            atomic_fetch_add(&stat_drained, rows);
+        } else {
+            UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                         "❌ Записи очереди вида %u пропущены (%llu строк): %s", recs[0].kind,
+                         (unsigned long long)rows, rc < 0 ? "вид не включён в этом запуске" : "база их не принимает");
+            atomic_fetch_add(&stat_poisoned, rows);
+        }
+        fails = 0;
+        spool_consume(spool, recs[k - 1].next, rows);
+    }
+    spool_sync(spool);
+    PQfinish(pg);
+    pg = NULL;
+    atomic_store(&db_up, 0);
+    return NULL;
+}
+
+// Закрытие базы: напрямую — соединение, с очередью — остановка выгрузки и файл очереди
+static void db_close(void) {
+    if (!spool) {
+        PQfinish(pg);
+        return;
+    }
+    atomic_store(&drain_stop, 1);
+    pthread_join(drain_tid, NULL);
+    SpoolStats st;
+    spool_stats(spool, &st);
+    if (st.rows > 0)
+        UA_LOG_WARNING(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                       "⚠️ В очереди %s осталось %llu строк — уйдут в базу при следующем запуске",
+                       spool_path, (unsigned long long)st.rows);
+    spool_close(spool);
+    spool = NULL;
+}
+
+// Колбэк уведомления MonitoredItem.
+// Контекст — (номер агрегата << 2) | номер тега, без выделения памяти на элемент.
+static void onDataChange(UA_Client *client, UA_UInt32 subId, void *subContext,
+                         UA_UInt32 monId, void *monContext, UA_DataValue *value) {
+    uintptr_t ctx = (uintptr_t)monContext;
+    size_t i = ctx >> 2;
+    unsigned tag = (unsigned)(ctx & 3);
+    if (!value->hasValue)
+        return;
+    stat_samples++;
+
+    if (tag == TAG_ALARM) { // тревога не завершает строку, только запоминается
+        if (UA_Variant_hasScalarType(&value->value, &UA_TYPES[UA_TYPES_BOOLEAN]))
+            cur_alarm[i] = *(UA_Boolean *)value->value.data;
+        return;
+    }
+    if (!UA_Variant_hasScalarType(&value->value, &UA_TYPES[UA_TYPES_DOUBLE]))
+        return;
+
+    // Повторный отсчёт того же тега — сначала сбрасываем незавершённую строку
+    if (have[i] & (1u << tag))
+        emit_row(i);
+
+    double v = *(UA_Double *)value->value.data;
+    if (tag == TAG_VIB)        cur_vib[i] = v;
+    else if (tag == TAG_TEMP)  cur_temp[i] = v;
+    else                       cur_press[i] = v;
+
+    UA_DateTime ts = value->hasSourceTimestamp ? value->sourceTimestamp : UA_DateTime_now();
+    if (ts > cur_ts[i])
+        cur_ts[i] = ts;
+    have[i] |= 1u << tag;
+
+    if (have[i] == HAVE_ALL)
+        emit_row(i);
+    if (copy.rows >= batch_rows)
+        flush_copy();
+}
+
+// Колбэк уведомления полосы огибающей (--envelope): только запоминается, как тревога
+static void onEnvelope(UA_Client *client, UA_UInt32 subId, void *subContext,
+                       UA_UInt32 monId, void *monContext, UA_DataValue *value) {
+    uintptr_t ctx = (uintptr_t)monContext;
+    if (!value->hasValue || !UA_Variant_hasScalarType(&value->value, &UA_TYPES[UA_TYPES_DOUBLE]))
+        return;
+    stat_samples++;
+    cur_env[(ctx >> 2) * ENVELOPE_BANDS + (ctx & 3)] = *(UA_Double *)value->value.data;
+}
+
+// Колбэк уведомления diagnostics.trace: тик — в кольцо, его возраст на публикации и приёме
+static void onTrace(UA_Client *client, UA_UInt32 subId, void *subContext,
+                    UA_UInt32 monId, void *monContext, UA_DataValue *value) {
+    const uint64_t recv = mono_ns();
+    if (!value->hasValue || !value->hasSourceTimestamp || value->value.arrayLength != 3 ||
+        value->value.type != &UA_TYPES[UA_TYPES_UINT64])
+        return;
+    const UA_UInt64 *tr = value->value.data; // номер тика, начало генерации, конец публикации
+    if (tr[0] == 0)
+        return; // узел ещё не записан
+    const uint64_t last = trace_pos ? trace_ring[(trace_pos - 1) % TRACE_RING].seq : 0;
+    if (last && tr[0] <= last)
+        stat_tick_dups++; // или перезапуск сервера — номера пошли заново
+    else if (last && tr[0] > last + 1)
+        stat_tick_gaps += tr[0] - last - 1;
+    trace_ring[trace_pos++ % TRACE_RING] = (TraceTick){ tr[0], to_pg_ts(value->sourceTimestamp), tr[1] };
+    if (tr[2] >= tr[1])
+        perf_hist_add(&hist_publish, tr[2] - tr[1]);
+    if (recv >= tr[1])
+        perf_hist_add(&hist_collect, recv - tr[1]);
+}
+
+// Строковый NodeId тега агрегата: equipment.<i>.* или прежний equipment.*;
+// tag >= TAG_COUNT — полоса огибающей tag - TAG_COUNT (bearing.envelope.<полоса>)
+static UA_NodeId tag_node(size_t i, unsigned tag) {
+    static const char *suffix[TAG_COUNT] = {
+        "bearing.vibration", "temperature", "pressure", "bearing.alarm"
+    };
+    char name[48], buf[96];
+    if (tag < TAG_COUNT)
+        snprintf(name, sizeof(name), "%s", suffix[tag]);
+    else
+        snprintf(name, sizeof(name), "bearing.envelope.%s", envelope_bands[tag - TAG_COUNT]);
+    if (fleet_mode)
+        snprintf(buf, sizeof(buf), "equipment.%zu.%s", i, name);
+    else
+        snprintf(buf, sizeof(buf), "equipment.%s", name);
+    return UA_NODEID_STRING_ALLOC(1, buf);
+}
+
+// Создание MonitoredItems пачками по ITEMS_PER_CALL
+static int subscribe_all(UA_Client *client, UA_UInt32 subId) {
+    const size_t per_asset = TAG_COUNT + (cur_env ? ENVELOPE_BANDS : 0);
+    const size_t total = n_assets * per_asset;
+    UA_MonitoredItemCreateRequest items[ITEMS_PER_CALL];
+    void *contexts[ITEMS_PER_CALL];
+    UA_Client_DataChangeNotificationCallback callbacks[ITEMS_PER_CALL];
+    size_t failed = 0;
+
+    // Зона нечувствительности тегов (--deadband): фильтр общий для всех агрегатов
+    UA_DataChangeFilter filters[FEATURE_TAGS];
+    for (size_t c = 0; c < FEATURE_TAGS; c++) {
+        filters[c].trigger = UA_DATACHANGETRIGGER_STATUSVALUE;
+        filters[c].deadbandType = deadband_type[c];
+        filters[c].deadbandValue = deadband_value[c];
+    }
+
+    for (size_t base = 0; base < total; base += ITEMS_PER_CALL) {
+        size_t cnt = total - base < ITEMS_PER_CALL ? total - base : ITEMS_PER_CALL;
+        for (size_t k = 0; k < cnt; k++) {
+            size_t idx = base + k;
+            size_t asset = idx / per_asset;
+            unsigned tag = (unsigned)(idx % per_asset);
+            items[k] = UA_MonitoredItemCreateRequest_default(tag_node(asset, tag));
+            items[k].requestedParameters.samplingInterval = sampling_ms;
+            items[k].requestedParameters.queueSize = queue_size;
+            items[k].requestedParameters.discardOldest = true;
+            if (tag < FEATURE_TAGS && deadband_type[tag] != UA_DEADBANDTYPE_NONE) {
+                UA_ExtensionObject *f = &items[k].requestedParameters.filter;
+                f->encoding = UA_EXTENSIONOBJECT_DECODED_NODELETE;
+                f->content.decoded.type = &UA_TYPES[UA_TYPES_DATACHANGEFILTER];
+                f->content.decoded.data = &filters[tag];
+            }
+            contexts[k] = (void *)(((uintptr_t)asset << 2) | (tag % TAG_COUNT)); // полоса — tag - TAG_COUNT
+            callbacks[k] = tag < TAG_COUNT ? onDataChange : onEnvelope;
+        }
+
+        UA_CreateMonitoredItemsRequest req;
+        UA_CreateMonitoredItemsRequest_init(&req);
+        req.subscriptionId = subId;
+        req.timestampsToReturn = UA_TIMESTAMPSTORETURN_SOURCE;
+        req.itemsToCreate = items;
+        req.itemsToCreateSize = cnt;
+        UA_CreateMonitoredItemsResponse resp =
+            UA_Client_MonitoredItems_createDataChanges(client, req, contexts, callbacks, NULL);
+        if (resp.responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
+            UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                         "CreateMonitoredItems: %s", UA_StatusCode_name(resp.responseHeader.serviceResult));
+            failed += cnt;
+        } else {
+            for (size_t k = 0; k < resp.resultsSize; k++)
+                failed += resp.results[k].statusCode != UA_STATUSCODE_GOOD;
+        }
+        UA_CreateMonitoredItemsResponse_clear(&resp);
+        for (size_t k = 0; k < cnt; k++)
+            UA_NodeId_clear(&items[k].itemToMonitor.nodeId);
+    }
+
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                "MonitoredItems: создано %zu из %zu", total - failed, total);
+    return failed < total;
+}
+
+// MonitoredItem трассы тиков (--trace); узел есть у dynamic4 с diagnostics.trace
+static int subscribe_trace(UA_Client *client, UA_UInt32 subId) {
+    UA_MonitoredItemCreateRequest item =
+        UA_MonitoredItemCreateRequest_default(UA_NODEID_STRING(1, "diagnostics.trace"));
+    item.requestedParameters.samplingInterval = sampling_ms;
+    item.requestedParameters.queueSize = queue_size;
+    item.requestedParameters.discardOldest = true;
+    void *context = NULL;
+    UA_Client_DataChangeNotificationCallback callback = onTrace;
+
+    UA_CreateMonitoredItemsRequest req;
+    UA_CreateMonitoredItemsRequest_init(&req);
+    req.subscriptionId = subId;
+    req.timestampsToReturn = UA_TIMESTAMPSTORETURN_SOURCE;
+    req.itemsToCreate = &item;
+    req.itemsToCreateSize = 1;
+    UA_CreateMonitoredItemsResponse resp =
+        UA_Client_MonitoredItems_createDataChanges(client, req, &context, &callback, NULL);
+    UA_StatusCode rc = resp.responseHeader.serviceResult;
+    if (rc == UA_STATUSCODE_GOOD)
+        rc = resp.resultsSize == 1 ? resp.results[0].statusCode : UA_STATUSCODE_BADINTERNALERROR;
+    UA_CreateMonitoredItemsResponse_clear(&resp);
+    if (rc != UA_STATUSCODE_GOOD)
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                     "❌ Трасса diagnostics.trace недоступна (сервер старше?): %s", UA_StatusCode_name(rc));
+    return rc == UA_STATUSCODE_GOOD;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Использование: %s [параметры]\n"
+            "  --url URL        OPC UA сервер (по умолчанию %s)\n"
+            "  --db CONNINFO    строка подключения libpq\n"
+            "  --assets N       режим парка: N агрегатов, узлы equipment.<id>.*\n"
+            "  --batch ROWS     строк в одном COPY (по умолчанию %zu)\n"
+            "  --flush MS       максимальная задержка строки в буфере (по умолчанию %.0f)\n"
+            "  --sampling MS    samplingInterval MonitoredItem (по умолчанию %.0f)\n"
+            "  --publish MS     publishingInterval подписки (по умолчанию %.0f)\n"
+            "  --queue N        размер очереди MonitoredItem (по умолчанию %u)\n"
+            "  --features W     оконные признаки тегов за W строк агрегата (2..%d)\n"
+            "  --store DIR      копия строк в сжатые сегменты (ml/seg_store.c)\n"
+            "  --rollup         агрегаты 1 с / 1 мин / 1 ч в sensor_rollup_* для дашбордов\n"
+            "  --online FILE    дообучение модели тревоги на каждой строке (ml/online_model.c)\n"
+            "  --anomaly        оценка аномалий без учителя в каждой строке (ml/anomaly.c)\n"
+            "  --envelope       полосы огибающей dynamic4 --spectrum в колонках envelope_* (не с --sdt)\n"
+            "  --spool FILE     запись в базу через дисковую очередь (переживает простой базы)\n"
+            "  --spool-mb N     ёмкость новой очереди, МБ (по умолчанию %llu)\n"
+            "  --deadband LIST  зона нечувствительности MonitoredItem: тег=порог[%%],...\n"
+            "                   (теги vibration, temperature, pressure; %% — от EURange узла)\n"
+            "  --sdt LIST       точки излома в sensor_sdt вместо строк: тег=погрешность,...\n"
+            "  --sdt-max S      наибольший интервал между точками тега, с (по умолчанию %.0f)\n"
+            "  --trace          seq/gen_ns тика в строках и задержки по этапам (не с --sdt)\n",
+            prog, opc_url, batch_rows, flush_ms, sampling_ms, publish_ms, queue_size,
+            MAX_FEATURE_WINDOW, (unsigned long long)spool_mb, sdt_max_s);
+}
+
+// Список тег=значение[%] через запятую → значения по тегам feat_tags; pct = NULL — без %
+static int parse_tag_values(const char *list, double val[FEATURE_TAGS], UA_UInt32 *pct) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", list);
+    for (char *save = NULL, *item = strtok_r(buf, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(item, '=');
+        if (!eq)
+            return 0;
+        *eq = '\0';
+        size_t c = 0;
+        while (c < FEATURE_TAGS && strcmp(item, feat_tags[c]))
+            c++;
+        char *end;
+        const double v = strtod(eq + 1, &end);
+        if (c == FEATURE_TAGS || end == eq + 1 || v < 0)
+            return 0;
+        if (*end == '%' && pct && !end[1])
+            pct[c] = UA_DEADBANDTYPE_PERCENT;
+        else if (*end == '\0' && pct)
+            pct[c] = UA_DEADBANDTYPE_ABSOLUTE;
+        else if (*end != '\0')
+            return 0;
+        val[c] = v;
+    }
+    return 1;
+}
+
+static int parse_args(int argc, char **argv) {
+    for (int a = 1; a < argc; a++) {
+        const char *opt = argv[a];
+        if (!strcmp(opt, "--rollup")) { // флаги без значения
+            rollup_mode = 1;
+            continue;
+        }
+        if (!strcmp(opt, "--trace")) {
+            trace_mode = 1;
+            continue;
+        }
+        if (!strcmp(opt, "--anomaly")) {
+            anomaly_mode = 1;
+            continue;
+        }
+        if (!strcmp(opt, "--envelope")) {
+            envelope_mode = 1;
+            continue;
+        }
+        if (a + 1 >= argc)
+            return 0;
+        const char *val = argv[++a];
+        if (!strcmp(opt, "--url"))            opc_url = val;
+        else if (!strcmp(opt, "--db"))        db_conninfo = val;
+        else if (!strcmp(opt, "--assets"))    { n_assets = strtoul(val, NULL, 10); fleet_mode = 1; }
+        else if (!strcmp(opt, "--batch"))     batch_rows = strtoul(val, NULL, 10);
+        else if (!strcmp(opt, "--flush"))     flush_ms = strtod(val, NULL);
+        else if (!strcmp(opt, "--sampling"))  sampling_ms = strtod(val, NULL);
+        else if (!strcmp(opt, "--publish"))   publish_ms = strtod(val, NULL);
+        else if (!strcmp(opt, "--queue"))     queue_size = (UA_UInt32)strtoul(val, NULL, 10);
+        else if (!strcmp(opt, "--features"))  feat_window = strtoul(val, NULL, 10);
+        else if (!strcmp(opt, "--store"))     store_dir = val;
+        else if (!strcmp(opt, "--online"))    online_path = val;
+        else if (!strcmp(opt, "--spool"))     spool_path = val;
+        else if (!strcmp(opt, "--spool-mb"))  spool_mb = strtoull(val, NULL, 10);
+        else if (!strcmp(opt, "--deadband"))  { if (!parse_tag_values(val, deadband_value, deadband_type)) return 0; }
+        else if (!strcmp(opt, "--sdt"))       { if (!parse_tag_values(val, sdt_dev, NULL)) return 0; sdt_mode = 1; }
+        else if (!strcmp(opt, "--sdt-max"))   sdt_max_s = strtod(val, NULL);
+        else return 0;
+    }
+    return n_assets >= 1 && n_assets <= MAX_ASSETS && batch_rows >= 1 && flush_ms > 0 &&
+           (feat_window == 0 || (feat_window >= 2 && feat_window <= MAX_FEATURE_WINDOW)) &&
+           spool_mb >= 1 && spool_mb <= (1ull << 24) && sdt_max_s > 0 && !(trace_mode && sdt_mode) &&
+           !(envelope_mode && sdt_mode);
+}
+
+int main(int argc, char **argv) {
+    if (!parse_args(argc, argv)) {
+        usage(argv[0]);
+        return 1;
+    }
+    signal(SIGINT, stopHandler);
+    signal(SIGTERM, stopHandler);
+
+    // --- Буферы ---
+    cur_vib   = calloc(n_assets, sizeof(double));
+    cur_temp  = calloc(n_assets, sizeof(double));
+    cur_press = calloc(n_assets, sizeof(double));
+    cur_alarm = calloc(n_assets, sizeof(uint8_t));
+    cur_ts    = calloc(n_assets, sizeof(UA_DateTime));
+    have      = calloc(n_assets, sizeof(uint8_t));
+    if (feat_window > 0)
+        features = features_new(n_assets * FEATURE_TAGS, feat_window, 0.0);
+    // каждый признак — 4 байта длины + 8 байт значения
+    const size_t row_bytes = ROW_BYTES_MAX + (feat_window > 0 ? FEATURE_TAGS * FEATURE_COUNT * 12 : 0) +
+                             (anomaly_mode ? 2 * 12 : 0) + (envelope_mode ? ENVELOPE_BANDS * 12 : 0);
+    if (trace_mode)
+        trace_seq = calloc(n_assets, sizeof(uint64_t));
+    copy.cap  = 32 + (batch_rows + 2) * row_bytes; // +2: строка может уйти дважды до проверки
+    copy.data = malloc(copy.cap);
+    if (rollup_mode)
+        rollup = rollup_new(n_assets);
+    if (envelope_mode && (cur_env = malloc(n_assets * ENVELOPE_BANDS * sizeof(double))))
+        for (size_t k = 0; k < n_assets * ENVELOPE_BANDS; k++)
+            cur_env[k] = NAN;
+    if (anomaly_mode) {
+        anomaly = anomaly_new(n_assets, NULL);
+        anomaly_high = calloc(n_assets, sizeof(uint8_t));
+    }
+    if (sdt_mode) {
+        sdt = sdt_new(n_assets, sdt_dev, (int64_t)(sdt_max_s * 1e6));
+        if ((sdt_alarm = malloc(n_assets)))
+            memset(sdt_alarm, 0xFF, n_assets);
+    }
+    for (int l = 0; rollup && l < ROLLUP_LEVELS; l++)
+        if (!copy_reserve(&rollup_buf[l], 0))
+            rollup_free(rollup), rollup = NULL;
+    if (!cur_vib || !cur_temp || !cur_press || !cur_alarm || !cur_ts || !have || !copy.data ||
+        (feat_window > 0 && !features) || (rollup_mode && !rollup) || (sdt_mode && (!sdt || !sdt_alarm)) ||
+        (trace_mode && !trace_seq) || (anomaly_mode && (!anomaly || !anomaly_high)) ||
+        (envelope_mode && !cur_env)) {
+        fprintf(stderr, "Не удалось выделить память\n");
+        return 1;
+    }
+    copy_begin(&copy);
+    for (int l = 0; rollup && l < ROLLUP_LEVELS; l++)
+        copy_begin(&rollup_buf[l]);
+    if (store_dir) {
+        char err[256];
+        if (!(store = seg_writer_open(store_dir, 0, err, sizeof(err)))) {
+            fprintf(stderr, "Хранилище: %s\n", err);
+            return 1;
+        }
+    }
+    if (online_path) {
+        // Продолжаем контрольную точку (online_train или прошлый запуск) или начинаем заново
+        const size_t nf = features ? OLM_ROW_FEATURES : OLM_ROW_TAGS;
+        char err[256];
+        online = olm_load(online_path, err, sizeof(err));
+        if (!online && errno != ENOENT) {
+            fprintf(stderr, "Модель: %s\n", err);
+            return 1;
+        }
+        if (online && olm_num_features(online) != nf) {
+            fprintf(stderr, "Модель %s обучена на %zu признаках, а строка сборщика даёт %zu"
+                            " (проверьте --features)\n", online_path, olm_num_features(online), nf);
+            return 1;
+        }
+        if (!online && !(online = olm_new(nf, NULL))) {
+            fprintf(stderr, "Не удалось выделить память\n");
+            return 1;
+        }
+    }
+
+    // --- Подключение к PostgreSQL: напрямую или потоком выгрузки дисковой очереди ---
+    if (spool_path) {
+        char err[256];
+        if (!(spool = spool_open(spool_path, spool_mb << 20, err, sizeof(err)))) {
+            fprintf(stderr, "Очередь: %s\n", err);
+            return 1;
+        }
+        SpoolStats st;
+        spool_stats(spool, &st);
+        if (st.rows > 0)
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                        "В очереди %s с прошлого запуска: %llu строк", spool_path, (unsigned long long)st.rows);
+        if (pthread_create(&drain_tid, NULL, drain_main, NULL) != 0) {
+            fprintf(stderr, "Поток выгрузки не запущен\n");
+            return 1;
+        }
+    } else {
+        pg = PQconnectdb(db_conninfo);
+        if (PQstatus(pg) != CONNECTION_OK) {
+            fprintf(stderr, "PostgreSQL: %s", PQerrorMessage(pg));
+            PQfinish(pg);
+            return 1;
+        }
+        prepare_schema();
+        if (rollup)
+            prepare_rollups();
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "✅ Подключено к PostgreSQL");
+    }
+
+    // --- Подключение к OPC UA серверу ---
+    UA_Client *client = UA_Client_new();
+    UA_ClientConfig_setDefault(UA_Client_getConfig(client));
+    UA_StatusCode rc = UA_Client_connect(client, opc_url);
+    if (rc != UA_STATUSCODE_GOOD) {
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                     "Не удалось подключиться к %s: %s", opc_url, UA_StatusCode_name(rc));
+        UA_Client_delete(client);
+        db_close();
+        return 1;
+    }
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "✅ Подключено к OPC UA серверу: %s", opc_url);
+
+    // --- Подписка ---
+    UA_CreateSubscriptionRequest sreq = UA_CreateSubscriptionRequest_default();
+    sreq.requestedPublishingInterval = publish_ms;
+    sreq.maxNotificationsPerPublish = 0; // без ограничения
+    UA_CreateSubscriptionResponse sresp =
+        UA_Client_Subscriptions_create(client, sreq, NULL, NULL, NULL);
+    if (sresp.responseHeader.serviceResult != UA_STATUSCODE_GOOD ||
+        (trace_mode && !subscribe_trace(client, sresp.subscriptionId)) ||
+        !subscribe_all(client, sresp.subscriptionId)) {
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "Не удалось создать подписку");
+        UA_Client_disconnect(client);
+        UA_Client_delete(client);
+        db_close();
+        return 1;
+    }
+
+    // --- Основной цикл: уведомления → строки → COPY ---
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "📡 Начинаем сбор метрик от dynamic4.c...");
+    double last_flush = now_ms(), last_stat = last_flush, last_checkpoint = last_flush;
+    uint64_t prev_samples = 0, prev_rows = 0, prev_drained = 0;
+    UA_UInt32 wait_ms = flush_ms < 50 ? (UA_UInt32)flush_ms : 50;
+    while (running) {
+        rc = UA_Client_run_iterate(client, wait_ms);
+        if (rc != UA_STATUSCODE_GOOD) {
+            UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                         "Связь с сервером потеряна: %s", UA_StatusCode_name(rc));
+            break;
+        }
+        double now = now_ms();
+        if (now - last_flush >= flush_ms) {
+            flush_copy();
+            if (rollup) {
+                // Корзины затихших агрегатов — с запасом на доставку уведомлений
+                const int64_t lag_us = (int64_t)((2 * publish_ms + 1000.0) * 1000.0);
+                rollup_close_before(rollup, unix_us() - lag_us, emit_rollup, NULL);
+                flush_rollup();
+            }
+            last_flush = now;
+        }
+        if (online && now - last_checkpoint >= ONLINE_CHECKPOINT_MS) {
+            checkpoint_online();
+            last_checkpoint = now;
+        }
+        if (now - last_stat >= 10000.0) {
+            double sec = (now - last_stat) / 1000.0;
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                        "Отсчётов/с: %.0f  Строк/с: %.0f  COPY: %llu  Потеряно строк: %llu",
+                        (stat_samples - prev_samples) / sec, (stat_rows - prev_rows) / sec,
+                        (unsigned long long)stat_flushes, (unsigned long long)stat_dropped);
+            if (rollup)
+                UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                            "Корзин записано: %llu  потеряно: %llu  опоздавших строк: %llu",
+                            (unsigned long long)stat_rollup_rows,
+                            (unsigned long long)stat_rollup_dropped,
+                            (unsigned long long)rollup_late(rollup));
+            if (sdt)
+                UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                            "SDT: строк %llu → точек %llu (сжатие ×%.1f)  опоздавших отсчётов: %llu",
+                            (unsigned long long)stat_sdt_rows, (unsigned long long)stat_rows,
+                            stat_rows ? (double)stat_sdt_rows / stat_rows : 0.0,
+                            (unsigned long long)sdt_late(sdt));
+            if (anomaly)
+                UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                            "Аномалии: строк выше %.1f: %llu  агрегатов выше уровня %.1f: %zu (входов %llu)%s",
+                            ANOMALY_SCORE_ALERT, (unsigned long long)stat_anomaly_rows,
+                            ANOMALY_LEVEL_ALERT, anomaly_assets_high,
+                            (unsigned long long)stat_anomaly_assets,
+                            anomaly_ready(anomaly) ? "" : "  (прогрев)");
+            if (spool) {
+                SpoolStats st;
+                spool_stats(spool, &st);
+                const uint64_t drained = atomic_load(&stat_drained);
+                UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                            "Очередь: %.1f / %.0f МБ (%.1f%%)  строк: %llu  старейшей: %.0f с"
+                            "  выгружено/с: %.0f  пропущено: %llu  база: %s",
+                            st.used / 1048576.0, st.capacity / 1048576.0, 100.0 * st.used / st.capacity,
+                            (unsigned long long)st.rows,
+                            st.oldest_us ? (unix_us() - st.oldest_us) / 1e6 : 0.0,
+                            (drained - prev_drained) / sec,
+                            (unsigned long long)atomic_load(&stat_poisoned),
+                            atomic_load(&db_up) ? "на связи" : "недоступна");
+                prev_drained = drained;
+            }
+            if (trace_mode) {
+                pthread_mutex_lock(&hist_commit_lock);
+                const double c50 = perf_hist_quantile(&hist_commit, 0.5) / 1e6;
+                const double c99 = perf_hist_quantile(&hist_commit, 0.99) / 1e6;
+                pthread_mutex_unlock(&hist_commit_lock);
+                UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                            "Возраст тика p50/p99, мс: публикация %.2f / %.2f  приём %.2f / %.2f"
+                            "  запись %.1f / %.1f",
+                            perf_hist_quantile(&hist_publish, 0.5) / 1e6,
+                            perf_hist_quantile(&hist_publish, 0.99) / 1e6,
+                            perf_hist_quantile(&hist_collect, 0.5) / 1e6,
+                            perf_hist_quantile(&hist_collect, 0.99) / 1e6, c50, c99);
+                UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                            "Тиков пропущено: %llu  повторно: %llu  строк: пропущено тиков %llu"
+                            "  повторов %llu  без тика %llu",
+                            (unsigned long long)stat_tick_gaps, (unsigned long long)stat_tick_dups,
+                            (unsigned long long)stat_row_gaps, (unsigned long long)stat_row_dups,
+                            (unsigned long long)stat_untraced);
+            }
+            prev_samples = stat_samples;
+            prev_rows = stat_rows;
+            last_stat = now;
+        }
+    }
+
+    // --- Завершение: дописываем хвост ---
+    if (sdt)
+        sdt_flush(sdt, emit_sdt_point, NULL); // последние отсчёты — концы отрезков
+    flush_copy();
+    if (rollup) {
+        rollup_close_all(rollup, emit_rollup, NULL);
+        flush_rollup();
+    }
+    if (online)
+        checkpoint_online();
+    UA_Client_disconnect(client);
+    UA_Client_delete(client);
+    db_close();
+    if (seg_writer_close(store) != 0)
+        UA_LOG_ERROR(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "Сегмент %s не закрыт", store_dir);
+    free(cur_vib); free(cur_temp); free(cur_press); free(cur_alarm);
+    free(cur_ts); free(have); free(copy.data); free(trace_seq);
+    for (int l = 0; l < ROLLUP_LEVELS; l++)
+        free(rollup_buf[l].data);
+    rollup_free(rollup);
+    sdt_free(sdt);
+    free(sdt_alarm);
+    olm_free(online);
+    anomaly_free(anomaly);
+    free(anomaly_high);
+    free(cur_env);
+    features_free(features);
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "🔌 Соединения закрыты");
+    return 0;
+}
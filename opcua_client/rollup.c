@@ -0,0 +1,133 @@
+/*
+ * rollup.c — реализация rollup.h
+ * -----------------------------
+ */
+#include "rollup.h"
+#include <stdlib.h>
+
+const int64_t rollup_period_us[ROLLUP_LEVELS] = { 1000000LL, 60000000LL, 3600000000LL };
+const char *const rollup_suffix[ROLLUP_LEVELS] = { "1s", "1m", "1h" };
+
+// Открытые корзины одного уровня (struct-of-arrays по агрегатам)
+typedef struct {
+    int64_t  *start;                 // начало корзины; при n = 0 — последней закрытой
+    uint32_t *n, *alarms;
+    double   *min[ROLLUP_TAGS], *max[ROLLUP_TAGS], *sum[ROLLUP_TAGS], *last[ROLLUP_TAGS];
+} Level;
+
+struct Rollup {
+    size_t   nAssets;
+    Level    lv[ROLLUP_LEVELS];
+    uint64_t late;
+};
+
+Rollup *rollup_new(size_t nAssets) {
+    Rollup *r = calloc(1, sizeof(*r));
+    if (!r)
+        return NULL;
+    r->nAssets = nAssets;
+    int ok = 1;
+    for (int l = 0; l < ROLLUP_LEVELS; l++) {
+        Level *L = &r->lv[l];
+        ok = ok && (L->start = malloc(nAssets * sizeof(int64_t)));
+        ok = ok && (L->n = calloc(nAssets, sizeof(uint32_t)));
+        ok = ok && (L->alarms = calloc(nAssets, sizeof(uint32_t)));
+        for (int t = 0; ok && t < ROLLUP_TAGS; t++) {
+            ok = ok && (L->min[t] = malloc(nAssets * sizeof(double)));
+            ok = ok && (L->max[t] = malloc(nAssets * sizeof(double)));
+            ok = ok && (L->sum[t] = malloc(nAssets * sizeof(double)));
+            ok = ok && (L->last[t] = malloc(nAssets * sizeof(double)));
+        }
+        for (size_t i = 0; ok && i < nAssets; i++)
+            L->start[i] = INT64_MIN / 2; // ни одной корзины ещё не было
+    }
+    if (!ok) {
+        rollup_free(r);
+        return NULL;
+    }
+    return r;
+}
+
+void rollup_free(Rollup *r) {
+    if (!r)
+        return;
+    for (int l = 0; l < ROLLUP_LEVELS; l++) {
+        Level *L = &r->lv[l];
+        free(L->start); free(L->n); free(L->alarms);
+        for (int t = 0; t < ROLLUP_TAGS; t++) {
+            free(L->min[t]); free(L->max[t]); free(L->sum[t]); free(L->last[t]);
+        }
+    }
+    free(r);
+}
+
+static void emit_bucket(Level *L, unsigned level, size_t i, RollupEmit emit, void *ctx) {
+    RollupRow row;
+    row.bucket = L->start[i];
+    row.asset  = (uint32_t)i;
+    row.n      = L->n[i];
+    row.alarms = L->alarms[i];
+    for (int t = 0; t < ROLLUP_TAGS; t++) {
+        row.min[t]  = L->min[t][i];
+        row.max[t]  = L->max[t][i];
+        row.avg[t]  = L->sum[t][i] / L->n[i];
+        row.last[t] = L->last[t][i];
+    }
+    L->n[i] = 0;
+    emit(ctx, level, &row);
+}
+
+void rollup_add(Rollup *r, size_t asset, int64_t ts, const double v[ROLLUP_TAGS], int alarm,
+                RollupEmit emit, void *ctx) {
+    if (asset >= r->nAssets)
+        return;
+    for (unsigned l = 0; l < ROLLUP_LEVELS; l++) {
+        Level *L = &r->lv[l];
+        const int64_t p = rollup_period_us[l], s = L->start[asset];
+        uint32_t n = L->n[asset];
+        // Открытая корзина принимает [s, ...); закрытая [s, s + p) уже записана
+        if (n ? ts < s : ts < s + p) {
+            r->late++;
+            continue;
+        }
+        if (n && ts >= s + p) {
+            emit_bucket(L, l, asset, emit, ctx);
+            n = 0;
+        }
+        if (n == 0) {
+            L->start[asset] = ts - ((ts % p) + p) % p;
+            L->alarms[asset] = 0;
+            for (int t = 0; t < ROLLUP_TAGS; t++) {
+                L->min[t][asset] = L->max[t][asset] = v[t];
+                L->sum[t][asset] = 0.0;
+            }
+        }
+        for (int t = 0; t < ROLLUP_TAGS; t++) {
+            if (v[t] < L->min[t][asset]) L->min[t][asset] = v[t];
+            if (v[t] > L->max[t][asset]) L->max[t][asset] = v[t];
+            L->sum[t][asset] += v[t];
+            L->last[t][asset] = v[t];
+        }
+        L->alarms[asset] += alarm != 0;
+        L->n[asset] = n + 1;
+    }
+}
+
+void rollup_close_before(Rollup *r, int64_t ts, RollupEmit emit, void *ctx) {
+    for (unsigned l = 0; l < ROLLUP_LEVELS; l++) {
+        Level *L = &r->lv[l];
+        const int64_t p = rollup_period_us[l];
+        for (size_t i = 0; i < r->nAssets; i++)
+            if (L->n[i] && L->start[i] + p <= ts)
+                emit_bucket(L, l, i, emit, ctx);
+    }
+}
+
+void rollup_close_all(Rollup *r, RollupEmit emit, void *ctx) {
+    for (unsigned l = 0; l < ROLLUP_LEVELS; l++)
+        for (size_t i = 0; i < r->nAssets; i++)
+            if (r->lv[l].n[i])
+                emit_bucket(&r->lv[l], l, i, emit, ctx);
+}
+
+uint64_t rollup_late(const Rollup *r) { return r->late; }
@@ -0,0 +1,57 @@
+/*
+ * rollup.h — инкрементальные агрегаты телеметрии для дашбордов (1 с, 1 мин, 1 ч)
+ * ----------------------------------------------------------------------------
+ * Каждая строка сборщика сразу добавляется в открытые корзины трёх уровней
+ * своего агрегата: count, min, max, сумма (→ avg), last по вибрации, температуре
+ * и давлению, плюс число строк с тревогой. Когда приходит строка следующей
+ * корзины (или rollup_close_before() по часам для затихших агрегатов), корзина
+ * закрывается и отдаётся колбэку — сборщик пишет её в sensor_rollup_<1s|1m|1h>.
+ *
+ * Уровни считаются независимо прямо из строк, без каскада 1 с → 1 мин → 1 ч:
+ * min/max/last точные, avg — взвешенный по count.
+ * Строка старше уже закрытой корзины в агрегаты не попадает (счётчик rollup_late);
+ * в сырой таблице она остаётся.
+ *
+ * Память: агрегатов × 3 уровня × ~110 байт, выделяется в rollup_new().
+ */
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ROLLUP_LEVELS 3
+#define ROLLUP_TAGS   3 // вибрация, температура, давление
+
+extern const int64_t rollup_period_us[ROLLUP_LEVELS]; // 1 с, 60 с, 3600 с
+extern const char *const rollup_suffix[ROLLUP_LEVELS]; // "1s", "1m", "1h"
+
+// Закрытая корзина
+typedef struct {
+    int64_t  bucket;                 // начало корзины, мкс Unix
+    uint32_t asset;
+    uint32_t n;                      // строк в корзине
+    uint32_t alarms;                 // из них с тревогой
+    double   min[ROLLUP_TAGS], max[ROLLUP_TAGS], avg[ROLLUP_TAGS], last[ROLLUP_TAGS];
+} RollupRow;
+
+typedef void (*RollupEmit)(void *ctx, unsigned level, const RollupRow *row);
+
+typedef struct Rollup Rollup;
+
+Rollup *rollup_new(size_t nAssets);
+void rollup_free(Rollup *r);
+
+// Строка агрегата asset в момент ts (мкс Unix); закрытые ею корзины — в emit
+void rollup_add(Rollup *r, size_t asset, int64_t ts, const double v[ROLLUP_TAGS], int alarm,
+                RollupEmit emit, void *ctx);
+
+// Закрыть все корзины, кончившиеся не позже ts (агрегаты, от которых нет строк)
+void rollup_close_before(Rollup *r, int64_t ts, RollupEmit emit, void *ctx);
+
+// Закрыть все открытые корзины (при завершении; повторная корзина сольётся в БД)
+void rollup_close_all(Rollup *r, RollupEmit emit, void *ctx);
+
+uint64_t rollup_late(const Rollup *r);
+
+#endif
@@ -0,0 +1,114 @@
+/*
+ * sdt.c — реализация sdt.h
+ * -----------------------
+ */
+#include "sdt.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define SDT_NONE INT64_MIN // у канала ещё нет сохранённой точки
+
+struct Sdt {
+    size_t   nAssets;
+    double   dev[SDT_TAGS];
+    int64_t  maxGap;
+    // Канал asset * SDT_TAGS + tag
+    int64_t *t0, *tl;        // сохранённая точка и последний принятый отсчёт
+    double  *v0, *vl;
+    double  *lo, *hi;        // допустимые наклоны от (t0, v0), единиц в мкс
+    uint64_t late;
+};
+
+Sdt *sdt_new(size_t nAssets, const double dev[SDT_TAGS], int64_t maxGap) {
+    Sdt *s = calloc(1, sizeof(*s));
+    if (!s)
+        return NULL;
+    const size_t n = nAssets * SDT_TAGS;
+    s->nAssets = nAssets;
+    s->maxGap = maxGap;
+    for (int t = 0; t < SDT_TAGS; t++)
+        s->dev[t] = dev[t];
+    s->t0 = malloc(n * sizeof(int64_t));
+    s->tl = malloc(n * sizeof(int64_t));
+    s->v0 = malloc(n * sizeof(double));
+    s->vl = malloc(n * sizeof(double));
+    s->lo = malloc(n * sizeof(double));
+    s->hi = malloc(n * sizeof(double));
+    if (!s->t0 || !s->tl || !s->v0 || !s->vl || !s->lo || !s->hi) {
+        sdt_free(s);
+        return NULL;
+    }
+    for (size_t c = 0; c < n; c++)
+        s->t0[c] = SDT_NONE;
+    return s;
+}
+
+void sdt_free(Sdt *s) {
+    if (!s)
+        return;
+    free(s->t0); free(s->tl); free(s->v0); free(s->vl); free(s->lo); free(s->hi);
+    free(s);
+}
+
+// Сохранить точку (t, v) и начать от неё отрезок
+static inline void archive(Sdt *s, size_t c, int64_t t, double v, SdtEmit emit, void *ctx) {
+    emit(ctx, c / SDT_TAGS, (unsigned)(c % SDT_TAGS), t, v);
+    s->t0[c] = s->tl[c] = t;
+    s->v0[c] = s->vl[c] = v;
+    s->lo[c] = -INFINITY;
+    s->hi[c] = INFINITY;
+}
+
+// Сохранить последний принятый отсчёт: значение — на прямой от (t0, v0) с наклоном из дверей
+static inline void archive_last(Sdt *s, size_t c, SdtEmit emit, void *ctx) {
+    const double dt = (double)(s->tl[c] - s->t0[c]);
+    double k = (s->vl[c] - s->v0[c]) / dt;
+    k = k < s->lo[c] ? s->lo[c] : k > s->hi[c] ? s->hi[c] : k;
+    archive(s, c, s->tl[c], s->v0[c] + k * dt, emit, ctx);
+}
+
+void sdt_add(Sdt *s, size_t asset, int64_t ts, const double v[SDT_TAGS], SdtEmit emit, void *ctx) {
+    for (unsigned t = 0; t < SDT_TAGS; t++) {
+        const size_t c = asset * SDT_TAGS + t;
+        if (s->t0[c] == SDT_NONE) {
+            archive(s, c, ts, v[t], emit, ctx);
+            continue;
+        }
+        if (ts <= s->tl[c]) {
+            s->late++;
+            continue;
+        }
+        if (ts - s->t0[c] > s->maxGap) {
+            if (s->tl[c] == s->t0[c]) { // разрыв в данных — отсчёт сразу в точку
+                archive(s, c, ts, v[t], emit, ctx);
+                continue;
+            }
+            archive_last(s, c, emit, ctx);
+        }
+        const double E = s->dev[t];
+        double dt = (double)(ts - s->t0[c]);
+        double lo = (v[t] - E - s->v0[c]) / dt, hi = (v[t] + E - s->v0[c]) / dt;
+        if (lo < s->lo[c]) lo = s->lo[c];
+        if (hi > s->hi[c]) hi = s->hi[c];
+        if (lo > hi) { // двери разошлись: излом на прошлом отсчёте
+            archive_last(s, c, emit, ctx);
+            dt = (double)(ts - s->t0[c]);
+            lo = (v[t] - E - s->v0[c]) / dt;
+            hi = (v[t] + E - s->v0[c]) / dt;
+        }
+        s->lo[c] = lo;
+        s->hi[c] = hi;
+        s->tl[c] = ts;
+        s->vl[c] = v[t];
+    }
+}
+
+void sdt_flush(Sdt *s, SdtEmit emit, void *ctx) {
+    for (size_t c = 0; c < s->nAssets * SDT_TAGS; c++)
+        if (s->t0[c] != SDT_NONE && s->tl[c] != s->t0[c])
+            archive_last(s, c, emit, ctx);
+}
+
+uint64_t sdt_late(const Sdt *s) {
+    return s->late;
+}
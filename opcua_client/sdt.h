@@ -0,0 +1,48 @@
+/*
+ * sdt.h — сжатие телеметрии «вращающейся дверью» (swinging door, SDT) для сборщика
+ * ---------------------------------------------------------------------------------
+ * Вместо каждого отсчёта хранятся только точки излома: пока все отсчёты после
+ * последней сохранённой точки лежат в пределах ±E (погрешность тега) от одной
+ * прямой, они не пишутся. Восстановление — линейная интерполяция между соседними
+ * точками (grafana/sdt_interp.sql), отклонение от любого принятого отсчёта не
+ * больше E.
+ *
+ * Алгоритм: от сохранённой точки (t0, v0) «двери» — допустимый интервал наклонов
+ * [lo, hi], общий для всех отсчётов после неё: (v - E - v0) / dt <= наклон <=
+ * (v + E - v0) / dt. Когда очередной отсчёт делает интервал пустым, сохраняется
+ * предыдущий отсчёт и от него начинается новый отрезок. Его значение берётся
+ * на прямой с наклоном из интервала (ближайшим к наклону на сам отсчёт): в
+ * классическом SDT сохраняется сам отсчёт, и промежуточные точки могут уйти
+ * дальше E. Кроме того, точка сохраняется не реже раза в maxGap — ровный сигнал
+ * не оставляет в базе многочасовых пустот.
+ *
+ * Каналы — агрегат × SDT_TAGS тегов (вибрация, температура, давление), состояние —
+ * struct-of-arrays, ~50 байт на канал, выделяется в sdt_new(). Отсчёт старше
+ * последнего принятого по каналу пропускается (счётчик sdt_late).
+ */
+#ifndef SDT_H
+#define SDT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SDT_TAGS 3 // вибрация, температура, давление
+
+// Сохраняемая точка тега tag агрегата asset: время ts (мкс Unix) и значение
+typedef void (*SdtEmit)(void *ctx, size_t asset, unsigned tag, int64_t ts, double v);
+
+typedef struct Sdt Sdt;
+
+// dev — погрешность E по тегам (0 — сохраняются все изломы), maxGap — мкс между точками
+Sdt *sdt_new(size_t nAssets, const double dev[SDT_TAGS], int64_t maxGap);
+void sdt_free(Sdt *s);
+
+// Строка агрегата asset в момент ts; сохранённые ею точки — в emit
+void sdt_add(Sdt *s, size_t asset, int64_t ts, const double v[SDT_TAGS], SdtEmit emit, void *ctx);
+
+// Последние принятые, но ещё не сохранённые отсчёты всех каналов (при завершении)
+void sdt_flush(Sdt *s, SdtEmit emit, void *ctx);
+
+uint64_t sdt_late(const Sdt *s);
+
+#endif
@@ -0,0 +1,160 @@
+/*
+ * shm_dump.c — проверка кольца dynamic4 --shm и задержки потребителя на том же хосте
+ * --------------------------------------------------------------------------------
+ * Читает тики через shm_sub.c и раз в секунду печатает: тиков/с, агрегатов в
+ * тревоге по последнему тику, потери (обгон писателем) и задержку до чтения слота
+ * по CLOCK_MONOTONIC — от начала генерации тика (gen) и от конца записи слота (pub),
+ * p50 / p99 / max. С --asset N дополнительно печатает значения агрегата N.
+ *
+ * Новых тиков нет — опрос через --poll-us мкс (nanosleep); --poll-us 0 — крутиться
+ * без сна: задержка минимальна, но ядро занято целиком.
+ *
+ * Сборка:
+ *   gcc -O2 shm_dump.c shm_sub.c ../open62541/perf_timer.c -lm -o shm_dump
+ *
+ * Запуск:
+ *   ./shm_dump                                 # кольцо по умолчанию /dynamic4
+ *   ./shm_dump --name /plant1 --asset 42 --poll-us 0
+ *   ./shm_dump --duration 30 --from-oldest 1
+ */
+#include "shm_sub.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../open62541/perf_timer.h"         // Гистограммы задержек
+
+static const char *name = SHM_DEFAULT_NAME;
+static double duration_s = 0; // 0 — до Ctrl+C
+static long show_asset = -1;
+static long poll_us = 50;
+static int from_oldest = 0;
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void stopHandler(int sig) {
+    (void)sig;
+    interrupted = 1;
+}
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts); // vDSO — без системного вызова
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Использование: %s [параметры]\n"
+            "  --name NAME        кольцо в /dev/shm (по умолчанию %s)\n"
+            "  --asset N          печатать значения агрегата N\n"
+            "  --poll-us US       пауза опроса без новых тиков, мкс (0 — без сна, по умолчанию 50)\n"
+            "  --from-oldest 1    начать с самого старого тика кольца\n"
+            "  --duration S       сколько читать, с (по умолчанию — до Ctrl+C)\n",
+            prog, name);
+}
+
+static int parse_args(int argc, char **argv) {
+    for (int a = 1; a < argc; a++) {
+        const char *opt = argv[a];
+        if (a + 1 >= argc)
+            return 0;
+        char *val = argv[++a];
+        if (!strcmp(opt, "--name"))               name = val;
+        else if (!strcmp(opt, "--asset"))         show_asset = strtol(val, NULL, 10);
+        else if (!strcmp(opt, "--poll-us"))       poll_us = strtol(val, NULL, 10);
+        else if (!strcmp(opt, "--from-oldest"))   from_oldest = atoi(val);
+        else if (!strcmp(opt, "--duration"))      duration_s = strtod(val, NULL);
+        else return 0;
+    }
+    return duration_s >= 0 && poll_us >= 0;
+}
+
+int main(int argc, char **argv) {
+    if (!parse_args(argc, argv)) {
+        usage(argv[0]);
+        return 1;
+    }
+    signal(SIGINT, stopHandler);
+    signal(SIGTERM, stopHandler);
+
+    char err[256];
+    ShmSubscriber *sub = shm_sub_open(name, from_oldest, err, sizeof(err));
+    if (!sub) {
+        fprintf(stderr, "❌ %s\n", err);
+        return 1;
+    }
+    const ShmHeader *h = shm_sub_header(sub);
+    if (show_asset >= (long)h->nAssets) {
+        fprintf(stderr, "❌ агрегат %ld вне кольца (%llu агрегатов)\n",
+                show_asset, (unsigned long long)h->nAssets);
+        shm_sub_close(sub);
+        return 1;
+    }
+    fprintf(stderr, "📡 Кольцо %s: %llu агрегатов, %llu слотов, писатель pid %d\n", name,
+            (unsigned long long)h->nAssets, (unsigned long long)h->slots, (int)h->pid);
+
+    const struct timespec pause = { 0, poll_us * 1000 };
+    const uint64_t start = mono_ns();
+    uint64_t mark = start, lastTicks = 0;
+    PerfHist fromGen, fromPub;
+    memset(&fromGen, 0, sizeof(fromGen));
+    memset(&fromPub, 0, sizeof(fromPub));
+    size_t alarms = 0;
+    ShmSample last;
+    int haveLast = 0;
+    while (!interrupted && !shm_sub_closed(sub) &&
+           (duration_s == 0 || (double)(mono_ns() - start) / 1e9 < duration_s)) {
+        const ShmSlot *s = shm_sub_next(sub);
+        if (s) {
+            const uint64_t now = mono_ns();
+            const uint64_t gen = s->gen_ns, pub = s->pub_ns;
+            size_t a = 0;
+            for (size_t i = 0; i < h->nAssets; i++)
+                a += s->sample[i].alarm;
+            ShmSample x;
+            if (show_asset >= 0)
+                x = s->sample[show_asset];
+            if (shm_sub_done(sub, s)) { // значения слота целые — учитываем
+                perf_hist_add(&fromGen, now > gen ? now - gen : 0);
+                perf_hist_add(&fromPub, now > pub ? now - pub : 0);
+                alarms = a;
+                if (show_asset >= 0) {
+                    last = x;
+                    haveLast = 1;
+                }
+            }
+        } else if (poll_us > 0) {
+            nanosleep(&pause, NULL);
+        }
+
+        const uint64_t t = mono_ns();
+        if (t - mark < 1000000000u)
+            continue;
+        const double dt = (double)(t - mark) / 1e9;
+        const uint64_t ticks = shm_sub_ticks(sub);
+        printf("%.1f тиков/с, в тревоге %zu, потеряно %llu, отставание %llu | "
+               "gen→чтение p50 %.1f p99 %.1f max %.1f мкс | pub→чтение p50 %.1f p99 %.1f мкс\n",
+               (double)(ticks - lastTicks) / dt, alarms, (unsigned long long)shm_sub_lost(sub),
+               (unsigned long long)shm_sub_lag(sub),
+               perf_hist_quantile(&fromGen, 0.5) / 1e3, perf_hist_quantile(&fromGen, 0.99) / 1e3,
+               fromGen.max_ns / 1e3,
+               perf_hist_quantile(&fromPub, 0.5) / 1e3, perf_hist_quantile(&fromPub, 0.99) / 1e3);
+        if (haveLast)
+            printf("  агрегат %ld: вибрация %.3f, температура %.2f, давление %.3f, тревога %s\n",
+                   show_asset, last.vib, last.temp, last.press, last.alarm ? "да" : "нет");
+        fflush(stdout);
+        memset(&fromGen, 0, sizeof(fromGen));
+        memset(&fromPub, 0, sizeof(fromPub));
+        lastTicks = ticks;
+        mark = t;
+    }
+
+    if (shm_sub_closed(sub))
+        fprintf(stderr, "⚠️ Писатель завершился\n");
+    fprintf(stderr, "✅ Прочитано %llu тиков, потеряно %llu\n",
+            (unsigned long long)shm_sub_ticks(sub), (unsigned long long)shm_sub_lost(sub));
+    shm_sub_close(sub);
+    return 0;
+}
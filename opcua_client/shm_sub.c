@@ -0,0 +1,126 @@
+/*
+ * shm_sub.c — реализация shm_sub.h
+ * -------------------------------
+ */
+#include "shm_sub.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct ShmSubscriber {
+    const ShmHeader *h;
+    size_t   bytes;
+    uint64_t pos;            // номер следующего тика для чтения
+    uint64_t curSeq;         // seq слота, отданного shm_sub_next()
+    uint64_t ticks, lost;
+};
+
+ShmSubscriber *shm_sub_open(const char *name, int fromOldest, char *err, size_t errLen) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s%s", name[0] == '/' ? "" : "/", name);
+    int fd = shm_open(path, O_RDONLY, 0);
+    if (fd < 0) {
+        snprintf(err, errLen, "shm_open %s: %s (сервер запущен с --shm?)", path, strerror(errno));
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < SHM_HEADER_BYTES) {
+        snprintf(err, errLen, "%s: файл кольца не создан до конца", path);
+        close(fd);
+        return NULL;
+    }
+    void *m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) {
+        snprintf(err, errLen, "mmap %s: %s", path, strerror(errno));
+        return NULL;
+    }
+    const ShmHeader *h = m;
+    // Магию писатель ставит последней — после неё остальные поля заголовка видны
+    const uint64_t magic = h->magic;
+    atomic_thread_fence(memory_order_acquire);
+    if (magic != SHM_MAGIC || h->version != SHM_VERSION || h->slots < 2 ||
+        h->headerSize + h->slots * h->slotSize > (uint64_t)st.st_size ||
+        h->slotSize < sizeof(ShmSlot) + h->nAssets * sizeof(ShmSample)) {
+        snprintf(err, errLen, "%s: не кольцо dynamic4 версии %d", path, SHM_VERSION);
+        munmap(m, (size_t)st.st_size);
+        return NULL;
+    }
+    ShmSubscriber *s = calloc(1, sizeof(*s));
+    if (!s) {
+        snprintf(err, errLen, "нет памяти");
+        munmap(m, (size_t)st.st_size);
+        return NULL;
+    }
+    s->h = h;
+    s->bytes = (size_t)st.st_size;
+    const uint64_t head = atomic_load_explicit(&((ShmHeader *)h)->head, memory_order_acquire);
+    // Слот тика head - slots сейчас может перезаписываться — самый старый целый на один новее
+    s->pos = !fromOldest ? head : head >= h->slots ? head - h->slots + 1 : 0;
+    return s;
+}
+
+void shm_sub_close(ShmSubscriber *s) {
+    if (!s)
+        return;
+    munmap((void *)s->h, s->bytes);
+    free(s);
+}
+
+const ShmHeader *shm_sub_header(const ShmSubscriber *s) {
+    return s->h;
+}
+
+const ShmSlot *shm_sub_next(ShmSubscriber *s) {
+    ShmHeader *h = (ShmHeader *)s->h; // атомарные чтения — не запись, отображение только для чтения
+    const uint64_t head = atomic_load_explicit(&h->head, memory_order_acquire);
+    while (s->pos < head) {
+        if (head - s->pos >= h->slots) { // обогнали на круг: к самому старому целому
+            s->lost += head - h->slots + 1 - s->pos;
+            s->pos = head - h->slots + 1;
+        }
+        ShmSlot *slot = (ShmSlot *)shm_slot(h, s->pos);
+        const uint64_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (seq != 2 * s->pos + 2) { // перезаписан после чтения head
+            s->lost++;
+            s->pos++;
+            continue;
+        }
+        s->curSeq = seq;
+        s->pos++;
+        return slot;
+    }
+    return NULL;
+}
+
+int shm_sub_done(ShmSubscriber *s, const ShmSlot *slot) {
+    atomic_thread_fence(memory_order_acquire); // чтения данных слота — до повторного чтения seq
+    if (atomic_load_explicit(&((ShmSlot *)slot)->seq, memory_order_relaxed) != s->curSeq) {
+        s->lost++;
+        return 0;
+    }
+    s->ticks++;
+    return 1;
+}
+
+uint64_t shm_sub_ticks(const ShmSubscriber *s) {
+    return s->ticks;
+}
+
+uint64_t shm_sub_lost(const ShmSubscriber *s) {
+    return s->lost;
+}
+
+uint64_t shm_sub_lag(const ShmSubscriber *s) {
+    const uint64_t head = atomic_load_explicit(&((ShmHeader *)s->h)->head, memory_order_relaxed);
+    return head > s->pos ? head - s->pos : 0;
+}
+
+int shm_sub_closed(const ShmSubscriber *s) {
+    return (int)atomic_load_explicit(&((ShmHeader *)s->h)->closed, memory_order_acquire);
+}
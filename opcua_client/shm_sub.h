@@ -0,0 +1,52 @@
+/*
+ * shm_sub.h — читатель кольца тиков dynamic4 --shm в разделяемой памяти
+ * --------------------------------------------------------------------
+ * Отображает /dev/shm/<имя> (open62541/shm_pub.c) только для чтения и отдаёт
+ * слоты тиков по порядку прямо из отображения: без копирования, сокетов и
+ * системных вызовов на тик. Сколько угодно читателей на одно кольцо, писатель
+ * о них не знает и их не ждёт.
+ *
+ * Цикл потребителя:
+ *   const ShmSlot *s;
+ *   while ((s = shm_sub_next(sub))) {
+ *       ... s->tick, s->sample[i].vib ...
+ *       if (!shm_sub_done(sub, s))  // писатель обогнал на круг — тик потерян,
+ *           ...                     // прочитанное из слота отбросить
+ *   }
+ * Нужна устойчивая копия — memcpy слота, затем shm_sub_done().
+ *
+ * Отставший больше чем на кольцо читатель перескакивает к самому старому целому
+ * тику, пропущенные — в shm_sub_lost(). Писатель завершился (shm_sub_closed()) —
+ * закрыть и открыть заново: новый сервер создаёт новый файл.
+ *
+ * Раскладка — open62541/shm_pub.h. Сборка вместе с потребителем:
+ *   gcc consumer.c shm_sub.c -o consumer
+ */
+#ifndef SHM_SUB_H
+#define SHM_SUB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../open62541/shm_pub.h"            // Раскладка ShmHeader / ShmSlot / ShmSample
+
+typedef struct ShmSubscriber ShmSubscriber;
+
+// Отображение кольца name ("/имя"); fromOldest — начать с самого старого тика кольца,
+// иначе — со следующего. NULL при ошибке, текст — в err
+ShmSubscriber *shm_sub_open(const char *name, int fromOldest, char *err, size_t errLen);
+void shm_sub_close(ShmSubscriber *s);
+
+const ShmHeader *shm_sub_header(const ShmSubscriber *s); // nAssets, slots, pid писателя
+
+// Следующий непрочитанный тик или NULL, если новых нет
+const ShmSlot *shm_sub_next(ShmSubscriber *s);
+
+// Конец чтения слота из shm_sub_next(): 1 — слот не перезаписывался, 0 — тик потерян
+int shm_sub_done(ShmSubscriber *s, const ShmSlot *slot);
+
+uint64_t shm_sub_ticks(const ShmSubscriber *s);  // прочитано целыми
+uint64_t shm_sub_lost(const ShmSubscriber *s);   // потеряно: обгон писателем
+uint64_t shm_sub_lag(const ShmSubscriber *s);    // тиков записано, но ещё не прочитано
+int      shm_sub_closed(const ShmSubscriber *s); // писатель завершился
+
+#endif
@@ -0,0 +1,270 @@
+/*
+ * spool.c — реализация spool.h
+ * ----------------------------
+ * Позиции (голова, хвост, позиция записи) — логические: растут без сброса,
+ * смещение в кольце — позиция % ёмкость. Запись хранит свою позицию, поэтому
+ * остаток прошлого круга с верным CRC не примешается к очереди при восстановлении.
+ * Если до конца кольца меньше заголовка, запись начинается с нового круга без
+ * пропуска; иначе конец кольца закрывается записью-пропуском (SPOOL_PAD).
+ */
+#include "spool.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SPOOL_MAGIC  "SPOOL01"
+#define SPOOL_HEADER 4096        // байт под заголовок файла
+#define SPOOL_PAD    UINT32_MAX  // вид записи-пропуска до конца кольца
+
+typedef struct {
+    char             magic[8];
+    uint64_t         capacity;  // байт под записи, кратно 8
+    _Atomic uint64_t tail;      // позиция первой невыгруженной записи
+    _Atomic uint64_t head;      // позиция за последней записью (подсказка — верна после spool_open)
+} SpoolFileHeader;
+
+typedef struct {
+    uint64_t pos;      // логическая позиция записи
+    int64_t  time_us;
+    uint32_t len;      // байт данных
+    uint32_t rows;
+    uint32_t kind;
+    uint32_t crc;      // CRC32 первых 28 байт заголовка и данных
+} RecHeader;
+
+struct Spool {
+    int              fd;
+    uint8_t         *map;
+    size_t           mapLen;
+    SpoolFileHeader *hdr;
+    uint8_t         *ring;
+    uint64_t         cap;
+    _Atomic uint64_t rows;      // строк в очереди
+};
+
+static uint32_t crc_table[256];
+
+static void crc_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crc_table[i] = c;
+    }
+}
+
+static uint32_t crc32_update(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = data;
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++)
+        crc = crc_table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static uint32_t rec_crc(const RecHeader *h, const void *data) {
+    return crc32_update(crc32_update(0, h, offsetof(RecHeader, crc)), data, h->len);
+}
+
+static inline uint64_t align8(uint64_t n) { return (n + 7) & ~(uint64_t)7; }
+
+static int64_t wall_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Проверка записи на позиции pos при восстановлении: 1 — цела, *next — позиция за ней
+static int rec_valid(const Spool *s, uint64_t pos, uint64_t *next, uint32_t *rows) {
+    const uint64_t off = pos % s->cap;
+    RecHeader h;
+    memcpy(&h, s->ring + off, sizeof(h));
+    if (h.pos != pos || h.len > s->cap - off - sizeof(h))
+        return 0;
+    if (h.kind == SPOOL_PAD) {
+        *next = pos + (s->cap - off);
+        *rows = 0;
+        return h.crc == rec_crc(&h, NULL);
+    }
+    *next = pos + align8(sizeof(h) + h.len);
+    *rows = h.rows;
+    return h.crc == rec_crc(&h, s->ring + off + sizeof(h));
+}
+
+Spool *spool_open(const char *path, uint64_t capacity, char *err, size_t errLen) {
+    crc_init();
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        snprintf(err, errLen, "%s: %s", path, strerror(errno));
+        return NULL;
+    }
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        snprintf(err, errLen, "%s: очередь уже открыта другим процессом", path);
+        close(fd);
+        return NULL;
+    }
+    struct stat st;
+    SpoolFileHeader fh;
+    int rc = fstat(fd, &st);
+    if (rc == 0 && st.st_size == 0) {
+        // Новый файл: место на диске выделяется сразу
+        capacity = align8(capacity);
+        rc = posix_fallocate(fd, 0, (off_t)(SPOOL_HEADER + capacity));
+        if (rc != 0) {
+            snprintf(err, errLen, "%s: не выделено %.0f МБ: %s", path, capacity / 1048576.0, strerror(rc));
+            unlink(path); // файл был пуст — создан здесь
+            close(fd);
+            return NULL;
+        }
+        memset(&fh, 0, sizeof(fh));
+        memcpy(fh.magic, SPOOL_MAGIC, 8);
+        fh.capacity = capacity;
+        rc = pwrite(fd, &fh, sizeof(fh), 0) == (ssize_t)sizeof(fh) ? 0 : -1;
+    } else if (rc == 0) {
+        rc = pread(fd, &fh, sizeof(fh), 0) == (ssize_t)sizeof(fh) ? 0 : -1;
+        if (rc == 0 && (memcmp(fh.magic, SPOOL_MAGIC, 8) != 0 || fh.capacity == 0 || fh.capacity % 8 ||
+                        (uint64_t)st.st_size < SPOOL_HEADER + fh.capacity)) {
+            snprintf(err, errLen, "%s: не файл очереди или файл обрезан", path);
+            close(fd);
+            return NULL;
+        }
+    }
+    Spool *s = rc == 0 ? calloc(1, sizeof(Spool)) : NULL;
+    if (!s) {
+        snprintf(err, errLen, "%s: %s", path, rc == 0 ? "нет памяти" : strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    s->fd = fd;
+    s->cap = fh.capacity;
+    s->mapLen = SPOOL_HEADER + s->cap;
+    s->map = mmap(NULL, s->mapLen, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (s->map == MAP_FAILED) {
+        snprintf(err, errLen, "%s: mmap: %s", path, strerror(errno));
+        close(fd);
+        free(s);
+        return NULL;
+    }
+    s->hdr = (SpoolFileHeader *)s->map;
+    s->ring = s->map + SPOOL_HEADER;
+
+    // --- Восстановление: целые записи от хвоста — очередь, первая битая — её конец ---
+    uint64_t tail = atomic_load(&s->hdr->tail) & ~(uint64_t)7, pos = tail, rows = 0;
+    while (pos - tail < s->cap) {
+        uint64_t next;
+        uint32_t n;
+        if (s->cap - pos % s->cap < sizeof(RecHeader)) {
+            pos += s->cap - pos % s->cap; // хвост кольца короче заголовка — пропуск без записи
+            continue;
+        }
+        if (!rec_valid(s, pos, &next, &n) || next - tail > s->cap)
+            break;
+        pos = next;
+        rows += n;
+    }
+    atomic_store(&s->hdr->tail, tail);
+    atomic_store(&s->hdr->head, pos);
+    atomic_init(&s->rows, rows);
+    return s;
+}
+
+void spool_close(Spool *s) {
+    if (!s)
+        return;
+    msync(s->map, s->mapLen, MS_SYNC);
+    munmap(s->map, s->mapLen);
+    close(s->fd);
+    free(s);
+}
+
+size_t spool_max_record(const Spool *s) {
+    return (size_t)(s->cap / 4 - sizeof(RecHeader));
+}
+
+int spool_append(Spool *s, uint32_t kind, const void *data, size_t len, uint32_t rows) {
+    if (len > spool_max_record(s)) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    const uint64_t head = atomic_load_explicit(&s->hdr->head, memory_order_relaxed);
+    const uint64_t tail = atomic_load_explicit(&s->hdr->tail, memory_order_acquire);
+    const uint64_t need = align8(sizeof(RecHeader) + len);
+    uint64_t off = head % s->cap, skip = 0;
+    if (s->cap - off < need)
+        skip = s->cap - off; // запись — с начала кольца
+    if (head + skip + need - tail > s->cap) {
+        errno = ENOSPC;
+        return -1;
+    }
+    if (skip >= sizeof(RecHeader)) {
+        RecHeader pad = { head, 0, 0, 0, SPOOL_PAD, 0 };
+        pad.crc = rec_crc(&pad, NULL);
+        memcpy(s->ring + off, &pad, sizeof(pad));
+    }
+    const uint64_t pos = head + skip;
+    off = pos % s->cap;
+    RecHeader h = { pos, wall_us(), (uint32_t)len, rows, kind, 0 };
+    h.crc = rec_crc(&h, data);
+    memcpy(s->ring + off + sizeof(h), data, len);
+    memcpy(s->ring + off, &h, sizeof(h));
+    atomic_fetch_add_explicit(&s->rows, rows, memory_order_relaxed);
+    atomic_store_explicit(&s->hdr->head, pos + need, memory_order_release);
+    return 0;
+}
+
+// Запись с позиции pos или NULL, если очередь до limit пуста; пропуски обходятся
+static const RecHeader *rec_at(const Spool *s, uint64_t *pos, uint64_t limit) {
+    while (*pos < limit) {
+        const uint64_t off = *pos % s->cap;
+        if (s->cap - off < sizeof(RecHeader)) {
+            *pos += s->cap - off;
+            continue;
+        }
+        const RecHeader *h = (const RecHeader *)(s->ring + off);
+        if (h->kind != SPOOL_PAD)
+            return h;
+        *pos += s->cap - off;
+    }
+    return NULL;
+}
+
+size_t spool_peek(Spool *s, SpoolRecord *out, size_t max, size_t maxBytes) {
+    const uint64_t head = atomic_load_explicit(&s->hdr->head, memory_order_acquire);
+    uint64_t pos = atomic_load_explicit(&s->hdr->tail, memory_order_relaxed);
+    size_t n = 0, bytes = 0;
+    const RecHeader *h;
+    while (n < max && (h = rec_at(s, &pos, head)) != NULL) {
+        if (n > 0 && bytes + h->len > maxBytes)
+            break;
+        pos += align8(sizeof(RecHeader) + h->len);
+        out[n++] = (SpoolRecord){ h + 1, h->len, h->rows, h->kind, h->time_us, pos };
+        bytes += h->len;
+    }
+    return n;
+}
+
+void spool_consume(Spool *s, uint64_t next, uint64_t rows) {
+    atomic_fetch_sub_explicit(&s->rows, rows, memory_order_relaxed);
+    atomic_store_explicit(&s->hdr->tail, next, memory_order_release);
+}
+
+int spool_sync(Spool *s) {
+    return msync(s->map, s->mapLen, MS_SYNC);
+}
+
+void spool_stats(Spool *s, SpoolStats *st) {
+    const uint64_t head = atomic_load_explicit(&s->hdr->head, memory_order_acquire);
+    uint64_t tail = atomic_load_explicit(&s->hdr->tail, memory_order_acquire);
+    st->capacity = s->cap;
+    st->used = head - tail;
+    st->rows = atomic_load_explicit(&s->rows, memory_order_relaxed);
+    const RecHeader *h = rec_at(s, &tail, head);
+    st->oldest_us = h ? h->time_us : 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * spool.h — дисковая очередь store-and-forward для сборщика
+ * --------------------------------------------------------
+ * Кольцо записей в файле, отображённом в память (mmap). Сборщик дописывает
+ * в него пачки строк COPY, а поток выгрузки забирает их в базу, когда она
+ * доступна, — приём данных не ждёт базу, и строки переживают её перезапуск,
+ * недоступность сети и перезапуск самого сборщика.
+ *
+ *   файл     — заголовок 4 КиБ (хвост очереди, ёмкость) и кольцо записей;
+ *              место выделяется сразу (posix_fallocate): диск занят ровно
+ *              на ёмкость, а переполненный диск не роняет процесс по SIGBUS;
+ *   запись   — заголовок 32 байта (логическая позиция, время, длина, строки,
+ *              вид, CRC32) и данные, выравнивание 8 байт. Запись, не влезшая
+ *              до конца кольца, начинается с его начала, остаток — пропуск;
+ *   очередь полна — новая запись отклоняется (errno = ENOSPC), очередь не
+ *              затирается: сначала выгружаются самые старые строки;
+ *   сбой     — при открытии записи проверяются от хвоста: позиция и CRC
+ *              отсекают оборванную запись и остатки прошлого круга. Хвост
+ *              сдвигается после подтверждения базы, поэтому после аварии
+ *              последняя пачка может уйти повторно (at-least-once).
+ *
+ * Один писатель и один читатель (разные потоки), без блокировок: голова и хвост —
+ * атомарные позиции. spool_sync() сбрасывает страницы на диск (msync) — от
+ * него зависит, что переживёт потерю питания; при падении процесса данные
+ * остаются в страничном кеше ядра и без него.
+ */
+#ifndef SPOOL_H
+#define SPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct Spool Spool;
+
+// Запись, выданная spool_peek(); данные указывают прямо в отображение файла
+typedef struct {
+    const void *data;
+    uint32_t    len;
+    uint32_t    rows;
+    uint32_t    kind;     // вид записи — задаёт вызывающий
+    int64_t     time_us;  // время записи, мкс Unix
+    uint64_t    next;     // позиция за записью — для spool_consume()
+} SpoolRecord;
+
+typedef struct {
+    uint64_t capacity;    // байт под записи
+    uint64_t used;        // байт занято
+    uint64_t rows;        // строк в очереди
+    int64_t  oldest_us;   // время самой старой записи, 0 — очередь пуста
+} SpoolStats;
+
+// Открытие или создание (capacity байт под записи; у существующего файла — его ёмкость).
+// Восстанавливает очередь после сбоя. NULL и сообщение в err при ошибке
+Spool *spool_open(const char *path, uint64_t capacity, char *err, size_t errLen);
+void spool_close(Spool *s);
+
+// Наибольшая длина данных одной записи (четверть ёмкости)
+size_t spool_max_record(const Spool *s);
+
+// Писатель: 0 — записано, -1 — нет места (ENOSPC) или запись длиннее spool_max_record (EMSGSIZE)
+int spool_append(Spool *s, uint32_t kind, const void *data, size_t len, uint32_t rows);
+
+// Читатель: до max записей от хвоста, суммарно не больше maxBytes (первая — всегда).
+// Записи остаются в очереди до spool_consume()
+size_t spool_peek(Spool *s, SpoolRecord *out, size_t max, size_t maxBytes);
+
+// Читатель: удалить записи до позиции next (SpoolRecord.next), rows — их строк
+void spool_consume(Spool *s, uint64_t next, uint64_t rows);
+
+// Сброс отображения на диск; 0 — успех
+int spool_sync(Spool *s);
+
+void spool_stats(Spool *s, SpoolStats *st);
+
+#endif
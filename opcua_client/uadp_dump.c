@@ -0,0 +1,163 @@
+/*
+ * uadp_dump.c — проверка PubSub-потока dynamic4 --pubsub без сессии с сервером
+ * ---------------------------------------------------------------------------
+ * Слушает multicast-группу через uadp_sub.c и раз в секунду печатает:
+ * датаграммы/с, DataSetMessage/с, сколько агрегатов обновилось за секунду,
+ * сколько из них в тревоге, пропуски по SequenceNumber и неподдерживаемые сообщения.
+ * С --asset N дополнительно печатает последние значения агрегата N.
+ *
+ * Раскладка полей — open62541/uadp_pub.h: [0] — первый агрегат блока,
+ * далее по 4 поля на агрегат (vib, temp, press, alarm).
+ *
+ * Сборка:
+ *   gcc -O2 uadp_dump.c uadp_sub.c -o uadp_dump
+ *
+ * Запуск:
+ *   ./uadp_dump                                    # группа по умолчанию opc.udp://224.0.0.22:4840
+ *   ./uadp_dump --url opc.udp://239.0.0.1:4840 --iface 192.168.1.10 --asset 42
+ *   ./uadp_dump --duration 30
+ */
+#include "uadp_sub.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_ASSETS (1u << 22)
+
+static const char *url = "opc.udp://224.0.0.22:4840";
+static const char *iface = NULL;
+static double duration_s = 0; // 0 — до Ctrl+C
+static long show_asset = -1;
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void stopHandler(int sig) {
+    (void)sig;
+    interrupted = 1;
+}
+
+typedef struct {
+    uint8_t *seen;              // [MAX_ASSETS] обновлён за текущую секунду
+    size_t   updated, alarms, maxAsset, dataSets;
+    double   last[4];           // последние значения --asset
+    int      haveLast;
+} DumpState;
+
+static void on_dataset(void *ctx, const UadpMessageInfo *info, const UadpField *f, size_t n) {
+    DumpState *st = ctx;
+    (void)info;
+    st->dataSets++;
+    if (n < 1 || f[0].type != 7) // первое поле — UInt32 с номером первого агрегата
+        return;
+    size_t first = (size_t)f[0].value;
+    for (size_t j = 0; 1 + 4 * j + 3 < n; j++) {
+        size_t id = first + j;
+        if (id >= MAX_ASSETS)
+            break;
+        const UadpField *a = &f[1 + 4 * j];
+        if (!st->seen[id]) {
+            st->seen[id] = 1;
+            st->updated++;
+            st->alarms += a[3].value != 0;
+        }
+        if (id + 1 > st->maxAsset)
+            st->maxAsset = id + 1;
+        if ((long)id == show_asset) {
+            for (int k = 0; k < 4; k++)
+                st->last[k] = a[k].value;
+            st->haveLast = 1;
+        }
+    }
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Использование: %s [параметры]\n"
+            "  --url URL        группа opc.udp://<IPv4>:<порт> (по умолчанию %s)\n"
+            "  --iface ADDR     IPv4-адрес интерфейса для входа в группу\n"
+            "  --asset N        печатать последние значения агрегата N\n"
+            "  --duration S     сколько слушать, с (по умолчанию — до Ctrl+C)\n",
+            prog, url);
+}
+
+static int parse_args(int argc, char **argv) {
+    for (int a = 1; a < argc; a++) {
+        const char *opt = argv[a];
+        if (a + 1 >= argc)
+            return 0;
+        char *val = argv[++a];
+        if (!strcmp(opt, "--url"))           url = val;
+        else if (!strcmp(opt, "--iface"))    iface = val;
+        else if (!strcmp(opt, "--asset"))    show_asset = strtol(val, NULL, 10);
+        else if (!strcmp(opt, "--duration")) duration_s = strtod(val, NULL);
+        else return 0;
+    }
+    return duration_s >= 0;
+}
+
+int main(int argc, char **argv) {
+    if (!parse_args(argc, argv)) {
+        usage(argv[0]);
+        return 1;
+    }
+    signal(SIGINT, stopHandler);
+    signal(SIGTERM, stopHandler);
+
+    char err[256];
+    UadpSubscriber *sub = uadp_sub_open(url, iface, err, sizeof(err));
+    if (!sub) {
+        fprintf(stderr, "❌ %s\n", err);
+        return 1;
+    }
+    DumpState st;
+    memset(&st, 0, sizeof(st));
+    st.seen = calloc(MAX_ASSETS, 1);
+    if (!st.seen) {
+        fprintf(stderr, "❌ нет памяти\n");
+        uadp_sub_close(sub);
+        return 1;
+    }
+    fprintf(stderr, "📡 Слушаем %s\n", url);
+
+    const double start = now_s();
+    double mark = start;
+    uint64_t lastDgrams = 0;
+    while (!interrupted && (duration_s == 0 || now_s() - start < duration_s)) {
+        if (uadp_sub_poll(sub, 100, on_dataset, &st) < 0) {
+            perror("recvmmsg");
+            break;
+        }
+        double t = now_s();
+        if (t - mark < 1.0)
+            continue;
+        double dt = t - mark;
+        uint64_t dgrams = uadp_sub_datagrams(sub);
+        printf("%.0f датаграмм/с, %.0f наборов/с, агрегатов %zu (из %zu), в тревоге %zu, "
+               "пропущено %llu, не поддерживается %llu\n",
+               (double)(dgrams - lastDgrams) / dt, st.dataSets / dt, st.updated, st.maxAsset,
+               st.alarms, (unsigned long long)uadp_sub_lost(sub),
+               (unsigned long long)uadp_sub_unsupported(sub));
+        if (st.haveLast)
+            printf("  агрегат %ld: вибрация %.3f, температура %.2f, давление %.3f, тревога %s\n",
+                   show_asset, st.last[0], st.last[1], st.last[2], st.last[3] != 0 ? "да" : "нет");
+        fflush(stdout);
+        memset(st.seen, 0, st.maxAsset);
+        st.updated = st.alarms = st.dataSets = 0;
+        lastDgrams = dgrams;
+        mark = t;
+    }
+
+    fprintf(stderr, "✅ Принято %llu датаграмм, пропущено %llu\n",
+            (unsigned long long)uadp_sub_datagrams(sub), (unsigned long long)uadp_sub_lost(sub));
+    free(st.seen);
+    uadp_sub_close(sub);
+    return 0;
+}
@@ -0,0 +1,309 @@
+/*
+ * uadp_sub.c — реализация uadp_sub.h
+ * ---------------------------------
+ */
+#define _GNU_SOURCE // recvmmsg()
+#include "uadp_sub.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define SUB_BATCH     32      // датаграмм на вызов recvmmsg()
+#define SUB_DGRAM_MAX 65536
+#define SUB_GROUPS    16      // отслеживаемых пар (PublisherId, WriterGroupId) для пропусков
+
+typedef struct {
+    uint64_t publisherId;
+    uint16_t writerGroupId;
+    uint16_t lastSeq;
+    int      used;
+} SeqTrack;
+
+struct UadpSubscriber {
+    int        fd;
+    uint8_t   *buf;                   // SUB_BATCH датаграмм
+    struct mmsghdr msgs[SUB_BATCH];
+    struct iovec   iov[SUB_BATCH];
+    UadpField *fields;
+    size_t     capFields;
+    SeqTrack   track[SUB_GROUPS];
+    uint64_t   datagrams, lost, unsupported;
+};
+
+// --- Чтение little-endian с проверкой границ ---
+
+typedef struct {
+    const uint8_t *p, *end;
+    int bad;
+} Reader;
+
+static uint64_t get_le(Reader *r, size_t n) {
+    if (r->bad || (size_t)(r->end - r->p) < n) {
+        r->bad = 1;
+        return 0;
+    }
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; i++)
+        v |= (uint64_t)r->p[i] << (8 * i);
+    r->p += n;
+    return v;
+}
+
+static void skip(Reader *r, size_t n) {
+    if (r->bad || (size_t)(r->end - r->p) < n)
+        r->bad = 1;
+    else
+        r->p += n;
+}
+
+// Скалярный Variant → поле; 0 — успех
+static int get_variant(Reader *r, UadpField *f) {
+    uint8_t mask = (uint8_t)get_le(r, 1);
+    if (mask & 0xC0) // массивы и размерности не поддерживаются
+        return -1;
+    f->type = mask & 0x3F;
+    switch (f->type) {
+    case 1:  f->value = get_le(r, 1) != 0;                  break; // Boolean
+    case 2:  f->value = (int8_t)get_le(r, 1);               break; // SByte
+    case 3:  f->value = (uint8_t)get_le(r, 1);              break; // Byte
+    case 4:  f->value = (int16_t)get_le(r, 2);              break; // Int16
+    case 5:  f->value = (uint16_t)get_le(r, 2);             break; // UInt16
+    case 6:  f->value = (int32_t)get_le(r, 4);              break; // Int32
+    case 7:  f->value = (uint32_t)get_le(r, 4);             break; // UInt32
+    case 8:
+    case 13: f->value = (double)(int64_t)get_le(r, 8);      break; // Int64, DateTime
+    case 9:  f->value = (double)get_le(r, 8);               break; // UInt64
+    case 10: {                                                     // Float
+        uint32_t bits = (uint32_t)get_le(r, 4);
+        float v;
+        memcpy(&v, &bits, sizeof(v));
+        f->value = v;
+        break;
+    }
+    case 11: {                                                     // Double
+        uint64_t bits = get_le(r, 8);
+        memcpy(&f->value, &bits, sizeof(f->value));
+        break;
+    }
+    default:
+        return -1;
+    }
+    return r->bad ? -1 : 0;
+}
+
+static void track_seq(UadpSubscriber *s, uint64_t publisherId, uint16_t writerGroupId, uint16_t seq) {
+    for (int i = 0; i < SUB_GROUPS; i++) {
+        SeqTrack *t = &s->track[i];
+        if (t->used && t->publisherId == publisherId && t->writerGroupId == writerGroupId) {
+            uint16_t gap = (uint16_t)(seq - t->lastSeq - 1);
+            if (gap < 0x8000) // иначе — повтор или перестановка, не пропуск
+                s->lost += gap;
+            t->lastSeq = seq;
+            return;
+        }
+        if (!t->used) {
+            *t = (SeqTrack){ publisherId, writerGroupId, seq, 1 };
+            return;
+        }
+    }
+}
+
+int uadp_decode(UadpSubscriber *s, const uint8_t *buf, size_t len, UadpDataSetCallback cb, void *ctx) {
+    Reader r = { buf, buf + len, 0 };
+    UadpMessageInfo info;
+    memset(&info, 0, sizeof(info));
+
+    // 1. Заголовок NetworkMessage
+    uint8_t flags = (uint8_t)get_le(&r, 1);
+    uint8_t ext1 = flags & 0x80 ? (uint8_t)get_le(&r, 1) : 0;
+    uint8_t ext2 = ext1 & 0x80 ? (uint8_t)get_le(&r, 1) : 0;
+    if ((flags & 0x0F) != 1 || (ext2 & 0x1F) || (ext1 & 0x10)) // версия; chunk/promoted/discovery; шифрование
+        goto unsupported;
+    if (flags & 0x10) {
+        static const size_t idBytes[4] = { 1, 2, 4, 8 };
+        if ((ext1 & 0x07) > 3) // PublisherId String
+            goto unsupported;
+        info.publisherId = get_le(&r, idBytes[ext1 & 0x07]);
+    }
+    if (ext1 & 0x08)
+        skip(&r, 16); // DataSetClassId
+    int haveSeq = 0;
+    if (flags & 0x20) {
+        uint8_t gf = (uint8_t)get_le(&r, 1);
+        if (gf & 0x01) info.writerGroupId = (uint16_t)get_le(&r, 2);
+        if (gf & 0x02) skip(&r, 4); // GroupVersion
+        if (gf & 0x04) skip(&r, 2); // NetworkMessageNumber
+        if (gf & 0x08) {
+            info.networkSeq = (uint16_t)get_le(&r, 2);
+            haveSeq = 1;
+        }
+    }
+    uint8_t count = 1;
+    uint16_t writerIds[256] = { 0 };
+    if (flags & 0x40) {
+        count = (uint8_t)get_le(&r, 1);
+        for (unsigned k = 0; k < count; k++)
+            writerIds[k] = (uint16_t)get_le(&r, 2);
+    }
+    if (ext1 & 0x20)
+        info.timestamp = (int64_t)get_le(&r, 8);
+    if (ext1 & 0x40)
+        skip(&r, 2); // PicoSeconds
+    uint16_t sizes[256] = { 0 };
+    if ((flags & 0x40) && count > 1)
+        for (unsigned k = 0; k < count; k++)
+            sizes[k] = (uint16_t)get_le(&r, 2);
+    if (r.bad)
+        goto unsupported;
+    if (haveSeq)
+        track_seq(s, info.publisherId, info.writerGroupId, info.networkSeq);
+
+    // 2. DataSetMessage
+    int delivered = 0;
+    for (unsigned k = 0; k < count; k++) {
+        const uint8_t *msgEnd = count > 1 ? r.p + sizes[k] : r.end;
+        if (msgEnd > r.end)
+            goto unsupported;
+        Reader m = { r.p, msgEnd, 0 };
+        r.p = msgEnd;
+
+        uint8_t f1 = (uint8_t)get_le(&m, 1);
+        uint8_t f2 = f1 & 0x80 ? (uint8_t)get_le(&m, 1) : 0;
+        info.dataSetWriterId = writerIds[k];
+        info.dataSetSeq = f1 & 0x08 ? (uint16_t)get_le(&m, 2) : 0;
+        if (f2 & 0x10) skip(&m, 8); // Timestamp DataSetMessage
+        if (f2 & 0x20) skip(&m, 2); // PicoSeconds
+        if (f1 & 0x10) skip(&m, 2); // Status
+        if (f1 & 0x20) skip(&m, 4); // ConfigurationVersion Major
+        if (f1 & 0x40) skip(&m, 4); // ConfigurationVersion Minor
+        if (!(f1 & 0x01))           // сообщение помечено недействительным
+            continue;
+        if (((f1 >> 1) & 0x03) != 0 || (f2 & 0x0F) != 0) { // не Variant или не keyframe
+            s->unsupported++;
+            continue;
+        }
+
+        size_t n = (size_t)get_le(&m, 2);
+        if (n > s->capFields) {
+            UadpField *grown = realloc(s->fields, n * sizeof(UadpField));
+            if (!grown)
+                return -1;
+            s->fields = grown;
+            s->capFields = n;
+        }
+        size_t i = 0;
+        while (i < n && get_variant(&m, &s->fields[i]) == 0)
+            i++;
+        if (i < n || m.bad) {
+            s->unsupported++;
+            continue;
+        }
+        cb(ctx, &info, s->fields, n);
+        delivered++;
+    }
+    return delivered;
+
+unsupported:
+    s->unsupported++;
+    return -1;
+}
+
+UadpSubscriber *uadp_sub_open(const char *url, const char *iface, char *err, size_t errLen) {
+    const char *prefix = "opc.udp://";
+    char host[64];
+    unsigned port;
+    struct ip_mreq mreq;
+    memset(&mreq, 0, sizeof(mreq));
+    if (strncmp(url, prefix, strlen(prefix)) != 0 ||
+        sscanf(url + strlen(prefix), "%63[^:]:%u", host, &port) != 2 || port == 0 || port > 65535 ||
+        inet_pton(AF_INET, host, &mreq.imr_multiaddr) != 1) {
+        snprintf(err, errLen, "адрес %s — нужен opc.udp://<IPv4>:<порт>", url);
+        return NULL;
+    }
+    if (iface && inet_pton(AF_INET, iface, &mreq.imr_interface) != 1) {
+        snprintf(err, errLen, "интерфейс %s — нужен IPv4-адрес", iface);
+        return NULL;
+    }
+    if (!iface)
+        mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+
+    UadpSubscriber *s = calloc(1, sizeof(*s));
+    if (!s || !(s->buf = malloc((size_t)SUB_BATCH * SUB_DGRAM_MAX))) {
+        snprintf(err, errLen, "нет памяти");
+        free(s);
+        return NULL;
+    }
+    s->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int one = 1, rcvbuf = 8 << 20;
+    struct sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons((uint16_t)port);
+    sa.sin_addr = mreq.imr_multiaddr; // только датаграммы группы
+    // SO_REUSEADDR — несколько подписчиков на одной машине слушают один порт
+    if (s->fd < 0 || setsockopt(s->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+        bind(s->fd, (struct sockaddr *)&sa, sizeof(sa)) != 0 ||
+        setsockopt(s->fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0) {
+        snprintf(err, errLen, "%s: %s", url, strerror(errno));
+        uadp_sub_close(s);
+        return NULL;
+    }
+    setsockopt(s->fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    for (int i = 0; i < SUB_BATCH; i++) {
+        s->iov[i].iov_base = s->buf + (size_t)i * SUB_DGRAM_MAX;
+        s->iov[i].iov_len  = SUB_DGRAM_MAX;
+        s->msgs[i].msg_hdr.msg_iov    = &s->iov[i];
+        s->msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    return s;
+}
+
+void uadp_sub_close(UadpSubscriber *s) {
+    if (!s)
+        return;
+    if (s->fd >= 0)
+        close(s->fd);
+    free(s->buf);
+    free(s->fields);
+    free(s);
+}
+
+int uadp_sub_fd(const UadpSubscriber *s) { return s->fd; }
+
+int uadp_sub_poll(UadpSubscriber *s, int timeoutMs, UadpDataSetCallback cb, void *ctx) {
+    struct pollfd pfd = { s->fd, POLLIN, 0 };
+    int pr = poll(&pfd, 1, timeoutMs);
+    if (pr < 0)
+        return errno == EINTR ? 0 : -1;
+    if (pr == 0)
+        return 0;
+
+    int delivered = 0;
+    for (;;) {
+        int r = recvmmsg(s->fd, s->msgs, SUB_BATCH, MSG_DONTWAIT, NULL);
+        if (r < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                break;
+            return -1;
+        }
+        for (int i = 0; i < r; i++) {
+            int d = uadp_decode(s, s->iov[i].iov_base, s->msgs[i].msg_len, cb, ctx);
+            delivered += d > 0 ? d : 0;
+        }
+        s->datagrams += (uint64_t)r;
+        if (r < SUB_BATCH)
+            break;
+    }
+    return delivered;
+}
+
+uint64_t uadp_sub_datagrams(const UadpSubscriber *s)  { return s->datagrams; }
+uint64_t uadp_sub_lost(const UadpSubscriber *s)       { return s->lost; }
+uint64_t uadp_sub_unsupported(const UadpSubscriber *s) { return s->unsupported; }
@@ -0,0 +1,63 @@
+/*
+ * uadp_sub.h — лёгкий подписчик OPC UA PubSub (UADP поверх UDP multicast)
+ * ----------------------------------------------------------------------
+ * Принимает NetworkMessage из multicast-группы (dynamic4 --pubsub) и отдаёт
+ * каждое DataSetMessage колбэку уже разобранным: заголовки и массив полей.
+ * Без open62541 и без сессии с сервером — сколько угодно потребителей слушают
+ * одну группу, сервер отправляет каждую датаграмму один раз.
+ *
+ * Поддерживается UADP без шифрования: любые PublisherId (кроме String),
+ * GroupHeader, PayloadHeader с несколькими DataSetMessage, Timestamp;
+ * поля DataSetMessage — в кодировке Variant, скалярные числовые типы и Boolean.
+ * Остальное (RawData, DataValue, массивы) считается в uadp_sub_unsupported().
+ *
+ * Раскладка полей набора equipment от dynamic4 — в open62541/uadp_pub.h:
+ *   [0] — номер первого агрегата, далее по 4 поля на агрегат (vib, temp, press, alarm).
+ *
+ * Сборка вместе с потребителем:
+ *   gcc consumer.c uadp_sub.c -o consumer
+ */
+#ifndef UADP_SUB_H
+#define UADP_SUB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Заголовки одного DataSetMessage
+typedef struct {
+    uint64_t publisherId;
+    uint16_t writerGroupId;
+    uint16_t networkSeq;       // SequenceNumber NetworkMessage (если есть)
+    uint16_t dataSetWriterId;
+    uint16_t dataSetSeq;       // SequenceNumber DataSetMessage (если есть)
+    int64_t  timestamp;        // UA_DateTime NetworkMessage, 0 — нет
+} UadpMessageInfo;
+
+// Поле: встроенный тип Variant (1 — Boolean, 7 — UInt32, 11 — Double, ...) и значение
+typedef struct {
+    uint8_t type;
+    double  value;
+} UadpField;
+
+typedef void (*UadpDataSetCallback)(void *ctx, const UadpMessageInfo *info,
+                                    const UadpField *fields, size_t nFields);
+
+typedef struct UadpSubscriber UadpSubscriber;
+
+// Вход в группу url (opc.udp://<группа>:<порт>); iface — IPv4 интерфейса или NULL
+UadpSubscriber *uadp_sub_open(const char *url, const char *iface, char *err, size_t errLen);
+void uadp_sub_close(UadpSubscriber *s);
+int uadp_sub_fd(const UadpSubscriber *s); // для poll()/epoll в своём цикле
+
+// Приём всех датаграмм, ожидая первую не дольше timeoutMs (0 — не ждать).
+// Возвращает число переданных колбэку DataSetMessage или -1 при ошибке сокета
+int uadp_sub_poll(UadpSubscriber *s, int timeoutMs, UadpDataSetCallback cb, void *ctx);
+
+// Разбор одной датаграммы (без сокета); -1 — некорректная или неподдерживаемая
+int uadp_decode(UadpSubscriber *s, const uint8_t *buf, size_t len, UadpDataSetCallback cb, void *ctx);
+
+uint64_t uadp_sub_datagrams(const UadpSubscriber *s);  // принято датаграмм
+uint64_t uadp_sub_lost(const UadpSubscriber *s);       // пропуски по SequenceNumber NetworkMessage
+uint64_t uadp_sub_unsupported(const UadpSubscriber *s); // отброшено: формат не поддерживается
+
+#endif
@@ -0,0 +1,251 @@
+/*
+ * alarm_engine.c — реализация alarm_engine.h
+ * -----------------------------------------
+ * Все правила сводятся к одному виду «s >= порог»:
+ *   s = sign · (x - rate · prev) · scale,
+ * где sign = -1 для low/fall, rate = 1 и scale = 1/dt для rise/fall.
+ * Порог срабатывания on = sign · limit, порог удержания off = on - hysteresis.
+ */
+#include "alarm_engine.h"
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct AlarmEngine {
+    size_t     n, nRules;
+    AlarmRule *rules;
+    uint8_t   *active;               // [nRules * n] состояние
+    float     *timer;                // [nRules * n] сколько секунд держится смена
+    size_t    *activeCount;          // [nRules]
+    uint8_t   *flip;                 // [n] переходы текущего правила
+    double    *prev[ALARM_MAX_TAGS]; // значения прошлого вызова — для rise/fall
+    int        primed;
+    AlarmEvent *events;
+    size_t     nEvents, capEvents;
+};
+
+static const char *const kind_names[] = { "high", "low", "rise", "fall" };
+
+// --- Файл правил ---
+
+static int parse_rule(char *line, const char *const tagNames[], size_t nTags, AlarmRule *r,
+                      char *err, size_t errLen) {
+    char name[64], tag[64], kind[16];
+    unsigned sev;
+    int used = 0;
+    memset(r, 0, sizeof(*r));
+    if (sscanf(line, "%63s %63s %15s %lf %lf %lf %lf %u %n", name, tag, kind, &r->limit,
+               &r->hysteresis, &r->onDelay, &r->offDelay, &sev, &used) < 8) {
+        snprintf(err, errLen, "нужно 8 полей: имя тег вид порог гистерезис on_delay off_delay severity");
+        return -1;
+    }
+    if (strlen(name) >= sizeof(r->name)) {
+        snprintf(err, errLen, "имя длиннее %zu символов", sizeof(r->name) - 1);
+        return -1;
+    }
+    strcpy(r->name, name);
+
+    size_t t = 0;
+    while (t < nTags && strcmp(tag, tagNames[t]) != 0)
+        t++;
+    if (t == nTags || t >= ALARM_MAX_TAGS) {
+        snprintf(err, errLen, "неизвестный тег %s", tag);
+        return -1;
+    }
+    r->tag = (unsigned)t;
+
+    size_t k = 0;
+    while (k < sizeof(kind_names) / sizeof(kind_names[0]) && strcmp(kind, kind_names[k]) != 0)
+        k++;
+    if (k == sizeof(kind_names) / sizeof(kind_names[0])) {
+        snprintf(err, errLen, "вид %s — нужен high, low, rise или fall", kind);
+        return -1;
+    }
+    r->kind = (AlarmKind)k;
+
+    if (r->hysteresis < 0 || r->onDelay < 0 || r->offDelay < 0 || sev < 1 || sev > 1000) {
+        snprintf(err, errLen, "гистерезис и задержки >= 0, severity 1..1000");
+        return -1;
+    }
+    r->severity = (uint16_t)sev;
+
+    // Сообщение — остаток строки; по умолчанию имя правила
+    char *msg = line + used;
+    size_t len = strlen(msg);
+    while (len > 0 && isspace((unsigned char)msg[len - 1]))
+        msg[--len] = '\0';
+    snprintf(r->message, sizeof(r->message), "%s", len ? msg : r->name);
+    return 0;
+}
+
+int alarm_rules_load(const char *path, const char *const tagNames[], size_t nTags,
+                     AlarmRule **rules, size_t *nRules, char *err, size_t errLen) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        snprintf(err, errLen, "%s: %s", path, strerror(errno));
+        return -1;
+    }
+    AlarmRule *out = NULL;
+    size_t n = 0, cap = 0;
+    char line[512], msg[160];
+    int lineNo = 0, rc = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        char *hash = strchr(line, '#');
+        if (hash)
+            *hash = '\0';
+        char *p = line;
+        while (isspace((unsigned char)*p))
+            p++;
+        if (!*p)
+            continue;
+        if (n == cap) {
+            cap = cap ? cap * 2 : 8;
+            AlarmRule *grown = realloc(out, cap * sizeof(AlarmRule));
+            if (!grown) {
+                snprintf(err, errLen, "нет памяти");
+                rc = -1;
+                break;
+            }
+            out = grown;
+        }
+        if (parse_rule(p, tagNames, nTags, &out[n], msg, sizeof(msg)) != 0) {
+            snprintf(err, errLen, "%s:%d: %s", path, lineNo, msg);
+            rc = -1;
+            break;
+        }
+        n++;
+    }
+    fclose(f);
+    if (rc == 0 && n == 0) {
+        snprintf(err, errLen, "%s: нет ни одного правила", path);
+        rc = -1;
+    }
+    if (rc != 0) {
+        free(out);
+        return -1;
+    }
+    *rules = out;
+    *nRules = n;
+    return 0;
+}
+
+// --- Движок ---
+
+AlarmEngine *alarm_engine_new(const AlarmRule *rules, size_t nRules, size_t nAssets) {
+    AlarmEngine *e = calloc(1, sizeof(*e));
+    if (!e)
+        return NULL;
+    e->n = nAssets;
+    e->nRules = nRules;
+    e->rules       = malloc(nRules * sizeof(AlarmRule));
+    e->active      = calloc(nRules * nAssets, sizeof(uint8_t));
+    e->timer       = calloc(nRules * nAssets, sizeof(float));
+    e->activeCount = calloc(nRules, sizeof(size_t));
+    e->flip        = calloc(nAssets, sizeof(uint8_t));
+    int ok = e->rules && e->active && e->timer && e->activeCount && e->flip;
+    for (size_t r = 0; ok && r < nRules; r++) {
+        e->rules[r] = rules[r];
+        unsigned t = rules[r].tag;
+        if (t >= ALARM_MAX_TAGS)
+            ok = 0;
+        else if ((rules[r].kind == ALARM_RISE || rules[r].kind == ALARM_FALL) && !e->prev[t])
+            ok = (e->prev[t] = calloc(nAssets, sizeof(double))) != NULL;
+    }
+    if (!ok) {
+        alarm_engine_free(e);
+        return NULL;
+    }
+    return e;
+}
+
+void alarm_engine_free(AlarmEngine *e) {
+    if (!e)
+        return;
+    for (size_t t = 0; t < ALARM_MAX_TAGS; t++)
+        free(e->prev[t]);
+    free(e->rules); free(e->active); free(e->timer);
+    free(e->activeCount); free(e->flip); free(e->events);
+    free(e);
+}
+
+static void push_event(AlarmEngine *e, size_t i, size_t r, uint8_t active, double value) {
+    if (e->nEvents == e->capEvents) {
+        size_t cap = e->capEvents ? e->capEvents * 2 : 256;
+        AlarmEvent *grown = realloc(e->events, cap * sizeof(AlarmEvent));
+        if (!grown)
+            return; // событие теряется, состояние движка остаётся верным
+        e->events = grown;
+        e->capEvents = cap;
+    }
+    e->events[e->nEvents++] = (AlarmEvent){ (uint32_t)i, (uint16_t)r, active, value };
+}
+
+// Проход одного правила по всем агрегатам — без ветвлений, векторизуется
+static void eval_rule(size_t n, const double *restrict x, const double *restrict prev,
+                      double sign, double rate, double scale, double on, double off,
+                      float dt, float onDelay, float offDelay,
+                      uint8_t *restrict active, float *restrict timer, uint8_t *restrict flip) {
+    for (size_t i = 0; i < n; i++) {
+        const double s = sign * (x[i] - rate * prev[i]) * scale;
+        const uint8_t a = active[i];
+        const uint8_t want = s >= (a ? off : on);    // каким должно быть состояние
+        const float t = want != a ? timer[i] + dt : 0.0f;
+        const uint8_t f = t >= (a ? offDelay : onDelay) && want != a;
+        active[i] = a ^ f;
+        timer[i] = f ? 0.0f : t;
+        flip[i] = f;
+    }
+}
+
+size_t alarm_engine_eval(AlarmEngine *e, const double *const *tags, double dt) {
+    e->nEvents = 0;
+    if (e->primed && dt > 0) {
+        for (size_t r = 0; r < e->nRules; r++) {
+            const AlarmRule *ru = &e->rules[r];
+            const int isRate = ru->kind == ALARM_RISE || ru->kind == ALARM_FALL;
+            const double sign = ru->kind == ALARM_LOW || ru->kind == ALARM_FALL ? -1.0 : 1.0;
+            const double on = ru->kind == ALARM_LOW ? -ru->limit : ru->limit;
+            const double *x = tags[ru->tag];
+            // для high/low prev не используется (rate = 0) — подставляем сам x
+            const double *prev = isRate ? e->prev[ru->tag] : x;
+            uint8_t *active = e->active + r * e->n;
+            eval_rule(e->n, x, prev, sign, isRate ? 1.0 : 0.0, isRate ? 1.0 / dt : 1.0,
+                      on, on - ru->hysteresis, (float)dt, (float)ru->onDelay, (float)ru->offDelay,
+                      active, e->timer + r * e->n, e->flip);
+
+            // Переходы редки: пропускаем по 8 байт нулей за раз
+            size_t i = 0;
+            for (; i + 8 <= e->n; i += 8) {
+                uint64_t w;
+                memcpy(&w, e->flip + i, 8);
+                if (!w)
+                    continue;
+                for (size_t j = i; j < i + 8; j++)
+                    if (e->flip[j]) {
+                        double v = isRate ? (x[j] - prev[j]) / dt : x[j];
+                        push_event(e, j, r, active[j], v);
+                        e->activeCount[r] += active[j] ? 1 : (size_t)-1;
+                    }
+            }
+            for (; i < e->n; i++)
+                if (e->flip[i]) {
+                    double v = isRate ? (x[i] - prev[i]) / dt : x[i];
+                    push_event(e, i, r, active[i], v);
+                    e->activeCount[r] += active[i] ? 1 : (size_t)-1;
+                }
+        }
+    }
+    for (size_t t = 0; t < ALARM_MAX_TAGS; t++)
+        if (e->prev[t])
+            memcpy(e->prev[t], tags[t], e->n * sizeof(double));
+    e->primed = 1;
+    return e->nEvents;
+}
+
+const AlarmEvent *alarm_engine_events(const AlarmEngine *e) { return e->events; }
+const AlarmRule *alarm_engine_rule(const AlarmEngine *e, size_t r) { return &e->rules[r]; }
+size_t alarm_engine_rule_count(const AlarmEngine *e) { return e->nRules; }
+size_t alarm_engine_active(const AlarmEngine *e, size_t r) { return e->activeCount[r]; }
@@ -0,0 +1,76 @@
+/*
+ * alarm_engine.h — тревоги по таблице правил для всего парка
+ * ---------------------------------------------------------
+ * Правило — условие на один тег каждого агрегата:
+ *   high  — значение >= limit,           сброс при значении < limit - hysteresis;
+ *   low   — значение <= limit,           сброс при значении > limit + hysteresis;
+ *   rise  — скорость роста >= limit ед./с, сброс при скорости < limit - hysteresis;
+ *   fall  — скорость спада >= limit ед./с, сброс аналогично.
+ * Срабатывание — если условие держится on_delay секунд подряд, сброс — если
+ * условие сброса держится off_delay секунд (0 — сразу): дребезг у порога
+ * не порождает пачки событий.
+ *
+ * Вычисление — один проход на правило по массивам парка (struct-of-arrays),
+ * без ветвлений: состояние — uint8_t, таймер задержки — float, порог выбирается
+ * по текущему состоянию. Компилятор векторизует проход при -O3. Наружу отдаются
+ * только переходы (alarm_engine_events) — по ним сервер поднимает события
+ * OPC UA Alarms & Conditions.
+ *
+ * Файл правил — строка на правило, поля через пробелы, # — комментарий:
+ *   # имя      тег          вид   порог гистерезис on_delay off_delay severity сообщение
+ *   vib_high   vibration    high  7.0   0.5         0        0         700      Вибрация выше нормы
+ * Пример — open62541/alarms.rules.
+ */
+#ifndef ALARM_ENGINE_H
+#define ALARM_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ALARM_MAX_TAGS 8
+
+typedef enum { ALARM_HIGH, ALARM_LOW, ALARM_RISE, ALARM_FALL } AlarmKind;
+
+typedef struct {
+    char      name[32];      // имя правила (BrowseName условия)
+    unsigned  tag;           // индекс тега в tags[] alarm_engine_eval()
+    AlarmKind kind;
+    double    limit;         // порог; для rise/fall — единиц тега в секунду
+    double    hysteresis;    // отступ от порога для сброса
+    double    onDelay;       // с — условие держится до срабатывания
+    double    offDelay;      // с — условие сброса держится до сброса
+    uint16_t  severity;      // 1..1000
+    char      message[96];
+} AlarmRule;
+
+// Переход состояния: агрегат, правило, новое состояние и значение (или скорость) тега
+typedef struct {
+    uint32_t asset;
+    uint16_t rule;
+    uint8_t  active;
+    double   value;
+} AlarmEvent;
+
+typedef struct AlarmEngine AlarmEngine;
+
+// Чтение файла правил; tagNames — имена тегов в порядке индексов.
+// 0 — успех (*rules выделяется, освобождать free()), -1 — ошибка, текст в err.
+int alarm_rules_load(const char *path, const char *const tagNames[], size_t nTags,
+                     AlarmRule **rules, size_t *nRules, char *err, size_t errLen);
+
+// Движок на nAssets агрегатов; правила копируются. NULL при нехватке памяти
+AlarmEngine *alarm_engine_new(const AlarmRule *rules, size_t nRules, size_t nAssets);
+void alarm_engine_free(AlarmEngine *e);
+
+// Проход по всем правилам: tags[t][i] — значение тега t агрегата i, dt — секунды
+// с прошлого вызова. Первый вызов только запоминает значения. Возвращает число переходов.
+size_t alarm_engine_eval(AlarmEngine *e, const double *const *tags, double dt);
+
+// Переходы последнего alarm_engine_eval()
+const AlarmEvent *alarm_engine_events(const AlarmEngine *e);
+
+const AlarmRule *alarm_engine_rule(const AlarmEngine *e, size_t r);
+size_t alarm_engine_rule_count(const AlarmEngine *e);
+size_t alarm_engine_active(const AlarmEngine *e, size_t r); // активных агрегатов по правилу
+
+#endif
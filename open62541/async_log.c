@@ -0,0 +1,217 @@
+/*
+ * async_log.c — реализация async_log.h
+ * -----------------------------------
+ * Кольцо слотов фиксированного размера. У слота свой номер seq:
+ *   seq == pos         — слот свободен для записи с позиции pos;
+ *   seq == pos + 1     — строка записана и ждёт потока вывода;
+ *   seq == pos + cap   — поток вывода освободил слот для следующего круга.
+ * Писатели резервируют позицию CAS по enqPos, поэтому писать можно из любых
+ * потоков; читатель один — фоновый поток.
+ *
+ * Остановка: alog_stop() сбрасывает started (новые строки идут синхронно), ждёт,
+ * пока писатели, уже взявшие кольцо (счётчик active), закончат, и только затем
+ * останавливает поток и освобождает слоты.
+ */
+#include "async_log.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ALOG_MSG_MAX   232            // текст строки; слот — 256 байт
+#define ALOG_IDLE_NS   5000000L       // пауза потока вывода при пустом буфере, 5 мс
+#define ALOG_OUT_BYTES 65536          // буфер пачки для write()
+
+typedef struct {
+    _Atomic uint64_t seq;
+    int64_t  ts_us;
+    uint16_t len;
+    uint8_t  level;
+    char     msg[ALOG_MSG_MAX];
+} LogSlot;
+
+static LogSlot *slots;
+static uint64_t mask;
+static _Atomic uint64_t enqPos;
+static uint64_t deqPos;                 // только поток вывода
+static _Atomic int started;
+static _Atomic int active;              // писателей внутри alog_write с кольцом
+static _Atomic int stopping;
+static pthread_t thread;
+
+static double maxRate;
+static _Atomic int64_t  rateWindow;     // текущая секунда ограничения частоты
+static _Atomic uint64_t rateCount;
+static _Atomic uint64_t dropped, suppressed;
+
+static const char *const level_names[] = { "info", "warn", "error" };
+
+static int64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Строка в формате лога → out; возвращает длину
+static size_t format_line(char *out, size_t cap, int64_t ts_us, int level, const char *msg, size_t len) {
+    time_t sec = (time_t)(ts_us / 1000000);
+    struct tm tm;
+    gmtime_r(&sec, &tm);
+    int n = snprintf(out, cap, "[%04d-%02d-%02d %02d:%02d:%02d.%03d (UTC+0000)] %s/userland\t%.*s\n",
+                     tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+                     (int)(ts_us / 1000 % 1000), level_names[level], (int)len, msg);
+    return n < 0 ? 0 : (size_t)n < cap ? (size_t)n : cap - 1;
+}
+
+static void write_all(const char *p, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(STDOUT_FILENO, p, len);
+        if (n <= 0)
+            return;
+        p += n;
+        len -= (size_t)n;
+    }
+}
+
+// Забрать всё готовое из кольца; возвращает число строк
+static size_t drain(void) {
+    static char out[ALOG_OUT_BYTES];
+    size_t used = 0, lines = 0;
+    for (;;) {
+        LogSlot *s = &slots[deqPos & mask];
+        uint64_t seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+        if (seq != deqPos + 1)
+            break;
+        if (ALOG_OUT_BYTES - used < ALOG_MSG_MAX + 64) {
+            write_all(out, used);
+            used = 0;
+        }
+        used += format_line(out + used, ALOG_OUT_BYTES - used, s->ts_us, s->level, s->msg, s->len);
+        atomic_store_explicit(&s->seq, deqPos + mask + 1, memory_order_release);
+        deqPos++;
+        lines++;
+    }
+    write_all(out, used);
+    return lines;
+}
+
+static void *writer_main(void *arg) {
+    (void)arg;
+    const struct timespec idle = { 0, ALOG_IDLE_NS };
+    for (;;) {
+        int stop = atomic_load(&stopping);
+        if (drain() == 0) {
+            if (stop)
+                break;
+            nanosleep(&idle, NULL);
+        }
+    }
+    return NULL;
+}
+
+int alog_start(size_t capacity, double maxPerSec) {
+    size_t cap = 64;
+    while (cap < capacity)
+        cap <<= 1;
+    slots = calloc(cap, sizeof(LogSlot));
+    if (!slots)
+        return -1;
+    for (size_t i = 0; i < cap; i++)
+        atomic_init(&slots[i].seq, i);
+    mask = cap - 1;
+    maxRate = maxPerSec;
+    atomic_store(&enqPos, 0);
+    deqPos = 0;
+    atomic_store(&stopping, 0);
+    if (pthread_create(&thread, NULL, writer_main, NULL) != 0) {
+        free(slots);
+        slots = NULL;
+        return -1;
+    }
+    atomic_store(&started, 1);
+    return 0;
+}
+
+void alog_stop(void) {
+    if (!atomic_exchange(&started, 0))
+        return;
+    // Новые писатели уже видят started == 0; дожидаемся тех, кто взял кольцо раньше
+    const struct timespec pause = { 0, 100000L };
+    while (atomic_load(&active) > 0)
+        nanosleep(&pause, NULL);
+    atomic_store(&stopping, 1);
+    pthread_join(thread, NULL);
+    free(slots);
+    slots = NULL;
+    if (atomic_load(&dropped) || atomic_load(&suppressed))
+        fprintf(stderr, "Лог: отброшено строк — буфер полон: %llu, ограничение частоты: %llu\n",
+                (unsigned long long)atomic_load(&dropped), (unsigned long long)atomic_load(&suppressed));
+}
+
+// Ограничение частоты INFO: счётчик строк в текущей секунде
+static int rate_allows(int64_t ts_us) {
+    if (maxRate <= 0)
+        return 1;
+    int64_t sec = ts_us / 1000000;
+    int64_t win = atomic_load_explicit(&rateWindow, memory_order_relaxed);
+    if (sec != win && atomic_compare_exchange_strong(&rateWindow, &win, sec))
+        atomic_store_explicit(&rateCount, 0, memory_order_relaxed);
+    return atomic_fetch_add_explicit(&rateCount, 1, memory_order_relaxed) < (uint64_t)maxRate;
+}
+
+void alog_write(int level, const char *fmt, ...) {
+    va_list ap;
+    int64_t ts = now_us();
+    if (level == ALOG_INFO && !rate_allows(ts)) {
+        atomic_fetch_add_explicit(&suppressed, 1, memory_order_relaxed);
+        return;
+    }
+
+    atomic_fetch_add(&active, 1); // до проверки started: alog_stop() не освободит кольцо под нами
+    if (!atomic_load(&started)) { // без потока — синхронно
+        atomic_fetch_sub(&active, 1);
+        char msg[ALOG_MSG_MAX], line[ALOG_MSG_MAX + 64];
+        va_start(ap, fmt);
+        int n = vsnprintf(msg, sizeof(msg), fmt, ap);
+        va_end(ap);
+        size_t len = n < 0 ? 0 : (size_t)n < sizeof(msg) ? (size_t)n : sizeof(msg) - 1;
+        write_all(line, format_line(line, sizeof(line), ts, level, msg, len));
+        return;
+    }
+
+    // Резервирование слота
+    uint64_t pos = atomic_load_explicit(&enqPos, memory_order_relaxed);
+    LogSlot *s;
+    for (;;) {
+        s = &slots[pos & mask];
+        uint64_t seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+        int64_t diff = (int64_t)(seq - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&enqPos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) { // буфер полон — не ждём
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            atomic_fetch_sub(&active, 1);
+            return;
+        } else {
+            pos = atomic_load_explicit(&enqPos, memory_order_relaxed);
+        }
+    }
+
+    va_start(ap, fmt);
+    int n = vsnprintf(s->msg, sizeof(s->msg), fmt, ap);
+    va_end(ap);
+    s->len   = (uint16_t)(n < 0 ? 0 : (size_t)n < sizeof(s->msg) ? (size_t)n : sizeof(s->msg) - 1);
+    s->level = (uint8_t)level;
+    s->ts_us = ts;
+    atomic_store_explicit(&s->seq, pos + 1, memory_order_release);
+    atomic_fetch_sub(&active, 1);
+}
+
+uint64_t alog_dropped(void)    { return atomic_load(&dropped); }
+uint64_t alog_suppressed(void) { return atomic_load(&suppressed); }
@@ -0,0 +1,51 @@
+/*
+ * async_log.h — неблокирующий лог для колбэков сервера
+ * ---------------------------------------------------
+ * UA_LOG_INFO пишет в stdout синхронно, и при большом парке или частом тике
+ * запись в терминал/журнал становится самой дорогой частью update_cb.
+ * Здесь колбэк только форматирует строку в слот кольцевого буфера
+ * (без блокировок, очередь Вьюкова с номерами слотов), а фоновый поток
+ * забирает строки и пишет их в stdout пачками.
+ *
+ *   — Буфер полон → строка отбрасывается и учитывается в alog_dropped().
+ *   — Ограничение частоты: не больше maxPerSec строк INFO в секунду,
+ *     остальные учитываются в alog_suppressed(); WARN и ERROR не ограничиваются.
+ *   — ALOG_EVERY(n, ...) — выборка: пишет каждый n-й вызов в этой точке кода.
+ *
+ * Формат строки близок к UA_Log_Stdout: [время UTC] уровень/userland<TAB>текст.
+ * До alog_start() и после alog_stop() строки пишутся синхронно.
+ *
+ * Сборка вместе с сервером:
+ *   gcc server.c async_log.c -lopen62541 -pthread
+ */
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum { ALOG_INFO = 0, ALOG_WARN, ALOG_ERROR };
+
+// Запуск фонового потока: capacity строк в буфере (округляется до степени двойки),
+// maxPerSec — предел строк INFO в секунду (0 — без предела). 0 — успех.
+int alog_start(size_t capacity, double maxPerSec);
+
+// Остановка: новые строки — синхронно; начатые записи завершаются, поток дописывает
+// всё, что в буфере, и завершается. Слоты освобождаются после этого
+void alog_stop(void);
+
+// Неблокирующая запись строки (printf-формат, перевод строки добавляется)
+void alog_write(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+uint64_t alog_dropped(void);    // отброшено из-за полного буфера
+uint64_t alog_suppressed(void); // отброшено ограничением частоты
+
+// Каждый n-й вызов в данной точке кода (n >= 1)
+#define ALOG_EVERY(n, level, ...)                         \
+    do {                                                  \
+        static uint64_t alog_every_counter_;              \
+        if (alog_every_counter_++ % (uint64_t)(n) == 0)   \
+            alog_write(level, __VA_ARGS__);               \
+    } while (0)
+
+#endif
@@ -0,0 +1,335 @@
+/*
+ * datagen.c — офлайн-генератор обучающих данных на модели сигналов dynamic4.c
+ * --------------------------------------------------------------------------
+ * Вместо многочасового сбора с живого сервера считает тики модели
+ * (signal_model.c) быстрее реального времени на всех ядрах и пишет CSV
+ * в формате data/sensor_data.csv:
+ *   ts,vibration,temperature,pressure,vibration_alarm[,asset_id]
+ *
+ * Значения совпадают с тем, что опубликовал бы dynamic4 с тем же --seed
+ * и --assets (тик k сервера = тик k генератора). Метки времени — синтетические:
+ * start + k * interval, по умолчанию от 2025-01-01 00:00:00 UTC с шагом 2 с,
+ * как у сервера с периодом по умолчанию.
+ *
+ * Распараллеливание:
+ *   Выход режется на куски по тикам (~64k строк). Потоки берут куски по
+ *   атомарному счётчику, форматируют их в слоты кольца буферов, а главный
+ *   поток пишет слоты строго по порядку — файл одинаков при любом --threads.
+ *
+ * Сборка:
+ *   gcc -O3 -march=native -ffast-math -pthread datagen.c signal_model.c -lm -o servers/datagen
+ *
+ * Запуск:
+ *   servers/datagen --rows 7000 -o ../data/sensor_data_sim.csv
+ *   servers/datagen --assets 1000 --rows 300000000 --seed 42 --digits 6 -o /data/fleet.csv
+ *
+ * Parquet: python -c "import pandas as pd; pd.read_csv('fleet.csv').to_parquet('fleet.parquet')"
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>                            // llround()
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>                            // gmtime_r()
+#include <unistd.h>                          // write(), sysconf()
+#include "signal_model.h"
+
+#define MAX_ASSETS    100000
+#define MAX_THREADS   256
+#define CHUNK_ROWS    65536    // строк в одном куске
+#define ROW_BYTES_MAX 160      // ts (32) + 3 × %.17g (до 24) + тревога + asset_id с запасом
+
+// === Настройки ===
+static size_t   n_assets  = 1;
+static uint64_t n_rows    = 0;
+static uint64_t seed      = 1;
+static int64_t  start_us  = 1735689600LL * 1000000; // 2025-01-01 00:00:00 UTC
+static int64_t  step_us   = 2000000;                // период тика, мкс
+static int      digits    = 0;                      // 0 — точно (%.17g), иначе знаков после запятой
+static int      n_threads = 0;
+static const char *out_path = NULL;
+
+// === Общее состояние модели (только чтение в потоках) ===
+static double   *phase;
+static uint64_t *rng_key;
+static uint64_t  ticks_per_chunk, n_chunks;
+
+// === Кольцо слотов: кусок c форматируется в слот c % n_slots ===
+typedef struct {
+    char    *buf;
+    size_t   len;
+    uint64_t next;  // номер куска, который может занять слот
+    int      ready; // кусок next отформатирован и ждёт записи
+} Slot;
+
+static Slot *slots;
+static size_t n_slots;
+static pthread_mutex_t lock       = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  slot_free  = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  slot_ready = PTHREAD_COND_INITIALIZER;
+static atomic_uint_fast64_t next_chunk;
+
+// Состояние потока: массивы одного тика и кэш даты текущей секунды
+typedef struct {
+    double  *vib, *temp, *press;
+    uint8_t *alarm, *diff;
+    int64_t  cached_sec;
+    char     date[20];  // "YYYY-mm-dd HH:MM:SS"
+} Worker;
+
+// --- Форматирование ---
+static char *put_uint(char *p, uint64_t v, int width) {
+    char tmp[24];
+    int n = 0;
+    do { tmp[n++] = (char)('0' + v % 10); v /= 10; } while (v);
+    while (n < width) tmp[n++] = '0';
+    while (n) *p++ = tmp[--n];
+    return p;
+}
+
+static char *put_double(char *p, double v) {
+    static const double pow10[] = { 1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+    if (digits == 0)
+        return p + sprintf(p, "%.17g", v);
+    if (v < 0) { *p++ = '-'; v = -v; }
+    const uint64_t scale = (uint64_t)pow10[digits];
+    const uint64_t q = (uint64_t)llround(v * pow10[digits]);
+    p = put_uint(p, q / scale, 1);
+    *p++ = '.';
+    return put_uint(p, q % scale, digits);
+}
+
+// Метка времени в формате pandas/PostgreSQL: 2025-01-01 00:00:02.000000+00:00
+static char *put_ts(Worker *w, char *p, int64_t us) {
+    int64_t sec = us / 1000000;
+    if (sec != w->cached_sec) {
+        time_t tt = (time_t)sec;
+        struct tm tm;
+        gmtime_r(&tt, &tm);
+        strftime(w->date, sizeof(w->date), "%Y-%m-%d %H:%M:%S", &tm);
+        w->cached_sec = sec;
+    }
+    memcpy(p, w->date, 19);
+    p += 19;
+    *p++ = '.';
+    p = put_uint(p, (uint64_t)(us % 1000000), 6);
+    memcpy(p, "+00:00", 6);
+    return p + 6;
+}
+
+// Кусок c: тики [c * ticks_per_chunk, ...) для всего парка → текст CSV
+static size_t format_chunk(Worker *w, uint64_t c, char *out) {
+    char *p = out;
+    uint64_t k0 = c * ticks_per_chunk;
+    uint64_t k1 = k0 + ticks_per_chunk;
+    // Состояние тревоги перед k0 нужно только для diff — его генератор не пишет
+    for (uint64_t k = k0; k < k1; k++) {
+        signal_model_step(n_assets, k, phase, rng_key, w->vib, w->temp, w->press, w->alarm, w->diff);
+        int64_t us = start_us + (int64_t)k * step_us;
+        for (size_t i = 0; i < n_assets; i++) {
+            if (k * n_assets + i >= n_rows)
+                return (size_t)(p - out);
+            p = put_ts(w, p, us);
+            *p++ = ',';
+            p = put_double(p, w->vib[i]);
+            *p++ = ',';
+            p = put_double(p, w->temp[i]);
+            *p++ = ',';
+            p = put_double(p, w->press[i]);
+            if (w->alarm[i]) { memcpy(p, ",True", 5);  p += 5; }
+            else             { memcpy(p, ",False", 6); p += 6; }
+            if (n_assets > 1) {
+                *p++ = ',';
+                p = put_uint(p, i, 1);
+            }
+            *p++ = '\n';
+        }
+    }
+    return (size_t)(p - out);
+}
+
+static void *worker_main(void *arg) {
+    Worker *w = arg;
+    for (;;) {
+        uint64_t c = atomic_fetch_add(&next_chunk, 1);
+        if (c >= n_chunks)
+            break;
+        Slot *s = &slots[c % n_slots];
+
+        pthread_mutex_lock(&lock);
+        while (s->next != c) // ждём, пока главный поток запишет прошлый кусок слота
+            pthread_cond_wait(&slot_free, &lock);
+        pthread_mutex_unlock(&lock);
+
+        size_t len = format_chunk(w, c, s->buf);
+
+        pthread_mutex_lock(&lock);
+        s->len = len;
+        s->ready = 1;
+        pthread_cond_broadcast(&slot_ready);
+        pthread_mutex_unlock(&lock);
+    }
+    return NULL;
+}
+
+static int write_all(int fd, const char *p, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return 0;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 1;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Использование: %s --rows N [параметры]\n"
+            "  --rows N        всего строк (тики × агрегаты)\n"
+            "  --assets N      агрегатов в парке (1..%d), добавляет колонку asset_id\n"
+            "  --seed S        seed модели (как dynamic4 --seed), по умолчанию 1\n"
+            "  --start SEC     Unix-время первой строки (по умолчанию 2025-01-01 UTC)\n"
+            "  --interval MS   шаг тика, мс (по умолчанию 2000)\n"
+            "  --digits D      знаков после запятой (1..9); без него — точные %%.17g\n"
+            "  --threads N     потоков (по умолчанию — все ядра)\n"
+            "  -o FILE         выходной CSV (по умолчанию stdout)\n",
+            prog, MAX_ASSETS);
+}
+
+static int parse_args(int argc, char **argv) {
+    for (int a = 1; a < argc; a++) {
+        const char *opt = argv[a];
+        if (a + 1 >= argc)
+            return 0;
+        const char *val = argv[++a];
+        if (!strcmp(opt, "--rows"))          n_rows = strtoull(val, NULL, 10);
+        else if (!strcmp(opt, "--assets"))   n_assets = strtoul(val, NULL, 10);
+        else if (!strcmp(opt, "--seed"))     seed = strtoull(val, NULL, 10);
+        else if (!strcmp(opt, "--start"))    start_us = strtoll(val, NULL, 10) * 1000000;
+        else if (!strcmp(opt, "--interval")) step_us = (int64_t)(strtod(val, NULL) * 1000.0);
+        else if (!strcmp(opt, "--digits"))   digits = atoi(val);
+        else if (!strcmp(opt, "--threads"))  n_threads = atoi(val);
+        else if (!strcmp(opt, "-o"))         out_path = val;
+        else return 0;
+    }
+    return n_rows > 0 && n_assets >= 1 && n_assets <= MAX_ASSETS && step_us > 0 &&
+           digits >= 0 && digits <= 9 && n_threads >= 0 && n_threads <= MAX_THREADS;
+}
+
+int main(int argc, char **argv) {
+    if (!parse_args(argc, argv)) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (n_threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        n_threads = cpus < 1 ? 1 : cpus > MAX_THREADS ? MAX_THREADS : (int)cpus;
+    }
+
+    // --- Модель и разбиение на куски ---
+    phase   = calloc(n_assets, sizeof(double));
+    rng_key = calloc(n_assets, sizeof(uint64_t));
+    if (!phase || !rng_key) {
+        fprintf(stderr, "Не удалось выделить память\n");
+        return 1;
+    }
+    signal_model_init(n_assets, seed, phase, rng_key);
+    ticks_per_chunk = CHUNK_ROWS / n_assets ? CHUNK_ROWS / n_assets : 1;
+    uint64_t n_ticks = (n_rows + n_assets - 1) / n_assets;
+    n_chunks = (n_ticks + ticks_per_chunk - 1) / ticks_per_chunk;
+
+    n_slots = 2 * (size_t)n_threads;
+    slots = calloc(n_slots, sizeof(Slot));
+    Worker *workers = calloc((size_t)n_threads, sizeof(Worker));
+    pthread_t *tids = calloc((size_t)n_threads, sizeof(pthread_t));
+    if (!slots || !workers || !tids) {
+        fprintf(stderr, "Не удалось выделить память\n");
+        return 1;
+    }
+    const size_t slot_bytes = ticks_per_chunk * n_assets * ROW_BYTES_MAX;
+    for (size_t s = 0; s < n_slots; s++) {
+        slots[s].buf  = malloc(slot_bytes);
+        slots[s].next = s;
+        if (!slots[s].buf) {
+            fprintf(stderr, "Не удалось выделить память под буферы\n");
+            return 1;
+        }
+    }
+    for (int t = 0; t < n_threads; t++) {
+        Worker *w = &workers[t];
+        w->vib   = calloc(n_assets, sizeof(double));
+        w->temp  = calloc(n_assets, sizeof(double));
+        w->press = calloc(n_assets, sizeof(double));
+        w->alarm = calloc(n_assets, sizeof(uint8_t));
+        w->diff  = calloc(n_assets, sizeof(uint8_t));
+        w->cached_sec = INT64_MIN;
+        if (!w->vib || !w->temp || !w->press || !w->alarm || !w->diff) {
+            fprintf(stderr, "Не удалось выделить память\n");
+            return 1;
+        }
+    }
+
+    int fd = out_path ? open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644) : STDOUT_FILENO;
+    if (fd < 0) {
+        perror(out_path);
+        return 1;
+    }
+
+    // --- Запуск потоков и упорядоченная запись ---
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    static const char header[] = "ts,vibration,temperature,pressure,vibration_alarm";
+    int ok = write_all(fd, header, sizeof(header) - 1) &&
+             (n_assets == 1 || write_all(fd, ",asset_id", 9)) && write_all(fd, "\n", 1);
+
+    for (int t = 0; t < n_threads; t++)
+        pthread_create(&tids[t], NULL, worker_main, &workers[t]);
+
+    uint64_t bytes = 0;
+    for (uint64_t c = 0; c < n_chunks; c++) {
+        Slot *s = &slots[c % n_slots];
+        pthread_mutex_lock(&lock);
+        while (!s->ready)
+            pthread_cond_wait(&slot_ready, &lock);
+        pthread_mutex_unlock(&lock);
+
+        ok = ok && write_all(fd, s->buf, s->len); // после ошибки только освобождаем слоты
+        bytes += s->len;
+
+        pthread_mutex_lock(&lock);
+        s->ready = 0;
+        s->next = c + n_slots;
+        pthread_cond_broadcast(&slot_free);
+        pthread_mutex_unlock(&lock);
+    }
+    for (int t = 0; t < n_threads; t++)
+        pthread_join(tids[t], NULL);
+    if (out_path && close(fd) != 0)
+        ok = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    double sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    if (!ok)
+        perror("Ошибка записи");
+    else
+        fprintf(stderr, "✅ %llu строк, %.1f МБ за %.2f с (%.1f млн строк/с, потоков: %d, seed %llu)\n",
+                (unsigned long long)n_rows, bytes / 1048576.0, sec, n_rows / sec / 1e6,
+                n_threads, (unsigned long long)seed);
+
+    for (size_t s = 0; s < n_slots; s++)
+        free(slots[s].buf);
+    for (int t = 0; t < n_threads; t++) {
+        free(workers[t].vib); free(workers[t].temp); free(workers[t].press);
+        free(workers[t].alarm); free(workers[t].diff);
+    }
+    free(slots); free(workers); free(tids); free(phase); free(rng_key);
+    return ok ? 0 : 1;
+}
@@ -1,6 +1,14 @@
+/*
+ * Сервер с деградирующим параметром, температурой и давлением.
+ * Лог тика уходит через async_log.c, поэтому он собирается вместе с сервером.
+ *
+ * Сборка:
+ *   gcc dynamic.c async_log.c -lopen62541 -lm -pthread -o servers/dynamic
+ */
 #include <open62541/plugin/log_stdout.h>     // Плагин логгера — позволяет выводить сообщения в консоль
 #include <open62541/server.h>                // Основные определения и структуры для OPC UA сервера
 #include <open62541/server_config_default.h> // Быстрая настройка сервера с конфигурацией по умолчанию
+#include "async_log.h"                       // Неблокирующий лог тика — stdout пишет фоновый поток
 #include <signal.h>                          // Для перехвата сигнала Ctrl+C (SIGINT) и завершения работы
 #include <math.h>                            // Для функции sin() — будет использоваться в симуляции температуры
 #include <stdlib.h>                          // Для rand() — генерация случайных колебаний давления
@@ -53,10 +61,9 @@ static void updateParameters(UA_Server *server, void *data) {
     UA_Variant_setScalar(&curVal, &pressureValue, &UA_TYPES[UA_TYPES_DOUBLE]);
     UA_Server_writeValue(server, varNodeId_press, curVal);
 
-    // Выводим все значения в консоль для наблюдения
-    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
-                "Deg: %.1f %%  Temp: %.2f °C  Press: %.3f бар",
-                parameterValue, tempValue, pressureValue);
+    // Выводим все значения в консоль для наблюдения — через кольцо async_log, без записи в stdout в колбэке
+    alog_write(ALOG_INFO, "Deg: %.1f %%  Temp: %.2f °C  Press: %.3f бар",
+               parameterValue, tempValue, pressureValue);
 }
 
 int main(void) {
@@ -68,6 +75,9 @@ int main(void) {
     // Создаём сервер и загружаем конфигурацию по умолчанию (порт 4840, стандартный endpoint)
     UA_Server *server = UA_Server_new();
     UA_ServerConfig_setDefault(UA_Server_getConfig(server));
+    // Фоновый поток лога: 1024 строки в буфере, без ограничения частоты
+    if (alog_start(1024, 0) != 0)
+        UA_LOG_WARNING(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "Асинхронный лог не запущен, пишем синхронно");
 
     // === Создание переменной 1: деградирующий параметр ===
     UA_VariableAttributes attr = UA_VariableAttributes_default;
@@ -118,5 +128,6 @@ int main(void) {
 
     // Завершаем работу
     UA_Server_delete(server);
+    alog_stop();                             // Дописываем строки из буфера и останавливаем поток лога
     return 0;
 }
@@ -1,6 +1,14 @@
+/*
+ * Сервер с растущей вибрацией (износ подшипника), температурой и давлением.
+ * Лог тика уходит через async_log.c, поэтому он собирается вместе с сервером.
+ *
+ * Сборка:
+ *   gcc dynamic2.c async_log.c -lopen62541 -lm -pthread -o servers/dynamic2
+ */
 #include <open62541/plugin/log_stdout.h>
 #include <open62541/server.h>
 #include <open62541/server_config_default.h>
+#include "async_log.h"                        // Неблокирующий лог тика
 #include <signal.h>
 #include <math.h>
 #include <stdlib.h>
@@ -51,9 +59,9 @@ static void updateParameters(UA_Server *server, void *data) {
     UA_Variant_setScalar(&curVal, &pressureValue, &UA_TYPES[UA_TYPES_DOUBLE]);
     UA_Server_writeValue(server, varNodeId_press, curVal);
 
-    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
-                "Vibration: %.2f мм/с  Temp: %.2f °C  Press: %.3f бар",
-                bearingVibration, tempValue, pressureValue);
+    // Лог тика — в кольцо async_log: stdout пишет фоновый поток
+    alog_write(ALOG_INFO, "Vibration: %.2f мм/с  Temp: %.2f °C  Press: %.3f бар",
+               bearingVibration, tempValue, pressureValue);
 }
 
 int main(void) {
@@ -62,6 +70,8 @@ int main(void) {
 
     UA_Server *server = UA_Server_new();
     UA_ServerConfig_setDefault(UA_Server_getConfig(server));
+    if (alog_start(1024, 0) != 0)
+        UA_LOG_WARNING(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "Асинхронный лог не запущен, пишем синхронно");
 
     // ==== Вибрация подшипника ====
     UA_VariableAttributes attr = UA_VariableAttributes_default;
@@ -112,5 +122,6 @@ int main(void) {
 
     // Завершение
     UA_Server_delete(server);
+    alog_stop();
     return 0;
 }
@@ -2,14 +2,26 @@
  * Пример OPC UA сервера на базе open62541.
  * Моделируются параметры оборудования: вибрация подшипника, температура, давление.
  * Реализован флаг тревоги по превышению порога вибрации.
+ *
+ * Переменные equipment.* — узлы с источником данных (UA_DataSource): сервер не
+ * хранит их значения, а при каждом чтении клиента вызывает readTag(), которая
+ * берёт текущие значения прямо из переменных программы. Колбэк обновления
+ * только пересчитывает их — без UA_Server_readValue/writeValue и копий в
+ * хранилище узлов. Запись клиента в вибрацию попадает в bearingVibration,
+ * и следующий тик продолжает от неё. Лог тика — через async_log.c.
+ *
+ * Сборка:
+ *   gcc dynamic3.c async_log.c -lopen62541 -lm -pthread -o servers/dynamic3
  */
 
 #include <open62541/plugin/log_stdout.h>
 #include <open62541/server.h>
 #include <open62541/server_config_default.h>
+#include "async_log.h"                        // Неблокирующий лог тика
 #include <signal.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 static UA_Boolean running = true;
@@ -19,57 +31,83 @@ static UA_NodeId varNodeId_press;  // Давление
 static UA_NodeId varNodeId_alarm;  // Тревожный флаг
 
 static UA_Double bearingVibration = 1.2; // мм/с
+static UA_Double tempValue = 25.0;       // °C
+static UA_Double pressureValue = 1.0;    // бар
 static UA_Boolean alarmState = false;
+static UA_DateTime lastUpdate;           // метка источника последнего пересчёта
 static double t = 0.0;
 
+// Контекст узла: где лежит значение и какого оно типа
+typedef struct {
+    void *value;
+    const UA_DataType *type;
+} TagSource;
+
 // --- Обработчик Ctrl+C ---
 static void stopHandler(int sig) {
     UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "Сервер завершает работу");
     running = false;
 }
 
-static void updateParameters(UA_Server *server, void *data) {
-    UA_Variant curVal;
-    UA_Variant_init(&curVal);
-
-    // 1. Вибрация: рост + шум
-    UA_Server_readValue(server, varNodeId_vib, &curVal);
-    if (UA_Variant_hasScalarType(&curVal, &UA_TYPES[UA_TYPES_DOUBLE])) {
-        bearingVibration = *(UA_Double *)curVal.data;
-        bearingVibration += 0.02 + ((rand() % 11) - 5) / 500.0; // ±0.01 случайно
-        if (bearingVibration > 10.0) bearingVibration = 10.0;
-        if (bearingVibration < 0) bearingVibration = 0;
-
-        UA_Variant_setScalar(&curVal, &bearingVibration, &UA_TYPES[UA_TYPES_DOUBLE]);
-        UA_Server_writeValue(server, varNodeId_vib, curVal);
-
-        // === Проверка порога ===
-        UA_Boolean newAlarmState = (bearingVibration >= 7.0);
-        if (newAlarmState != alarmState) {
-            alarmState = newAlarmState;
-            UA_Variant alarmVal;
-            UA_Variant_setScalar(&alarmVal, &alarmState, &UA_TYPES[UA_TYPES_BOOLEAN]);
-            UA_Server_writeValue(server, varNodeId_alarm, alarmVal);
-        }
+static TagSource srcVib   = { &bearingVibration, &UA_TYPES[UA_TYPES_DOUBLE] };
+static TagSource srcTemp  = { &tempValue,        &UA_TYPES[UA_TYPES_DOUBLE] };
+static TagSource srcPress = { &pressureValue,    &UA_TYPES[UA_TYPES_DOUBLE] };
+static TagSource srcAlarm = { &alarmState,       &UA_TYPES[UA_TYPES_BOOLEAN] };
+
+// --- Чтение узла клиентом: значение берётся из переменной программы ---
+static UA_StatusCode readTag(UA_Server *server, const UA_NodeId *sessionId, void *sessionContext,
+                             const UA_NodeId *nodeId, void *nodeContext, UA_Boolean includeSourceTimeStamp,
+                             const UA_NumericRange *range, UA_DataValue *value) {
+    const TagSource *src = (const TagSource *)nodeContext;
+    if (range)
+        return UA_STATUSCODE_BADINDEXRANGEINVALID; // все теги — скаляры
+    UA_StatusCode rc = UA_Variant_setScalarCopy(&value->value, src->value, src->type);
+    if (rc != UA_STATUSCODE_GOOD)
+        return rc;
+    value->hasValue = true;
+    if (includeSourceTimeStamp) {
+        value->sourceTimestamp = lastUpdate;
+        value->hasSourceTimestamp = true;
     }
+    return UA_STATUSCODE_GOOD;
+}
+
+// --- Запись клиентом (узлы с правом записи): новое значение — в переменную программы ---
+static UA_StatusCode writeTag(UA_Server *server, const UA_NodeId *sessionId, void *sessionContext,
+                              const UA_NodeId *nodeId, void *nodeContext,
+                              const UA_NumericRange *range, const UA_DataValue *value) {
+    const TagSource *src = (const TagSource *)nodeContext;
+    if (range)
+        return UA_STATUSCODE_BADINDEXRANGEINVALID;
+    if (!value->hasValue || !UA_Variant_hasScalarType(&value->value, src->type))
+        return UA_STATUSCODE_BADTYPEMISMATCH;
+    memcpy(src->value, value->value.data, src->type->memSize);
+    lastUpdate = value->hasSourceTimestamp ? value->sourceTimestamp : UA_DateTime_now();
+    return UA_STATUSCODE_GOOD;
+}
+
+static void updateParameters(UA_Server *server, void *data) {
+    // 1. Вибрация: рост + шум (от текущего значения — его мог записать клиент)
+    bearingVibration += 0.02 + ((rand() % 11) - 5) / 500.0; // ±0.01 случайно
+    if (bearingVibration > 10.0) bearingVibration = 10.0;
+    if (bearingVibration < 0) bearingVibration = 0;
+
+    // === Проверка порога ===
+    alarmState = (bearingVibration >= 7.0);
 
     // 2. Температура
     t += 0.1;
-    UA_Double tempValue = 25.0 + 5.0 * sin(t);
-    UA_Variant_setScalar(&curVal, &tempValue, &UA_TYPES[UA_TYPES_DOUBLE]);
-    UA_Server_writeValue(server, varNodeId_temp, curVal);
+    tempValue = 25.0 + 5.0 * sin(t);
 
     // 3. Давление
     double rnd = (rand() % 2001 - 1000) / 10000.0;
-    UA_Double pressureValue = 1.0 + rnd;
-    UA_Variant_setScalar(&curVal, &pressureValue, &UA_TYPES[UA_TYPES_DOUBLE]);
-    UA_Server_writeValue(server, varNodeId_press, curVal);
-
-    // Лог
-    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
-                "Vib: %.2f мм/с  Temp: %.2f°C  Press: %.3f бар  Alarm: %s",
-                bearingVibration, tempValue, pressureValue,
-                alarmState ? "ON" : "OFF");
+    pressureValue = 1.0 + rnd;
+
+    lastUpdate = UA_DateTime_now();
+
+    // Лог тика — в кольцо async_log: stdout пишет фоновый поток
+    alog_write(ALOG_INFO, "Vib: %.2f мм/с  Temp: %.2f°C  Press: %.3f бар  Alarm: %s",
+               bearingVibration, tempValue, pressureValue, alarmState ? "ON" : "OFF");
 }
 
 int main(void) {
@@ -78,62 +116,60 @@ int main(void) {
 
     UA_Server *server = UA_Server_new();
     UA_ServerConfig_setDefault(UA_Server_getConfig(server));
+    if (alog_start(1024, 0) != 0)
+        UA_LOG_WARNING(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "Асинхронный лог не запущен, пишем синхронно");
 
+    UA_DataSource tagSource = { readTag, writeTag };
+    lastUpdate = UA_DateTime_now();
     UA_VariableAttributes attr = UA_VariableAttributes_default;
 
     // --- Вибрация ---
-    UA_Variant_setScalar(&attr.value, &bearingVibration, &UA_TYPES[UA_TYPES_DOUBLE]);
     attr.displayName = UA_LOCALIZEDTEXT("en-US", "Bearing_Vibration_mm_s");
     attr.description = UA_LOCALIZEDTEXT("ru-RU", "Скорость вибрации подшипника, мм/с");
     attr.dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
     attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
     varNodeId_vib = UA_NODEID_STRING(1, "equipment.bearing.vibration");
-    UA_Server_addVariableNode(server, varNodeId_vib,
+    UA_Server_addDataSourceVariableNode(server, varNodeId_vib,
                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
                                UA_QUALIFIEDNAME(1, "Bearing_Vibration_mm_s"),
                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
-                               attr, NULL, NULL);
+                               attr, tagSource, &srcVib, NULL);
 
     // --- Температура ---
-    UA_Double tempInit = 25.0;
-    UA_Variant_setScalar(&attr.value, &tempInit, &UA_TYPES[UA_TYPES_DOUBLE]);
     attr.displayName = UA_LOCALIZEDTEXT("en-US", "Temperature_C");
     attr.description = UA_LOCALIZEDTEXT("ru-RU", "Температура оборудования, °C");
     varNodeId_temp = UA_NODEID_STRING(1, "equipment.temperature");
-    UA_Server_addVariableNode(server, varNodeId_temp,
+    UA_Server_addDataSourceVariableNode(server, varNodeId_temp,
                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
                                UA_QUALIFIEDNAME(1, "Temperature_C"),
                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
-                               attr, NULL, NULL);
+                               attr, tagSource, &srcTemp, NULL);
 
     // --- Давление ---
-    UA_Double pressInit = 1.0;
-    UA_Variant_setScalar(&attr.value, &pressInit, &UA_TYPES[UA_TYPES_DOUBLE]);
     attr.displayName = UA_LOCALIZEDTEXT("en-US", "Pressure_bar");
     attr.description = UA_LOCALIZEDTEXT("ru-RU", "Давление в системе, бар");
     varNodeId_press = UA_NODEID_STRING(1, "equipment.pressure");
-    UA_Server_addVariableNode(server, varNodeId_press,
+    UA_Server_addDataSourceVariableNode(server, varNodeId_press,
                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
                                UA_QUALIFIEDNAME(1, "Pressure_bar"),
                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
-                               attr, NULL, NULL);
+                               attr, tagSource, &srcPress, NULL);
 
     // --- Тревога ---
-    UA_Variant_setScalar(&attr.value, &alarmState, &UA_TYPES[UA_TYPES_BOOLEAN]);
     attr.displayName = UA_LOCALIZEDTEXT("en-US", "Bearing_Alarm");
     attr.description = UA_LOCALIZEDTEXT("ru-RU", "Тревога по вибрации подшипника");
     attr.dataType = UA_TYPES[UA_TYPES_BOOLEAN].typeId;
     attr.accessLevel = UA_ACCESSLEVELMASK_READ;
     varNodeId_alarm = UA_NODEID_STRING(1, "equipment.bearing.alarm");
-    UA_Server_addVariableNode(server, varNodeId_alarm,
+    UA_Server_addDataSourceVariableNode(server, varNodeId_alarm,
                                UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
                                UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
                                UA_QUALIFIEDNAME(1, "Bearing_Alarm"),
                                UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
-                               attr, NULL, NULL);
+                               attr, tagSource, &srcAlarm, NULL);
 
     // --- Колбэк ---
     UA_Server_addRepeatedCallback(server, updateParameters, NULL, 1000, NULL);
@@ -141,5 +177,6 @@ int main(void) {
     // --- Запуск ---
     UA_Server_run(server, &running);
     UA_Server_delete(server);
+    alog_stop();
     return 0;
 }
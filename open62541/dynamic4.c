@@ -8,16 +8,179 @@
  *
  * Дополнительно:
  *   — Логический флаг Bearing_Alarm = true при вибрации >= 7.0 мм/с, иначе false.
- *   — Обновление каждые 100 мс для имитации реального потока данных (10 Гц).
+ *   — Обновление каждые --interval мс (по умолчанию 2000 мс; --interval 100 — поток 10 Гц, как в gen.c).
+ *
+ * Режим парка (--assets N):
+ *   Сервер моделирует N агрегатов (10..100k) вместо одного. Состояние хранится
+ *   в непрерывных массивах (struct-of-arrays), и каждый тик пересчитывает весь
+ *   парк одним проходом без ветвлений — компилятор векторизует его при -O3.
+ *   У каждого агрегата своё поддерево узлов:
+ *     ns=1;s=equipment.<id>.bearing.vibration
+ *     ns=1;s=equipment.<id>.temperature
+ *     ns=1;s=equipment.<id>.pressure
+ *     ns=1;s=equipment.<id>.bearing.alarm
+ *   Без --assets сервер работает как раньше: один агрегат, узлы equipment.*.
+ *
+ * Зона нечувствительности:
+ *   У вибрации, температуры и давления есть свойство EURange (0..15 мм/с, 0..100 °C,
+ *   0..2 бар) — диапазон, от которого сервер считает процентный порог DataChangeFilter
+ *   (DeadbandType Percent). Абсолютный и процентный пороги задаёт клиент при создании
+ *   MonitoredItem (collector --deadband); шум ниже порога сервер не отправляет.
+ *   Процентный порог требует open62541 с -DUA_ENABLE_DA=ON (по умолчанию включено).
+ *
+ * История (--history N):
+ *   Последние N отсчётов каждого узла хранятся в кольцевых буферах (history_ring.c)
+ *   и доступны через HistoryRead (ReadRawModified), чтобы сборщик мог дозабрать
+ *   пропуски после переподключения. Память: узлов × N × 16 байт, выделяется при старте.
+ *   Нужна open62541 с -DUA_ENABLE_HISTORIZING=ON.
+ *
+ * Прогноз тревоги (--model ml/model_rf_alarm.rff):
+ *   Лес model_rf_alarm.pkl, выгруженный ml/export_forest.py, считается прямо в тике
+ *   для каждого агрегата (ml/rf_infer.c) и публикуется в узле
+ *   equipment[.<id>].bearing.alarm_probability — вероятность тревоги по модели.
+ *
+ * Форма вибросигнала (--waveform RATE [--block N]):
+ *   Сырая виброскорость с частотой дискретизации RATE Гц (10–50 кГц) публикуется
+ *   блоками по N отсчётов (по умолчанию 4096) в массивах Double[]:
+ *     equipment[.<id>].bearing.waveform              — отсчёты блока, SourceTimestamp = начало блока
+ *     equipment[.<id>].bearing.waveform.timestamp    — время первого отсчёта блока
+ *     equipment[.<id>].bearing.waveform.sample_rate  — частота дискретизации, Гц
+ *   Блок генерируется в один заранее выделенный буфер (waveform.c) и пишется
+ *   одним UA_Server_writeDataValue, без UA_Variant на каждый отсчёт.
+ *
+ * Спектр огибающей (--spectrum N, вместе с --waveform):
+ *   Блоки формы сигнала копятся в кадры по N отсчётов (--overlap — перекрытие, %),
+ *   spectrum.c считает по кадру спектр огибающей полосы резонанса (--envelope-band)
+ *   и СКЗ огибающей в полосах гармоник частот дефектов подшипника (--bearing):
+ *     equipment[.<id>].bearing.envelope.<ftf|bpfo|bpfi|bsf>  — мм/с
+ *   Каналы всех агрегатов делятся между --spectrum-threads потоками (по умолчанию —
+ *   по числу процессоров); время расчёта за блок — в diagnostics.spectrum.
+ *
+ * Оконные признаки (--features W):
+ *   По каждому тегу агрегата за последние W тиков считаются rms, peak, crest,
+ *   kurtosis, ewma и slope (ml/window_features.c, O(1) на отсчёт) и публикуются
+ *   в узлах только для чтения рядом с исходным тегом:
+ *     equipment[.<id>].bearing.vibration.rms, ....kurtosis, ...
+ *     equipment[.<id>].temperature.ewma, equipment[.<id>].pressure.slope, ...
+ *   slope — в единицах тега за секунду. В историю (--history) не попадают.
+ *
+ * Воспроизводимость (--seed S):
+ *   Модель сигналов вынесена в signal_model.c и общая с офлайн-генератором
+ *   datagen.c: при том же seed и размере парка значения тиков совпадают.
+ *   Без --seed берётся текущее время; выбранный seed пишется в лог.
+ *
+ * Узлы с источником данных (--datasource):
+ *   Переменные агрегатов (вибрация, температура, давление, тревога, вероятность,
+ *   признаки) создаются как UA_DataSource: сервер не хранит их значения, а при
+ *   чтении или опросе подписки вызывает read_tag(), которая берёт значение прямо
+ *   из массивов парка, с меткой источника — временем последнего тика. Тик только
+ *   пересчитывает массивы: ни одного UA_Server_writeValue и копии UA_Variant в
+ *   хранилище узлов, сколько бы узлов ни было и читает ли их кто-нибудь.
+ *   Признаки при этом считаются в read_tag() только для читаемых узлов.
+ *   История (--history) пишется на UA_Server_writeValue, поэтому с --datasource
+ *   не совмещается.
+ *
+ * Тревоги по правилам (--rules FILE):
+ *   Таблица правил (alarms.rules, alarm_engine.c) — пороги с гистерезисом, скорость
+ *   изменения и задержки срабатывания/сброса для любого тега агрегата. Каждый тик
+ *   все правила считаются векторизованным проходом по массивам парка, а по переходам
+ *   состояния сервер поднимает события OPC UA Alarms & Conditions (OffNormalAlarmType;
+ *   источник — объект агрегата equipment.<id> или Server для одиночного агрегата).
+ *   Условие создаётся при первом срабатывании правила на агрегате. Клиенты получают
+ *   изменения подпиской на события вместо опроса Bearing_Alarm. Нужна open62541 с
+ *   -DUA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS=ON; без неё переходы пишутся в лог.
+ *   Прежний флаг Bearing_Alarm (вибрация >= 7 мм/с) публикуется как раньше.
+ *
+ * Поток симуляции (--threaded):
+ *   Обычно тик считается в колбэке внутри UA_Server_run, и тяжёлый тик задерживает
+ *   сессии клиентов, а всплеск запросов — тик. С --threaded модель, лес и признаки
+ *   считаются в отдельном потоке по расписанию CLOCK_MONOTONIC (sim_thread.c), кадры
+ *   передаются серверу через тройной буфер без блокировок, а колбэк сервера
+ *   (publish_cb, опрос каждые ≤10 мс) только забирает последний кадр и публикует его.
+ *   Если сервер не успел забрать кадр, он заменяется следующим — расписание тика
+ *   не сдвигается; счётчики — diagnostics.sim.skipped и diagnostics.sim.overruns.
+ *   API сервера вызывается только из его потока, UA_MULTITHREADING не нужен.
+ *
+ * Публикация PubSub (--pubsub URL):
+ *   Каждому потребителю (сборщик, прогноз, мосты Grafana) нужна своя сессия opc.tcp,
+ *   и цена сервера растёт с их числом. С --pubsub сервер раз в --pubsub-interval мс
+ *   (по умолчанию — период тика) отправляет набор equipment.* в multicast-группу
+ *   UADP-сообщениями (uadp_pub.c, OPC UA Part 14): по датаграмме на блок из
+ *   --pubsub-block агрегатов, все датаграммы цикла — пачкой через sendmmsg().
+ *   Число подписчиков стоимость не меняет: копии делает сеть. Группа по умолчанию —
+ *   opc.udp://224.0.0.22:4840, работает и через loopback; интерфейс — --pubsub-iface.
+ *   Приём без open62541 — opcua_client/uadp_sub.c (пример — uadp_dump.c).
+ *   Счётчики — diagnostics.pubsub.datagrams, .bytes, .errors.
+ *
+ * Разделяемая память (--shm NAME):
+ *   Потребителям на том же хосте не нужны ни сессия, ни сеть: каждый тик все агрегаты
+ *   пишутся в кольцо из --shm-slots слотов в /dev/shm/<NAME> (shm_pub.c, раскладка —
+ *   shm_pub.h) под seqlock слота. Читатели (opcua_client/shm_sub.c, пример —
+ *   shm_dump.c) отображают файл и читают слоты на месте, без системных вызовов;
+ *   отставший на круг читатель теряет тики, но не получает смешанных. С --threaded
+ *   слот пишет поток симуляции сразу после расчёта кадра, до публикации в узлы.
+ *   Счётчик — diagnostics.shm.ticks.
+ *
+ * Теги из файла (--tags FILE):
+ *   Кроме узлов агрегатов, адресное пространство достраивается из файла описания
+ *   тегов (tags.csv, tag_model.c): иерархия папок по пути тега, тип, единицы
+ *   (свойство EngineeringUnits) и доступ r/rw. Узлы — в папке Tags, NodeId —
+ *   ns=1;s=tags.<путь>. Файл разбирается целиком до создания сервера, узлы
+ *   создаются одним проходом в порядке родитель → потомки, переменные — источники
+ *   данных над массивом значений в памяти: клиенты читают и пишут (rw) их, тик
+ *   их не трогает.
+ *
+ * Диагностика горячего пути:
+ *   Длительность тика, джиттер запуска колбэка, время генерации и каждого
+ *   UA_Server_writeValue замеряются счётчиком тактов (perf_timer.c) и копятся
+ *   в гистограммах по степеням двойки. Раз в секунду они публикуются в папке
+ *   Diagnostics: diagnostics.<замер>.count, .p50_us, .p99_us, .max_us и
+ *   .histogram (UInt64[40], корзина k — [2^k, 2^(k+1)) нс); замеры —
+ *   tick_duration, tick_jitter, generate, write_value, publish. С --threaded tick_duration —
+ *   публикация кадра в потоке сервера, tick_jitter — опоздание пробуждения потока
+ *   симуляции относительно расписания, generate — расчёт кадра в этом потоке.
+ *   Строки лога из колбэков уходят в неблокирующий буфер (async_log.c):
+ *   --log-every N пишет каждый N-й тик, --log-rate N ограничивает строки в секунду;
+ *   потерянные строки — в diagnostics.log.dropped и diagnostics.log.suppressed.
+ *
+ * Трассировка задержки:
+ *   Все значения тика пишутся с одной меткой источника — моментом тика (tickTime).
+ *   После публикации тика узел diagnostics.trace (UInt64[3]) получает номер тика,
+ *   начало генерации и конец публикации по CLOCK_MONOTONIC в нс — с той же меткой
+ *   источника. Сборщик (collector --trace) по метке находит номер тика строки и
+ *   считает возраст строки на каждом этапе; diagnostics.publish — от начала
+ *   генерации до конца публикации (с --threaded — вместе с ожиданием кадра).
+ *
+ * Время запуска:
+ *   Разбор файла тегов, создание узлов и старт сервера (UA_Server_run_startup —
+ *   после него сервер принимает подключения) замеряются отдельно и пишутся в лог
+ *   одной строкой и в diagnostics.startup.parse_ms, .nodes_ms, .listen_ms,
+ *   .total_ms (от запуска процесса до приёма подключений) и .nodes — все созданные
+ *   узлы агрегатов и тегов: папки, объекты, переменные и свойства (EURange, единицы).
  *
  * Основан на предыдущей версии сервера (вибрация/температура/давление + тревога)
  * с доработкой генерации сигналов в стиле скрипта gen.c.
  *
  * Сборка:
- *   gcc dynamic4.c -lopen62541 -lm -o servers/dynamic4
+ *   gcc -O3 -march=native -ffast-math dynamic4.c signal_model.c history_ring.c waveform.c spectrum.c ../ml/rf_infer.c ../ml/window_features.c async_log.c perf_timer.c sim_thread.c alarm_engine.c uadp_pub.c shm_pub.c tag_model.c -lopen62541 -lm -pthread -o servers/dynamic4
  *
  * Запуск:
- *   servers/dynamic4
+ *   servers/dynamic4                          # один агрегат
+ *   servers/dynamic4 --assets 10000           # парк из 10 000 агрегатов
+ *   servers/dynamic4 --assets 100000 --interval 1000
+ *   servers/dynamic4 --history 3600           # час истории при периоде 1 с
+ *   servers/dynamic4 --model ../ml/model_rf_alarm.rff
+ *   servers/dynamic4 --waveform 25600 --block 4096
+ *   servers/dynamic4 --assets 2000 --waveform 25600 --spectrum 4096 --overlap 50
+ *   servers/dynamic4 --features 60            # признаки за последние 60 тиков
+ *   servers/dynamic4 --seed 42                # те же значения, что datagen --seed 42
+ *   servers/dynamic4 --assets 100000 --interval 100 --log-every 50
+ *   servers/dynamic4 --assets 100000 --datasource  # без записи узлов в тике
+ *   servers/dynamic4 --assets 100000 --interval 100 --threaded --datasource
+ *   servers/dynamic4 --assets 1000 --rules alarms.rules
+ *   servers/dynamic4 --assets 100000 --interval 100 --datasource --pubsub opc.udp://224.0.0.22:4840
+ *   servers/dynamic4 --assets 10000 --interval 100 --threaded --shm /dynamic4
+ *   servers/dynamic4 --tags tags.csv         # + теги из файла в папке Tags
  *   OPC UA Endpoint: opc.tcp://localhost:4840
  *
  * Подключение клиента: UAExpert, Python (opcua.Client) или SCADA.
@@ -26,21 +189,143 @@
 #include <open62541/server.h>                // Основное API сервера OPC UA
 #include <open62541/server_config_default.h> // Быстрая конфигурация сервера
 #include <signal.h>                          // Обработка Ctrl+C (SIGINT)
-#include <math.h>                            // sin()
-#include <stdlib.h>                          // rand()
+#include <stdint.h>                          // uint64_t, uintptr_t
+#include <stdio.h>                           // snprintf(), fprintf()
+#include <stdlib.h>                          // calloc(), strtol()
+#include <string.h>                          // strcmp()
 #include <time.h>                            // time()
+#include <unistd.h>                          // sysconf() — число процессоров
+#include "signal_model.h"                    // Модель сигналов агрегата (общая с datagen.c)
+#include "history_ring.h"                    // Кольцевые буферы истории для HistoryRead
+#include "waveform.h"                        // Форма вибросигнала блоками
+#include "spectrum.h"                        // Спектр огибающей и полосы дефектов
+#include "../ml/rf_infer.h"                  // Инференс RandomForest
+#include "../ml/window_features.h"           // Оконные признаки rms/kurtosis/...
+#include "async_log.h"                       // Неблокирующий лог колбэков
+#include "perf_timer.h"                      // Таймеры и гистограммы горячего пути
+#include "sim_thread.h"                      // Поток симуляции и тройной буфер кадров
+#include "alarm_engine.h"                    // Тревоги по таблице правил
+#include "uadp_pub.h"                        // Публикация UADP в multicast
+#include "shm_pub.h"                         // Кольцо тиков в /dev/shm
+#include "tag_model.h"                       // Адресное пространство из файла тегов
+
+#define MAX_ASSETS 100000 // верхняя граница размера парка
+#define MAX_FEATURE_WINDOW 86400 // верхняя граница окна признаков, тиков
+#define FEATURE_TAGS 3    // теги с признаками: вибрация, температура, давление
+
+// === Состояние парка (struct-of-arrays) ===
+// Каждое поле — отдельный непрерывный массив длиной n, чтобы проход по парку
+// читал память последовательно и раскладывался компилятором в SIMD-инструкции.
+typedef struct {
+    size_t      n;           // число агрегатов
+    UA_Double  *vib;         // мм/с — вибрация подшипника
+    UA_Double  *temp;        // °C — температура
+    UA_Double  *press;       // бар — давление
+    uint8_t    *alarm;       // тревога по вибрации (0/1; bool не векторизуется)
+    uint8_t    *alarm_diff;  // тревога изменилась на этом тике
+    double     *phase;       // сдвиг фазы синусоид, чтобы агрегаты не шли в ногу
+    uint64_t   *rng_key;     // ключ счётчикового ГПСЧ агрегата
+    UA_NodeId  *node_vib, *node_temp, *node_press, *node_alarm;
+    float      *rf_x;        // признаки для леса: строки (vib, temp, press) — только с --model
+    float      *alarm_prob;  // вероятность тревоги по модели
+    UA_NodeId  *node_prob;
+    UA_NodeId  *node_wf, *node_wf_ts; // форма сигнала — только с --waveform
+    UA_NodeId  *node_env;    // полосы огибающей [n * SPECTRUM_FAULTS] — только с --spectrum
+    UA_NodeId  *node_feat;   // признаки [n * FEATURE_TAGS * FEATURE_COUNT] — только с --features
+    UA_Double  *feat;        // значения признаков в том же порядке — только с --threaded
+} Fleet;
 
 // === Глобальные переменные для управления работой ===
 static UA_Boolean running = true;      // Флаг работы сервера
-static UA_NodeId node_vib, node_temp, node_press, node_alarm;
+static Fleet fleet;                    // Все агрегаты (в обычном режиме n = 1)
+static uint64_t tick = 0;              // Номер тика — счётчик для ГПСЧ
+static HistoryRing *history = NULL;    // История узлов (--history), NULL — выключена
+static RfForest *forest = NULL;        // Модель тревоги (--model), NULL — выключена
+static FeatureEngine *features = NULL; // Оконные признаки (--features), NULL — выключены
+static double tickSeconds = 2.0;       // период тика, с — ось времени для slope
+static UA_DateTime tickTime;           // время последнего тика — метка источника
+
+// === Узлы с источником данных (--datasource) ===
+// Контекст узла — номер агрегата и тег, упакованные в указатель: (i << TAG_BITS) | тег
+enum { TAG_VIB, TAG_TEMP, TAG_PRESS, TAG_ALARM, TAG_PROB, TAG_FEAT }; // TAG_FEAT + c * FEATURE_COUNT + k
+#define TAG_BITS 5
+static UA_Boolean dataSourceMode = false;
+
+// === Форма вибросигнала (--waveform) ===
+static WaveformConfig wfConfig;        // частота, размер блока, параметры подшипника
+static UA_Boolean waveformMode = false;
+static double *wfBuf = NULL;           // буфер одного блока, переиспользуется всеми агрегатами
+static uint64_t wfPos = 0;             // сквозной номер первого отсчёта следующего блока
+static UA_DateTime wfStart;            // время отсчёта с номером 0
+static SpectrumBank *spectrum = NULL;  // спектр огибающей (--spectrum), NULL — выключен
+
+// === Диагностика горячего пути ===
+static PerfHist histTick;              // длительность update_cb целиком
+static PerfHist histJitter;            // |фактический период - заданный|
+static PerfHist histGen;               // генерация: модель, лес, окна признаков (без записи узлов)
+static PerfHist histWrite;             // одна запись значения узла
+static PerfHist histPublish;           // от начала генерации тика до конца публикации
+static PerfHist histSpectrum;          // спектры огибающей всех агрегатов за блок
+static uint64_t tickMonoNs;            // начало генерации тика, CLOCK_MONOTONIC нс
+static uint64_t lastTickStart = 0;     // такты начала предыдущего тика
+static uint64_t intervalNs = 0;        // заданный период тика, нс
+static long logEvery = 1;              // писать в лог каждый N-й тик
+
+// === Поток симуляции (--threaded) ===
+// Кадр — результат одного тика; три кадра ходят по кругу через sim_thread.c
+typedef struct {
+    uint64_t    tick;        // номер тика после шага
+    UA_DateTime time;        // момент расчёта — метка источника
+    uint64_t    mono;        // начало расчёта, CLOCK_MONOTONIC нс
+    UA_Double  *vib, *temp, *press;
+    uint8_t    *alarm;
+    float      *alarm_prob;  // с --model
+    UA_Double  *feat;        // [n * FEATURE_TAGS * FEATURE_COUNT] — с --features
+    PerfHist    gen, jitter; // гистограммы потока симуляции на момент кадра
+} SimFrame;
+
+static UA_Boolean threadedMode = false;
+static SimThread *simThread = NULL;
+static SimFrame simFrames[3];
+static uint8_t *simDiff = NULL;        // смена тревоги — в потоке симуляции не нужна
+static float *simRfX = NULL;           // признаки леса потока симуляции
+static PerfHist simGen, simJitter;     // пишет только поток симуляции
+
+// === Тревоги по правилам (--rules) ===
+static const char *const alarmTagNames[FEATURE_TAGS] = { "vibration", "temperature", "pressure" };
+static AlarmEngine *alarmEngine = NULL;
+static UA_Boolean assetObjects = false;  // у агрегатов есть объекты equipment.<id> (режим парка)
+static UA_DateTime alarmTime = 0;        // tickTime прошлого прохода правил
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+static UA_NodeId *alarmCond = NULL;      // [n * правил] условия A&C, создаются при первом срабатывании
+static uint8_t *alarmSource = NULL;      // [n] объект агрегата уже выдаёт события
+#endif
+
+// === Публикация PubSub (--pubsub) ===
+static UadpPublisher *pubsub = NULL;
+static uint64_t pubsubSent = 0;          // датаграмм отправлено
+
+// === Разделяемая память (--shm) ===
+static ShmPublisher *shm = NULL;         // пишет тот поток, что считает тик
 
-static UA_Double vib_value   = 1.2;    // мм/с — вибрация подшипника
-static UA_Double temp_value  = 60.0;   // °C — температура
-static UA_Double press_value = 1.0;    // бар — давление
-static UA_Boolean alarm_state = false; // тревога по вибрации
+// === Теги из файла (--tags) ===
+static TagModel *tagModel = NULL;        // освобождается после UA_Server_delete
 
-// Случайное число [0..1)
-static double frand(void) { return (double)rand() / (double)RAND_MAX; }
+// === Время запуска (замеры по UA_DateTime_nowMonotonic) ===
+static struct {
+    UA_Double parse_ms;   // разбор файла тегов
+    UA_Double nodes_ms;   // создание узлов агрегатов и тегов
+    UA_Double listen_ms;  // UA_Server_run_startup
+    UA_Double total_ms;   // от запуска процесса до приёма подключений
+    UA_UInt64 nodes;      // узлов создано
+} startup;
+static size_t nodesAdded;   // узлов агрегатов создано: объекты, переменные, свойства EURange
+
+// Учёт созданного узла агрегата; возвращает rc
+static UA_StatusCode count_node(UA_StatusCode rc) {
+    nodesAdded += rc == UA_STATUSCODE_GOOD;
+    return rc;
+}
 
 // Обработчик SIGINT
 static void stopHandler(int sig) {
@@ -48,115 +333,1429 @@ static void stopHandler(int sig) {
     running = false;
 }
 
-// Колбэк обновления значений (каждые 100 мс)
+// Выделение массивов парка; возвращает false при нехватке памяти
+static UA_Boolean fleet_alloc(Fleet *f, size_t n, uint64_t seed) {
+    f->n          = n;
+    f->vib        = calloc(n, sizeof(UA_Double));
+    f->temp       = calloc(n, sizeof(UA_Double));
+    f->press      = calloc(n, sizeof(UA_Double));
+    f->alarm      = calloc(n, sizeof(uint8_t));
+    f->alarm_diff = calloc(n, sizeof(uint8_t));
+    f->phase      = calloc(n, sizeof(double));
+    f->rng_key    = calloc(n, sizeof(uint64_t));
+    f->node_vib   = calloc(n, sizeof(UA_NodeId));
+    f->node_temp  = calloc(n, sizeof(UA_NodeId));
+    f->node_press = calloc(n, sizeof(UA_NodeId));
+    f->node_alarm = calloc(n, sizeof(UA_NodeId));
+    if (!f->vib || !f->temp || !f->press || !f->alarm || !f->alarm_diff || !f->phase ||
+        !f->rng_key || !f->node_vib || !f->node_temp || !f->node_press || !f->node_alarm)
+        return false;
+
+    for (size_t i = 0; i < n; i++) {
+        f->vib[i]     = 1.2;   // начальные значения как у одиночного агрегата
+        f->temp[i]    = 60.0;
+        f->press[i]   = 1.0;
+    }
+    signal_model_init(n, seed, f->phase, f->rng_key);
+    return true;
+}
+
+static void fleet_free(Fleet *f) {
+    for (size_t i = 0; f->node_vib && i < f->n; i++) {
+        UA_NodeId_clear(&f->node_vib[i]);
+        UA_NodeId_clear(&f->node_temp[i]);
+        UA_NodeId_clear(&f->node_press[i]);
+        UA_NodeId_clear(&f->node_alarm[i]);
+    }
+    free(f->vib); free(f->temp); free(f->press);
+    free(f->alarm); free(f->alarm_diff); free(f->phase); free(f->rng_key);
+    free(f->node_vib); free(f->node_temp); free(f->node_press); free(f->node_alarm);
+    for (size_t i = 0; f->node_prob && i < f->n; i++)
+        UA_NodeId_clear(&f->node_prob[i]);
+    free(f->rf_x); free(f->alarm_prob); free(f->node_prob);
+    for (size_t i = 0; f->node_wf && i < f->n; i++) {
+        UA_NodeId_clear(&f->node_wf[i]);
+        UA_NodeId_clear(&f->node_wf_ts[i]);
+    }
+    free(f->node_wf); free(f->node_wf_ts);
+    for (size_t i = 0; f->node_env && i < f->n * SPECTRUM_FAULTS; i++)
+        UA_NodeId_clear(&f->node_env[i]);
+    free(f->node_env);
+    for (size_t i = 0; f->node_feat && i < f->n * FEATURE_TAGS * FEATURE_COUNT; i++)
+        UA_NodeId_clear(&f->node_feat[i]);
+    free(f->node_feat);
+}
+
+// Буферы прогноза модели; возвращает false при нехватке памяти
+static UA_Boolean fleet_alloc_model(Fleet *f) {
+    f->rf_x       = calloc(f->n * 3, sizeof(float));
+    f->alarm_prob = calloc(f->n, sizeof(float));
+    f->node_prob  = calloc(f->n, sizeof(UA_NodeId));
+    return f->rf_x && f->alarm_prob && f->node_prob;
+}
+
+// Прогноз тревоги для n агрегатов одной пачкой; rf_x — буфер строк (vib, temp, press)
+static void predict_alarm(size_t n, const UA_Double *vib, const UA_Double *temp,
+                          const UA_Double *press, float *rf_x, float *prob) {
+    for (size_t i = 0; i < n; i++) {
+        rf_x[i * 3 + 0] = (float)vib[i];
+        rf_x[i * 3 + 1] = (float)temp[i];
+        rf_x[i * 3 + 2] = (float)press[i];
+    }
+    rf_predict_proba(forest, rf_x, n, prob);
+}
+
+static void fleet_predict(Fleet *f) {
+    predict_alarm(f->n, f->vib, f->temp, f->press, f->rf_x, f->alarm_prob);
+}
+
+static inline void *tag_context(size_t i, unsigned tag) {
+    return (void *)(((uintptr_t)i << TAG_BITS) | tag);
+}
+
+// Значения признаков в порядке feature_names[] и узлов node_feat
+static inline void feature_values(const FeatureSet *fs, UA_Double v[FEATURE_COUNT]) {
+    v[0] = fs->rms;  v[1] = fs->peak; v[2] = fs->crest;
+    v[3] = fs->kurtosis; v[4] = fs->ewma; v[5] = fs->slope;
+}
+
+// Чтение узла клиентом или подпиской: текущее значение из массивов парка
+static UA_StatusCode read_tag(UA_Server *server, const UA_NodeId *sessionId, void *sessionContext,
+                              const UA_NodeId *nodeId, void *nodeContext, UA_Boolean includeSourceTimeStamp,
+                              const UA_NumericRange *range, UA_DataValue *value) {
+    const uintptr_t ctx = (uintptr_t)nodeContext;
+    const size_t i = ctx >> TAG_BITS;
+    const unsigned tag = ctx & ((1u << TAG_BITS) - 1);
+    if (range)
+        return UA_STATUSCODE_BADINDEXRANGEINVALID; // все теги — скаляры
+
+    UA_StatusCode rc;
+    if (tag == TAG_ALARM) {
+        UA_Boolean alarm = fleet.alarm[i];
+        rc = UA_Variant_setScalarCopy(&value->value, &alarm, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    } else {
+        UA_Double v;
+        if (tag == TAG_VIB)
+            v = fleet.vib[i];
+        else if (tag == TAG_TEMP)
+            v = fleet.temp[i];
+        else if (tag == TAG_PRESS)
+            v = fleet.press[i];
+        else if (tag == TAG_PROB)
+            v = fleet.alarm_prob[i];
+        else if (fleet.feat) // --threaded: значения из последнего кадра
+            v = fleet.feat[i * FEATURE_TAGS * FEATURE_COUNT + (tag - TAG_FEAT)];
+        else { // признак: канал i * FEATURE_TAGS + c, признак k
+            FeatureSet fs;
+            UA_Double fv[FEATURE_COUNT];
+            features_get(features, i * FEATURE_TAGS + (tag - TAG_FEAT) / FEATURE_COUNT, &fs);
+            feature_values(&fs, fv);
+            v = fv[(tag - TAG_FEAT) % FEATURE_COUNT];
+        }
+        rc = UA_Variant_setScalarCopy(&value->value, &v, &UA_TYPES[UA_TYPES_DOUBLE]);
+    }
+    if (rc != UA_STATUSCODE_GOOD)
+        return rc;
+    value->hasValue = true;
+    if (includeSourceTimeStamp) {
+        value->sourceTimestamp = tickTime;
+        value->hasSourceTimestamp = true;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+// Запись клиентом (вибрация, температура, давление): значение — в массив парка до следующего тика
+static UA_StatusCode write_tag(UA_Server *server, const UA_NodeId *sessionId, void *sessionContext,
+                               const UA_NodeId *nodeId, void *nodeContext,
+                               const UA_NumericRange *range, const UA_DataValue *value) {
+    const uintptr_t ctx = (uintptr_t)nodeContext;
+    const size_t i = ctx >> TAG_BITS;
+    const unsigned tag = ctx & ((1u << TAG_BITS) - 1);
+    if (range)
+        return UA_STATUSCODE_BADINDEXRANGEINVALID;
+    if (tag != TAG_VIB && tag != TAG_TEMP && tag != TAG_PRESS)
+        return UA_STATUSCODE_BADNOTWRITABLE;
+    if (!value->hasValue || !UA_Variant_hasScalarType(&value->value, &UA_TYPES[UA_TYPES_DOUBLE]))
+        return UA_STATUSCODE_BADTYPEMISMATCH;
+    UA_Double v = *(const UA_Double *)value->value.data;
+    if (tag == TAG_VIB)
+        fleet.vib[i] = v;
+    else if (tag == TAG_TEMP)
+        fleet.temp[i] = v;
+    else
+        fleet.press[i] = v;
+    return UA_STATUSCODE_GOOD;
+}
+
+// Время по CLOCK_MONOTONIC, нс — общая шкала с другими процессами на этом хосте
+static inline uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// Запись значения узла с меткой источника тика и замером времени в histWrite
+static void timedWrite(UA_Server *server, const UA_NodeId nodeId, const UA_Variant val) {
+    UA_DataValue dv;
+    UA_DataValue_init(&dv);
+    dv.value = val;
+    dv.hasValue = true;
+    dv.sourceTimestamp = tickTime;
+    dv.hasSourceTimestamp = true;
+    uint64_t t0 = perf_now();
+    UA_Server_writeDataValue(server, nodeId, dv);
+    perf_hist_add(&histWrite, perf_ns(perf_now() - t0));
+}
+
+// Трасса опубликованного тика: номер, начало генерации, конец публикации — с меткой
+// источника тика, по которой сборщик находит тик своих строк
+static void publish_trace(UA_Server *server) {
+    const uint64_t done = mono_ns();
+    perf_hist_add(&histPublish, done - tickMonoNs);
+    UA_UInt64 trace[3] = { tick, tickMonoNs, done };
+    UA_DataValue dv;
+    UA_DataValue_init(&dv);
+    UA_Variant_setArray(&dv.value, trace, 3, &UA_TYPES[UA_TYPES_UINT64]);
+    dv.hasValue = true;
+    dv.sourceTimestamp = tickTime;
+    dv.hasSourceTimestamp = true;
+    UA_Server_writeDataValue(server, UA_NODEID_STRING(1, "diagnostics.trace"), dv);
+}
+
+// Обновление окон признаков отсчётами тика: канал агрегата i, тега c — i * FEATURE_TAGS + c
+static void fleet_features(Fleet *f, double ts) {
+    for (size_t i = 0; i < f->n; i++) {
+        const UA_Double x[FEATURE_TAGS] = { f->vib[i], f->temp[i], f->press[i] };
+        for (size_t c = 0; c < FEATURE_TAGS; c++)
+            features_push(features, i * FEATURE_TAGS + c, ts, x[c]);
+    }
+}
+
+// Публикация признаков из движка в узлы (без --threaded и --datasource)
+static void fleet_publish_features(UA_Server *server, Fleet *f) {
+    UA_Variant val;
+    for (size_t ch = 0; ch < f->n * FEATURE_TAGS; ch++) {
+        FeatureSet fs;
+        UA_Double v[FEATURE_COUNT];
+        features_get(features, ch, &fs);
+        feature_values(&fs, v);
+        for (size_t k = 0; k < FEATURE_COUNT; k++) {
+            UA_Variant_setScalar(&val, &v[k], &UA_TYPES[UA_TYPES_DOUBLE]);
+            timedWrite(server, f->node_feat[ch * FEATURE_COUNT + k], val);
+        }
+    }
+}
+
+// Запись готовых значений признаков f->feat (--threaded) в узлы
+static void fleet_write_features(UA_Server *server, Fleet *f) {
+    UA_Variant val;
+    for (size_t j = 0; j < f->n * FEATURE_TAGS * FEATURE_COUNT; j++) {
+        UA_Variant_setScalar(&val, &f->feat[j], &UA_TYPES[UA_TYPES_DOUBLE]);
+        timedWrite(server, f->node_feat[j], val);
+    }
+}
+
+// Один шаг модели для всего парка (signal_model.c, векторизуется при -O3)
+static void fleet_step(Fleet *f, uint64_t k) {
+    signal_model_step(f->n, k, f->phase, f->rng_key,
+                      f->vib, f->temp, f->press, f->alarm, f->alarm_diff);
+}
+
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+// Событие A&C по переходу правила; условие создаётся при первом срабатывании
+static void raise_condition(UA_Server *server, const AlarmEvent *ev) {
+    const AlarmRule *rule = alarm_engine_rule(alarmEngine, ev->rule);
+    UA_NodeId *cond = &alarmCond[(size_t)ev->asset * alarm_engine_rule_count(alarmEngine) + ev->rule];
+    char id[64], text[160];
+    snprintf(id, sizeof(id), "equipment.%u", (unsigned)ev->asset);
+    UA_NodeId source = assetObjects ? UA_NODEID_STRING(1, id) : UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER);
+    UA_Variant v;
+
+    if (UA_NodeId_isNull(cond)) {
+        if (assetObjects && !alarmSource[ev->asset]) { // объект агрегата становится источником событий
+            UA_Server_writeEventNotifier(server, source, UA_EVENTNOTIFIER_SUBSCRIBE_TO_EVENT);
+            UA_Server_addReference(server, UA_NODEID_NUMERIC(0, UA_NS0ID_SERVER),
+                UA_NODEID_NUMERIC(0, UA_NS0ID_HASNOTIFIER), UA_EXPANDEDNODEID_STRING(1, id), true);
+            alarmSource[ev->asset] = 1;
+        }
+        UA_StatusCode rc = UA_Server_createCondition(server, UA_NODEID_NULL,
+            UA_NODEID_NUMERIC(0, UA_NS0ID_OFFNORMALALARMTYPE), UA_QUALIFIEDNAME(1, (char *)rule->name),
+            source, UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT), cond);
+        if (rc != UA_STATUSCODE_GOOD) {
+            alog_write(ALOG_ERROR, "Условие %s агрегата %u не создано: %s",
+                       rule->name, (unsigned)ev->asset, UA_StatusCode_name(rc));
+            *cond = UA_NODEID_NULL;
+            return;
+        }
+        UA_Boolean enabled = true;
+        UA_Variant_setScalar(&v, &enabled, &UA_TYPES[UA_TYPES_BOOLEAN]);
+        UA_Server_setConditionVariableFieldProperty(server, *cond, &v,
+            UA_QUALIFIEDNAME(0, "EnabledState"), UA_QUALIFIEDNAME(0, "Id"));
+        UA_UInt16 severity = rule->severity;
+        UA_Variant_setScalar(&v, &severity, &UA_TYPES[UA_TYPES_UINT16]);
+        UA_Server_setConditionField(server, *cond, &v, UA_QUALIFIEDNAME(0, "Severity"));
+    }
+
+    // Состояние, сообщение и время перехода
+    UA_Boolean active = ev->active;
+    UA_Variant_setScalar(&v, &active, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    UA_Server_setConditionVariableFieldProperty(server, *cond, &v,
+        UA_QUALIFIEDNAME(0, "ActiveState"), UA_QUALIFIEDNAME(0, "Id"));
+    UA_LocalizedText state = UA_LOCALIZEDTEXT("en-US", active ? "Active" : "Inactive");
+    UA_Variant_setScalar(&v, &state, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    UA_Server_setConditionField(server, *cond, &v, UA_QUALIFIEDNAME(0, "ActiveState"));
+    UA_Variant_setScalar(&v, &active, &UA_TYPES[UA_TYPES_BOOLEAN]);
+    UA_Server_setConditionField(server, *cond, &v, UA_QUALIFIEDNAME(0, "Retain"));
+    snprintf(text, sizeof(text), "%s: %.3f%s", rule->message, ev->value, active ? "" : " — норма");
+    UA_LocalizedText message = UA_LOCALIZEDTEXT("ru-RU", text);
+    UA_Variant_setScalar(&v, &message, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    UA_Server_setConditionField(server, *cond, &v, UA_QUALIFIEDNAME(0, "Message"));
+    UA_DateTime eventTime = tickTime;
+    UA_Variant_setScalar(&v, &eventTime, &UA_TYPES[UA_TYPES_DATETIME]);
+    UA_Server_setConditionField(server, *cond, &v, UA_QUALIFIEDNAME(0, "Time"));
+    UA_Server_triggerConditionEvent(server, *cond, source, NULL);
+}
+#endif
+
+// Проход правил тревог по парку; по каждому переходу — строка лога и событие A&C
+static void fleet_alarms(UA_Server *server) {
+    const double *const tags[FEATURE_TAGS] = { fleet.vib, fleet.temp, fleet.press };
+    double dt = alarmTime ? (double)(tickTime - alarmTime) / UA_DATETIME_SEC : 0.0;
+    alarmTime = tickTime;
+    size_t n = alarm_engine_eval(alarmEngine, tags, dt);
+    const AlarmEvent *ev = alarm_engine_events(alarmEngine);
+    for (size_t j = 0; j < n; j++) {
+        const AlarmRule *rule = alarm_engine_rule(alarmEngine, ev[j].rule);
+        alog_write(ALOG_WARN, "Тревога %s, агрегат %u: %s (%.3f)", rule->name,
+                   (unsigned)ev[j].asset, ev[j].active ? "активна" : "снята", ev[j].value);
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+        raise_condition(server, &ev[j]);
+#endif
+    }
+}
+
+// Публикация значений парка в адресное пространство и строка лога
+static void fleet_publish(UA_Server *server) {
+    size_t alarms = 0;
+    for (size_t i = 0; i < fleet.n; i++)
+        alarms += fleet.alarm[i];
+
+    // 2. Публикация в адресное пространство (с --datasource узлы читают массивы сами)
+    UA_Variant val;
+    for (size_t i = 0; i < fleet.n && !dataSourceMode; i++) {
+        UA_Variant_setScalar(&val, &fleet.vib[i], &UA_TYPES[UA_TYPES_DOUBLE]);
+        timedWrite(server, fleet.node_vib[i], val);
+
+        if (fleet.alarm_diff[i]) { // тревогу пишем только при смене состояния
+            UA_Boolean alarm = fleet.alarm[i];
+            UA_Variant_setScalar(&val, &alarm, &UA_TYPES[UA_TYPES_BOOLEAN]);
+            timedWrite(server, fleet.node_alarm[i], val);
+        }
+
+        UA_Variant_setScalar(&val, &fleet.temp[i], &UA_TYPES[UA_TYPES_DOUBLE]);
+        timedWrite(server, fleet.node_temp[i], val);
+
+        UA_Variant_setScalar(&val, &fleet.press[i], &UA_TYPES[UA_TYPES_DOUBLE]);
+        timedWrite(server, fleet.node_press[i], val);
+
+        if (forest) {
+            UA_Double prob = fleet.alarm_prob[i];
+            UA_Variant_setScalar(&val, &prob, &UA_TYPES[UA_TYPES_DOUBLE]);
+            timedWrite(server, fleet.node_prob[i], val);
+        }
+    }
+
+    // Тревоги по правилам — события только по переходам
+    if (alarmEngine)
+        fleet_alarms(server);
+
+    // Лог в консоль — через буфер, без ожидания stdout
+    if (fleet.n == 1)
+        ALOG_EVERY(logEvery, ALOG_INFO,
+                   "Vib: %.2f мм/с  Temp: %.1f°C  Press: %.3f бар  Alarm: %s",
+                   fleet.vib[0], fleet.temp[0], fleet.press[0], fleet.alarm[0] ? "ON" : "OFF");
+    else
+        ALOG_EVERY(logEvery, ALOG_INFO,
+                   "Агрегатов: %zu  В тревоге: %zu  [0] Vib: %.2f  Temp: %.1f  Press: %.3f",
+                   fleet.n, alarms, fleet.vib[0], fleet.temp[0], fleet.press[0]);
+}
+
+// Колбэк обновления значений (каждые --interval мс)
 static void update_cb(UA_Server *server, void *data) {
-    static double t = 0; // "время" для генерации синусов
-    t += 0.1;            // шаг времени
+    uint64_t t0 = perf_now();
+    if (lastTickStart) {
+        uint64_t gap = perf_ns(t0 - lastTickStart);
+        perf_hist_add(&histJitter, gap > intervalNs ? gap - intervalNs : intervalNs - gap);
+    }
+    lastTickStart = t0;
+    tickTime = UA_DateTime_now();
+    tickMonoNs = mono_ns();
+
+    // 1. Пересчёт всего парка одним проходом: модель, лес, окна признаков — как в sim_step()
+    fleet_step(&fleet, tick++);
+    if (forest)
+        fleet_predict(&fleet);
+    if (features)
+        fleet_features(&fleet, tick * tickSeconds);
+    perf_hist_add(&histGen, perf_ns(perf_now() - t0));
+    if (shm) // соседям по хосту — до записи узлов
+        shm_pub_write(shm, tick, tickTime, tickMonoNs, fleet.vib, fleet.temp, fleet.press,
+                      fleet.alarm, forest ? fleet.alarm_prob : NULL);
+
+    // 2. Публикация (узлы признаков с --datasource читают движок сами)
+    if (features && !dataSourceMode)
+        fleet_publish_features(server, &fleet);
+    fleet_publish(server);
+    publish_trace(server);
+    perf_hist_add(&histTick, perf_ns(perf_now() - t0));
+}
+
+// Шаг потока симуляции (--threaded): модель, лес и признаки тика k — в кадр.
+// Работает параллельно с сервером: только массивы кадра и свои буферы, без API сервера.
+static void sim_step(void *ctx, void *frame, uint64_t k, uint64_t lateNs) {
+    SimFrame *fr = frame;
+    const size_t n = fleet.n;
+    uint64_t t0 = perf_now();
+    fr->mono = mono_ns();
+    // alarm кадра — состояние трёхкадровой давности, но тревога пересчитывается заново
+    signal_model_step(n, k, fleet.phase, fleet.rng_key, fr->vib, fr->temp, fr->press, fr->alarm, simDiff);
+    if (forest)
+        predict_alarm(n, fr->vib, fr->temp, fr->press, simRfX, fr->alarm_prob);
+    if (features) {
+        const double ts = (double)(k + 1) * tickSeconds;
+        for (size_t i = 0; i < n; i++) {
+            const UA_Double x[FEATURE_TAGS] = { fr->vib[i], fr->temp[i], fr->press[i] };
+            for (size_t c = 0; c < FEATURE_TAGS; c++) {
+                const size_t ch = i * FEATURE_TAGS + c;
+                FeatureSet fs;
+                features_push(features, ch, ts, x[c]);
+                features_get(features, ch, &fs);
+                feature_values(&fs, &fr->feat[ch * FEATURE_COUNT]);
+            }
+        }
+    }
+    fr->tick = k + 1;
+    fr->time = UA_DateTime_now();
+    if (shm) // слот — из потока симуляции, не дожидаясь публикации кадра сервером
+        shm_pub_write(shm, fr->tick, fr->time, fr->mono, fr->vib, fr->temp, fr->press,
+                      fr->alarm, forest ? fr->alarm_prob : NULL);
+    perf_hist_add(&simJitter, lateNs);
+    perf_hist_add(&simGen, perf_ns(perf_now() - t0));
+    fr->gen = simGen;
+    fr->jitter = simJitter;
+}
+
+// Колбэк сервера (--threaded): забрать последний кадр и опубликовать его
+static void publish_cb(UA_Server *server, void *data) {
+    const SimFrame *fr = sim_thread_acquire(simThread);
+    if (!fr)
+        return;
+    uint64_t t0 = perf_now();
+    const size_t n = fleet.n;
+    memcpy(fleet.vib, fr->vib, n * sizeof(UA_Double));
+    memcpy(fleet.temp, fr->temp, n * sizeof(UA_Double));
+    memcpy(fleet.press, fr->press, n * sizeof(UA_Double));
+    for (size_t i = 0; i < n; i++) { // смена тревоги — относительно опубликованного кадра
+        fleet.alarm_diff[i] = fleet.alarm[i] != fr->alarm[i];
+        fleet.alarm[i] = fr->alarm[i];
+    }
+    if (forest)
+        memcpy(fleet.alarm_prob, fr->alarm_prob, n * sizeof(float));
+    if (features)
+        memcpy(fleet.feat, fr->feat, n * FEATURE_TAGS * FEATURE_COUNT * sizeof(UA_Double));
+    tick = fr->tick;
+    tickTime = fr->time;
+    tickMonoNs = fr->mono;
+    histGen = fr->gen;
+    histJitter = fr->jitter;
+
+    if (features && !dataSourceMode)
+        fleet_write_features(server, &fleet);
+    fleet_publish(server);
+    publish_trace(server);
+    perf_hist_add(&histTick, perf_ns(perf_now() - t0));
+}
+
+static void sim_frames_free(void) {
+    for (int j = 0; j < 3; j++) {
+        SimFrame *fr = &simFrames[j];
+        free(fr->vib); free(fr->temp); free(fr->press);
+        free(fr->alarm); free(fr->alarm_prob); free(fr->feat);
+    }
+    free(simDiff);
+    free(simRfX);
+    free(fleet.feat);
+}
 
+// Кадры потока симуляции и буфер признаков парка; false при нехватке памяти
+static UA_Boolean sim_frames_alloc(void) {
+    const size_t n = fleet.n, nf = n * FEATURE_TAGS * FEATURE_COUNT;
+    UA_Boolean ok = true;
+    for (int j = 0; j < 3; j++) {
+        SimFrame *fr = &simFrames[j];
+        fr->vib   = calloc(n, sizeof(UA_Double));
+        fr->temp  = calloc(n, sizeof(UA_Double));
+        fr->press = calloc(n, sizeof(UA_Double));
+        fr->alarm = calloc(n, sizeof(uint8_t));
+        ok = ok && fr->vib && fr->temp && fr->press && fr->alarm;
+        if (forest)
+            ok = ok && (fr->alarm_prob = calloc(n, sizeof(float)));
+        if (features)
+            ok = ok && (fr->feat = calloc(nf, sizeof(UA_Double)));
+    }
+    simDiff = calloc(n, sizeof(uint8_t));
+    ok = ok && simDiff;
+    if (forest)
+        ok = ok && (simRfX = calloc(n * 3, sizeof(float)));
+    if (features)
+        ok = ok && (fleet.feat = calloc(nf, sizeof(UA_Double)));
+    return ok;
+}
+
+// === Узлы диагностики ===
+static const struct {
+    const char *id;           // diagnostics.<id>.*
+    const char *name;         // BrowseName объекта
+    const char *description;
+    PerfHist   *hist;
+} diagHists[] = {
+    { "tick_duration", "Tick_Duration", "Длительность тика (с --threaded — публикации кадра)", &histTick },
+    { "tick_jitter",   "Tick_Jitter",   "Отклонение периода тика от заданного",        &histJitter },
+    { "generate",      "Generate",      "Генерация парка: модель, прогноз, окна признаков", &histGen },
+    { "write_value",   "Write_Value",   "Одна запись значения узла",                   &histWrite },
+    { "publish",       "Publish",       "От начала генерации тика до конца публикации", &histPublish },
+    { "spectrum",      "Spectrum",      "Спектры огибающей всех агрегатов за блок",    &histSpectrum },
+};
+#define DIAG_HISTS (sizeof(diagHists) / sizeof(diagHists[0]))
+
+// Переменная диагностики (только чтение); value — скаляр или массив из n элементов
+static void addDiagVar(UA_Server *server, const char *id, const UA_NodeId *parent, const char *name,
+                       const char *description, void *value, size_t n, const UA_DataType *type) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.dataType = type->typeId;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+    if (n > 0) {
+        attr.valueRank = UA_VALUERANK_ONE_DIMENSION;
+        UA_Variant_setArray(&attr.value, value, n, type);
+    } else {
+        UA_Variant_setScalar(&attr.value, value, type);
+    }
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", (char *)name);
+    attr.description = UA_LOCALIZEDTEXT("ru-RU", (char *)description);
+    UA_Server_addVariableNode(server, UA_NODEID_STRING(1, (char *)id), *parent,
+        UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+        UA_QUALIFIEDNAME(1, (char *)name),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+        attr, NULL, NULL);
+}
+
+static void addObject(UA_Server *server, const char *id, const UA_NodeId parent,
+                      const UA_NodeId refType, const char *name, const UA_NodeId type) {
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    oattr.displayName = UA_LOCALIZEDTEXT("en-US", (char *)name);
+    UA_Server_addObjectNode(server, UA_NODEID_STRING(1, (char *)id), parent, refType,
+        UA_QUALIFIEDNAME(1, (char *)name), type, oattr, NULL, NULL);
+}
+
+// Папка Diagnostics: по объекту на гистограмму и счётчики лога
+static void addDiagnosticsNodes(UA_Server *server) {
+    char id[96], obj[64];
+    UA_UInt64 zero = 0, zeros[PERF_BUCKETS] = { 0 };
+    UA_Double dzero = 0.0;
+    addObject(server, "diagnostics", UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+              UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), "Diagnostics",
+              UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE));
+    for (size_t h = 0; h < DIAG_HISTS; h++) {
+        snprintf(obj, sizeof(obj), "diagnostics.%s", diagHists[h].id);
+        addObject(server, obj, UA_NODEID_STRING(1, "diagnostics"),
+                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), diagHists[h].name,
+                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE));
+        UA_NodeId parent = UA_NODEID_STRING(1, obj);
+        snprintf(id, sizeof(id), "%s.count", obj);
+        addDiagVar(server, id, &parent, "Count", diagHists[h].description, &zero, 0, &UA_TYPES[UA_TYPES_UINT64]);
+        snprintf(id, sizeof(id), "%s.p50_us", obj);
+        addDiagVar(server, id, &parent, "P50_us", "Медиана, мкс", &dzero, 0, &UA_TYPES[UA_TYPES_DOUBLE]);
+        snprintf(id, sizeof(id), "%s.p99_us", obj);
+        addDiagVar(server, id, &parent, "P99_us", "99-й перцентиль, мкс", &dzero, 0, &UA_TYPES[UA_TYPES_DOUBLE]);
+        snprintf(id, sizeof(id), "%s.max_us", obj);
+        addDiagVar(server, id, &parent, "Max_us", "Максимум, мкс", &dzero, 0, &UA_TYPES[UA_TYPES_DOUBLE]);
+        snprintf(id, sizeof(id), "%s.histogram", obj);
+        addDiagVar(server, id, &parent, "Histogram", "Корзина k — замеры в [2^k, 2^(k+1)) нс",
+                   zeros, PERF_BUCKETS, &UA_TYPES[UA_TYPES_UINT64]);
+    }
+    UA_UInt64 trace[3] = { 0, 0, 0 };
+    UA_NodeId diagNode = UA_NODEID_STRING(1, "diagnostics");
+    addDiagVar(server, "diagnostics.trace", &diagNode, "Trace",
+               "Последний тик: номер, начало генерации и конец публикации (CLOCK_MONOTONIC, нс)",
+               trace, 3, &UA_TYPES[UA_TYPES_UINT64]);
+    addObject(server, "diagnostics.log", UA_NODEID_STRING(1, "diagnostics"),
+              UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), "Log",
+              UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE));
+    UA_NodeId logNode = UA_NODEID_STRING(1, "diagnostics.log");
+    addDiagVar(server, "diagnostics.log.dropped", &logNode, "Dropped",
+               "Строк лога отброшено: буфер полон", &zero, 0, &UA_TYPES[UA_TYPES_UINT64]);
+    addDiagVar(server, "diagnostics.log.suppressed", &logNode, "Suppressed",
+               "Строк лога отброшено ограничением частоты", &zero, 0, &UA_TYPES[UA_TYPES_UINT64]);
+    addObject(server, "diagnostics.startup", UA_NODEID_STRING(1, "diagnostics"),
+              UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), "Startup",
+              UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE));
+    UA_NodeId startNode = UA_NODEID_STRING(1, "diagnostics.startup");
+    addDiagVar(server, "diagnostics.startup.parse_ms", &startNode, "Parse_ms",
+               "Разбор файла тегов, мс", &dzero, 0, &UA_TYPES[UA_TYPES_DOUBLE]);
+    addDiagVar(server, "diagnostics.startup.nodes_ms", &startNode, "Nodes_ms",
+               "Создание узлов агрегатов и тегов, мс", &dzero, 0, &UA_TYPES[UA_TYPES_DOUBLE]);
+    addDiagVar(server, "diagnostics.startup.listen_ms", &startNode, "Listen_ms",
+               "Старт сервера (UA_Server_run_startup), мс", &dzero, 0, &UA_TYPES[UA_TYPES_DOUBLE]);
+    addDiagVar(server, "diagnostics.startup.total_ms", &startNode, "Total_ms",
+               "От запуска процесса до приёма подключений, мс", &dzero, 0, &UA_TYPES[UA_TYPES_DOUBLE]);
+    addDiagVar(server, "diagnostics.startup.nodes", &startNode, "Nodes",
+               "Узлов агрегатов и тегов создано", &zero, 0, &UA_TYPES[UA_TYPES_UINT64]);
+    if (threadedMode) {
+        addObject(server, "diagnostics.sim", UA_NODEID_STRING(1, "diagnostics"),
+                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), "Simulation",
+                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE));
+        UA_NodeId simNode = UA_NODEID_STRING(1, "diagnostics.sim");
+        addDiagVar(server, "diagnostics.sim.skipped", &simNode, "Skipped",
+                   "Кадров заменено следующим до публикации", &zero, 0, &UA_TYPES[UA_TYPES_UINT64]);
+        addDiagVar(server, "diagnostics.sim.overruns", &simNode, "Overruns",
+                   "Тиков пропущено: расчёт не уложился в период", &zero, 0, &UA_TYPES[UA_TYPES_UINT64]);
+    }
+    if (pubsub) {
+        addObject(server, "diagnostics.pubsub", UA_NODEID_STRING(1, "diagnostics"),
+                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), "PubSub",
+                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE));
+        UA_NodeId psNode = UA_NODEID_STRING(1, "diagnostics.pubsub");
+        addDiagVar(server, "diagnostics.pubsub.datagrams", &psNode, "Datagrams",
+                   "UADP-датаграмм отправлено", &zero, 0, &UA_TYPES[UA_TYPES_UINT64]);
+        addDiagVar(server, "diagnostics.pubsub.bytes", &psNode, "Bytes",
+                   "Байт отправлено", &zero, 0, &UA_TYPES[UA_TYPES_UINT64]);
+        addDiagVar(server, "diagnostics.pubsub.errors", &psNode, "Errors",
+                   "Датаграмм не отправлено: буфер сокета полон или сеть недоступна",
+                   &zero, 0, &UA_TYPES[UA_TYPES_UINT64]);
+    }
+    if (shm) {
+        addObject(server, "diagnostics.shm", UA_NODEID_STRING(1, "diagnostics"),
+                  UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES), "SharedMemory",
+                  UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE));
+        UA_NodeId shmNode = UA_NODEID_STRING(1, "diagnostics.shm");
+        addDiagVar(server, "diagnostics.shm.ticks", &shmNode, "Ticks",
+                   "Тиков записано в кольцо /dev/shm", &zero, 0, &UA_TYPES[UA_TYPES_UINT64]);
+    }
+}
+
+static void writeDiag(UA_Server *server, const char *id, void *value, size_t n, const UA_DataType *type) {
     UA_Variant val;
+    if (n > 0)
+        UA_Variant_setArray(&val, value, n, type);
+    else
+        UA_Variant_setScalar(&val, value, type);
+    UA_Server_writeValue(server, UA_NODEID_STRING(1, (char *)id), val);
+}
 
-    // --- 1. Вибрация ---
-    vib_value = 2.0 + 0.5 * sin(t * 3.1) + 0.2 * (frand() - 0.5); // базовая модель
-    if (frand() < 0.05) vib_value += 5.0;                        // редкий скачок
-    if (vib_value < 0) vib_value = 0;
-    if (vib_value > 15.0) vib_value = 15.0;
-    UA_Variant_setScalar(&val, &vib_value, &UA_TYPES[UA_TYPES_DOUBLE]);
-    UA_Server_writeValue(server, node_vib, val);
-
-    // Порог тревоги по вибрации (>= 7 мм/с)
-    UA_Boolean newAlarm = (vib_value >= 7.0);
-    if (newAlarm != alarm_state) {
-        alarm_state = newAlarm;
-        UA_Variant alarmVal;
-        UA_Variant_setScalar(&alarmVal, &alarm_state, &UA_TYPES[UA_TYPES_BOOLEAN]);
-        UA_Server_writeValue(server, node_alarm, alarmVal);
-    }
-
-    // --- 2. Температура ---
-    temp_value = 60.0 + 10.0 * sin(t * 0.1) + 0.5 * (frand() - 0.5);
-    if (frand() < 0.001) temp_value += 20.0; // редкий перегрев
-    UA_Variant_setScalar(&val, &temp_value, &UA_TYPES[UA_TYPES_DOUBLE]);
-    UA_Server_writeValue(server, node_temp, val);
-
-    // --- 3. Давление ---
-    press_value = 1.0 + 0.1 * sin(t * 0.7) + 0.02 * (frand() - 0.5);
-    UA_Variant_setScalar(&val, &press_value, &UA_TYPES[UA_TYPES_DOUBLE]);
-    UA_Server_writeValue(server, node_press, val);
-
-    // Лог в консоль
-    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
-                "Vib: %.2f мм/с  Temp: %.1f°C  Press: %.3f бар  Alarm: %s",
-                vib_value, temp_value, press_value, alarm_state ? "ON" : "OFF");
+// Колбэк диагностики (раз в секунду): накопленные гистограммы → узлы
+static void diag_cb(UA_Server *server, void *data) {
+    char id[96];
+    for (size_t h = 0; h < DIAG_HISTS; h++) {
+        const PerfHist *ph = diagHists[h].hist;
+        UA_UInt64 count = ph->count;
+        UA_Double p50 = perf_hist_quantile(ph, 0.50) / 1000.0;
+        UA_Double p99 = perf_hist_quantile(ph, 0.99) / 1000.0;
+        UA_Double max = (double)ph->max_ns / 1000.0;
+        UA_UInt64 bucket[PERF_BUCKETS];
+        memcpy(bucket, ph->bucket, sizeof(bucket));
+        snprintf(id, sizeof(id), "diagnostics.%s.count", diagHists[h].id);
+        writeDiag(server, id, &count, 0, &UA_TYPES[UA_TYPES_UINT64]);
+        snprintf(id, sizeof(id), "diagnostics.%s.p50_us", diagHists[h].id);
+        writeDiag(server, id, &p50, 0, &UA_TYPES[UA_TYPES_DOUBLE]);
+        snprintf(id, sizeof(id), "diagnostics.%s.p99_us", diagHists[h].id);
+        writeDiag(server, id, &p99, 0, &UA_TYPES[UA_TYPES_DOUBLE]);
+        snprintf(id, sizeof(id), "diagnostics.%s.max_us", diagHists[h].id);
+        writeDiag(server, id, &max, 0, &UA_TYPES[UA_TYPES_DOUBLE]);
+        snprintf(id, sizeof(id), "diagnostics.%s.histogram", diagHists[h].id);
+        writeDiag(server, id, bucket, PERF_BUCKETS, &UA_TYPES[UA_TYPES_UINT64]);
+    }
+    UA_UInt64 dropped = alog_dropped(), suppressed = alog_suppressed();
+    writeDiag(server, "diagnostics.log.dropped", &dropped, 0, &UA_TYPES[UA_TYPES_UINT64]);
+    writeDiag(server, "diagnostics.log.suppressed", &suppressed, 0, &UA_TYPES[UA_TYPES_UINT64]);
+    if (simThread) {
+        UA_UInt64 skipped = sim_thread_skipped(simThread), overruns = sim_thread_overruns(simThread);
+        writeDiag(server, "diagnostics.sim.skipped", &skipped, 0, &UA_TYPES[UA_TYPES_UINT64]);
+        writeDiag(server, "diagnostics.sim.overruns", &overruns, 0, &UA_TYPES[UA_TYPES_UINT64]);
+    }
+    if (pubsub) {
+        UA_UInt64 sent = pubsubSent, bytes = uadp_pub_bytes(pubsub), errors = uadp_pub_errors(pubsub);
+        writeDiag(server, "diagnostics.pubsub.datagrams", &sent, 0, &UA_TYPES[UA_TYPES_UINT64]);
+        writeDiag(server, "diagnostics.pubsub.bytes", &bytes, 0, &UA_TYPES[UA_TYPES_UINT64]);
+        writeDiag(server, "diagnostics.pubsub.errors", &errors, 0, &UA_TYPES[UA_TYPES_UINT64]);
+    }
+    if (shm) {
+        UA_UInt64 ticks = shm_pub_ticks(shm);
+        writeDiag(server, "diagnostics.shm.ticks", &ticks, 0, &UA_TYPES[UA_TYPES_UINT64]);
+    }
 }
 
-int main(void) {
-    signal(SIGINT, stopHandler);
-    srand(time(NULL));
+// Колбэк PubSub: последние значения парка (тик или кадр --threaded) — в multicast-группу
+static void pubsub_cb(UA_Server *server, void *data) {
+    pubsubSent += uadp_pub_send(pubsub, tickTime, fleet.vib, fleet.temp, fleet.press, fleet.alarm);
+}
 
-    // Создаём сервер и конфигурацию по умолчанию
-    UA_Server *server = UA_Server_new();
-    UA_ServerConfig_setDefault(UA_Server_getConfig(server));
+// Колбэк формы сигнала: раз в blockSize / sampleRate секунд — по блоку на агрегат
+static void waveform_cb(UA_Server *server, void *data) {
+    const size_t B = wfConfig.blockSize;
+    UA_DateTime blockTime = wfStart + (UA_DateTime)((double)wfPos / wfConfig.sampleRate * UA_DATETIME_SEC);
+    UA_Variant val;
+    UA_DataValue dv;
+    for (size_t i = 0; i < fleet.n; i++) {
+        // Уровень — текущая вибрация агрегата; выше фона появляются удары дефекта
+        double level  = fleet.vib[i];
+        double defect = level > 2.5 ? 3.0 * (level - 2.5) : 0.0;
+        waveform_block(&wfConfig, fleet.rng_key[i], wfPos, level, defect, wfBuf);
+
+        UA_DataValue_init(&dv);
+        UA_Variant_setArray(&dv.value, wfBuf, B, &UA_TYPES[UA_TYPES_DOUBLE]);
+        dv.hasValue = true;
+        dv.sourceTimestamp = blockTime;
+        dv.hasSourceTimestamp = true;
+        UA_Server_writeDataValue(server, fleet.node_wf[i], dv);
+
+        UA_Variant_setScalar(&val, &blockTime, &UA_TYPES[UA_TYPES_DATETIME]);
+        UA_Server_writeValue(server, fleet.node_wf_ts[i], val);
+        if (spectrum)
+            spectrum_bank_feed(spectrum, i, wfBuf, B);
+    }
+    wfPos += B;
+
+    // Кадры, набравшиеся за блок, — всеми потоками; полосы пишутся, если кадры были
+    if (spectrum) {
+        uint64_t t0 = perf_now();
+        size_t frames = spectrum_bank_run(spectrum);
+        perf_hist_add(&histSpectrum, perf_ns(perf_now() - t0));
+        for (size_t i = 0; frames > 0 && i < fleet.n; i++) {
+            const float *bands = spectrum_bank_bands(spectrum, i);
+            for (size_t f = 0; f < SPECTRUM_FAULTS; f++) {
+                UA_Double v = bands[f];
+                UA_Variant_setScalar(&val, &v, &UA_TYPES[UA_TYPES_DOUBLE]);
+                UA_Server_writeValue(server, fleet.node_env[i * SPECTRUM_FAULTS + f], val);
+            }
+        }
+    }
+}
 
-    // Общие атрибуты для параметров типа Double
+// Добавление узла переменной: обычного или (с --datasource) с источником данных read_tag/write_tag
+static UA_StatusCode addValueNode(UA_Server *server, const UA_NodeId *nodeId, const UA_NodeId *parent,
+                         const UA_NodeId *refType, const char *browseName,
+                         UA_VariableAttributes *attr, void *dsContext) {
+    if (dataSourceMode) {
+        const UA_DataSource source = { read_tag, write_tag };
+        attr->minimumSamplingInterval = tickSeconds * 1000.0; // чаще тика значение не меняется
+        return count_node(UA_Server_addDataSourceVariableNode(server, *nodeId, *parent, *refType,
+            UA_QUALIFIEDNAME(1, (char *)browseName),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+            *attr, source, dsContext, NULL));
+    }
+    return count_node(UA_Server_addVariableNode(server, *nodeId, *parent, *refType,
+        UA_QUALIFIEDNAME(1, (char *)browseName),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+        *attr, NULL, NULL));
+}
+
+// Добавление одной переменной телеметрии; dsContext — tag_context() для --datasource
+static void addTelemetryVar(UA_Server *server, const UA_NodeId *nodeId, const UA_NodeId *parent,
+                            const UA_NodeId *refType, char *browseName, char *description,
+                            void *value, const UA_DataType *type, UA_Byte accessLevel,
+                            void *dsContext) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.dataType = type->typeId;
+    attr.accessLevel = accessLevel;
+    if (history) { // узел ведёт историю в кольцевом буфере
+        attr.historizing = true;
+        attr.accessLevel |= UA_ACCESSLEVELMASK_HISTORYREAD;
+    }
+    UA_Variant_setScalar(&attr.value, value, type);
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", browseName);
+    attr.description = UA_LOCALIZEDTEXT("ru-RU", description);
+    const UA_StatusCode rc = addValueNode(server, nodeId, parent, refType, browseName, &attr, dsContext);
+    if (rc != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "Узел %s не создан: %s",
+                       browseName, UA_StatusCode_name(rc));
+        return;
+    }
+    if (history) // кольцо — только у созданного узла
+        history_ring_register(history, nodeId, type);
+}
+
+// Свойство EURange аналоговой переменной: диапазон для процентной зоны нечувствительности
+static void addEURange(UA_Server *server, const UA_NodeId *nodeId, UA_Double low, UA_Double high) {
+    UA_Range range = { low, high };
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.dataType = UA_TYPES[UA_TYPES_RANGE].typeId;
+    attr.valueRank = UA_VALUERANK_SCALAR;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+    UA_Variant_setScalar(&attr.value, &range, &UA_TYPES[UA_TYPES_RANGE]);
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "EURange");
+    // NodeId свойства назначает сервер: фильтр находит его по имени EURange
+    count_node(UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, 0), *nodeId,
+        UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+        UA_QUALIFIEDNAME(0, "EURange"),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_PROPERTYTYPE),
+        attr, NULL, NULL));
+}
+
+// Узлы формы сигнала агрегата: массив отсчётов, время блока, частота дискретизации
+static void addWaveformVars(UA_Server *server, size_t i, const char *prefix,
+                            const UA_NodeId *parent, const UA_NodeId *refType) {
+    char buf[96];
+    UA_UInt32 dim = (UA_UInt32)wfConfig.blockSize;
+
+    // 1. Отсчёты блока (Double[blockSize])
+    snprintf(buf, sizeof(buf), "%s.bearing.waveform", prefix);
+    fleet.node_wf[i] = UA_NODEID_STRING_ALLOC(1, buf);
     UA_VariableAttributes attr = UA_VariableAttributes_default;
     attr.dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
-    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    attr.valueRank = UA_VALUERANK_ONE_DIMENSION;
+    attr.arrayDimensionsSize = 1;
+    attr.arrayDimensions = &dim;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+    UA_Variant_setArray(&attr.value, wfBuf, wfConfig.blockSize, &UA_TYPES[UA_TYPES_DOUBLE]);
+    attr.value.arrayDimensionsSize = 1;
+    attr.value.arrayDimensions = &dim;
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Bearing_Vibration_Waveform_mm_s");
+    attr.description = UA_LOCALIZEDTEXT("ru-RU", "Блок отсчётов виброскорости подшипника, мм/с");
+    count_node(UA_Server_addVariableNode(server, fleet.node_wf[i], *parent, *refType,
+        UA_QUALIFIEDNAME(1, "Bearing_Vibration_Waveform_mm_s"),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+        attr, NULL, NULL));
 
-    // 1. Вибрация
-    UA_Variant_setScalar(&attr.value, &vib_value, &UA_TYPES[UA_TYPES_DOUBLE]);
-    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Bearing_Vibration_mm_s");
-    attr.description = UA_LOCALIZEDTEXT("ru-RU", "Скорость вибрации подшипника, мм/с");
-    node_vib = UA_NODEID_STRING(1, "equipment.bearing.vibration");
-    UA_Server_addVariableNode(server, node_vib,
-        UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
-        UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
-        UA_QUALIFIEDNAME(1, "Bearing_Vibration_mm_s"),
+    // 2. Время первого отсчёта блока
+    UA_DateTime tsInit = wfStart;
+    snprintf(buf, sizeof(buf), "%s.bearing.waveform.timestamp", prefix);
+    fleet.node_wf_ts[i] = UA_NODEID_STRING_ALLOC(1, buf);
+    UA_VariableAttributes tattr = UA_VariableAttributes_default;
+    tattr.dataType = UA_TYPES[UA_TYPES_DATETIME].typeId;
+    tattr.accessLevel = UA_ACCESSLEVELMASK_READ;
+    UA_Variant_setScalar(&tattr.value, &tsInit, &UA_TYPES[UA_TYPES_DATETIME]);
+    tattr.displayName = UA_LOCALIZEDTEXT("en-US", "Waveform_Block_Time");
+    tattr.description = UA_LOCALIZEDTEXT("ru-RU", "Время первого отсчёта блока");
+    count_node(UA_Server_addVariableNode(server, fleet.node_wf_ts[i], *parent, *refType,
+        UA_QUALIFIEDNAME(1, "Waveform_Block_Time"),
         UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
-        attr, NULL, NULL);
+        tattr, NULL, NULL));
 
-    // 2. Температура
-    UA_Variant_setScalar(&attr.value, &temp_value, &UA_TYPES[UA_TYPES_DOUBLE]);
-    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Temperature_C");
-    attr.description = UA_LOCALIZEDTEXT("ru-RU", "Температура оборудования, °C");
-    node_temp = UA_NODEID_STRING(1, "equipment.temperature");
-    UA_Server_addVariableNode(server, node_temp,
-        UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
-        UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
-        UA_QUALIFIEDNAME(1, "Temperature_C"),
+    // 3. Частота дискретизации (постоянная)
+    UA_Double rate = wfConfig.sampleRate;
+    snprintf(buf, sizeof(buf), "%s.bearing.waveform.sample_rate", prefix);
+    UA_VariableAttributes rattr = UA_VariableAttributes_default;
+    rattr.dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
+    rattr.accessLevel = UA_ACCESSLEVELMASK_READ;
+    UA_Variant_setScalar(&rattr.value, &rate, &UA_TYPES[UA_TYPES_DOUBLE]);
+    rattr.displayName = UA_LOCALIZEDTEXT("en-US", "Waveform_Sample_Rate_Hz");
+    rattr.description = UA_LOCALIZEDTEXT("ru-RU", "Частота дискретизации формы сигнала, Гц");
+    count_node(UA_Server_addVariableNode(server, UA_NODEID_STRING(1, buf), *parent, *refType,
+        UA_QUALIFIEDNAME(1, "Waveform_Sample_Rate_Hz"),
         UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
-        attr, NULL, NULL);
+        rattr, NULL, NULL));
+}
+
+// Узлы полос огибающей агрегата: bearing.envelope.<ftf|bpfo|bpfi|bsf>
+static void addEnvelopeVars(UA_Server *server, size_t i, const char *prefix,
+                            const UA_NodeId *parent, const UA_NodeId *refType) {
+    static const char *const names[SPECTRUM_FAULTS] = { "FTF", "BPFO", "BPFI", "BSF" };
+    char buf[96], name[64];
+    UA_Double init = 0.0;
+    for (size_t f = 0; f < SPECTRUM_FAULTS; f++) {
+        UA_NodeId *id = &fleet.node_env[i * SPECTRUM_FAULTS + f];
+        snprintf(buf, sizeof(buf), "%s.bearing.envelope.%s", prefix, spectrum_fault_names[f]);
+        snprintf(name, sizeof(name), "Bearing_Envelope_%s_mm_s", names[f]);
+        *id = UA_NODEID_STRING_ALLOC(1, buf);
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        attr.dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
+        attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+        UA_Variant_setScalar(&attr.value, &init, &UA_TYPES[UA_TYPES_DOUBLE]);
+        attr.displayName = UA_LOCALIZEDTEXT("en-US", name);
+        attr.description = UA_LOCALIZEDTEXT("ru-RU", "СКЗ огибающей в полосах гармоник частоты дефекта, мм/с");
+        count_node(UA_Server_addVariableNode(server, *id, *parent, *refType,
+            UA_QUALIFIEDNAME(1, name),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+            attr, NULL, NULL));
+    }
+}
+
+// Узлы оконных признаков агрегата: <тег>.<признак> для вибрации, температуры и давления
+static void addFeatureVars(UA_Server *server, size_t i, const char *prefix,
+                           const UA_NodeId *parent, const UA_NodeId *refType) {
+    static const char *const tagIds[FEATURE_TAGS]   = { "bearing.vibration", "temperature", "pressure" };
+    static const char *const tagNames[FEATURE_TAGS] = { "Bearing_Vibration_mm_s", "Temperature_C", "Pressure_bar" };
+    char buf[96], name[64];
+    UA_Double init = 0.0;
+    for (size_t c = 0; c < FEATURE_TAGS; c++)
+        for (size_t k = 0; k < FEATURE_COUNT; k++) {
+            UA_NodeId *id = &fleet.node_feat[(i * FEATURE_TAGS + c) * FEATURE_COUNT + k];
+            snprintf(buf, sizeof(buf), "%s.%s.%s", prefix, tagIds[c], feature_names[k]);
+            snprintf(name, sizeof(name), "%s_%s", tagNames[c], feature_names[k]);
+            *id = UA_NODEID_STRING_ALLOC(1, buf);
+            UA_VariableAttributes attr = UA_VariableAttributes_default;
+            attr.dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
+            attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+            UA_Variant_setScalar(&attr.value, &init, &UA_TYPES[UA_TYPES_DOUBLE]);
+            attr.displayName = UA_LOCALIZEDTEXT("en-US", name);
+            attr.description = UA_LOCALIZEDTEXT("ru-RU", "Оконный признак тега");
+            addValueNode(server, id, parent, refType, name, &attr,
+                         tag_context(i, TAG_FEAT + (unsigned)(c * FEATURE_COUNT + k)));
+        }
+}
+
+// Узлы агрегата i. В обычном режиме (fleetMode = false) — прежние equipment.*
+// прямо в папке Objects, в режиме парка — поддерево equipment.<i>.* под объектом агрегата.
+static void addAssetNodes(UA_Server *server, size_t i, UA_Boolean fleetMode) {
+    UA_NodeId parent  = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_NodeId refType = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    char id[64], name[64];
 
+    if (fleetMode) {
+        snprintf(id, sizeof(id), "equipment.%zu", i);
+        snprintf(name, sizeof(name), "Asset_%zu", i);
+        UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+        oattr.displayName = UA_LOCALIZEDTEXT("en-US", name);
+        parent = UA_NODEID_STRING(1, id);
+        count_node(UA_Server_addObjectNode(server, parent,
+            UA_NODEID_STRING(1, "equipment"),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+            UA_QUALIFIEDNAME(1, name),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+            oattr, NULL, NULL));
+        refType = UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT);
+    }
+
+    const char *prefix = fleetMode ? id : "equipment";
+    char buf[96];
+    snprintf(buf, sizeof(buf), "%s.bearing.vibration", prefix);
+    fleet.node_vib[i] = UA_NODEID_STRING_ALLOC(1, buf);
+    snprintf(buf, sizeof(buf), "%s.temperature", prefix);
+    fleet.node_temp[i] = UA_NODEID_STRING_ALLOC(1, buf);
+    snprintf(buf, sizeof(buf), "%s.pressure", prefix);
+    fleet.node_press[i] = UA_NODEID_STRING_ALLOC(1, buf);
+    snprintf(buf, sizeof(buf), "%s.bearing.alarm", prefix);
+    fleet.node_alarm[i] = UA_NODEID_STRING_ALLOC(1, buf);
+
+    const UA_Byte rw = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_Boolean alarmInit = false;
+
+    // 1. Вибрация
+    addTelemetryVar(server, &fleet.node_vib[i], &parent, &refType,
+                    "Bearing_Vibration_mm_s", "Скорость вибрации подшипника, мм/с",
+                    &fleet.vib[i], &UA_TYPES[UA_TYPES_DOUBLE], rw,
+                    tag_context(i, TAG_VIB));
+    addEURange(server, &fleet.node_vib[i], 0.0, 15.0);
+    // 2. Температура
+    addTelemetryVar(server, &fleet.node_temp[i], &parent, &refType,
+                    "Temperature_C", "Температура оборудования, °C",
+                    &fleet.temp[i], &UA_TYPES[UA_TYPES_DOUBLE], rw,
+                    tag_context(i, TAG_TEMP));
+    addEURange(server, &fleet.node_temp[i], 0.0, 100.0);
     // 3. Давление
-    UA_Variant_setScalar(&attr.value, &press_value, &UA_TYPES[UA_TYPES_DOUBLE]);
-    attr.displayName = UA_LOCALIZEDTEXT("en-US", "Pressure_bar");
-    attr.description = UA_LOCALIZEDTEXT("ru-RU", "Давление в системе, бар");
-    node_press = UA_NODEID_STRING(1, "equipment.pressure");
-    UA_Server_addVariableNode(server, node_press,
-        UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
-        UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
-        UA_QUALIFIEDNAME(1, "Pressure_bar"),
-        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
-        attr, NULL, NULL);
+    addTelemetryVar(server, &fleet.node_press[i], &parent, &refType,
+                    "Pressure_bar", "Давление в системе, бар",
+                    &fleet.press[i], &UA_TYPES[UA_TYPES_DOUBLE], rw,
+                    tag_context(i, TAG_PRESS));
+    addEURange(server, &fleet.node_press[i], 0.0, 2.0);
+    // 4. Флаг тревоги (Boolean, только чтение)
+    addTelemetryVar(server, &fleet.node_alarm[i], &parent, &refType,
+                    "Bearing_Alarm", "Тревога по вибрации подшипника",
+                    &alarmInit, &UA_TYPES[UA_TYPES_BOOLEAN], UA_ACCESSLEVELMASK_READ,
+                    tag_context(i, TAG_ALARM));
 
-    // 4. Флаг тревоги (Boolean)
-    UA_VariableAttributes attrAlarm = UA_VariableAttributes_default;
-    attrAlarm.dataType = UA_TYPES[UA_TYPES_BOOLEAN].typeId;
-    attrAlarm.accessLevel = UA_ACCESSLEVELMASK_READ;
-    UA_Variant_setScalar(&attrAlarm.value, &alarm_state, &UA_TYPES[UA_TYPES_BOOLEAN]);
-    attrAlarm.displayName = UA_LOCALIZEDTEXT("en-US", "Bearing_Alarm");
-    attrAlarm.description = UA_LOCALIZEDTEXT("ru-RU", "Тревога по вибрации подшипника");
-    node_alarm = UA_NODEID_STRING(1, "equipment.bearing.alarm");
-    UA_Server_addVariableNode(server, node_alarm,
-        UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
-        UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
-        UA_QUALIFIEDNAME(1, "Bearing_Alarm"),
-        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
-        attrAlarm, NULL, NULL);
+    // 5. Вероятность тревоги по модели (только с --model)
+    if (forest) {
+        UA_Double probInit = 0.0;
+        snprintf(buf, sizeof(buf), "%s.bearing.alarm_probability", prefix);
+        fleet.node_prob[i] = UA_NODEID_STRING_ALLOC(1, buf);
+        addTelemetryVar(server, &fleet.node_prob[i], &parent, &refType,
+                        "Bearing_Alarm_Probability", "Вероятность тревоги по модели RandomForest",
+                        &probInit, &UA_TYPES[UA_TYPES_DOUBLE], UA_ACCESSLEVELMASK_READ,
+                        tag_context(i, TAG_PROB));
+    }
+
+    // 6. Форма вибросигнала (только с --waveform)
+    if (waveformMode)
+        addWaveformVars(server, i, prefix, &parent, &refType);
+    if (spectrum)
+        addEnvelopeVars(server, i, prefix, &parent, &refType);
 
-    // Регистрируем обновление каждые 100 мс (как в gen.c)
-    UA_Server_addRepeatedCallback(server, update_cb, NULL, 2000, NULL);
+    // 7. Оконные признаки тегов (только с --features)
+    if (features)
+        addFeatureVars(server, i, prefix, &parent, &refType);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Использование: %s [--assets N] [--interval MS] [--history N] [--model FILE]\n"
+            "       [--waveform RATE] [--block N] [--spectrum N] [--overlap PCT] [--window NAME]\n"
+            "       [--envelope-band LO,HI] [--bearing NB,D,DP[,DEG]] [--spectrum-threads T]\n"
+            "       [--features W] [--seed S]\n"
+            "       [--log-every N] [--log-rate N] [--datasource] [--threaded] [--rules FILE]\n"
+            "       [--pubsub URL] [--pubsub-interval MS] [--pubsub-block N] [--pubsub-iface ADDR]\n"
+            "       [--shm NAME] [--shm-slots N] [--tags FILE]\n"
+            "  --assets N     режим парка: N агрегатов (1..%d), узлы equipment.<id>.*\n"
+            "  --interval MS  период обновления, мс (по умолчанию 2000)\n"
+            "  --history N    хранить N последних отсчётов узла для HistoryRead\n"
+            "  --model FILE   лес .rff (ml/export_forest.py) для прогноза тревоги в тике\n"
+            "  --waveform RATE  форма вибросигнала с частотой RATE Гц (1000..100000)\n"
+            "  --block N      отсчётов в блоке формы сигнала (64..65536, по умолчанию 4096)\n"
+            "  --spectrum N   спектр огибающей по кадрам из N отсчётов (степень двойки 256..65536)\n"
+            "  --overlap PCT  перекрытие кадров, %% (0..75, по умолчанию 50)\n"
+            "  --window NAME  окно кадра: hann (по умолчанию), blackman, rect\n"
+            "  --envelope-band LO,HI  полоса демодуляции, Гц (по умолчанию 2000,4000)\n"
+            "  --bearing NB,D,DP[,DEG]  тел качения, их диаметр, диаметр центров, угол контакта\n"
+            "                 (по умолчанию 6205: 9,7.94,39.04,0)\n"
+            "  --spectrum-threads T  потоков спектра (по умолчанию — по числу процессоров)\n"
+            "  --features W   оконные признаки тегов за W тиков (2..%d)\n"
+            "  --seed S       seed модели сигналов (по умолчанию — текущее время)\n"
+            "  --log-every N  писать в лог каждый N-й тик (по умолчанию 1)\n"
+            "  --log-rate N   не больше N строк лога в секунду (по умолчанию 100, 0 — без предела)\n"
+            "  --datasource   узлы читают массивы парка при чтении, без записи в тике (без --history)\n"
+            "  --threaded     тик в отдельном потоке, сервер публикует готовые кадры\n"
+            "  --rules FILE   таблица правил тревог (alarms.rules) с событиями Alarms & Conditions\n"
+            "  --pubsub URL   публикация UADP в multicast-группу (например %s)\n"
+            "  --pubsub-interval MS  период публикации, мс (по умолчанию — как --interval)\n"
+            "  --pubsub-block N      агрегатов в датаграмме (1..%d, по умолчанию 32)\n"
+            "  --pubsub-iface ADDR   IPv4-адрес интерфейса для multicast\n"
+            "  --shm NAME     кольцо тиков в /dev/shm для потребителей на хосте (например %s)\n"
+            "  --shm-slots N  слотов кольца (2..65536, по умолчанию 32)\n"
+            "  --tags FILE    теги из файла описания (tags.csv) в папке Tags\n",
+            prog, MAX_ASSETS, MAX_FEATURE_WINDOW, UADP_DEFAULT_URL, UADP_MAX_BLOCK, SHM_DEFAULT_NAME);
+}
 
-    UA_Server_run(server, &running);
-    UA_Server_delete(server);
-    return 0;
+int main(int argc, char **argv) {
+    const UA_DateTime processStart = UA_DateTime_nowMonotonic();
+    // --- Разбор аргументов командной строки ---
+    long nAssets = 1;           // по умолчанию — один агрегат
+    double interval = 2000.0;   // период колбэка, мс
+    UA_Boolean fleetMode = false;
+    long historyDepth = 0;      // отсчётов истории на узел, 0 — без истории
+    const char *modelPath = NULL;
+    const char *rulesPath = NULL;
+    const char *tagsPath = NULL;
+    double wfRate = 0.0;        // частота дискретизации формы сигнала, 0 — выключена
+    long wfBlock = 4096;        // отсчётов в блоке
+    long spFrame = 0;           // кадр спектра огибающей, 0 — выключен
+    double spOverlap = 50.0;    // перекрытие кадров, %
+    SpectrumWindow spWindow = SPECTRUM_HANN;
+    double spBand[2] = { 0.0, 0.0 };             // полоса демодуляции, 0 — по умолчанию
+    double spBearing[4] = { 0.0, 0.0, 0.0, 0.0 }; // тел качения, d, D, угол; 0 — 6205
+    long spThreads = 0;         // потоков спектра, 0 — по числу процессоров
+    long featWindow = 0;        // окно признаков, тиков; 0 — выключены
+    uint64_t seed = (uint64_t)time(NULL);
+    double logRate = 100.0;     // строк лога в секунду
+    UadpPublisherConfig psConfig = { NULL, NULL, 1, 1, 32, 1 }; // url, iface, PublisherId, WriterGroupId, блок, TTL
+    double psInterval = 0.0;    // период публикации, мс; 0 — как у тика
+    const char *shmName = NULL; // кольцо в /dev/shm, NULL — выключено
+    long shmSlots = 32;
+    for (int a = 1; a < argc; a++) {
+        if (!strcmp(argv[a], "--assets") && a + 1 < argc) {
+            nAssets = strtol(argv[++a], NULL, 10);
+            fleetMode = true;
+        } else if (!strcmp(argv[a], "--interval") && a + 1 < argc) {
+            interval = strtod(argv[++a], NULL);
+        } else if (!strcmp(argv[a], "--history") && a + 1 < argc) {
+            historyDepth = strtol(argv[++a], NULL, 10);
+        } else if (!strcmp(argv[a], "--model") && a + 1 < argc) {
+            modelPath = argv[++a];
+        } else if (!strcmp(argv[a], "--waveform") && a + 1 < argc) {
+            wfRate = strtod(argv[++a], NULL);
+            waveformMode = true;
+        } else if (!strcmp(argv[a], "--block") && a + 1 < argc) {
+            wfBlock = strtol(argv[++a], NULL, 10);
+        } else if (!strcmp(argv[a], "--spectrum") && a + 1 < argc) {
+            spFrame = strtol(argv[++a], NULL, 10);
+        } else if (!strcmp(argv[a], "--overlap") && a + 1 < argc) {
+            spOverlap = strtod(argv[++a], NULL);
+        } else if (!strcmp(argv[a], "--window") && a + 1 < argc) {
+            const char *w = argv[++a];
+            spWindow = !strcmp(w, "blackman") ? SPECTRUM_BLACKMAN : !strcmp(w, "rect") ? SPECTRUM_RECT : SPECTRUM_HANN;
+            if (spWindow == SPECTRUM_HANN && strcmp(w, "hann"))
+                spFrame = -1; // неизвестное окно — ошибка ниже
+        } else if (!strcmp(argv[a], "--envelope-band") && a + 1 < argc) {
+            if (sscanf(argv[++a], "%lf,%lf", &spBand[0], &spBand[1]) != 2)
+                spFrame = -1;
+        } else if (!strcmp(argv[a], "--bearing") && a + 1 < argc) {
+            if (sscanf(argv[++a], "%lf,%lf,%lf,%lf", &spBearing[0], &spBearing[1], &spBearing[2], &spBearing[3]) < 3)
+                spFrame = -1;
+        } else if (!strcmp(argv[a], "--spectrum-threads") && a + 1 < argc) {
+            spThreads = strtol(argv[++a], NULL, 10);
+        } else if (!strcmp(argv[a], "--features") && a + 1 < argc) {
+            featWindow = strtol(argv[++a], NULL, 10);
+        } else if (!strcmp(argv[a], "--seed") && a + 1 < argc) {
+            seed = strtoull(argv[++a], NULL, 10);
+        } else if (!strcmp(argv[a], "--log-every") && a + 1 < argc) {
+            logEvery = strtol(argv[++a], NULL, 10);
+        } else if (!strcmp(argv[a], "--log-rate") && a + 1 < argc) {
+            logRate = strtod(argv[++a], NULL);
+        } else if (!strcmp(argv[a], "--datasource")) {
+            dataSourceMode = true;
+        } else if (!strcmp(argv[a], "--threaded")) {
+            threadedMode = true;
+        } else if (!strcmp(argv[a], "--rules") && a + 1 < argc) {
+            rulesPath = argv[++a];
+        } else if (!strcmp(argv[a], "--pubsub") && a + 1 < argc) {
+            psConfig.url = argv[++a];
+        } else if (!strcmp(argv[a], "--pubsub-interval") && a + 1 < argc) {
+            psInterval = strtod(argv[++a], NULL);
+        } else if (!strcmp(argv[a], "--pubsub-block") && a + 1 < argc) {
+            psConfig.assetsPerMessage = strtoul(argv[++a], NULL, 10);
+        } else if (!strcmp(argv[a], "--pubsub-iface") && a + 1 < argc) {
+            psConfig.iface = argv[++a];
+        } else if (!strcmp(argv[a], "--shm") && a + 1 < argc) {
+            shmName = argv[++a];
+        } else if (!strcmp(argv[a], "--shm-slots") && a + 1 < argc) {
+            shmSlots = strtol(argv[++a], NULL, 10);
+        } else if (!strcmp(argv[a], "--tags") && a + 1 < argc) {
+            tagsPath = argv[++a];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (nAssets < 1 || nAssets > MAX_ASSETS || interval <= 0 || historyDepth < 0 ||
+        (waveformMode && (wfRate < 1000 || wfRate > 100000)) || wfBlock < 64 || wfBlock > 65536 ||
+        spFrame < 0 || (spFrame > 0 && !waveformMode) || spThreads < 0 ||
+        (featWindow != 0 && (featWindow < 2 || featWindow > MAX_FEATURE_WINDOW)) ||
+        logEvery < 1 || logRate < 0 || (dataSourceMode && historyDepth > 0) || psInterval < 0 ||
+        shmSlots < 2 || shmSlots > 65536) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    signal(SIGINT, stopHandler);
+    tickSeconds = interval / 1000.0;
+    tickTime = UA_DateTime_now();
+    if (!fleet_alloc(&fleet, (size_t)nAssets, seed)) {
+        fprintf(stderr, "Не удалось выделить память под %ld агрегатов\n", nAssets);
+        fleet_free(&fleet);
+        return 1;
+    }
+    if (modelPath) {
+        forest = rf_load(modelPath);
+        if (!forest || rf_num_features(forest) != 3 || !fleet_alloc_model(&fleet)) {
+            fprintf(stderr, "Модель %s не загружена (нужен лес на 3 признака)\n", modelPath);
+            rf_free(forest);
+            fleet_free(&fleet);
+            return 1;
+        }
+    }
+    if (waveformMode) {
+        waveform_default(&wfConfig, wfRate, (size_t)wfBlock);
+        wfBuf = calloc((size_t)wfBlock, sizeof(double));
+        fleet.node_wf    = calloc(fleet.n, sizeof(UA_NodeId));
+        fleet.node_wf_ts = calloc(fleet.n, sizeof(UA_NodeId));
+        if (!wfBuf || !fleet.node_wf || !fleet.node_wf_ts) {
+            fprintf(stderr, "Не удалось выделить память под форму сигнала\n");
+            free(wfBuf);
+            rf_free(forest);
+            fleet_free(&fleet);
+            return 1;
+        }
+        wfStart = UA_DateTime_now();
+    }
+    if (spFrame > 0) {
+        SpectrumConfig spc;
+        spectrum_default(&spc, wfConfig.sampleRate, wfConfig.shaftHz);
+        spc.frameSize = (size_t)spFrame;
+        spc.overlap = spOverlap / 100.0;
+        spc.window = spWindow;
+        if (spBand[1] > 0) {
+            spc.bandLo = spBand[0];
+            spc.bandHi = spBand[1];
+        }
+        if (spBearing[0] > 0) {
+            spc.balls = (int)spBearing[0];
+            spc.ballDiam = spBearing[1];
+            spc.pitchDiam = spBearing[2];
+            spc.contactDeg = spBearing[3];
+        }
+        if (spThreads == 0)
+            spThreads = sysconf(_SC_NPROCESSORS_ONLN) > 0 ? sysconf(_SC_NPROCESSORS_ONLN) : 1;
+        char err[256];
+        fleet.node_env = calloc(fleet.n * SPECTRUM_FAULTS, sizeof(UA_NodeId));
+        if (!fleet.node_env ||
+            !(spectrum = spectrum_bank_new(&spc, fleet.n, wfConfig.blockSize, (int)spThreads, err, sizeof(err)))) {
+            fprintf(stderr, "Спектр огибающей: %s\n", fleet.node_env ? err : "нет памяти");
+            free(wfBuf);
+            rf_free(forest);
+            fleet_free(&fleet);
+            return 1;
+        }
+        double hz[SPECTRUM_FAULTS];
+        spectrum_fault_hz(&spc, hz);
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                    "Спектр огибающей: кадр %zu, перекрытие %.0f%%, полоса %.0f..%.0f Гц, потоков %ld; "
+                    "FTF %.1f BPFO %.1f BPFI %.1f BSF %.1f Гц",
+                    spc.frameSize, spOverlap, spc.bandLo, spc.bandHi, spThreads, hz[0], hz[1], hz[2], hz[3]);
+    }
+    if (featWindow > 0) {
+        features = features_new(fleet.n * FEATURE_TAGS, (size_t)featWindow, 0.0);
+        fleet.node_feat = calloc(fleet.n * FEATURE_TAGS * FEATURE_COUNT, sizeof(UA_NodeId));
+        if (!features || !fleet.node_feat) {
+            fprintf(stderr, "Не удалось выделить память под признаки (окно %ld)\n", featWindow);
+            features_free(features);
+            spectrum_bank_free(spectrum);
+            free(wfBuf);
+            rf_free(forest);
+            fleet_free(&fleet);
+            return 1;
+        }
+    }
+    if (rulesPath) {
+        AlarmRule *rules = NULL;
+        size_t nRules = 0;
+        char err[256];
+        if (alarm_rules_load(rulesPath, alarmTagNames, FEATURE_TAGS, &rules, &nRules, err, sizeof(err)) != 0)
+            fprintf(stderr, "Правила тревог: %s\n", err);
+        else if (!(alarmEngine = alarm_engine_new(rules, nRules, fleet.n)))
+            fprintf(stderr, "Не удалось выделить память под правила тревог\n");
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+        alarmCond   = calloc(fleet.n * nRules, sizeof(UA_NodeId));
+        alarmSource = calloc(fleet.n, sizeof(uint8_t));
+        if (alarmEngine && (!alarmCond || !alarmSource)) {
+            fprintf(stderr, "Не удалось выделить память под условия тревог\n");
+            alarm_engine_free(alarmEngine);
+            alarmEngine = NULL;
+        }
+#endif
+        free(rules);
+        if (!alarmEngine) {
+            features_free(features);
+            spectrum_bank_free(spectrum);
+            free(wfBuf);
+            rf_free(forest);
+            fleet_free(&fleet);
+            return 1;
+        }
+        assetObjects = fleetMode;
+    }
+    if (psConfig.url) {
+        char err[256];
+        if (!(pubsub = uadp_pub_new(&psConfig, fleet.n, err, sizeof(err)))) {
+            fprintf(stderr, "PubSub: %s\n", err);
+            alarm_engine_free(alarmEngine);
+            features_free(features);
+            spectrum_bank_free(spectrum);
+            free(wfBuf);
+            rf_free(forest);
+            fleet_free(&fleet);
+            return 1;
+        }
+    }
+    if (shmName) {
+        char err[256];
+        if (!(shm = shm_pub_new(shmName, fleet.n, (size_t)shmSlots, UA_DateTime_now(), err, sizeof(err)))) {
+            fprintf(stderr, "Разделяемая память: %s\n", err);
+            uadp_pub_free(pubsub);
+            alarm_engine_free(alarmEngine);
+            features_free(features);
+            spectrum_bank_free(spectrum);
+            free(wfBuf);
+            rf_free(forest);
+            fleet_free(&fleet);
+            return 1;
+        }
+    }
+    if (tagsPath) {
+        char err[256];
+        UA_DateTime t0 = UA_DateTime_nowMonotonic();
+        if (!(tagModel = tag_model_load(tagsPath, err, sizeof(err)))) {
+            fprintf(stderr, "Теги: %s\n", err);
+            shm_pub_free(shm);
+            uadp_pub_free(pubsub);
+            alarm_engine_free(alarmEngine);
+            features_free(features);
+            spectrum_bank_free(spectrum);
+            free(wfBuf);
+            rf_free(forest);
+            fleet_free(&fleet);
+            return 1;
+        }
+        startup.parse_ms = (double)(UA_DateTime_nowMonotonic() - t0) / UA_DATETIME_MSEC;
+    }
+    // Создаём сервер и конфигурацию по умолчанию
+    UA_Server *server = UA_Server_new();
+    UA_ServerConfig_setDefault(UA_Server_getConfig(server));
+#ifndef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    if (alarmEngine)
+        UA_LOG_WARNING(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                       "--rules: open62541 собрана без UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS, "
+                       "события Alarms & Conditions не поднимаются — переходы тревог только в лог");
+#endif
+
+    // Кольцевые буферы истории: по кольцу на каждый узел агрегата
+    if (historyDepth > 0) {
+        history = history_ring_new(fleet.n * (forest ? 5 : 4), (size_t)historyDepth);
+        if (!history) {
+            fprintf(stderr, "Не удалось выделить память под историю\n");
+            UA_Server_delete(server);
+            tag_model_free(tagModel);
+            shm_pub_free(shm);
+            uadp_pub_free(pubsub);
+            alarm_engine_free(alarmEngine);
+            features_free(features);
+            rf_free(forest);
+            spectrum_bank_free(spectrum);
+            free(wfBuf);
+            fleet_free(&fleet);
+            return 1;
+        }
+        history_ring_attach(history, UA_Server_getConfig(server)); // освободит UA_Server_delete
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                    "История: %ld отсчётов на узел, %.1f МБ", historyDepth,
+                    history_ring_bytes(history) / 1048576.0);
+    }
+
+    // Папка Equipment — корень поддеревьев агрегатов в режиме парка
+    UA_DateTime nodesStart = UA_DateTime_nowMonotonic();
+    if (fleetMode) {
+        UA_ObjectAttributes fattr = UA_ObjectAttributes_default;
+        fattr.displayName = UA_LOCALIZEDTEXT("en-US", "Equipment");
+        count_node(UA_Server_addObjectNode(server, UA_NODEID_STRING(1, "equipment"),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+            UA_QUALIFIEDNAME(1, "Equipment"),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE),
+            fattr, NULL, NULL));
+    }
+
+    // Узлы всех агрегатов
+    for (size_t i = 0; i < fleet.n; i++)
+        addAssetNodes(server, i, fleetMode);
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                "Создано агрегатов: %zu (узлов: %zu), период %.0f мс, seed %llu%s",
+                fleet.n, nodesAdded, interval, (unsigned long long)seed,
+                dataSourceMode ? ", узлы — источники данных" : "");
+    startup.nodes = nodesAdded;
+
+    // Теги из файла — папка Tags
+    if (tagModel) {
+        char err[256];
+        if (tag_model_build(tagModel, server, err, sizeof(err)) != UA_STATUSCODE_GOOD) {
+            fprintf(stderr, "Теги: %s\n", err);
+            UA_Server_delete(server);
+            tag_model_free(tagModel);
+            shm_pub_free(shm);
+            uadp_pub_free(pubsub);
+            alarm_engine_free(alarmEngine);
+            features_free(features);
+            rf_free(forest);
+            spectrum_bank_free(spectrum);
+            free(wfBuf);
+            fleet_free(&fleet);
+            return 1;
+        }
+        startup.nodes += tag_model_nodes(tagModel);
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "Теги из %s: %zu (узлов: %zu)",
+                    tagsPath, tag_model_tags(tagModel), tag_model_nodes(tagModel));
+    }
+    startup.nodes_ms = (double)(UA_DateTime_nowMonotonic() - nodesStart) / UA_DATETIME_MSEC;
+
+    // Диагностика: калибровка счётчика тактов и узлы гистограмм
+    perf_calibrate();
+    intervalNs = (uint64_t)(interval * 1e6);
+    addDiagnosticsNodes(server);
+
+    // Регистрируем обновление каждые --interval мс или, с --threaded,
+    // поток симуляции и частый опрос готовых кадров
+    if (threadedMode) {
+        void *frames[3] = { &simFrames[0], &simFrames[1], &simFrames[2] };
+        if (!sim_frames_alloc() || !(simThread = sim_thread_start(interval, frames, sim_step, NULL))) {
+            fprintf(stderr, "Не удалось запустить поток симуляции\n");
+            UA_Server_delete(server);
+            tag_model_free(tagModel);
+            shm_pub_free(shm);
+            uadp_pub_free(pubsub);
+            alarm_engine_free(alarmEngine);
+            sim_frames_free();
+            features_free(features);
+            rf_free(forest);
+            spectrum_bank_free(spectrum);
+            free(wfBuf);
+            fleet_free(&fleet);
+            return 1;
+        }
+        double pollMs = interval / 4 < 10.0 ? interval / 4 : 10.0;
+        UA_Server_addRepeatedCallback(server, publish_cb, NULL, pollMs, NULL);
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                    "Поток симуляции: период %.0f мс, опрос кадров каждые %.1f мс", interval, pollMs);
+    } else {
+        UA_Server_addRepeatedCallback(server, update_cb, NULL, interval, NULL);
+    }
+    UA_Server_addRepeatedCallback(server, diag_cb, NULL, 1000.0, NULL);
+    if (pubsub) {
+        if (psInterval <= 0)
+            psInterval = interval;
+        UA_Server_addRepeatedCallback(server, pubsub_cb, NULL, psInterval, NULL);
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                    "PubSub: %s, каждые %.0f мс, %zu агрегатов в датаграмме",
+                    psConfig.url, psInterval, psConfig.assetsPerMessage);
+    }
+    if (shm)
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                    "Разделяемая память: /dev/shm%s%s, %ld слотов, %.1f МБ",
+                    shmName[0] == '/' ? "" : "/", shmName, shmSlots, shm_pub_bytes(shm) / 1048576.0);
+    if (waveformMode) {
+        double blockMs = wfConfig.blockSize / wfConfig.sampleRate * 1000.0;
+        UA_Server_addRepeatedCallback(server, waveform_cb, NULL, blockMs, NULL);
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                    "Форма сигнала: %.0f Гц, блок %zu отсчётов каждые %.1f мс",
+                    wfConfig.sampleRate, wfConfig.blockSize, blockMs);
+    }
+
+    if (alog_start(4096, logRate) != 0)
+        fprintf(stderr, "Фоновый лог не запущен, строки пишутся синхронно\n");
+
+    // Запуск вручную (как UA_Server_run), чтобы замерить время до приёма подключений
+    UA_DateTime listenStart = UA_DateTime_nowMonotonic();
+    UA_StatusCode rc = UA_Server_run_startup(server);
+    UA_DateTime listening = UA_DateTime_nowMonotonic();
+    startup.listen_ms = (double)(listening - listenStart) / UA_DATETIME_MSEC;
+    startup.total_ms = (double)(listening - processStart) / UA_DATETIME_MSEC;
+    if (rc == UA_STATUSCODE_GOOD) {
+        UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                    "Подключения принимаются через %.0f мс после запуска: теги %.0f мс, "
+                    "узлы %.0f мс (%llu, %.0f узлов/с), старт сервера %.0f мс",
+                    startup.total_ms, startup.parse_ms, startup.nodes_ms,
+                    (unsigned long long)startup.nodes,
+                    startup.nodes_ms > 0 ? startup.nodes * 1000.0 / startup.nodes_ms : 0.0,
+                    startup.listen_ms);
+        writeDiag(server, "diagnostics.startup.parse_ms", &startup.parse_ms, 0, &UA_TYPES[UA_TYPES_DOUBLE]);
+        writeDiag(server, "diagnostics.startup.nodes_ms", &startup.nodes_ms, 0, &UA_TYPES[UA_TYPES_DOUBLE]);
+        writeDiag(server, "diagnostics.startup.listen_ms", &startup.listen_ms, 0, &UA_TYPES[UA_TYPES_DOUBLE]);
+        writeDiag(server, "diagnostics.startup.total_ms", &startup.total_ms, 0, &UA_TYPES[UA_TYPES_DOUBLE]);
+        writeDiag(server, "diagnostics.startup.nodes", &startup.nodes, 0, &UA_TYPES[UA_TYPES_UINT64]);
+        while (running)
+            UA_Server_run_iterate(server, true);
+        UA_Server_run_shutdown(server);
+    } else {
+        fprintf(stderr, "Сервер не запущен: %s\n", UA_StatusCode_name(rc));
+    }
+    sim_thread_stop(simThread);
+    alog_stop();
+    if (history && history_ring_clamped(history))
+        UA_LOG_WARNING(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                       "История: %llu отсчётов с меткой старше предыдущей, метка поднята",
+                       (unsigned long long)history_ring_clamped(history));
+    UA_Server_delete(server); // освобождает и history
+    tag_model_free(tagModel);
+    shm_pub_free(shm);
+    uadp_pub_free(pubsub);
+#ifdef UA_ENABLE_SUBSCRIPTIONS_ALARMS_CONDITIONS
+    for (size_t j = 0; alarmEngine && j < fleet.n * alarm_engine_rule_count(alarmEngine); j++)
+        UA_NodeId_clear(&alarmCond[j]);
+    free(alarmCond);
+    free(alarmSource);
+#endif
+    alarm_engine_free(alarmEngine);
+    sim_frames_free();
+    features_free(features);
+    rf_free(forest);
+    spectrum_bank_free(spectrum);
+    free(wfBuf);
+    fleet_free(&fleet);
+    return rc == UA_STATUSCODE_GOOD ? 0 : 1;
 }
@@ -0,0 +1,282 @@
+/*
+ * history_ring.c — реализация history_ring.h
+ * ------------------------------------------
+ * Раскладка памяти: для узла с номером слота s отсчёт с порядковым номером seq
+ * лежит в ts[s * cap + seq % cap] и val[s * cap + seq % cap]. Порядковый номер
+ * растёт с каждой записью и не сбрасывается, поэтому точка продолжения
+ * (continuation point) — это просто seq следующего отсчёта, без состояния на сервере.
+ *
+ * Поиск слота по NodeId — открытая адресация, таблица строится при регистрации.
+ */
+#include "history_ring.h"
+#include <open62541/plugin/historydatabase.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct HistoryRing {
+    size_t       maxNodes;    // слотов выделено
+    size_t       nNodes;      // слотов занято
+    size_t       cap;         // отсчётов на узел
+    UA_DateTime *ts;          // метки источника [maxNodes * cap]
+    double      *val;         // значения (Boolean хранится как 0/1) [maxNodes * cap]
+    uint64_t    *written;     // всего записано в слот
+    UA_NodeId   *ids;         // NodeId слота
+    const UA_DataType **type; // тип значения слота
+    uint32_t    *table;       // хеш-таблица: номер слота + 1, 0 — пусто
+    size_t       tableMask;
+    uint64_t     clamped;     // отсчётов с меткой старше предыдущей (поднята до неё)
+};
+
+HistoryRing *history_ring_new(size_t maxNodes, size_t samplesPerNode) {
+    if (maxNodes == 0 || samplesPerNode == 0)
+        return NULL;
+    HistoryRing *h = calloc(1, sizeof(HistoryRing));
+    if (!h)
+        return NULL;
+    size_t tableSize = 16;
+    while (tableSize < maxNodes * 2)
+        tableSize <<= 1;
+    h->maxNodes  = maxNodes;
+    h->cap       = samplesPerNode;
+    h->tableMask = tableSize - 1;
+    h->ts      = malloc(maxNodes * samplesPerNode * sizeof(UA_DateTime));
+    h->val     = malloc(maxNodes * samplesPerNode * sizeof(double));
+    h->written = calloc(maxNodes, sizeof(uint64_t));
+    h->ids     = calloc(maxNodes, sizeof(UA_NodeId));
+    h->type    = calloc(maxNodes, sizeof(UA_DataType *));
+    h->table   = calloc(tableSize, sizeof(uint32_t));
+    if (!h->ts || !h->val || !h->written || !h->ids || !h->type || !h->table) {
+        history_ring_delete(h);
+        return NULL;
+    }
+    return h;
+}
+
+void history_ring_delete(HistoryRing *h) {
+    if (!h)
+        return;
+    for (size_t s = 0; h->ids && s < h->nNodes; s++)
+        UA_NodeId_clear(&h->ids[s]);
+    free(h->ts); free(h->val); free(h->written);
+    free(h->ids); free(h->type); free(h->table);
+    free(h);
+}
+
+size_t history_ring_bytes(const HistoryRing *h) {
+    return h->maxNodes * h->cap * (sizeof(UA_DateTime) + sizeof(double));
+}
+
+uint64_t history_ring_clamped(const HistoryRing *h) {
+    return h->clamped;
+}
+
+// Слот узла или -1, если узел не зарегистрирован
+static long lookup(const HistoryRing *h, const UA_NodeId *nodeId) {
+    for (size_t pos = UA_NodeId_hash(nodeId) & h->tableMask;; pos = (pos + 1) & h->tableMask) {
+        uint32_t e = h->table[pos];
+        if (e == 0)
+            return -1;
+        if (UA_NodeId_equal(&h->ids[e - 1], nodeId))
+            return (long)(e - 1);
+    }
+}
+
+UA_StatusCode history_ring_register(HistoryRing *h, const UA_NodeId *nodeId,
+                                    const UA_DataType *type) {
+    if (lookup(h, nodeId) >= 0)
+        return UA_STATUSCODE_GOOD;
+    if (h->nNodes == h->maxNodes)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    size_t s = h->nNodes;
+    UA_StatusCode rc = UA_NodeId_copy(nodeId, &h->ids[s]);
+    if (rc != UA_STATUSCODE_GOOD)
+        return rc;
+    h->type[s] = type;
+    size_t pos = UA_NodeId_hash(nodeId) & h->tableMask;
+    while (h->table[pos] != 0)
+        pos = (pos + 1) & h->tableMask;
+    h->table[pos] = (uint32_t)(s + 1);
+    h->nNodes++;
+    return UA_STATUSCODE_GOOD;
+}
+
+// --- Колбэки UA_HistoryDatabase ---
+
+static void hdb_clear(UA_HistoryDatabase *hdb) {
+    history_ring_delete((HistoryRing *)hdb->context);
+    hdb->context = NULL;
+}
+
+// Метка отсчёта seq слота s
+static inline UA_DateTime ts_at(const HistoryRing *h, size_t s, uint64_t seq) {
+    return h->ts[s * h->cap + seq % h->cap];
+}
+
+// Вызывается сервером при каждой записи значения переменной
+static void hdb_setValue(UA_Server *server, void *hdbContext, const UA_NodeId *sessionId,
+                         void *sessionContext, const UA_NodeId *nodeId,
+                         UA_Boolean historizing, const UA_DataValue *value) {
+    HistoryRing *h = (HistoryRing *)hdbContext;
+    if (!historizing || !value->hasValue || !UA_Variant_isScalar(&value->value))
+        return;
+    long s = lookup(h, nodeId);
+    if (s < 0)
+        return;
+
+    double v;
+    if (value->value.type == &UA_TYPES[UA_TYPES_DOUBLE])
+        v = *(const UA_Double *)value->value.data;
+    else if (value->value.type == &UA_TYPES[UA_TYPES_BOOLEAN])
+        v = *(const UA_Boolean *)value->value.data ? 1.0 : 0.0;
+    else
+        return;
+
+    // Метки в кольце не должны убывать (на этом стоит lower_bound): шаг часов назад
+    // или запись клиента со старой меткой поднимаются до метки предыдущего отсчёта
+    UA_DateTime ts = value->hasSourceTimestamp ? value->sourceTimestamp : UA_DateTime_now();
+    if (h->written[s] > 0) {
+        UA_DateTime prev = ts_at(h, (size_t)s, h->written[s] - 1);
+        if (ts < prev) {
+            ts = prev;
+            h->clamped++;
+        }
+    }
+    size_t idx = (size_t)s * h->cap + h->written[s] % h->cap;
+    h->ts[idx]  = ts;
+    h->val[idx] = v;
+    h->written[s]++;
+}
+
+// Первый seq в [lo, hi) с меткой >= t (метки в кольце не убывают)
+static uint64_t lower_bound(const HistoryRing *h, size_t s, uint64_t lo, uint64_t hi, UA_DateTime t) {
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (ts_at(h, s, mid) < t) lo = mid + 1;
+        else                      hi = mid;
+    }
+    return lo;
+}
+
+// Чтение истории одного узла в hd; cp — точка продолжения (вход и выход)
+static UA_StatusCode read_node(const HistoryRing *h, size_t s,
+                               const UA_ReadRawModifiedDetails *d,
+                               UA_TimestampsToReturn ttr, const UA_ByteString *cpIn,
+                               UA_ByteString *cpOut, UA_HistoryData *hd) {
+    const uint64_t newest = h->written[s];                        // seq после последнего
+    const uint64_t oldest = newest > h->cap ? newest - h->cap : 0; // seq самого старого
+    const UA_Boolean forward = d->startTime != 0 && (d->endTime == 0 || d->startTime <= d->endTime);
+    const UA_DateTime from = d->startTime != 0 ? d->startTime : d->endTime;
+    const UA_DateTime to   = d->startTime != 0 ? d->endTime   : 0;
+    const size_t limit = d->numValuesPerNode ? d->numValuesPerNode : h->cap;
+
+    // Диапазон seq: вперёд [first, last), назад — от first вниз до last
+    uint64_t first, last;
+    if (forward) {
+        first = lower_bound(h, s, oldest, newest, from);
+        last  = to != 0 ? lower_bound(h, s, first, newest, to + 1) : newest;
+    } else {
+        first = lower_bound(h, s, oldest, newest, from + 1);  // за последним с меткой <= from
+        last  = to != 0 ? lower_bound(h, s, oldest, first, to) : oldest;
+    }
+
+    // Продолжение предыдущего запроса
+    if (cpIn->length > 0) {
+        uint64_t next;
+        if (cpIn->length != sizeof(next))
+            return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        memcpy(&next, cpIn->data, sizeof(next));
+        if (next < oldest) // отсчёты уже перезаписаны
+            return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        first = next;
+    }
+
+    size_t avail = forward ? (first < last ? (size_t)(last - first) : 0)
+                           : (first > last ? (size_t)(first - last) : 0);
+    size_t cnt = avail < limit ? avail : limit;
+    if (cnt == 0)
+        return UA_STATUSCODE_GOOD;
+
+    UA_DataValue *dv = (UA_DataValue *)UA_Array_new(cnt, &UA_TYPES[UA_TYPES_DATAVALUE]);
+    if (!dv)
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    const UA_DataType *type = h->type[s];
+    for (size_t k = 0; k < cnt; k++) {
+        uint64_t seq = forward ? first + k : first - 1 - k;
+        size_t idx = s * h->cap + seq % h->cap;
+        if (type == &UA_TYPES[UA_TYPES_BOOLEAN]) {
+            UA_Boolean b = h->val[idx] != 0.0;
+            UA_Variant_setScalarCopy(&dv[k].value, &b, type);
+        } else {
+            UA_Variant_setScalarCopy(&dv[k].value, &h->val[idx], type);
+        }
+        dv[k].hasValue = true;
+        if (ttr == UA_TIMESTAMPSTORETURN_SOURCE || ttr == UA_TIMESTAMPSTORETURN_BOTH) {
+            dv[k].sourceTimestamp = h->ts[idx];
+            dv[k].hasSourceTimestamp = true;
+        }
+        if (ttr == UA_TIMESTAMPSTORETURN_SERVER || ttr == UA_TIMESTAMPSTORETURN_BOTH) {
+            dv[k].serverTimestamp = h->ts[idx];
+            dv[k].hasServerTimestamp = true;
+        }
+    }
+    hd->dataValues = dv;
+    hd->dataValuesSize = cnt;
+
+    // Остались значения — отдаём точку продолжения
+    if (cnt < avail) {
+        uint64_t next = forward ? first + cnt : first - cnt;
+        if (UA_ByteString_allocBuffer(cpOut, sizeof(next)) == UA_STATUSCODE_GOOD)
+            memcpy(cpOut->data, &next, sizeof(next));
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static void hdb_readRaw(UA_Server *server, void *hdbContext, const UA_NodeId *sessionId,
+                        void *sessionContext, const UA_RequestHeader *requestHeader,
+                        const UA_ReadRawModifiedDetails *details,
+                        UA_TimestampsToReturn timestampsToReturn,
+                        UA_Boolean releaseContinuationPoints,
+                        size_t nodesToReadSize, const UA_HistoryReadValueId *nodesToRead,
+                        UA_HistoryReadResponse *response,
+                        UA_HistoryData * const * const historyData) {
+    HistoryRing *h = (HistoryRing *)hdbContext;
+    for (size_t i = 0; i < nodesToReadSize; i++) {
+        UA_HistoryReadResult *res = &response->results[i];
+        if (releaseContinuationPoints) { // точки продолжения без состояния — освобождать нечего
+            res->statusCode = UA_STATUSCODE_GOOD;
+            continue;
+        }
+        long s = lookup(h, &nodesToRead[i].nodeId);
+        if (s < 0 || details->isReadModified) {
+            res->statusCode = UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED;
+            continue;
+        }
+        if (details->startTime == 0 && (details->endTime == 0 || details->numValuesPerNode == 0)) {
+            res->statusCode = UA_STATUSCODE_BADINVALIDARGUMENT;
+            continue;
+        }
+        if (timestampsToReturn == UA_TIMESTAMPSTORETURN_NEITHER) {
+            res->statusCode = UA_STATUSCODE_BADTIMESTAMPSTORETURNINVALID;
+            continue;
+        }
+        res->statusCode = read_node(h, (size_t)s, details, timestampsToReturn,
+                                    &nodesToRead[i].continuationPoint,
+                                    &res->continuationPoint, historyData[i]);
+    }
+    response->responseHeader.serviceResult = UA_STATUSCODE_GOOD;
+}
+
+void history_ring_attach(HistoryRing *h, UA_ServerConfig *config) {
+    if (config->historyDatabase.clear)
+        config->historyDatabase.clear(&config->historyDatabase);
+    UA_HistoryDatabase hdb;
+    memset(&hdb, 0, sizeof(hdb));
+    hdb.context  = h;
+    hdb.clear    = hdb_clear;
+    hdb.setValue = hdb_setValue;
+    hdb.readRaw  = hdb_readRaw;
+    config->historyDatabase = hdb;
+    config->accessHistoryDataCapability = true;
+    config->maxReturnDataValues = (UA_UInt32)h->cap;
+}
@@ -0,0 +1,54 @@
+/*
+ * history_ring.h — история значений узлов в кольцевых буферах (HistoryRead)
+ * ------------------------------------------------------------------------
+ * Модуль для серверов open62541/dynamic*.c: для каждого зарегистрированного узла
+ * хранит последние N пар (метка источника, значение) в заранее выделенном
+ * кольцевом буфере и отдаёт их клиентам через Historical Access
+ * (HistoryRead / ReadRawModifiedDetails). Так сборщик после переподключения
+ * может дозабрать пропущенные отсчёты без полной пересинхронизации с БД.
+ *
+ * Память выделяется один раз в history_ring_new(): узлов × N × 16 байт.
+ * Запись отсчёта (setValue) не выделяет память — старые значения перезаписываются.
+ * Метки в слоте не убывают: отсчёт с меткой старше предыдущей получает её метку.
+ *
+ * Требуется open62541, собранная с -DUA_ENABLE_HISTORIZING=ON.
+ *
+ * Использование:
+ *   HistoryRing *h = history_ring_new(maxNodes, 3600);
+ *   history_ring_register(h, &nodeId, &UA_TYPES[UA_TYPES_DOUBLE]); // для каждого узла
+ *   history_ring_attach(h, UA_Server_getConfig(server));          // h освобождает сервер
+ * У переменных нужно выставить attr.historizing = true и
+ * attr.accessLevel |= UA_ACCESSLEVELMASK_HISTORYREAD.
+ */
+#ifndef HISTORY_RING_H
+#define HISTORY_RING_H
+
+#include <open62541/server.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct HistoryRing HistoryRing;
+
+// Кольца на maxNodes узлов по samplesPerNode отсчётов; NULL при нехватке памяти
+HistoryRing *history_ring_new(size_t maxNodes, size_t samplesPerNode);
+
+// Освобождение (если кольца не переданы серверу через history_ring_attach)
+void history_ring_delete(HistoryRing *h);
+
+// Регистрация узла; тип — UA_TYPES_DOUBLE или UA_TYPES_BOOLEAN
+UA_StatusCode history_ring_register(HistoryRing *h, const UA_NodeId *nodeId,
+                                    const UA_DataType *type);
+
+// Подключение колец к конфигурации сервера как UA_HistoryDatabase.
+// После этого кольца удаляет сервер в UA_Server_delete().
+void history_ring_attach(HistoryRing *h, UA_ServerConfig *config);
+
+// Объём памяти под кольца, байт
+size_t history_ring_bytes(const HistoryRing *h);
+
+// Отсчётов, чья метка была старше предыдущей в слоте (шаг часов назад, запись со
+// старой sourceTimestamp): такие метки поднимаются до предыдущей, чтобы кольцо
+// оставалось упорядоченным для HistoryRead
+uint64_t history_ring_clamped(const HistoryRing *h);
+
+#endif
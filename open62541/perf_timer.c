@@ -0,0 +1,37 @@
+/*
+ * perf_timer.c — реализация perf_timer.h
+ * -------------------------------------
+ */
+#include "perf_timer.h"
+#include <math.h>
+#include <time.h>
+
+double perf_ns_per_tick = 1.0;
+
+static uint64_t mono_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void perf_calibrate(void) {
+    const struct timespec pause = { 0, 20000000L };
+    uint64_t n0 = mono_ns(), c0 = perf_now();
+    nanosleep(&pause, NULL);
+    uint64_t n1 = mono_ns(), c1 = perf_now();
+    perf_ns_per_tick = c1 > c0 ? (double)(n1 - n0) / (double)(c1 - c0) : 1.0;
+}
+
+double perf_hist_quantile(const PerfHist *h, double q) {
+    if (h->count == 0)
+        return 0.0;
+    uint64_t rank = (uint64_t)(q * (double)(h->count - 1)) + 1, acc = 0;
+    for (unsigned k = 0; k < PERF_BUCKETS; k++) {
+        acc += h->bucket[k];
+        if (acc >= rank) {
+            double mid = ldexp(M_SQRT2, (int)k); // 2^k · √2 — середина [2^k, 2^(k+1))
+            return mid < (double)h->max_ns ? mid : (double)h->max_ns;
+        }
+    }
+    return (double)h->max_ns;
+}
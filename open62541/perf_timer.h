@@ -0,0 +1,61 @@
+/*
+ * perf_timer.h — дешёвые таймеры горячего пути и гистограммы длительностей
+ * -----------------------------------------------------------------------
+ * perf_now() — счётчик тактов процессора (rdtsc, ~20 тактов на вызов) на x86,
+ * на других архитектурах — CLOCK_MONOTONIC. Перевод в наносекунды — по
+ * коэффициенту, измеренному один раз в perf_calibrate().
+ *
+ * PerfHist — гистограмма по степеням двойки: корзина k — [2^k, 2^(k+1)) нс,
+ * плюс число замеров, сумма и максимум. Добавление — несколько инструкций,
+ * без выделения памяти; читать можно из того же потока (колбэки сервера).
+ */
+#ifndef PERF_TIMER_H
+#define PERF_TIMER_H
+
+#include <stdint.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+#define PERF_BUCKETS 40 // до 2^40 нс ≈ 18 минут
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    uint64_t bucket[PERF_BUCKETS];
+} PerfHist;
+
+extern double perf_ns_per_tick; // задаётся perf_calibrate()
+
+// Измерение частоты счётчика (~20 мс); вызывать один раз при старте
+void perf_calibrate(void);
+
+static inline uint64_t perf_now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static inline uint64_t perf_ns(uint64_t ticks) {
+    return (uint64_t)((double)ticks * perf_ns_per_tick);
+}
+
+static inline void perf_hist_add(PerfHist *h, uint64_t ns) {
+    unsigned k = ns ? 63u - (unsigned)__builtin_clzll(ns) : 0;
+    h->bucket[k < PERF_BUCKETS ? k : PERF_BUCKETS - 1]++;
+    h->count++;
+    h->sum_ns += ns;
+    h->max_ns = ns > h->max_ns ? ns : h->max_ns;
+}
+
+// Квантиль q (0..1), нс: середина корзины в логарифмической шкале
+double perf_hist_quantile(const PerfHist *h, double q);
+
+#endif
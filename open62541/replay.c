@@ -0,0 +1,353 @@
+/*
+ * replay.c — OPC UA Сервер: проигрывание записанной телеметрии
+ * ------------------------------------------------------------
+ * Вместо синтетических синусоид публикует строки из файла записи
+ * (data/sensor_data.csv, выгрузка sensor_data2, вывод datagen или его RPL1-копия)
+ * в те же узлы, что dynamic4.c:
+ *   ns=1;s=equipment.bearing.vibration, .temperature, .pressure, .bearing.alarm
+ *   или equipment.<id>.* — если в файле есть asset_id (режим парка).
+ *
+ * Темп:
+ *   Интервалы между строками берутся из колонки ts и делятся на --speed:
+ *   1 — реальное время, 60 — минута записи за секунду, 0 — так быстро, как
+ *   успевает сервер (порциями по --burst строк между итерациями сети).
+ *   С --loop после конца файла проигрывание начинается заново.
+ *
+ * Файл отображается в память (replay_file.c): старт мгновенный, память не
+ * зависит от размера файла. Для больших CSV быстрее заранее перевести их
+ * в двоичный RPL1: replay --convert in.csv out.rpl
+ *
+ * SourceTimestamp — момент публикации; с --keep-ts — исходный ts из файла.
+ * Тревога пишется только при смене состояния, как в dynamic4.c.
+ *
+ * Сборка:
+ *   gcc -O2 replay.c replay_file.c -lopen62541 -o servers/replay
+ *
+ * Запуск:
+ *   servers/replay ../data/sensor_data.csv                 # реальное время
+ *   servers/replay ../data/sensor_data.csv --speed 100 --loop
+ *   servers/replay --convert fleet.csv fleet.rpl && servers/replay fleet.rpl --speed 0
+ *   OPC UA Endpoint: opc.tcp://localhost:4840
+ */
+#include <open62541/plugin/log_stdout.h>     // Лог в stdout
+#include <open62541/server.h>                // Основное API сервера OPC UA
+#include <open62541/server_config_default.h> // Быстрая конфигурация сервера
+#include <signal.h>                          // Обработка Ctrl+C (SIGINT)
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>                            // nanosleep()
+#include "replay_file.h"                     // Чтение записи через mmap
+
+#define MAX_ASSETS 100000
+
+// === Узлы агрегатов ===
+typedef struct {
+    size_t     n;
+    UA_NodeId *node_vib, *node_temp, *node_press, *node_alarm;
+    uint8_t   *alarm;      // последнее опубликованное состояние тревоги, 2 — ещё не было
+} Assets;
+
+static UA_Boolean running = true;
+static Assets assets;
+
+static void stopHandler(int sig) {
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND, "⏹ Завершение работы сервера");
+    running = false;
+}
+
+// Добавление одной переменной телеметрии
+static void addTelemetryVar(UA_Server *server, const UA_NodeId *nodeId, const UA_NodeId *parent,
+                            const UA_NodeId *refType, char *browseName, char *description,
+                            void *value, const UA_DataType *type) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.dataType = type->typeId;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+    UA_Variant_setScalar(&attr.value, value, type);
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", browseName);
+    attr.description = UA_LOCALIZEDTEXT("ru-RU", description);
+    UA_Server_addVariableNode(server, *nodeId, *parent, *refType,
+        UA_QUALIFIEDNAME(1, browseName),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+        attr, NULL, NULL);
+}
+
+// Узлы агрегата i: equipment.* в обычном режиме, equipment.<i>.* — в режиме парка
+static void addAssetNodes(UA_Server *server, size_t i, UA_Boolean fleetMode) {
+    UA_NodeId parent  = UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER);
+    UA_NodeId refType = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    char id[64], name[64];
+
+    if (fleetMode) {
+        snprintf(id, sizeof(id), "equipment.%zu", i);
+        snprintf(name, sizeof(name), "Asset_%zu", i);
+        UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+        oattr.displayName = UA_LOCALIZEDTEXT("en-US", name);
+        parent = UA_NODEID_STRING(1, id);
+        UA_Server_addObjectNode(server, parent,
+            UA_NODEID_STRING(1, "equipment"),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+            UA_QUALIFIEDNAME(1, name),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+            oattr, NULL, NULL);
+        refType = UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT);
+    }
+
+    const char *prefix = fleetMode ? id : "equipment";
+    char buf[96];
+    snprintf(buf, sizeof(buf), "%s.bearing.vibration", prefix);
+    assets.node_vib[i] = UA_NODEID_STRING_ALLOC(1, buf);
+    snprintf(buf, sizeof(buf), "%s.temperature", prefix);
+    assets.node_temp[i] = UA_NODEID_STRING_ALLOC(1, buf);
+    snprintf(buf, sizeof(buf), "%s.pressure", prefix);
+    assets.node_press[i] = UA_NODEID_STRING_ALLOC(1, buf);
+    snprintf(buf, sizeof(buf), "%s.bearing.alarm", prefix);
+    assets.node_alarm[i] = UA_NODEID_STRING_ALLOC(1, buf);
+
+    UA_Double zero = 0.0;
+    UA_Boolean alarmInit = false;
+    addTelemetryVar(server, &assets.node_vib[i], &parent, &refType,
+                    "Bearing_Vibration_mm_s", "Скорость вибрации подшипника, мм/с",
+                    &zero, &UA_TYPES[UA_TYPES_DOUBLE]);
+    addTelemetryVar(server, &assets.node_temp[i], &parent, &refType,
+                    "Temperature_C", "Температура оборудования, °C",
+                    &zero, &UA_TYPES[UA_TYPES_DOUBLE]);
+    addTelemetryVar(server, &assets.node_press[i], &parent, &refType,
+                    "Pressure_bar", "Давление в системе, бар",
+                    &zero, &UA_TYPES[UA_TYPES_DOUBLE]);
+    addTelemetryVar(server, &assets.node_alarm[i], &parent, &refType,
+                    "Bearing_Alarm", "Тревога по вибрации подшипника",
+                    &alarmInit, &UA_TYPES[UA_TYPES_BOOLEAN]);
+}
+
+static UA_Boolean assets_alloc(size_t n) {
+    assets.n          = n;
+    assets.node_vib   = calloc(n, sizeof(UA_NodeId));
+    assets.node_temp  = calloc(n, sizeof(UA_NodeId));
+    assets.node_press = calloc(n, sizeof(UA_NodeId));
+    assets.node_alarm = calloc(n, sizeof(UA_NodeId));
+    assets.alarm      = malloc(n);
+    if (!assets.node_vib || !assets.node_temp || !assets.node_press || !assets.node_alarm || !assets.alarm)
+        return false;
+    memset(assets.alarm, 2, n);
+    return true;
+}
+
+static void assets_free(void) {
+    for (size_t i = 0; assets.node_vib && i < assets.n; i++) {
+        UA_NodeId_clear(&assets.node_vib[i]);
+        UA_NodeId_clear(&assets.node_temp[i]);
+        UA_NodeId_clear(&assets.node_press[i]);
+        UA_NodeId_clear(&assets.node_alarm[i]);
+    }
+    free(assets.node_vib); free(assets.node_temp); free(assets.node_press);
+    free(assets.node_alarm); free(assets.alarm);
+}
+
+// Запись одного значения с меткой источника
+static void writeWithTs(UA_Server *server, const UA_NodeId node, void *value,
+                        const UA_DataType *type, UA_DateTime ts) {
+    UA_DataValue dv;
+    UA_DataValue_init(&dv);
+    UA_Variant_setScalar(&dv.value, value, type);
+    dv.hasValue = true;
+    dv.sourceTimestamp = ts;
+    dv.hasSourceTimestamp = true;
+    UA_Server_writeDataValue(server, node, dv);
+}
+
+// Публикация строки записи; false — агрегата с таким номером нет
+static UA_Boolean publishRow(UA_Server *server, ReplayRow *row, UA_Boolean keepTs) {
+    const size_t i = row->asset;
+    if (i >= assets.n)
+        return false;
+    UA_DateTime ts = keepTs ? UA_DATETIME_UNIX_EPOCH + row->ts_us * UA_DATETIME_USEC : UA_DateTime_now();
+    writeWithTs(server, assets.node_vib[i], &row->vib, &UA_TYPES[UA_TYPES_DOUBLE], ts);
+    writeWithTs(server, assets.node_temp[i], &row->temp, &UA_TYPES[UA_TYPES_DOUBLE], ts);
+    writeWithTs(server, assets.node_press[i], &row->press, &UA_TYPES[UA_TYPES_DOUBLE], ts);
+    if (row->alarm != assets.alarm[i]) { // тревогу пишем только при смене состояния
+        UA_Boolean alarm = row->alarm;
+        writeWithTs(server, assets.node_alarm[i], &alarm, &UA_TYPES[UA_TYPES_BOOLEAN], ts);
+        assets.alarm[i] = row->alarm;
+    }
+    return true;
+}
+
+// Число агрегатов по первой метке времени: все строки первого тика
+static size_t detectAssets(ReplayFile *f) {
+    ReplayRow row;
+    size_t n = 0;
+    int64_t first = 0;
+    for (uint64_t k = 0; replay_next(f, &row); k++) {
+        if (k == 0)
+            first = row.ts_us;
+        else if (row.ts_us != first)
+            break;
+        if (row.asset + (size_t)1 > n)
+            n = row.asset + (size_t)1;
+    }
+    replay_rewind(f);
+    return n;
+}
+
+static void sleepMs(double ms) {
+    if (ms <= 0)
+        return;
+    struct timespec ts = { (time_t)(ms / 1000.0), (long)((ms - (time_t)(ms / 1000.0) * 1000.0) * 1e6) };
+    nanosleep(&ts, NULL);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Использование: %s FILE [--speed X] [--loop] [--assets N] [--keep-ts] [--burst N]\n"
+            "       %s --convert IN.csv OUT.rpl\n"
+            "  FILE          CSV (ts,vibration,temperature,pressure,vibration_alarm[,asset_id]) или RPL1\n"
+            "  --speed X     ускорение относительно ts (по умолчанию 1; 0 — без пауз)\n"
+            "  --loop        по концу файла начинать заново\n"
+            "  --assets N    агрегатов (по умолчанию — по первому тику файла с asset_id)\n"
+            "  --keep-ts     SourceTimestamp = ts из файла, а не момент публикации\n"
+            "  --burst N     строк за итерацию сервера при --speed 0 (по умолчанию 10000)\n"
+            "  --convert     перевести CSV в двоичный RPL1 и выйти\n",
+            prog, prog);
+}
+
+int main(int argc, char **argv) {
+    // --- Разбор аргументов командной строки ---
+    const char *path = NULL;
+    double speed = 1.0;
+    UA_Boolean loop = false, keepTs = false;
+    long nAssets = 0;
+    long burst = 10000;
+    for (int a = 1; a < argc; a++) {
+        if (!strcmp(argv[a], "--convert") && a + 2 < argc) {
+            int64_t rows = replay_convert(argv[a + 1], argv[a + 2]);
+            if (rows < 0)
+                return 1;
+            printf("✅ %s → %s: %lld записей\n", argv[a + 1], argv[a + 2], (long long)rows);
+            return 0;
+        } else if (!strcmp(argv[a], "--speed") && a + 1 < argc) {
+            speed = strtod(argv[++a], NULL);
+        } else if (!strcmp(argv[a], "--loop")) {
+            loop = true;
+        } else if (!strcmp(argv[a], "--keep-ts")) {
+            keepTs = true;
+        } else if (!strcmp(argv[a], "--assets") && a + 1 < argc) {
+            nAssets = strtol(argv[++a], NULL, 10);
+        } else if (!strcmp(argv[a], "--burst") && a + 1 < argc) {
+            burst = strtol(argv[++a], NULL, 10);
+        } else if (argv[a][0] != '-' && !path) {
+            path = argv[a];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!path || speed < 0 || nAssets < 0 || nAssets > MAX_ASSETS || burst < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    ReplayFile *file = replay_open(path);
+    if (!file)
+        return 1;
+    const UA_Boolean fleetMode = replay_has_asset(file);
+    if (nAssets == 0)
+        nAssets = fleetMode ? (long)detectAssets(file) : 1;
+    if (nAssets < 1 || nAssets > MAX_ASSETS || !assets_alloc((size_t)nAssets)) {
+        fprintf(stderr, "Неверное число агрегатов: %ld\n", nAssets);
+        assets_free();
+        replay_close(file);
+        return 1;
+    }
+
+    signal(SIGINT, stopHandler);
+    UA_Server *server = UA_Server_new();
+    UA_ServerConfig_setDefault(UA_Server_getConfig(server));
+
+    // Папка Equipment — корень поддеревьев агрегатов в режиме парка
+    if (fleetMode) {
+        UA_ObjectAttributes fattr = UA_ObjectAttributes_default;
+        fattr.displayName = UA_LOCALIZEDTEXT("en-US", "Equipment");
+        UA_Server_addObjectNode(server, UA_NODEID_STRING(1, "equipment"),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+            UA_QUALIFIEDNAME(1, "Equipment"),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE),
+            fattr, NULL, NULL);
+    }
+    for (size_t i = 0; i < assets.n; i++)
+        addAssetNodes(server, i, fleetMode);
+    UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                "▶ %s: агрегатов %zu, скорость %s%.1f%s",
+                path, assets.n, speed > 0 ? "x" : "", speed > 0 ? speed : 0.0,
+                speed > 0 ? (loop ? ", по кругу" : "") : " (без пауз)");
+
+    // --- Цикл: строки, срок которых наступил, → узлы; затем итерация сети ---
+    // Срок строки = wall0 + (ts - ts0) / speed, по монотонным часам сервера.
+    UA_Server_run_startup(server);
+    ReplayRow row;
+    int have = replay_next(file, &row);
+    int64_t ts0 = have ? row.ts_us : 0;
+    UA_DateTime wall0 = UA_DateTime_nowMonotonic();
+    uint64_t published = 0, unknown = 0, loops = 0, prevPublished = 0;
+    UA_DateTime lastStat = wall0;
+    UA_Boolean finished = false;
+
+    while (running) {
+        UA_DateTime now = UA_DateTime_nowMonotonic();
+        UA_DateTime due = 0;
+        for (long b = 0; have && b < burst; b++) {
+            if (speed > 0) {
+                due = wall0 + (UA_DateTime)((row.ts_us - ts0) * UA_DATETIME_USEC / speed);
+                if (due > now)
+                    break;
+            }
+            if (publishRow(server, &row, keepTs))
+                published++;
+            else
+                unknown++;
+            have = replay_next(file, &row);
+            if (!have && loop) { // новый круг: отсчёт времени от текущего момента
+                replay_rewind(file);
+                have = replay_next(file, &row);
+                ts0 = have ? row.ts_us : 0;
+                wall0 = now;
+                loops++;
+            }
+        }
+        if (!have && !finished) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                        "⏹ Запись проиграна: %llu строк (битых: %llu, чужих агрегатов: %llu)",
+                        (unsigned long long)published, (unsigned long long)replay_skipped(file),
+                        (unsigned long long)unknown);
+            finished = true;
+        }
+
+        if (now - lastStat >= 10 * UA_DATETIME_SEC) {
+            UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_USERLAND,
+                        "Строк/с: %.0f  Всего: %llu  Кругов: %llu",
+                        (published - prevPublished) * (double)UA_DATETIME_SEC / (now - lastStat),
+                        (unsigned long long)published, (unsigned long long)loops);
+            prevPublished = published;
+            lastStat = now;
+        }
+
+        // Пауза до следующей строки, но не дольше, чем нужно сети и таймерам сервера
+        UA_UInt16 timeout = UA_Server_run_iterate(server, false);
+        double waitMs = timeout;
+        if (have && (speed == 0 || due <= now))
+            waitMs = 0; // строки уже просрочены — сразу следующая порция
+        else if (have) {
+            double untilRow = (double)(due - UA_DateTime_nowMonotonic()) / UA_DATETIME_MSEC;
+            waitMs = untilRow < waitMs ? untilRow : waitMs;
+        }
+        sleepMs(waitMs > 50 ? 50 : waitMs);
+    }
+
+    UA_Server_run_shutdown(server);
+    UA_Server_delete(server);
+    assets_free();
+    replay_close(file);
+    return 0;
+}
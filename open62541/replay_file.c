@@ -0,0 +1,326 @@
+/*
+ * replay_file.c — реализация replay_file.h
+ * ---------------------------------------
+ * Формат RPL1 (little-endian):
+ *   char     magic[4] = "RPL1"
+ *   uint32   flags           — бит 0: есть asset_id
+ *   uint64   rows
+ *   Record   rows[rows]      — {int64 ts_us; double vib, temp, press; uint32 asset; uint8 alarm; pad[3]}
+ */
+#include "replay_file.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define RELEASE_BYTES (64u << 20) // отдавать ядру прочитанное каждые 64 МБ
+#define MAX_COLUMNS   16
+
+typedef struct {
+    int64_t  ts_us;
+    double   vib, temp, press;
+    uint32_t asset;
+    uint8_t  alarm;
+    uint8_t  pad[3];
+} ReplayRecord;
+
+typedef struct {
+    char     magic[4];
+    uint32_t flags;
+    uint64_t rows;
+} ReplayHeader;
+
+// Колонки CSV, которые нужны проигрывателю
+enum { COL_TS = 0, COL_VIB, COL_TEMP, COL_PRESS, COL_ALARM, COL_ASSET, COL_COUNT };
+static const char *const col_names[COL_COUNT] = {
+    "ts", "vibration", "temperature", "pressure", "vibration_alarm", "asset_id"
+};
+
+struct ReplayFile {
+    const char *map;
+    size_t      mapSize;     // размер отображения
+    size_t      size;        // конец данных
+    int         binary;
+    int         hasAsset;
+    size_t      dataStart;   // смещение первой строки данных / записи
+    size_t      pos;         // текущее смещение
+    size_t      released;    // до этого смещения страницы уже отданы ядру
+    int         colOf[MAX_COLUMNS]; // номер колонки CSV → COL_*, -1 — не нужна
+    int         nColumns;
+    uint64_t    skipped;
+};
+
+// Дни от 1970-01-01 для григорианской даты (алгоритм days_from_civil)
+static int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+static int take_digits(const char **p, const char *end, int n, int *out) {
+    int v = 0;
+    for (int k = 0; k < n; k++, (*p)++) {
+        if (*p >= end || **p < '0' || **p > '9')
+            return 0;
+        v = v * 10 + (**p - '0');
+    }
+    *out = v;
+    return 1;
+}
+
+// "YYYY-MM-DD HH:MM:SS[.ffffff][Z|±HH[:MM]]" → мкс Unix-времени
+static int parse_ts(const char *p, const char *end, int64_t *us) {
+    int Y, M, D, h, m, s;
+    if (!take_digits(&p, end, 4, &Y) || p >= end || *p++ != '-' ||
+        !take_digits(&p, end, 2, &M) || p >= end || *p++ != '-' ||
+        !take_digits(&p, end, 2, &D) || p >= end || (*p != ' ' && *p != 'T'))
+        return 0;
+    p++;
+    if (!take_digits(&p, end, 2, &h) || p >= end || *p++ != ':' ||
+        !take_digits(&p, end, 2, &m) || p >= end || *p++ != ':' ||
+        !take_digits(&p, end, 2, &s) || M < 1 || M > 12 || D < 1 || D > 31)
+        return 0;
+    int64_t frac = 0;
+    if (p < end && *p == '.') {
+        int64_t scale = 100000;
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++, scale /= 10)
+            frac += scale * (*p - '0');
+    }
+    int64_t offset = 0; // смещение пояса, с
+    if (p < end && (*p == '+' || *p == '-')) {
+        int sign = *p++ == '-' ? -1 : 1, oh, om = 0;
+        if (!take_digits(&p, end, 2, &oh))
+            return 0;
+        if (p < end && *p == ':')
+            p++;
+        if (p < end && !take_digits(&p, end, 2, &om))
+            return 0;
+        offset = sign * (oh * 3600 + om * 60);
+    }
+    int64_t sec = days_from_civil(Y, (unsigned)M, (unsigned)D) * 86400 + h * 3600 + m * 60 + s - offset;
+    *us = sec * 1000000 + frac;
+    return 1;
+}
+
+// Число из поля [p, end): копия в буфер с нулём, чтобы strtod не вышел за отображение
+static int parse_double(const char *p, const char *end, double *out) {
+    char buf[64];
+    size_t len = (size_t)(end - p);
+    if (len == 0 || len >= sizeof(buf))
+        return 0;
+    memcpy(buf, p, len);
+    buf[len] = '\0';
+    char *e;
+    *out = strtod(buf, &e);
+    return e == buf + len;
+}
+
+static int parse_bool(const char *p, const char *end, uint8_t *out) {
+    size_t len = (size_t)(end - p);
+    if (len == 0)
+        return 0;
+    *out = (p[0] == 'T' || p[0] == 't' || p[0] == '1');
+    return 1;
+}
+
+// Заголовок CSV → соответствие колонок
+static int parse_header(ReplayFile *f) {
+    const char *p = f->map;
+    const char *eol = memchr(p, '\n', f->size);
+    if (!eol)
+        return 0;
+    int found[COL_COUNT] = {0};
+    f->nColumns = 0;
+    while (p <= eol && f->nColumns < MAX_COLUMNS) {
+        const char *q = p;
+        while (q < eol && *q != ',')
+            q++;
+        const char *fe = (q > p && q[-1] == '\r') ? q - 1 : q;
+        int col = -1;
+        for (int c = 0; c < COL_COUNT; c++)
+            if ((size_t)(fe - p) == strlen(col_names[c]) && !memcmp(p, col_names[c], (size_t)(fe - p)))
+                col = c;
+        if (col >= 0)
+            found[col] = 1;
+        f->colOf[f->nColumns++] = col;
+        p = q + 1;
+    }
+    f->hasAsset = found[COL_ASSET];
+    f->dataStart = (size_t)(eol + 1 - f->map);
+    return found[COL_TS] && found[COL_VIB] && found[COL_TEMP] && found[COL_PRESS] && found[COL_ALARM];
+}
+
+ReplayFile *replay_open(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        fprintf(stderr, "%s: пустой файл\n", path);
+        close(fd);
+        return NULL;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror(path);
+        return NULL;
+    }
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    ReplayFile *f = calloc(1, sizeof(ReplayFile));
+    if (!f) {
+        munmap(map, (size_t)st.st_size);
+        return NULL;
+    }
+    f->map  = map;
+    f->size = f->mapSize = (size_t)st.st_size;
+
+    const ReplayHeader *h = map;
+    if (f->size >= sizeof(ReplayHeader) && !memcmp(h->magic, "RPL1", 4)) {
+        if (f->size < sizeof(ReplayHeader) + h->rows * sizeof(ReplayRecord)) {
+            fprintf(stderr, "%s: файл RPL1 обрезан\n", path);
+            replay_close(f);
+            return NULL;
+        }
+        f->binary    = 1;
+        f->hasAsset  = h->flags & 1;
+        f->dataStart = sizeof(ReplayHeader);
+        f->size      = sizeof(ReplayHeader) + h->rows * sizeof(ReplayRecord);
+    } else if (!parse_header(f)) {
+        fprintf(stderr, "%s: нет колонок ts, vibration, temperature, pressure, vibration_alarm\n", path);
+        replay_close(f);
+        return NULL;
+    }
+    f->pos = f->released = f->dataStart;
+    return f;
+}
+
+void replay_close(ReplayFile *f) {
+    if (!f)
+        return;
+    munmap((void *)f->map, f->mapSize);
+    free(f);
+}
+
+int replay_has_asset(const ReplayFile *f) { return f->hasAsset; }
+uint64_t replay_skipped(const ReplayFile *f) { return f->skipped; }
+
+void replay_rewind(ReplayFile *f) {
+    f->pos = f->released = f->dataStart;
+    f->skipped = 0;
+}
+
+// Отдаём ядру страницы, которые уже прочитаны (файл не меняется — перечитаются при rewind)
+static void release_consumed(ReplayFile *f) {
+    if (f->pos - f->released < RELEASE_BYTES)
+        return;
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t from = f->released & ~(page - 1), to = f->pos & ~(page - 1);
+    madvise((void *)(f->map + from), to - from, MADV_DONTNEED);
+    f->released = to;
+}
+
+// Одна строка CSV [p, eol) → row; 0 — строка битая
+static int parse_line(const ReplayFile *f, const char *p, const char *eol, ReplayRow *row) {
+    unsigned got = 0;
+    row->asset = 0;
+    for (int c = 0; c < f->nColumns && p <= eol; c++) {
+        const char *q = memchr(p, ',', (size_t)(eol - p));
+        if (!q)
+            q = eol;
+        const char *fe = (q > p && q[-1] == '\r') ? q - 1 : q;
+        int ok = 1;
+        double v = 0.0;
+        switch (f->colOf[c]) {
+        case COL_TS:    ok = parse_ts(p, fe, &row->ts_us); break;
+        case COL_VIB:   ok = parse_double(p, fe, &row->vib); break;
+        case COL_TEMP:  ok = parse_double(p, fe, &row->temp); break;
+        case COL_PRESS: ok = parse_double(p, fe, &row->press); break;
+        case COL_ALARM: ok = parse_bool(p, fe, &row->alarm); break;
+        case COL_ASSET: ok = parse_double(p, fe, &v) && v >= 0; row->asset = (uint32_t)v; break;
+        default:        break;
+        }
+        if (!ok)
+            return 0;
+        if (f->colOf[c] >= 0)
+            got |= 1u << f->colOf[c];
+        p = q + 1;
+    }
+    return (got & 0x1F) == 0x1F; // ts, vibration, temperature, pressure, vibration_alarm
+}
+
+int replay_next(ReplayFile *f, ReplayRow *row) {
+    if (f->binary) {
+        if (f->pos + sizeof(ReplayRecord) > f->size)
+            return 0;
+        ReplayRecord r;
+        memcpy(&r, f->map + f->pos, sizeof(r));
+        f->pos += sizeof(r);
+        row->ts_us = r.ts_us;
+        row->vib   = r.vib;
+        row->temp  = r.temp;
+        row->press = r.press;
+        row->asset = r.asset;
+        row->alarm = r.alarm;
+        release_consumed(f);
+        return 1;
+    }
+    while (f->pos < f->size) {
+        const char *p = f->map + f->pos, *end = f->map + f->size;
+        const char *eol = memchr(p, '\n', (size_t)(end - p));
+        if (!eol)
+            eol = end;
+        f->pos = (size_t)(eol - f->map) + 1;
+        if (eol == p || (eol == p + 1 && *p == '\r')) // пустая строка
+            continue;
+        int ok = parse_line(f, p, eol, row);
+        release_consumed(f);
+        if (ok)
+            return 1;
+        f->skipped++;
+    }
+    return 0;
+}
+
+int64_t replay_convert(const char *csvPath, const char *outPath) {
+    ReplayFile *f = replay_open(csvPath);
+    if (!f)
+        return -1;
+    if (f->binary) {
+        fprintf(stderr, "%s: уже в формате RPL1\n", csvPath);
+        replay_close(f);
+        return -1;
+    }
+    FILE *out = fopen(outPath, "wb");
+    if (!out) {
+        perror(outPath);
+        replay_close(f);
+        return -1;
+    }
+    ReplayHeader h = { {'R', 'P', 'L', '1'}, (uint32_t)f->hasAsset, 0 };
+    fwrite(&h, sizeof(h), 1, out);
+
+    ReplayRow row;
+    while (replay_next(f, &row)) {
+        ReplayRecord r = { row.ts_us, row.vib, row.temp, row.press, row.asset, row.alarm, {0} };
+        fwrite(&r, sizeof(r), 1, out);
+        h.rows++;
+    }
+    fseek(out, 0, SEEK_SET); // число записей известно только в конце
+    fwrite(&h, sizeof(h), 1, out);
+    int ok = !ferror(out);
+    ok = (fclose(out) == 0) && ok;
+    if (f->skipped)
+        fprintf(stderr, "%s: пропущено битых строк: %llu\n", csvPath, (unsigned long long)f->skipped);
+    replay_close(f);
+    return ok ? (int64_t)h.rows : -1;
+}
@@ -0,0 +1,53 @@
+/*
+ * replay_file.h — потоковое чтение записанной телеметрии для replay.c
+ * ------------------------------------------------------------------
+ * Файл отображается в память (mmap) и читается строка за строкой без загрузки
+ * целиком: открытие мгновенное при любом размере, а прочитанные страницы
+ * периодически отдаются ядру (MADV_DONTNEED), поэтому RSS не растёт.
+ *
+ * Форматы:
+ *   CSV  — как data/sensor_data.csv: ts,vibration,temperature,pressure,vibration_alarm
+ *          (+ необязательная asset_id, порядок колонок любой, по заголовку).
+ *          ts — "YYYY-MM-DD HH:MM:SS[.ffffff][+HH:MM]", как пишут pandas и PostgreSQL.
+ *   RPL1 — компактные записи по 40 байт, см. replay_convert(); без разбора текста.
+ *
+ * sensor_data.parquet сначала переводится в CSV (pandas: read_parquet → to_csv),
+ * затем, при желании, в RPL1.
+ */
+#ifndef REPLAY_FILE_H
+#define REPLAY_FILE_H
+
+#include <stdint.h>
+
+// Одна строка записи
+typedef struct {
+    int64_t  ts_us;   // Unix-время, мкс
+    double   vib;     // мм/с
+    double   temp;    // °C
+    double   press;   // бар
+    uint32_t asset;   // номер агрегата (0, если колонки asset_id нет)
+    uint8_t  alarm;
+} ReplayRow;
+
+typedef struct ReplayFile ReplayFile;
+
+// Открытие CSV или RPL1 (по сигнатуре); NULL при ошибке (сообщение в stderr)
+ReplayFile *replay_open(const char *path);
+void replay_close(ReplayFile *f);
+
+// Есть ли в файле номер агрегата
+int replay_has_asset(const ReplayFile *f);
+
+// Следующая строка: 1 — прочитана, 0 — конец файла. Битые строки CSV пропускаются.
+int replay_next(ReplayFile *f, ReplayRow *row);
+
+// Возврат к первой строке данных (для --loop)
+void replay_rewind(ReplayFile *f);
+
+// Пропущено битых строк с начала (или с последнего rewind)
+uint64_t replay_skipped(const ReplayFile *f);
+
+// Перевод CSV → RPL1; возвращает число записей или -1 при ошибке
+int64_t replay_convert(const char *csvPath, const char *outPath);
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ * shm_pub.c — реализация shm_pub.h
+ * -------------------------------
+ */
+#include "shm_pub.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+struct ShmPublisher {
+    char       name[256];
+    ShmHeader *h;
+    size_t     bytes;
+    uint64_t   next;      // номер следующего тика кольца (копия head без атомарного чтения)
+};
+
+ShmPublisher *shm_pub_new(const char *name, size_t nAssets, size_t slots, int64_t created,
+                          char *err, size_t errLen) {
+    if (nAssets == 0 || slots < 2) {
+        snprintf(err, errLen, "нужны агрегаты и хотя бы 2 слота (%zu, %zu)", nAssets, slots);
+        return NULL;
+    }
+    ShmPublisher *p = calloc(1, sizeof(*p));
+    if (!p) {
+        snprintf(err, errLen, "нет памяти");
+        return NULL;
+    }
+    snprintf(p->name, sizeof(p->name), "%s%s", name[0] == '/' ? "" : "/", name);
+    const size_t slotSize = (sizeof(ShmSlot) + nAssets * sizeof(ShmSample) + 63) & ~(size_t)63;
+    p->bytes = SHM_HEADER_BYTES + slots * slotSize;
+
+    // Новый файл вместо прежнего: читатели старого дочитают его и увидят closed
+    shm_unlink(p->name);
+    int fd = shm_open(p->name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        snprintf(err, errLen, "shm_open %s: %s", p->name, strerror(errno));
+        free(p);
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)p->bytes) < 0) {
+        snprintf(err, errLen, "ftruncate %s (%zu байт): %s", p->name, p->bytes, strerror(errno));
+        close(fd);
+        shm_unlink(p->name);
+        free(p);
+        return NULL;
+    }
+    void *m = mmap(NULL, p->bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) {
+        snprintf(err, errLen, "mmap %s: %s", p->name, strerror(errno));
+        shm_unlink(p->name);
+        free(p);
+        return NULL;
+    }
+    memset(m, 0, p->bytes); // все страницы — сейчас, а не отказами в тиках
+
+    ShmHeader *h = p->h = m;
+    h->version = SHM_VERSION;
+    h->headerSize = SHM_HEADER_BYTES;
+    h->nAssets = nAssets;
+    h->slots = slots;
+    h->slotSize = slotSize;
+    h->created = created;
+    h->pid = (int32_t)getpid();
+    atomic_store_explicit(&h->head, 0, memory_order_relaxed);
+    // Магия — последней: читатель, открывший файл раньше, не примет его недозаполненным
+    atomic_thread_fence(memory_order_release);
+    h->magic = SHM_MAGIC;
+    return p;
+}
+
+void shm_pub_free(ShmPublisher *p) {
+    if (!p)
+        return;
+    atomic_store_explicit(&p->h->closed, 1, memory_order_release);
+    munmap(p->h, p->bytes);
+    shm_unlink(p->name);
+    free(p);
+}
+
+void shm_pub_write(ShmPublisher *p, uint64_t tick, int64_t time, uint64_t genNs,
+                   const double *vib, const double *temp, const double *press,
+                   const uint8_t *alarm, const float *alarmProb) {
+    ShmHeader *h = p->h;
+    const uint64_t pos = p->next;
+    ShmSlot *s = (ShmSlot *)shm_slot(h, pos);
+
+    // seqlock: нечётный seq, данные, чётный seq, затем head
+    atomic_store_explicit(&s->seq, 2 * pos + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    s->tick = tick;
+    s->time = time;
+    s->gen_ns = genNs;
+    const size_t n = h->nAssets;
+    ShmSample *x = s->sample;
+    for (size_t i = 0; i < n; i++) {
+        x[i].vib = vib[i];
+        x[i].temp = temp[i];
+        x[i].press = press[i];
+        x[i].alarm_prob = alarmProb ? alarmProb[i] : NAN;
+        x[i].alarm = alarm[i];
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    s->pub_ns = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+    atomic_store_explicit(&s->seq, 2 * pos + 2, memory_order_release);
+    atomic_store_explicit(&h->head, pos + 1, memory_order_release);
+    p->next = pos + 1;
+}
+
+uint64_t shm_pub_ticks(const ShmPublisher *p) {
+    return atomic_load_explicit(&p->h->head, memory_order_relaxed); // читается и из потока сервера
+}
+
+size_t shm_pub_bytes(const ShmPublisher *p) {
+    return p->bytes;
+}
@@ -0,0 +1,92 @@
+/*
+ * shm_pub.h — публикация тиков парка в разделяемую память (/dev/shm) для потребителей на том же хосте
+ * ------------------------------------------------------------------------------------------------
+ * Сборщик, прогноз и признаки обычно работают на одной машине с сервером, но каждый
+ * отсчёт идёт через TCP, кодирование OPC UA Binary и сессию — это миллисекунды.
+ * Здесь сервер раз в тик пишет все агрегаты в кольцо слотов в файле /dev/shm/<имя>,
+ * а потребители (opcua_client/shm_sub.c) отображают его в свою память и читают
+ * слоты на месте — без копирования, сокетов и системных вызовов.
+ *
+ * Раскладка файла (фиксированная, little-endian, как у процессора):
+ *   ShmHeader — страница 4 КБ: магия, версия, размеры, head — номер следующего тика
+ *               кольца (тиков записано всего);
+ *   slots слотов по slotSize байт: ShmSlot (64 байта) и nAssets записей ShmSample
+ *               (32 байта, вибрация, температура, давление, вероятность, тревога).
+ *   Тик с номером p в кольце лежит в слоте p % slots.
+ *
+ * Один писатель, сколько угодно читателей — seqlock на слот: перед записью
+ * seq = 2p + 1, после — 2p + 2 и только затем head = p + 1. Читатель тика p берёт
+ * seq до и после чтения: совпадение с 2p + 2 значит, что слот не перезаписан,
+ * пока его читали (писатель обогнал читателя на круг — тик потерян, а не испорчен).
+ *
+ * Размер — slots × (64 + nAssets × 32) байт; страницы трогаются в shm_pub_new(),
+ * в тике нет отказов страниц. Файл удаляется в shm_pub_free(); отображение у
+ * читателей остаётся, а флаг closed говорит им переподключиться.
+ */
+#ifndef SHM_PUB_H
+#define SHM_PUB_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHM_DEFAULT_NAME "/dynamic4"
+#define SHM_MAGIC        0x314D485334444E59ull // "YND4SHM1"
+#define SHM_VERSION      1
+#define SHM_HEADER_BYTES 4096
+
+// Запись агрегата в слоте тика
+typedef struct {
+    double  vib;         // мм/с
+    double  temp;        // °C
+    double  press;       // бар
+    float   alarm_prob;  // вероятность тревоги по модели, NaN — сервер без --model
+    uint8_t alarm;
+    uint8_t reserved[3];
+} ShmSample;
+
+// Слот тика: заголовок и nAssets записей сразу за ним
+typedef struct {
+    _Atomic uint64_t seq; // 2p + 2 — тик p записан, нечётный — пишется
+    uint64_t tick;        // номер тика сервера (как в diagnostics.trace)
+    int64_t  time;        // UA_DateTime тика — метка источника узлов
+    uint64_t gen_ns;      // CLOCK_MONOTONIC начала генерации тика
+    uint64_t pub_ns;      // CLOCK_MONOTONIC конца записи слота
+    uint64_t reserved[3];
+    ShmSample sample[];
+} ShmSlot;
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t headerSize;       // SHM_HEADER_BYTES — начало первого слота
+    uint64_t nAssets;
+    uint64_t slots;
+    uint64_t slotSize;         // байт на слот, кратно 64
+    int64_t  created;          // UA_DateTime создания
+    int32_t  pid;              // процесс-писатель
+    _Atomic uint32_t closed;   // 1 — писатель завершился, файл удалён
+    _Alignas(64) _Atomic uint64_t head; // тиков записано (номер следующего)
+} ShmHeader;
+
+static inline const ShmSlot *shm_slot(const ShmHeader *h, uint64_t p) {
+    return (const ShmSlot *)((const uint8_t *)h + h->headerSize + (p % h->slots) * h->slotSize);
+}
+
+typedef struct ShmPublisher ShmPublisher;
+
+// Файл /dev/shm/<name> (name — "/имя", прежний файл заменяется) на nAssets агрегатов
+// и slots слотов. NULL при ошибке, текст — в err
+ShmPublisher *shm_pub_new(const char *name, size_t nAssets, size_t slots, int64_t created,
+                          char *err, size_t errLen);
+void shm_pub_free(ShmPublisher *p);
+
+// Один тик: все агрегаты в следующий слот. alarmProb — NULL без модели
+void shm_pub_write(ShmPublisher *p, uint64_t tick, int64_t time, uint64_t genNs,
+                   const double *vib, const double *temp, const double *press,
+                   const uint8_t *alarm, const float *alarmProb);
+
+uint64_t shm_pub_ticks(const ShmPublisher *p); // тиков записано
+size_t   shm_pub_bytes(const ShmPublisher *p); // размер файла
+
+#endif
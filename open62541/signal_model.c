@@ -0,0 +1,47 @@
+/*
+ * signal_model.c — реализация signal_model.h
+ * -----------------------------------------
+ * Цикл по агрегатам без ветвлений и зависимостей между итерациями:
+ * при -O3 -march=native -ffast-math gcc векторизует его вместе с sin().
+ */
+#include "signal_model.h"
+#include "sim_rng.h"
+#include <math.h>
+
+void signal_model_init(size_t n, uint64_t seed, double *phase, uint64_t *key) {
+    for (size_t i = 0; i < n; i++) {
+        phase[i] = 2.0 * M_PI * fmod((double)i * 0.6180339887498949, 1.0); // агрегат 0 — без сдвига
+        key[i]   = mix64(seed + (uint64_t)i * 0xD1B54A32D192ED03ULL);
+    }
+}
+
+// Условия записаны тернарными выражениями, которые компилятор превращает в blend/select.
+// Массивы передаются параметрами с restrict — так gcc знает, что они не пересекаются.
+void signal_model_step(size_t n, uint64_t k,
+                       const double *restrict phase, const uint64_t *restrict key,
+                       double *restrict vib, double *restrict temp, double *restrict press,
+                       uint8_t *restrict alarm, uint8_t *restrict diff) {
+    const double t = signal_model_time(k);
+    const uint64_t ctr = k * SIGNAL_MODEL_DRAWS;
+    for (size_t i = 0; i < n; i++) {
+        // --- 1. Вибрация ---
+        double v = 2.0 + 0.5 * sin(t * 3.1 + phase[i]) + 0.2 * (urand(key[i], ctr) - 0.5); // базовая модель
+        v += (urand(key[i], ctr + 1) < 0.05) ? 5.0 : 0.0;                                  // редкий скачок
+        v = v < 0.0 ? 0.0 : v;
+        v = v > 15.0 ? 15.0 : v;
+        vib[i] = v;
+
+        // Порог тревоги по вибрации (>= 7 мм/с)
+        uint8_t a = (v >= 7.0);
+        diff[i]  = (a != alarm[i]);
+        alarm[i] = a;
+
+        // --- 2. Температура ---
+        double tc = 60.0 + 10.0 * sin(t * 0.1 + phase[i]) + 0.5 * (urand(key[i], ctr + 2) - 0.5);
+        tc += (urand(key[i], ctr + 3) < 0.001) ? 20.0 : 0.0; // редкий перегрев
+        temp[i] = tc;
+
+        // --- 3. Давление ---
+        press[i] = 1.0 + 0.1 * sin(t * 0.7 + phase[i]) + 0.02 * (urand(key[i], ctr + 4) - 0.5);
+    }
+}
@@ -0,0 +1,37 @@
+/*
+ * signal_model.h — модель сигналов агрегата (вибрация, температура, давление, тревога)
+ * ----------------------------------------------------------------------------------
+ * Общая для сервера dynamic4.c и офлайн-генератора datagen.c: синусоиды + шум
+ * + редкие скачки вибрации (5 %) и перегревы (0,1 %), тревога при вибрации >= 7 мм/с.
+ *
+ * Случайные числа — счётчиковый ГПСЧ sim_rng.h: значение тика k агрегата i
+ * зависит только от seed, i и k, поэтому тики можно считать в любом порядке
+ * и в любом числе потоков, а результат совпадает с живым сервером при том же seed.
+ * Бит в бит — при одинаковых флагах сборки signal_model.c и одном размере парка
+ * (векторный sin из libmvec и хвост цикла дают разные младшие биты).
+ */
+#ifndef SIGNAL_MODEL_H
+#define SIGNAL_MODEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SIGNAL_MODEL_DT    0.1 // шаг модельного времени за тик (как t += 0.1 в gen.c)
+#define SIGNAL_MODEL_DRAWS 5   // случайных чисел на агрегат за тик
+
+// Фазы синусоид и ключи ГПСЧ для агрегатов 0..n-1 парка с данным seed
+void signal_model_init(size_t n, uint64_t seed, double *phase, uint64_t *key);
+
+// Модельное время тика k (первый тик — 0.1)
+static inline double signal_model_time(uint64_t k) {
+    return SIGNAL_MODEL_DT * (double)(k + 1);
+}
+
+// Тик k для всего парка. alarm хранит состояние прошлого тика; diff = 1 там,
+// где тревога изменилась. Массивы не должны пересекаться.
+void signal_model_step(size_t n, uint64_t k,
+                       const double *restrict phase, const uint64_t *restrict key,
+                       double *restrict vib, double *restrict temp, double *restrict press,
+                       uint8_t *restrict alarm, uint8_t *restrict diff);
+
+#endif
@@ -0,0 +1,31 @@
+/*
+ * sim_rng.h — счётчиковый генератор случайных чисел для моделей сигналов
+ * ---------------------------------------------------------------------
+ * Генератор без состояния: число зависит только от ключа и номера отсчёта,
+ * поэтому циклы по агрегатам и отсчётам не имеют зависимостей между
+ * итерациями и векторизуются, а любой кусок последовательности можно
+ * получить независимо (воспроизводимо для одного и того же seed).
+ */
+#ifndef SIM_RNG_H
+#define SIM_RNG_H
+
+#include <stdint.h>
+
+// Перемешивание splitmix64: биекция 64 → 64 бит с хорошей лавинностью
+static inline uint64_t mix64(uint64_t z) {
+    z += 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Случайное число [0..1) по ключу и номеру отсчёта.
+// Старшие 52 бита кладутся в мантиссу числа из [1, 2) — это обходится
+// без преобразования int64 → double, которого нет в AVX2.
+static inline double urand(uint64_t key, uint64_t ctr) {
+    union { uint64_t u; double d; } x;
+    x.u = (mix64(key + ctr) >> 12) | 0x3FF0000000000000ULL;
+    return x.d - 1.0;
+}
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ * sim_thread.c — реализация sim_thread.h
+ * -------------------------------------
+ * Тройной буфер: у производителя кадр back, у потребителя front, третий —
+ * в атомарном middle вместе с флагом SIM_FRESH («кадр ещё не забран»).
+ * Обмен — один atomic_exchange с каждой стороны.
+ *
+ * Ожидание следующего тика — pthread_cond_timedwait по CLOCK_MONOTONIC:
+ * мьютекс нужен только чтобы sim_thread_stop() разбудил поток сразу,
+ * на передачу кадров он не влияет.
+ */
+#include "sim_thread.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define SIM_FRESH 4u // флаг в middle: кадр записан и не забран
+
+struct SimThread {
+    void     *frames[3];
+    unsigned  back, front;         // кадр производителя и кадр потребителя
+    _Atomic unsigned middle;       // индекс третьего кадра | SIM_FRESH
+    uint64_t  periodNs;
+    SimStepFn step;
+    void     *ctx;
+    _Atomic uint64_t skipped, overruns;
+    int       stop;                // под lock
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;
+    pthread_t thread;
+};
+
+static uint64_t ts_ns(const struct timespec *ts) {
+    return (uint64_t)ts->tv_sec * 1000000000u + (uint64_t)ts->tv_nsec;
+}
+
+static struct timespec ns_ts(uint64_t ns) {
+    struct timespec ts = { (time_t)(ns / 1000000000u), (long)(ns % 1000000000u) };
+    return ts;
+}
+
+static void *sim_main(void *arg) {
+    SimThread *t = arg;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t next = ts_ns(&now);
+    uint64_t tick = 0;
+
+    pthread_mutex_lock(&t->lock);
+    for (;;) {
+        // 1. Ожидание момента next по расписанию (или остановки)
+        next += t->periodNs;
+        const struct timespec deadline = ns_ts(next);
+        while (!t->stop && pthread_cond_timedwait(&t->wake, &t->lock, &deadline) != ETIMEDOUT)
+            ;
+        if (t->stop)
+            break;
+        pthread_mutex_unlock(&t->lock);
+
+        // 2. Опоздание; если прошёл целый период и больше — пропускаем тики, не сдвигая сетку
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        uint64_t late = ts_ns(&now) > next ? ts_ns(&now) - next : 0;
+        if (late >= t->periodNs) {
+            uint64_t missed = late / t->periodNs;
+            atomic_fetch_add_explicit(&t->overruns, missed, memory_order_relaxed);
+            next += missed * t->periodNs;
+            late -= missed * t->periodNs;
+        }
+
+        // 3. Шаг и передача кадра
+        t->step(t->ctx, t->frames[t->back], tick++, late);
+        unsigned prev = atomic_exchange_explicit(&t->middle, t->back | SIM_FRESH, memory_order_acq_rel);
+        if (prev & SIM_FRESH)
+            atomic_fetch_add_explicit(&t->skipped, 1, memory_order_relaxed);
+        t->back = prev & ~SIM_FRESH;
+
+        pthread_mutex_lock(&t->lock);
+    }
+    pthread_mutex_unlock(&t->lock);
+    return NULL;
+}
+
+SimThread *sim_thread_start(double periodMs, void *frames[3], SimStepFn step, void *ctx) {
+    SimThread *t = calloc(1, sizeof(*t));
+    if (!t || periodMs <= 0) {
+        free(t);
+        return NULL;
+    }
+    for (int i = 0; i < 3; i++)
+        t->frames[i] = frames[i];
+    t->back = 0;
+    atomic_init(&t->middle, 1u);
+    t->front = 2;
+    t->periodNs = (uint64_t)(periodMs * 1e6);
+    t->step = step;
+    t->ctx = ctx;
+
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&t->wake, &ca);
+    pthread_condattr_destroy(&ca);
+    pthread_mutex_init(&t->lock, NULL);
+    if (pthread_create(&t->thread, NULL, sim_main, t) != 0) {
+        pthread_cond_destroy(&t->wake);
+        pthread_mutex_destroy(&t->lock);
+        free(t);
+        return NULL;
+    }
+    return t;
+}
+
+void *sim_thread_acquire(SimThread *t) {
+    if (!(atomic_load_explicit(&t->middle, memory_order_relaxed) & SIM_FRESH))
+        return NULL;
+    unsigned prev = atomic_exchange_explicit(&t->middle, t->front, memory_order_acq_rel);
+    t->front = prev & ~SIM_FRESH;
+    return t->frames[t->front];
+}
+
+void sim_thread_stop(SimThread *t) {
+    if (!t)
+        return;
+    pthread_mutex_lock(&t->lock);
+    t->stop = 1;
+    pthread_cond_signal(&t->wake);
+    pthread_mutex_unlock(&t->lock);
+    pthread_join(t->thread, NULL);
+    pthread_cond_destroy(&t->wake);
+    pthread_mutex_destroy(&t->lock);
+    free(t);
+}
+
+uint64_t sim_thread_skipped(SimThread *t)  { return atomic_load(&t->skipped); }
+uint64_t sim_thread_overruns(SimThread *t) { return atomic_load(&t->overruns); }
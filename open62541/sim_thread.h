@@ -0,0 +1,48 @@
+/*
+ * sim_thread.h — поток симуляции с передачей кадров серверу без блокировок
+ * -----------------------------------------------------------------------
+ * В обычном режиме тик считается в колбэке UA_Server_addRepeatedCallback —
+ * внутри цикла UA_Server_run: тяжёлый тик задерживает сессии и публикацию,
+ * а всплеск запросов клиентов задерживает тик. Здесь тик идёт в отдельном
+ * потоке по абсолютному расписанию CLOCK_MONOTONIC (ошибка периода не
+ * накапливается), а готовые кадры передаются потоку сервера через тройной
+ * буфер — очередь одного производителя и одного потребителя на последний кадр:
+ *
+ *   — производитель заполняет «свой» кадр и атомарно меняет его местами
+ *     со средним; если сервер не успел забрать предыдущий — тот пропускается
+ *     (sim_thread_skipped), расписание тика при этом не сдвигается;
+ *   — потребитель (колбэк сервера) забирает средний кадр обменом, если он новый,
+ *     и читает его, пока не заберёт следующий. Ни мьютексов, ни копий под замком.
+ *
+ * Кадры выделяет вызывающий (три одинаковых), модуль знает о них только указатели.
+ * Функция шага не должна вызывать API сервера — его вызывает только поток сервера,
+ * поэтому сборка open62541 с UA_MULTITHREADING не требуется.
+ *
+ * Сборка вместе с сервером:
+ *   gcc server.c sim_thread.c -lopen62541 -pthread
+ */
+#ifndef SIM_THREAD_H
+#define SIM_THREAD_H
+
+#include <stdint.h>
+
+typedef struct SimThread SimThread;
+
+// Шаг симуляции: заполнить frame для тика tick; lateNs — опоздание пробуждения
+// относительно расписания, нс
+typedef void (*SimStepFn)(void *ctx, void *frame, uint64_t tick, uint64_t lateNs);
+
+// Запуск потока с периодом periodMs; frames — три кадра. NULL при ошибке
+SimThread *sim_thread_start(double periodMs, void *frames[3], SimStepFn step, void *ctx);
+
+// Новый кадр, которого потребитель ещё не видел, или NULL. Кадр принадлежит
+// потребителю до следующего вызова, вернувшего не NULL.
+void *sim_thread_acquire(SimThread *t);
+
+// Остановка потока и освобождение (кадры освобождает вызывающий)
+void sim_thread_stop(SimThread *t);
+
+uint64_t sim_thread_skipped(SimThread *t);  // кадров перезаписано до того, как их забрали
+uint64_t sim_thread_overruns(SimThread *t); // тиков пропущено: шаг не уложился в период
+
+#endif
@@ -0,0 +1,492 @@
+/*
+ * spectrum.c — реализация spectrum.h
+ * ---------------------------------
+ * Проход Стокхэма по основанию 4 (длина nn, шаг s, m = nn / 4): из x[q + s(p + km)],
+ * k = 0..3, — y[q + s(4p + k)] = w^(kp) · Σ_j x_j (-i)^(jk), w = e^(-2πi / nn); затем
+ * nn = m, s *= 4. Последний проход при нечётном log2 — по основанию 2 с w = 1.
+ * Результат оказывается в одном из двух буферов — fft_run() возвращает, в каком.
+ */
+#include "spectrum.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_HARMONICS 8
+#define MAX_THREADS   256
+#define MIN_ENVELOPE  16 // наименьшая длина огибающей
+
+const char *const spectrum_fault_names[SPECTRUM_FAULTS] = { "ftf", "bpfo", "bpfi", "bsf" };
+
+void spectrum_default(SpectrumConfig *c, double sampleRate, double shaftHz) {
+    c->sampleRate = sampleRate;
+    c->frameSize  = 4096;
+    c->overlap    = 0.5;
+    c->window     = SPECTRUM_HANN;
+    c->bandLo     = 2000.0;
+    c->bandHi     = 4000.0;
+    c->shaftHz    = shaftHz;
+    c->balls      = 9;
+    c->ballDiam   = 7.94;
+    c->pitchDiam  = 39.04;
+    c->contactDeg = 0.0;
+    c->harmonics  = 3;
+    c->tolerance  = 0.02;
+}
+
+void spectrum_fault_hz(const SpectrumConfig *c, double hz[SPECTRUM_FAULTS]) {
+    const double r = c->ballDiam / c->pitchDiam * cos(c->contactDeg * M_PI / 180.0);
+    hz[0] = c->shaftHz / 2.0 * (1.0 - r);                                 // FTF — сепаратор
+    hz[1] = c->balls * c->shaftHz / 2.0 * (1.0 - r);                      // BPFO — наружное кольцо
+    hz[2] = c->balls * c->shaftHz / 2.0 * (1.0 + r);                      // BPFI — внутреннее кольцо
+    hz[3] = c->pitchDiam / (2.0 * c->ballDiam) * c->shaftHz * (1.0 - r * r); // BSF — тело качения
+}
+
+// === Комплексное БПФ: действительные и мнимые части — в отдельных массивах ===
+typedef struct {
+    size_t n;
+    float *tw; // множители проходов подряд: w1re, w1im, w2re, w2im, w3re, w3im по m элементов
+} Fft;
+
+static int fft_init(Fft *f, size_t n) {
+    size_t total = 0;
+    for (size_t nn = n; nn >= 4; nn /= 4)
+        total += 6 * (nn / 4);
+    f->n = n;
+    f->tw = malloc((total ? total : 1) * sizeof(float));
+    if (!f->tw)
+        return 0;
+    float *tw = f->tw;
+    for (size_t nn = n; nn >= 4; nn /= 4) {
+        const size_t m = nn / 4;
+        for (size_t p = 0; p < m; p++)
+            for (int k = 1; k <= 3; k++) {
+                const double a = -2.0 * M_PI * (double)(k * p) / (double)nn;
+                tw[(2 * k - 2) * m + p] = (float)cos(a);
+                tw[(2 * k - 1) * m + p] = (float)sin(a);
+            }
+        tw += 6 * m;
+    }
+    return 1;
+}
+
+// Прямое БПФ x → (x или y); 0 — результат в x, 1 — в y. Оба буфера портятся
+static int fft_run(const Fft *f, float *xr, float *xi, float *yr, float *yi) {
+    float *ar = xr, *ai = xi, *br = yr, *bi = yi, *t;
+    const float *tw = f->tw;
+    size_t nn = f->n, s = 1;
+    for (; nn >= 4; nn /= 4, s *= 4) {
+        const size_t m = nn / 4;
+        const float *restrict w1r = tw, *restrict w1i = tw + m, *restrict w2r = tw + 2 * m,
+                    *restrict w2i = tw + 3 * m, *restrict w3r = tw + 4 * m, *restrict w3i = tw + 5 * m;
+        if (s == 1) { // первый проход: соседние p, запись с шагом 4
+            const float *restrict a0r = ar, *restrict a1r = ar + m, *restrict a2r = ar + 2 * m, *restrict a3r = ar + 3 * m;
+            const float *restrict a0i = ai, *restrict a1i = ai + m, *restrict a2i = ai + 2 * m, *restrict a3i = ai + 3 * m;
+            float *restrict yr_ = br, *restrict yi_ = bi;
+            for (size_t p = 0; p < m; p++) {
+                const float apcr = a0r[p] + a2r[p], apci = a0i[p] + a2i[p];
+                const float amcr = a0r[p] - a2r[p], amci = a0i[p] - a2i[p];
+                const float bpdr = a1r[p] + a3r[p], bpdi = a1i[p] + a3i[p];
+                const float bmdr = a1r[p] - a3r[p], bmdi = a1i[p] - a3i[p];
+                const float t1r = amcr + bmdi, t1i = amci - bmdr; // (a - c) - i(b - d)
+                const float t2r = apcr - bpdr, t2i = apci - bpdi;
+                const float t3r = amcr - bmdi, t3i = amci + bmdr; // (a - c) + i(b - d)
+                yr_[4 * p]     = apcr + bpdr;                  yi_[4 * p]     = apci + bpdi;
+                yr_[4 * p + 1] = t1r * w1r[p] - t1i * w1i[p];  yi_[4 * p + 1] = t1r * w1i[p] + t1i * w1r[p];
+                yr_[4 * p + 2] = t2r * w2r[p] - t2i * w2i[p];  yi_[4 * p + 2] = t2r * w2i[p] + t2i * w2r[p];
+                yr_[4 * p + 3] = t3r * w3r[p] - t3i * w3i[p];  yi_[4 * p + 3] = t3r * w3i[p] + t3i * w3r[p];
+            }
+        } else { // дальше: соседние q с общим множителем
+            for (size_t p = 0; p < m; p++) {
+                const float c1 = w1r[p], s1 = w1i[p], c2 = w2r[p], s2 = w2i[p], c3 = w3r[p], s3 = w3i[p];
+                const float *restrict a0r = ar + s * p, *restrict a1r = ar + s * (p + m);
+                const float *restrict a2r = ar + s * (p + 2 * m), *restrict a3r = ar + s * (p + 3 * m);
+                const float *restrict a0i = ai + s * p, *restrict a1i = ai + s * (p + m);
+                const float *restrict a2i = ai + s * (p + 2 * m), *restrict a3i = ai + s * (p + 3 * m);
+                float *restrict y0r = br + s * 4 * p, *restrict y1r = y0r + s, *restrict y2r = y0r + 2 * s, *restrict y3r = y0r + 3 * s;
+                float *restrict y0i = bi + s * 4 * p, *restrict y1i = y0i + s, *restrict y2i = y0i + 2 * s, *restrict y3i = y0i + 3 * s;
+                for (size_t q = 0; q < s; q++) {
+                    const float apcr = a0r[q] + a2r[q], apci = a0i[q] + a2i[q];
+                    const float amcr = a0r[q] - a2r[q], amci = a0i[q] - a2i[q];
+                    const float bpdr = a1r[q] + a3r[q], bpdi = a1i[q] + a3i[q];
+                    const float bmdr = a1r[q] - a3r[q], bmdi = a1i[q] - a3i[q];
+                    const float t1r = amcr + bmdi, t1i = amci - bmdr;
+                    const float t2r = apcr - bpdr, t2i = apci - bpdi;
+                    const float t3r = amcr - bmdi, t3i = amci + bmdr;
+                    y0r[q] = apcr + bpdr;          y0i[q] = apci + bpdi;
+                    y1r[q] = t1r * c1 - t1i * s1;  y1i[q] = t1r * s1 + t1i * c1;
+                    y2r[q] = t2r * c2 - t2i * s2;  y2i[q] = t2r * s2 + t2i * c2;
+                    y3r[q] = t3r * c3 - t3i * s3;  y3i[q] = t3r * s3 + t3i * c3;
+                }
+            }
+        }
+        tw += 6 * m;
+        t = ar; ar = br; br = t;
+        t = ai; ai = bi; bi = t;
+    }
+    if (nn == 2) {
+        const float *restrict a0r = ar, *restrict a1r = ar + s, *restrict a0i = ai, *restrict a1i = ai + s;
+        float *restrict y0r = br, *restrict y1r = br + s, *restrict y0i = bi, *restrict y1i = bi + s;
+        for (size_t q = 0; q < s; q++) {
+            y0r[q] = a0r[q] + a1r[q];  y0i[q] = a0i[q] + a1i[q];
+            y1r[q] = a0r[q] - a1r[q];  y1i[q] = a0i[q] - a1i[q];
+        }
+        ar = br;
+    }
+    return ar != xr;
+}
+
+// === Вещественное БПФ длины n: комплексное n / 2 над парами отсчётов и разделение спектров ===
+typedef struct {
+    Fft    c;
+    float *wr, *wi; // e^(-2πik / n), k < n / 2
+} Rfft;
+
+static int rfft_init(Rfft *r, size_t n) {
+    const size_t m = n / 2;
+    r->wr = malloc(m * sizeof(float));
+    r->wi = malloc(m * sizeof(float));
+    if (!r->wr || !r->wi || !fft_init(&r->c, m))
+        return 0;
+    for (size_t k = 0; k < m; k++) {
+        r->wr[k] = (float)cos(-2.0 * M_PI * (double)k / (double)n);
+        r->wi[k] = (float)sin(-2.0 * M_PI * (double)k / (double)n);
+    }
+    return 1;
+}
+
+static void rfft_free(Rfft *r) {
+    free(r->c.tw);
+    free(r->wr);
+    free(r->wi);
+}
+
+// x (n отсчётов) → X[0..n/2]; s0r..s1i — рабочие массивы по n / 2
+static void rfft_run(const Rfft *r, const float *restrict x, float *restrict Xr, float *restrict Xi,
+                     float *s0r, float *s0i, float *s1r, float *s1i) {
+    const size_t m = r->c.n;
+    for (size_t k = 0; k < m; k++) {
+        s0r[k] = x[2 * k];
+        s0i[k] = x[2 * k + 1];
+    }
+    const int in_y = fft_run(&r->c, s0r, s0i, s1r, s1i);
+    const float *restrict zr = in_y ? s1r : s0r, *restrict zi = in_y ? s1i : s0i;
+    Xr[0] = zr[0] + zi[0];
+    Xi[0] = 0.0f;
+    Xr[m] = zr[0] - zi[0];
+    Xi[m] = 0.0f;
+    for (size_t k = 1; k < m; k++) {
+        const float er = 0.5f * (zr[k] + zr[m - k]), ei = 0.5f * (zi[k] - zi[m - k]); // чётные отсчёты
+        const float or_ = 0.5f * (zi[k] + zi[m - k]), oi = -0.5f * (zr[k] - zr[m - k]); // нечётные
+        Xr[k] = er + or_ * r->wr[k] - oi * r->wi[k];
+        Xi[k] = ei + or_ * r->wi[k] + oi * r->wr[k];
+    }
+}
+
+// === Банк каналов ===
+typedef struct {
+    struct SpectrumBank *bank;
+    size_t  index;
+    size_t  frames;                // кадров в последнем spectrum_bank_run()
+    float  *t, *s0r, *s0i, *s1r, *s1i, *xr, *xi;
+} Worker;
+
+struct SpectrumBank {
+    size_t   n, hop, cap;          // кадр, шаг кадров, буфер канала
+    size_t   channels;
+    size_t   lo, width, L;         // бины полосы демодуляции, длина огибающей
+    Rfft     rN, rL;
+    Fft      cL;
+    float   *win, *wd;             // окно кадра и оно же в отсчётах огибающей
+    float    sumWd, norm;          // Σ wd; 2 / (L Σ wd²) — СКЗ по мощности бинов
+    uint32_t range[SPECTRUM_FAULTS][MAX_HARMONICS][2]; // бины гармоник [from, to)
+    int      harmonics;
+    float   *buf;                  // буферы каналов по cap отсчётов
+    size_t  *fill;
+    float   *bands;                // SPECTRUM_FAULTS на канал
+    // Пул: рабочий 0 — вызывающий поток
+    int             threads;
+    Worker         *workers;
+    pthread_t      *tid;
+    int             started;       // запущено потоков пула
+    pthread_mutex_t lock;
+    pthread_cond_t  start, done;
+    uint64_t        gen;
+    int             pending, stop;
+};
+
+static float window_at(SpectrumWindow w, size_t j, size_t n) {
+    const double a = 2.0 * M_PI * (double)j / (double)n; // периодическое окно — для спектра
+    switch (w) {
+    case SPECTRUM_HANN:     return (float)(0.5 - 0.5 * cos(a));
+    case SPECTRUM_BLACKMAN: return (float)(0.35875 - 0.48829 * cos(a) + 0.14128 * cos(2 * a) - 0.01168 * cos(3 * a));
+    default:                return 1.0f;
+    }
+}
+
+// Кадр x → СКЗ огибающей в полосах дефектов
+static void frame_bands(const struct SpectrumBank *b, Worker *w, const float *restrict x, float *bands) {
+    const size_t n = b->n, L = b->L, width = b->width;
+    float *restrict t = w->t;
+    for (size_t j = 0; j < n; j++)
+        t[j] = x[j] * b->win[j];
+    rfft_run(&b->rN, t, w->xr, w->xi, w->s0r, w->s0i, w->s1r, w->s1i);
+
+    // Полоса резонанса, сдвинутая к нулю: положительные частоты ×2 — аналитический сигнал.
+    // Обратное БПФ — прямое с переставленными частями: модуль результата тот же
+    float *restrict zr = w->s0r, *restrict zi = w->s0i;
+    for (size_t k = 0; k < width; k++) {
+        zi[k] = 2.0f * w->xr[b->lo + k];
+        zr[k] = 2.0f * w->xi[b->lo + k];
+    }
+    memset(zr + width, 0, (L - width) * sizeof(float));
+    memset(zi + width, 0, (L - width) * sizeof(float));
+    const int in_y = fft_run(&b->cL, zr, zi, w->s1r, w->s1i);
+    const float *restrict er = in_y ? w->s1r : zr, *restrict ei = in_y ? w->s1i : zi;
+
+    // Огибающая без постоянной составляющей: она — окно × среднее
+    float *restrict env = t;
+    const float inv = 1.0f / (float)n;
+    float sum = 0.0f;
+    for (size_t j = 0; j < L; j++) {
+        env[j] = sqrtf(er[j] * er[j] + ei[j] * ei[j]) * inv;
+        sum += env[j];
+    }
+    const float mean = sum / b->sumWd;
+    for (size_t j = 0; j < L; j++)
+        env[j] -= mean * b->wd[j];
+    // Спектр огибающей — в xr/xi (кадр уже не нужен), рабочие массивы — вторые половины s0/s1
+    rfft_run(&b->rL, env, w->xr, w->xi, w->s1r, w->s1i, w->s1r + L / 2, w->s1i + L / 2);
+
+    for (int f = 0; f < SPECTRUM_FAULTS; f++) {
+        float p = 0.0f;
+        for (int h = 0; h < b->harmonics; h++)
+            for (uint32_t k = b->range[f][h][0]; k < b->range[f][h][1]; k++)
+                p += w->xr[k] * w->xr[k] + w->xi[k] * w->xi[k];
+        bands[f] = sqrtf(p * b->norm);
+    }
+}
+
+// Каналы рабочего: поровну подряд идущими диапазонами
+static void worker_run(struct SpectrumBank *b, Worker *w) {
+    const size_t from = b->channels * w->index / (size_t)b->threads;
+    const size_t to = b->channels * (w->index + 1) / (size_t)b->threads;
+    w->frames = 0;
+    for (size_t ch = from; ch < to; ch++) {
+        float *buf = b->buf + ch * b->cap;
+        while (b->fill[ch] >= b->n) {
+            frame_bands(b, w, buf, b->bands + ch * SPECTRUM_FAULTS);
+            b->fill[ch] -= b->hop;
+            memmove(buf, buf + b->hop, b->fill[ch] * sizeof(float));
+            w->frames++;
+        }
+    }
+}
+
+static void *worker_main(void *arg) {
+    Worker *w = arg;
+    struct SpectrumBank *b = w->bank;
+    uint64_t seen = 0;
+    pthread_mutex_lock(&b->lock);
+    for (;;) {
+        while (b->gen == seen && !b->stop)
+            pthread_cond_wait(&b->start, &b->lock);
+        if (b->stop)
+            break;
+        seen = b->gen;
+        pthread_mutex_unlock(&b->lock);
+        worker_run(b, w);
+        pthread_mutex_lock(&b->lock);
+        if (--b->pending == 0)
+            pthread_cond_signal(&b->done);
+    }
+    pthread_mutex_unlock(&b->lock);
+    return NULL;
+}
+
+static int is_pow2(size_t n) { return n && !(n & (n - 1)); }
+
+SpectrumBank *spectrum_bank_new(const SpectrumConfig *c, size_t channels, size_t maxBlock,
+                                int threads, char *err, size_t errLen) {
+    const double fs = c->sampleRate;
+    const size_t n = c->frameSize;
+    if (!is_pow2(n) || n < 256 || n > 65536 || c->overlap < 0 || c->overlap > 0.75 ||
+        channels == 0 || maxBlock == 0 || threads < 1 || threads > MAX_THREADS ||
+        c->harmonics < 1 || c->harmonics > MAX_HARMONICS || c->tolerance < 0 ||
+        c->balls < 1 || c->ballDiam <= 0 || c->pitchDiam <= c->ballDiam || c->shaftHz <= 0) {
+        snprintf(err, errLen, "недопустимые параметры спектра");
+        return NULL;
+    }
+    // Полоса демодуляции — бины [lo, lo + width), без нулевого и последнего
+    const double binHz = fs / (double)n;
+    size_t lo = (size_t)ceil(c->bandLo / binHz), hi = (size_t)floor(c->bandHi / binHz);
+    if (lo < 1)
+        lo = 1;
+    if (hi > n / 2 - 1)
+        hi = n / 2 - 1;
+    if (c->bandLo <= 0 || hi < lo + 1) {
+        snprintf(err, errLen, "полоса демодуляции %.0f..%.0f Гц вне 0..%.0f Гц или уже двух бинов",
+                 c->bandLo, c->bandHi, fs / 2);
+        return NULL;
+    }
+    // Длина огибающей: вмещает полосу и спектр огибающей до старшей гармоники
+    double hz[SPECTRUM_FAULTS], fmax = 0.0;
+    spectrum_fault_hz(c, hz);
+    for (int f = 0; f < SPECTRUM_FAULTS; f++)
+        fmax = hz[f] > fmax ? hz[f] : fmax;
+    const double topBin = fmax * c->harmonics * (1.0 + c->tolerance) / binHz + 3.0;
+    size_t L = MIN_ENVELOPE;
+    while (L < hi - lo + 1 || L / 2 < topBin)
+        L *= 2;
+    if (L > n / 2) {
+        snprintf(err, errLen, "гармоники до %.0f Гц не помещаются в спектр огибающей кадра %zu",
+                 fmax * c->harmonics, n);
+        return NULL;
+    }
+
+    SpectrumBank *b = calloc(1, sizeof(*b));
+    if (!b) {
+        snprintf(err, errLen, "нет памяти");
+        return NULL;
+    }
+    b->n = n;
+    b->hop = (size_t)((double)n * (1.0 - c->overlap));
+    b->cap = n + maxBlock;
+    b->channels = channels;
+    b->lo = lo;
+    b->width = hi - lo + 1;
+    b->L = L;
+    b->harmonics = c->harmonics;
+    b->threads = threads;
+    pthread_mutex_init(&b->lock, NULL);
+    pthread_cond_init(&b->start, NULL);
+    pthread_cond_init(&b->done, NULL);
+
+    int ok = rfft_init(&b->rN, n) && rfft_init(&b->rL, L) && fft_init(&b->cL, L);
+    b->win   = malloc(n * sizeof(float));
+    b->wd    = malloc(L * sizeof(float));
+    b->buf   = malloc(channels * b->cap * sizeof(float));
+    b->fill  = calloc(channels, sizeof(size_t));
+    b->bands = calloc(channels * SPECTRUM_FAULTS, sizeof(float));
+    b->workers = calloc((size_t)threads, sizeof(Worker));
+    b->tid     = calloc((size_t)threads, sizeof(pthread_t));
+    ok = ok && b->win && b->wd && b->buf && b->fill && b->bands && b->workers && b->tid;
+    for (int k = 0; ok && k < threads; k++) {
+        Worker *w = &b->workers[k];
+        w->bank = b;
+        w->index = (size_t)k;
+        w->t   = malloc(n * sizeof(float));
+        w->s0r = malloc(n / 2 * sizeof(float));
+        w->s0i = malloc(n / 2 * sizeof(float));
+        w->s1r = malloc(n / 2 * sizeof(float));
+        w->s1i = malloc(n / 2 * sizeof(float));
+        w->xr  = malloc((n / 2 + 1) * sizeof(float));
+        w->xi  = malloc((n / 2 + 1) * sizeof(float));
+        ok = w->t && w->s0r && w->s0i && w->s1r && w->s1i && w->xr && w->xi;
+    }
+    if (!ok) {
+        snprintf(err, errLen, "нет памяти под %zu каналов (%.0f МБ)", channels,
+                 channels * b->cap * sizeof(float) / 1048576.0);
+        spectrum_bank_free(b);
+        return NULL;
+    }
+
+    // Окно, оно же в моменты отсчётов огибающей, нормировка СКЗ
+    for (size_t j = 0; j < n; j++)
+        b->win[j] = window_at(c->window, j, n);
+    double sw = 0.0, sw2 = 0.0;
+    for (size_t j = 0; j < L; j++) {
+        b->wd[j] = b->win[j * (n / L)];
+        sw += b->wd[j];
+        sw2 += (double)b->wd[j] * b->wd[j];
+    }
+    b->sumWd = (float)sw;
+    b->norm = (float)(2.0 / ((double)L * sw2));
+
+    // Бины гармоник: ±max(2 бина, tolerance), без повторов и постоянной составляющей
+    for (int f = 0; f < SPECTRUM_FAULTS; f++) {
+        uint32_t prev = 1;
+        for (int h = 0; h < c->harmonics; h++) {
+            const double center = hz[f] * (h + 1) / binHz;
+            double half = c->tolerance * center;
+            if (half < 2.0)
+                half = 2.0;
+            double from = ceil(center - half), to = floor(center + half) + 1;
+            if (from < prev)
+                from = prev;
+            if (to > (double)(L / 2 + 1))
+                to = (double)(L / 2 + 1);
+            if (to < from)
+                to = from;
+            b->range[f][h][0] = (uint32_t)from;
+            b->range[f][h][1] = (uint32_t)to;
+            prev = (uint32_t)to;
+        }
+    }
+
+    for (int k = 1; k < threads; k++) {
+        if (pthread_create(&b->tid[k], NULL, worker_main, &b->workers[k]) != 0) {
+            snprintf(err, errLen, "поток %d не запущен", k);
+            spectrum_bank_free(b);
+            return NULL;
+        }
+        b->started = k;
+    }
+    return b;
+}
+
+void spectrum_bank_free(SpectrumBank *b) {
+    if (!b)
+        return;
+    pthread_mutex_lock(&b->lock);
+    b->stop = 1;
+    pthread_cond_broadcast(&b->start);
+    pthread_mutex_unlock(&b->lock);
+    for (int k = 1; k <= b->started; k++)
+        pthread_join(b->tid[k], NULL);
+    for (int k = 0; b->workers && k < b->threads; k++) {
+        Worker *w = &b->workers[k];
+        free(w->t); free(w->s0r); free(w->s0i); free(w->s1r); free(w->s1i); free(w->xr); free(w->xi);
+    }
+    rfft_free(&b->rN);
+    rfft_free(&b->rL);
+    free(b->cL.tw);
+    free(b->win); free(b->wd); free(b->buf); free(b->fill); free(b->bands);
+    free(b->workers); free(b->tid);
+    pthread_mutex_destroy(&b->lock);
+    pthread_cond_destroy(&b->start);
+    pthread_cond_destroy(&b->done);
+    free(b);
+}
+
+int spectrum_bank_feed(SpectrumBank *b, size_t ch, const double *x, size_t count) {
+    if (b->fill[ch] + count > b->cap)
+        return -1;
+    float *restrict dst = b->buf + ch * b->cap + b->fill[ch];
+    for (size_t j = 0; j < count; j++)
+        dst[j] = (float)x[j];
+    b->fill[ch] += count;
+    return 0;
+}
+
+size_t spectrum_bank_run(SpectrumBank *b) {
+    pthread_mutex_lock(&b->lock);
+    b->gen++;
+    b->pending = b->threads - 1;
+    pthread_cond_broadcast(&b->start);
+    pthread_mutex_unlock(&b->lock);
+    worker_run(b, &b->workers[0]);
+    pthread_mutex_lock(&b->lock);
+    while (b->pending > 0)
+        pthread_cond_wait(&b->done, &b->lock);
+    pthread_mutex_unlock(&b->lock);
+    size_t frames = 0;
+    for (int k = 0; k < b->threads; k++)
+        frames += b->workers[k].frames;
+    return frames;
+}
+
+const float *spectrum_bank_bands(const SpectrumBank *b, size_t ch) {
+    return b->bands + ch * SPECTRUM_FAULTS;
+}
@@ -0,0 +1,87 @@
+/*
+ * spectrum.h — спектр огибающей вибросигнала и энергия полос частот дефектов подшипника
+ * ------------------------------------------------------------------------------------
+ * Дефект подшипника даёт удары с частотой BPFO / BPFI / BSF / FTF, каждый возбуждает
+ * резонанс корпуса на килогерцах. В СКЗ вибрации и в прямом спектре эти частоты почти
+ * не видны, в спектре огибающей резонансной полосы — видны гармониками. Кадр канала:
+ *
+ *   1. окно (Ханн, Блэкман или прямоугольное) и вещественное БПФ кадра из N отсчётов;
+ *   2. демодуляция по Гильберту: бины полосы резонанса [bandLo, bandHi] ×2, остальные —
+ *      нули. Полоса сдвигается к нулевой частоте (модуль аналитического сигнала от
+ *      сдвига не меняется), и обратное БПФ длины L << N даёт огибающую, сразу
+ *      прореженную в N / L раз, — с тем же разрешением fs / N в её спектре;
+ *   3. огибающая без постоянной составляющей (вычитается окно × среднее) и её
+ *      вещественное БПФ длины L;
+ *   4. по каждой частоте дефекта — СКЗ огибающей в полосах ±max(2 бина, tolerance)
+ *      вокруг гармоник 1..harmonics (мм/с для виброскорости); бины, общие у соседних
+ *      гармоник, считаются один раз.
+ *
+ * Частоты дефектов — из геометрии подшипника и оборотной частоты вала; по умолчанию —
+ * 6205 (9 тел качения 7,94 мм на диаметре 39,04 мм), у которого BPFO = 3,585 × вал,
+ * как в модели waveform.c.
+ *
+ * БПФ — комплексное по Стокхэму (без перестановки бит), основание 4 и последний
+ * проход по основанию 2, действительная и мнимая части — в отдельных массивах float.
+ * Внутренний цикл прохода идёт по соседним элементам с общим поворотным множителем,
+ * поэтому компилятор раскладывает его в SIMD (-O3 -march=native); множители всех
+ * проходов посчитаны при создании. Вещественное БПФ N — комплексное N / 2 и проход
+ * разделения спектров.
+ *
+ * SpectrumBank — каналы с буферами кадров (перекрытие кадров — доля overlap) и пул
+ * рабочих потоков: spectrum_bank_feed() дописывает отсчёты канала, spectrum_bank_run()
+ * считает все накопившиеся кадры, каналы делятся между потоками поровну. Вызывающий
+ * поток — тоже рабочий. Канал — N + maxBlock float буфера и полосы; у потока —
+ * рабочие массивы на ~6N float, всё выделено в spectrum_bank_new().
+ */
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SPECTRUM_FAULTS 4 // FTF, BPFO, BPFI, BSF
+
+typedef enum { SPECTRUM_HANN, SPECTRUM_BLACKMAN, SPECTRUM_RECT } SpectrumWindow;
+
+typedef struct {
+    double sampleRate;     // частота дискретизации, Гц
+    size_t frameSize;      // отсчётов в кадре БПФ, степень двойки 256..65536
+    double overlap;        // доля перекрытия соседних кадров, 0..0.75
+    SpectrumWindow window;
+    double bandLo, bandHi; // полоса демодуляции — резонанс корпуса, Гц
+    double shaftHz;        // оборотная частота вала, Гц
+    int    balls;          // тел качения
+    double ballDiam;       // диаметр тела качения
+    double pitchDiam;      // диаметр окружности центров (в тех же единицах)
+    double contactDeg;     // угол контакта, градусы
+    int    harmonics;      // гармоник частоты дефекта в полосе (1..8)
+    double tolerance;      // полуширина полосы гармоники — доля её частоты (скольжение)
+} SpectrumConfig;
+
+// Имена полос: "ftf", "bpfo", "bpfi", "bsf"
+extern const char *const spectrum_fault_names[SPECTRUM_FAULTS];
+
+// Кадр 4096, перекрытие 50 %, окно Ханна, полоса 2..4 кГц, подшипник 6205, 3 гармоники ±2 %
+void spectrum_default(SpectrumConfig *c, double sampleRate, double shaftHz);
+
+// Частоты дефектов по геометрии, Гц, в порядке spectrum_fault_names
+void spectrum_fault_hz(const SpectrumConfig *c, double hz[SPECTRUM_FAULTS]);
+
+typedef struct SpectrumBank SpectrumBank;
+
+// channels каналов, между spectrum_bank_run() — не больше maxBlock отсчётов на канал,
+// threads рабочих (вместе с вызывающим). NULL и сообщение в err при ошибке
+SpectrumBank *spectrum_bank_new(const SpectrumConfig *c, size_t channels, size_t maxBlock,
+                                int threads, char *err, size_t errLen);
+void spectrum_bank_free(SpectrumBank *b);
+
+// count отсчётов канала ch в его буфер; -1 — больше maxBlock с прошлого spectrum_bank_run()
+int spectrum_bank_feed(SpectrumBank *b, size_t ch, const double *x, size_t count);
+
+// Все полные кадры всех каналов; возвращает число посчитанных кадров
+size_t spectrum_bank_run(SpectrumBank *b);
+
+// СКЗ огибающей в полосах дефектов канала по последнему кадру (до первого кадра — нули)
+const float *spectrum_bank_bands(const SpectrumBank *b, size_t ch);
+
+#endif
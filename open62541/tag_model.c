@@ -0,0 +1,452 @@
+/*
+ * tag_model.c — реализация tag_model.h
+ * ------------------------------------
+ * Узлы хранятся списком в порядке создания: папка добавляется, когда путь
+ * впервые встречает её префикс, поэтому родитель всегда стоит раньше потомков
+ * и сортировка не нужна. Поиск пути — открытая адресация по хешу FNV-1a,
+ * в таблице — номер узла + 1 (0 — пусто). Строки — смещения в общем буфере
+ * text (он растёт realloc, указатели появляются только в tag_model_build).
+ */
+#include "tag_model.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define TAG_ROOT_ID   "tags"       // NodeId корневой папки и префикс NodeId тегов
+#define TAG_MAX_PATH  1024         // предел длины NodeId, байт
+#define NO_PARENT     UINT32_MAX   // родитель — корневая папка
+#define NO_SLOT       UINT32_MAX   // узел — папка
+#define UNECE_URI     "http://www.opcfoundation.org/UA/units/un/cefact"
+
+static const struct {
+    const char *name;
+    int         type; // индекс в UA_TYPES
+} tag_types[] = {
+    { "Boolean", UA_TYPES_BOOLEAN }, { "Byte",   UA_TYPES_BYTE },
+    { "Int16",   UA_TYPES_INT16 },   { "UInt16", UA_TYPES_UINT16 },
+    { "Int32",   UA_TYPES_INT32 },   { "UInt32", UA_TYPES_UINT32 },
+    { "Int64",   UA_TYPES_INT64 },   { "UInt64", UA_TYPES_UINT64 },
+    { "Float",   UA_TYPES_FLOAT },   { "Double", UA_TYPES_DOUBLE },
+};
+#define TAG_TYPES (sizeof(tag_types) / sizeof(tag_types[0]))
+
+// Значение тега: все поддерживаемые типы — скаляры до 8 байт
+typedef union {
+    UA_Boolean b;
+    UA_Byte    u8;
+    UA_Int16   i16;
+    UA_UInt16  u16;
+    UA_Int32   i32;
+    UA_UInt32  u32;
+    UA_Int64   i64;
+    UA_UInt64  u64;
+    UA_Float   f;
+    UA_Double  d;
+} TagValue;
+
+// Ячейка тега — контекст узла-источника данных
+typedef struct {
+    TagValue           value;
+    UA_DateTime        sourceTime;  // время последней записи (или загрузки)
+    const UA_DataType *type;
+    UA_Byte            accessLevel;
+} TagSlot;
+
+typedef struct {
+    uint32_t id;          // NodeId "tags.<путь>" — смещение в text
+    uint32_t name;        // BrowseName — последний сегмент пути, смещение в text
+    uint32_t parent;      // номер узла-родителя или NO_PARENT
+    uint32_t slot;        // номер ячейки или NO_SLOT
+    uint32_t unit;        // единицы, 0 — нет
+    uint32_t description; // описание, 0 — нет
+} TagNode;
+
+struct TagModel {
+    char     *text;       // все строки модели; text[0] = '\0' — пустая строка
+    size_t    textLen, textCap;
+    TagNode  *nodes;
+    size_t    nNodes, nodesCap;
+    TagSlot  *slots;
+    size_t    nSlots, slotsCap;
+    size_t    nUnits;     // переменных со свойством EngineeringUnits
+    uint32_t *table;      // номер узла + 1, 0 — пусто
+    size_t    tableMask;
+};
+
+// --- Буфер строк и список узлов ---
+
+static uint32_t text_add(TagModel *m, const char *s, size_t len) {
+    if (m->textLen + len + 1 > m->textCap) {
+        size_t cap = m->textCap ? m->textCap : 4096;
+        while (m->textLen + len + 1 > cap)
+            cap *= 2;
+        if (cap > UINT32_MAX)
+            return 0;
+        char *grown = realloc(m->text, cap);
+        if (!grown)
+            return 0;
+        m->text = grown;
+        m->textCap = cap;
+    }
+    uint32_t off = (uint32_t)m->textLen;
+    memcpy(m->text + off, s, len);
+    m->text[off + len] = '\0';
+    m->textLen += len + 1;
+    return off;
+}
+
+static uint32_t hash_path(const char *s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ (uint8_t)s[i]) * 16777619u;
+    return h;
+}
+
+// Номер узла с NodeId key или -1
+static long find_node(const TagModel *m, const char *key, size_t len) {
+    if (!m->table)
+        return -1;
+    for (size_t h = hash_path(key, len) & m->tableMask;; h = (h + 1) & m->tableMask) {
+        uint32_t e = m->table[h];
+        if (e == 0)
+            return -1;
+        const char *id = m->text + m->nodes[e - 1].id;
+        if (strncmp(id, key, len) == 0 && id[len] == '\0')
+            return (long)(e - 1);
+    }
+}
+
+static void table_insert(TagModel *m, size_t k) {
+    const char *id = m->text + m->nodes[k].id;
+    size_t h = hash_path(id, strlen(id)) & m->tableMask;
+    while (m->table[h])
+        h = (h + 1) & m->tableMask;
+    m->table[h] = (uint32_t)(k + 1);
+}
+
+// Новый узел с NodeId key; заполнение таблицы не выше 1/2
+static TagNode *add_node(TagModel *m, const char *key, size_t len, size_t nameAt, uint32_t parent) {
+    if (m->nNodes == m->nodesCap) {
+        size_t cap = m->nodesCap ? m->nodesCap * 2 : 1024;
+        TagNode *grown = realloc(m->nodes, cap * sizeof(TagNode));
+        if (!grown)
+            return NULL;
+        m->nodes = grown;
+        m->nodesCap = cap;
+    }
+    if ((m->nNodes + 1) * 2 > m->tableMask + 1 || !m->table) {
+        size_t size = m->table ? (m->tableMask + 1) * 2 : 2048;
+        uint32_t *table = calloc(size, sizeof(uint32_t));
+        if (!table)
+            return NULL;
+        free(m->table);
+        m->table = table;
+        m->tableMask = size - 1;
+        for (size_t k = 0; k < m->nNodes; k++)
+            table_insert(m, k);
+    }
+    uint32_t id = text_add(m, key, len);
+    if (!id)
+        return NULL;
+    TagNode *nd = &m->nodes[m->nNodes];
+    *nd = (TagNode){ id, id + (uint32_t)nameAt, parent, NO_SLOT, 0, 0 };
+    table_insert(m, m->nNodes++);
+    return nd;
+}
+
+static char *trim(char *s) {
+    while (*s == ' ' || *s == '\t')
+        s++;
+    char *e = s + strlen(s);
+    while (e > s && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r'))
+        *--e = '\0';
+    return s;
+}
+
+// --- Разбор строки: путь,тип,единицы,доступ[,описание] ---
+
+static int parse_tag(TagModel *m, char *line, char *msg, size_t msgLen) {
+    char *field[5] = { line, NULL, NULL, NULL, "" };
+    for (int f = 1; f < 5; f++) {
+        char *comma = strchr(field[f - 1], ',');
+        if (!comma) {
+            if (f < 4) {
+                snprintf(msg, msgLen, "нужны поля путь,тип,единицы,доступ[,описание]");
+                return -1;
+            }
+            break;
+        }
+        *comma = '\0';
+        field[f] = comma + 1;
+    }
+    for (int f = 0; f < 5; f++)
+        field[f] = trim(field[f]);
+    const char *path = field[0], *typeName = field[1], *unit = field[2], *access = field[3];
+
+    size_t t = 0;
+    while (t < TAG_TYPES && strcasecmp(typeName, tag_types[t].name) != 0)
+        t++;
+    if (t == TAG_TYPES) {
+        snprintf(msg, msgLen, "неизвестный тип '%s'", typeName);
+        return -1;
+    }
+    UA_Byte accessLevel;
+    if (!strcmp(access, "r"))
+        accessLevel = UA_ACCESSLEVELMASK_READ;
+    else if (!strcmp(access, "rw"))
+        accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    else {
+        snprintf(msg, msgLen, "доступ '%s': нужно r или rw", access);
+        return -1;
+    }
+
+    // NodeId "tags.<путь>": каждый префикс до точки — папка, создаётся при первой встрече
+    char key[TAG_MAX_PATH];
+    const size_t pathLen = strlen(path), rootLen = strlen(TAG_ROOT_ID);
+    if (rootLen + 1 + pathLen >= sizeof(key)) {
+        snprintf(msg, msgLen, "путь длиннее %d байт", TAG_MAX_PATH - (int)rootLen - 2);
+        return -1;
+    }
+    memcpy(key, TAG_ROOT_ID ".", rootLen + 1);
+    memcpy(key + rootLen + 1, path, pathLen + 1);
+    const size_t keyLen = rootLen + 1 + pathLen;
+    uint32_t parent = NO_PARENT;
+    size_t seg = rootLen + 1; // начало текущего сегмента
+    for (size_t i = seg; i <= keyLen; i++) {
+        if (key[i] != '.' && key[i] != '\0')
+            continue;
+        if (i == seg) {
+            snprintf(msg, msgLen, "пустой сегмент в пути '%s'", path);
+            return -1;
+        }
+        long k = find_node(m, key, i);
+        if (i == keyLen) {
+            if (k >= 0) {
+                snprintf(msg, msgLen, "'%s' уже есть (%s)", path,
+                         m->nodes[k].slot == NO_SLOT ? "папка" : "тег");
+                return -1;
+            }
+            break;
+        }
+        if (k >= 0 && m->nodes[k].slot != NO_SLOT) {
+            snprintf(msg, msgLen, "'%.*s' — тег, а не папка", (int)(i - rootLen - 1), path);
+            return -1;
+        }
+        if (k < 0) {
+            TagNode *folder = add_node(m, key, i, seg, parent);
+            if (!folder) {
+                snprintf(msg, msgLen, "нет памяти");
+                return -1;
+            }
+            k = (long)(folder - m->nodes);
+        }
+        parent = (uint32_t)k;
+        seg = i + 1;
+    }
+
+    if (m->nSlots == m->slotsCap) {
+        size_t cap = m->slotsCap ? m->slotsCap * 2 : 1024;
+        TagSlot *grown = realloc(m->slots, cap * sizeof(TagSlot));
+        if (!grown) {
+            snprintf(msg, msgLen, "нет памяти");
+            return -1;
+        }
+        m->slots = grown;
+        m->slotsCap = cap;
+    }
+    TagNode *nd = add_node(m, key, keyLen, seg, parent);
+    uint32_t unitOff = 0, descOff = 0;
+    if (nd && *unit && !(unitOff = text_add(m, unit, strlen(unit))))
+        nd = NULL;
+    if (nd && *field[4] && !(descOff = text_add(m, field[4], strlen(field[4]))))
+        nd = NULL;
+    if (!nd) {
+        snprintf(msg, msgLen, "нет памяти");
+        return -1;
+    }
+    nd = &m->nodes[m->nNodes - 1];
+    nd->unit = unitOff;
+    nd->description = descOff;
+    nd->slot = (uint32_t)m->nSlots;
+    TagSlot *s = &m->slots[m->nSlots++];
+    memset(&s->value, 0, sizeof(s->value));
+    s->sourceTime = UA_DateTime_now();
+    s->type = &UA_TYPES[tag_types[t].type];
+    s->accessLevel = accessLevel;
+    m->nUnits += unitOff != 0;
+    return 0;
+}
+
+TagModel *tag_model_load(const char *path, char *err, size_t errLen) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        snprintf(err, errLen, "%s: %s", path, strerror(errno));
+        return NULL;
+    }
+    // Файл читается целиком: 100k тегов — несколько мегабайт
+    char *buf = NULL;
+    long size = -1;
+    if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0 &&
+        (buf = malloc((size_t)size + 1)) && fread(buf, 1, (size_t)size, f) != (size_t)size) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    TagModel *m = calloc(1, sizeof(TagModel));
+    if (!buf || !m || text_add(m, "", 0) != 0 || !m->text) {
+        snprintf(err, errLen, "%s: %s", path, buf ? "нет памяти" : "ошибка чтения");
+        free(buf);
+        tag_model_free(m);
+        return NULL;
+    }
+    buf[size] = '\0';
+
+    int lineNo = 0, rc = 0;
+    char msg[160];
+    for (char *line = buf, *next; line && rc == 0; line = next) {
+        lineNo++;
+        char *nl = strchr(line, '\n');
+        next = nl ? nl + 1 : NULL;
+        if (nl)
+            *nl = '\0';
+        char *p = trim(line);
+        // Комментарий — только целая строка: в описании # допустим; перед тегами — заголовок CSV
+        if (!*p || *p == '#' || (m->nSlots == 0 && !strncasecmp(p, "path,", 5)))
+            continue;
+        if (parse_tag(m, p, msg, sizeof(msg)) != 0) {
+            snprintf(err, errLen, "%s:%d: %s", path, lineNo, msg);
+            rc = -1;
+        }
+    }
+    free(buf);
+    if (rc == 0 && m->nSlots == 0) {
+        snprintf(err, errLen, "%s: нет ни одного тега", path);
+        rc = -1;
+    }
+    if (rc != 0) {
+        tag_model_free(m);
+        return NULL;
+    }
+    free(m->table); // поиск нужен только при разборе
+    m->table = NULL;
+    return m;
+}
+
+void tag_model_free(TagModel *m) {
+    if (!m)
+        return;
+    free(m->text);
+    free(m->nodes);
+    free(m->slots);
+    free(m->table);
+    free(m);
+}
+
+size_t tag_model_tags(const TagModel *m)  { return m->nSlots; }
+size_t tag_model_nodes(const TagModel *m) { return 1 + m->nNodes + m->nUnits; }
+
+// --- Источник данных: ячейка тега ---
+
+static UA_StatusCode tag_read(UA_Server *server, const UA_NodeId *sessionId, void *sessionContext,
+                              const UA_NodeId *nodeId, void *nodeContext, UA_Boolean includeSourceTimeStamp,
+                              const UA_NumericRange *range, UA_DataValue *value) {
+    const TagSlot *s = nodeContext;
+    if (range)
+        return UA_STATUSCODE_BADINDEXRANGEINVALID; // все теги — скаляры
+    UA_StatusCode rc = UA_Variant_setScalarCopy(&value->value, &s->value, s->type);
+    if (rc != UA_STATUSCODE_GOOD)
+        return rc;
+    value->hasValue = true;
+    if (includeSourceTimeStamp) {
+        value->sourceTimestamp = s->sourceTime;
+        value->hasSourceTimestamp = true;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode tag_write(UA_Server *server, const UA_NodeId *sessionId, void *sessionContext,
+                               const UA_NodeId *nodeId, void *nodeContext,
+                               const UA_NumericRange *range, const UA_DataValue *value) {
+    TagSlot *s = nodeContext;
+    if (range)
+        return UA_STATUSCODE_BADINDEXRANGEINVALID;
+    if (!(s->accessLevel & UA_ACCESSLEVELMASK_WRITE))
+        return UA_STATUSCODE_BADNOTWRITABLE;
+    if (!value->hasValue || !UA_Variant_hasScalarType(&value->value, s->type))
+        return UA_STATUSCODE_BADTYPEMISMATCH;
+    memcpy(&s->value, value->value.data, s->type->memSize);
+    s->sourceTime = value->hasSourceTimestamp ? value->sourceTimestamp : UA_DateTime_now();
+    return UA_STATUSCODE_GOOD;
+}
+
+// --- Построение узлов ---
+
+// Свойство EngineeringUnits переменной: единицы без кода UNECE (unitId = -1)
+static UA_StatusCode add_units(UA_Server *server, const UA_NodeId *tag, char *unit) {
+    UA_EUInformation eu;
+    eu.namespaceUri = UA_STRING(UNECE_URI);
+    eu.unitId = -1;
+    eu.displayName = UA_LOCALIZEDTEXT("", unit);
+    eu.description = UA_LOCALIZEDTEXT("", unit);
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.dataType = UA_TYPES[UA_TYPES_EUINFORMATION].typeId;
+    attr.valueRank = UA_VALUERANK_SCALAR;
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+    UA_Variant_setScalar(&attr.value, &eu, &UA_TYPES[UA_TYPES_EUINFORMATION]);
+    attr.displayName = UA_LOCALIZEDTEXT("en-US", "EngineeringUnits");
+    // NodeId свойства назначает сервер: по нему не обращаются, только по пути
+    return UA_Server_addVariableNode(server, UA_NODEID_NUMERIC(1, 0), *tag,
+        UA_NODEID_NUMERIC(0, UA_NS0ID_HASPROPERTY),
+        UA_QUALIFIEDNAME(0, "EngineeringUnits"),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_PROPERTYTYPE),
+        attr, NULL, NULL);
+}
+
+UA_StatusCode tag_model_build(TagModel *m, UA_Server *server, char *err, size_t errLen) {
+    const UA_NodeId root = UA_NODEID_STRING(1, TAG_ROOT_ID);
+    const UA_NodeId organizes = UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES);
+    const UA_NodeId folderType = UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE);
+    const UA_NodeId varType = UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE);
+    const UA_DataSource source = { tag_read, tag_write };
+
+    UA_ObjectAttributes fattr = UA_ObjectAttributes_default;
+    fattr.displayName = UA_LOCALIZEDTEXT("en-US", "Tags");
+    UA_StatusCode rc = UA_Server_addObjectNode(server, root,
+        UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER), organizes,
+        UA_QUALIFIEDNAME(1, "Tags"), folderType, fattr, NULL, NULL);
+
+    // Один проход в порядке создания: родитель уже в адресном пространстве
+    size_t k = 0;
+    for (; k < m->nNodes && rc == UA_STATUSCODE_GOOD; k++) {
+        const TagNode *nd = &m->nodes[k];
+        UA_NodeId id = UA_NODEID_STRING(1, m->text + nd->id);
+        UA_NodeId parent = nd->parent == NO_PARENT ? root : UA_NODEID_STRING(1, m->text + m->nodes[nd->parent].id);
+        char *name = m->text + nd->name;
+        if (nd->slot == NO_SLOT) {
+            UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+            oattr.displayName = UA_LOCALIZEDTEXT("en-US", name);
+            rc = UA_Server_addObjectNode(server, id, parent, organizes,
+                UA_QUALIFIEDNAME(1, name), folderType, oattr, NULL, NULL);
+            continue;
+        }
+        TagSlot *s = &m->slots[nd->slot];
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        attr.dataType = s->type->typeId;
+        attr.valueRank = UA_VALUERANK_SCALAR;
+        attr.accessLevel = s->accessLevel;
+        attr.displayName = UA_LOCALIZEDTEXT("en-US", name);
+        if (nd->description)
+            attr.description = UA_LOCALIZEDTEXT("ru-RU", m->text + nd->description);
+        rc = UA_Server_addDataSourceVariableNode(server, id, parent, organizes,
+            UA_QUALIFIEDNAME(1, name), varType, attr, source, s, NULL);
+        if (rc == UA_STATUSCODE_GOOD && nd->unit)
+            rc = add_units(server, &id, m->text + nd->unit);
+    }
+    if (rc != UA_STATUSCODE_GOOD)
+        snprintf(err, errLen, "%s: %s", k ? m->text + m->nodes[k - 1].id : TAG_ROOT_ID,
+                 UA_StatusCode_name(rc));
+    return rc;
+}
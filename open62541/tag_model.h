@@ -0,0 +1,49 @@
+/*
+ * tag_model.h — адресное пространство из файла описания тегов
+ * ----------------------------------------------------------
+ * Вместо узлов, прописанных в коде сервера по одному, теги берутся из файла
+ * CSV — строка на тег, поля через запятую, # — комментарий:
+ *   # путь                       тип     единицы доступ описание
+ *   line1.pump1.bearing.vibration,Double,mm/s,rw,Вибрация подшипника насоса 1
+ *   line1.pump1.running,Boolean,,r,Насос в работе
+ * Пример — open62541/tags.csv.
+ *
+ *   путь      — сегменты через точку; все сегменты, кроме последнего, — папки
+ *               (FolderType, Organizes), последний — переменная. NodeId узла —
+ *               ns=1;s=tags.<путь>, корень — папка Tags (ns=1;s=tags) в Objects;
+ *   тип       — Boolean, Byte, Int16, UInt16, Int32, UInt32, Int64, UInt64, Float, Double;
+ *   единицы   — свойство EngineeringUnits (EUInformation), пусто — без свойства;
+ *   доступ    — r или rw;
+ *   описание  — необязательное, до конца строки (запятые допустимы).
+ *
+ * Загрузка (tag_model_load) читает файл целиком и раскладывает его в список
+ * узлов в порядке создания: родитель всегда раньше потомков, каждая папка —
+ * один раз (хеш-таблица путей), повторы и конфликты тег/папка — ошибка с номером
+ * строки. Все строки (NodeId, имена, единицы) лежат в одном буфере, значения
+ * тегов — в одном массиве ячеек.
+ *
+ * Построение (tag_model_build) — один проход по списку до UA_Server_run_startup:
+ * NodeId и атрибуты указывают в буфер модели, сервер копирует их один раз, своих
+ * выделений памяти на узел нет. Переменные — источники данных над ячейками:
+ * хранилище узлов не держит копий UA_Variant, запись клиента (доступ rw) попадает
+ * прямо в ячейку. Модель освобождается после UA_Server_delete.
+ */
+#ifndef TAG_MODEL_H
+#define TAG_MODEL_H
+
+#include <open62541/server.h>
+#include <stddef.h>
+
+typedef struct TagModel TagModel;
+
+// Чтение файла тегов; NULL и сообщение в err при ошибке
+TagModel *tag_model_load(const char *path, char *err, size_t errLen);
+void tag_model_free(TagModel *m);
+
+size_t tag_model_tags(const TagModel *m);  // переменных
+size_t tag_model_nodes(const TagModel *m); // всех узлов: корень, папки, переменные, EngineeringUnits
+
+// Узлы модели в адресном пространстве сервера; при ошибке — код первой неудачи и путь узла в err
+UA_StatusCode tag_model_build(TagModel *m, UA_Server *server, char *err, size_t errLen);
+
+#endif
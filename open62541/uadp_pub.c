@@ -0,0 +1,230 @@
+/*
+ * uadp_pub.c — реализация uadp_pub.h
+ * ---------------------------------
+ */
+#define _GNU_SOURCE // sendmmsg()
+#include "uadp_pub.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Флаги UADP (Part 14, 7.2.2.2)
+#define UADP_VERSION            0x01
+#define UADP_PUBLISHERID        0x10
+#define UADP_GROUPHEADER        0x20
+#define UADP_PAYLOADHEADER      0x40
+#define UADP_EXTFLAGS1          0x80
+#define UADP_EXT1_PUBID_UINT16  0x01
+#define UADP_EXT1_TIMESTAMP     0x20
+#define UADP_GROUP_WRITERGROUP  0x01
+#define UADP_GROUP_SEQNUM       0x08
+#define UADP_DSM_VALID          0x01 // DataSetFlags1: поля — Variant (биты 1-2 = 0)
+#define UADP_DSM_SEQNUM         0x08
+
+// Встроенные типы Variant
+#define UADP_BOOLEAN 1
+#define UADP_UINT32  7
+#define UADP_DOUBLE  11
+
+#define UADP_HEADER_BYTES 25 // заголовки NetworkMessage (20) и DataSetMessage (5)
+#define UADP_BATCH        256 // датаграмм на вызов sendmmsg()
+
+struct UadpPublisher {
+    int       fd;
+    struct sockaddr_in dst;
+    uint16_t  publisherId, writerGroupId;
+    size_t    n, block, nMessages;
+    uint8_t  *buf;           // nMessages датаграмм по msgCap байт
+    size_t    msgCap;
+    struct mmsghdr *msgs;
+    struct iovec   *iov;
+    uint16_t  networkSeq;    // SequenceNumber NetworkMessage — сквозной по группе
+    uint16_t  cycle;         // SequenceNumber DataSetMessage — номер цикла
+    uint64_t  bytes, errors;
+};
+
+// --- Кодирование (little-endian, как в OPC UA Binary) ---
+
+static inline uint8_t *put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static inline uint8_t *put_u32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+    return p + 4;
+}
+
+static inline uint8_t *put_u64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+    return p + 8;
+}
+
+static inline uint8_t *put_double(uint8_t *p, double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return put_u64(p, bits);
+}
+
+// Разбор opc.udp://a.b.c.d:port
+static int parse_url(const char *url, struct sockaddr_in *sa) {
+    const char *prefix = "opc.udp://";
+    char host[64];
+    unsigned port;
+    if (strncmp(url, prefix, strlen(prefix)) != 0)
+        return -1;
+    if (sscanf(url + strlen(prefix), "%63[^:]:%u", host, &port) != 2 || port == 0 || port > 65535)
+        return -1;
+    memset(sa, 0, sizeof(*sa));
+    sa->sin_family = AF_INET;
+    sa->sin_port = htons((uint16_t)port);
+    return inet_pton(AF_INET, host, &sa->sin_addr) == 1 ? 0 : -1;
+}
+
+UadpPublisher *uadp_pub_new(const UadpPublisherConfig *cfg, size_t nAssets, char *err, size_t errLen) {
+    if (cfg->assetsPerMessage < 1 || cfg->assetsPerMessage > UADP_MAX_BLOCK || nAssets == 0) {
+        snprintf(err, errLen, "блок — 1..%d агрегатов", UADP_MAX_BLOCK);
+        return NULL;
+    }
+    UadpPublisher *p = calloc(1, sizeof(*p));
+    if (!p) {
+        snprintf(err, errLen, "нет памяти");
+        return NULL;
+    }
+    p->fd = -1;
+    if (parse_url(cfg->url, &p->dst) != 0) {
+        snprintf(err, errLen, "адрес %s — нужен opc.udp://<IPv4>:<порт>", cfg->url);
+        uadp_pub_free(p);
+        return NULL;
+    }
+    p->publisherId   = cfg->publisherId;
+    p->writerGroupId = cfg->writerGroupId;
+    p->n         = nAssets;
+    p->block     = cfg->assetsPerMessage;
+    p->nMessages = (nAssets + p->block - 1) / p->block;
+    if (p->nMessages > 65535) { // DataSetWriterId — UInt16
+        snprintf(err, errLen, "больше 65535 сообщений за цикл — увеличьте блок");
+        uadp_pub_free(p);
+        return NULL;
+    }
+    p->msgCap    = UADP_HEADER_BYTES + 5 + p->block * (3 * 9 + 2);
+    p->buf  = malloc(p->nMessages * p->msgCap);
+    p->msgs = calloc(p->nMessages, sizeof(struct mmsghdr));
+    p->iov  = calloc(p->nMessages, sizeof(struct iovec));
+    if (!p->buf || !p->msgs || !p->iov) {
+        snprintf(err, errLen, "нет памяти под %zu датаграмм", p->nMessages);
+        uadp_pub_free(p);
+        return NULL;
+    }
+
+    p->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    unsigned char ttl = (unsigned char)(cfg->ttl > 0 ? cfg->ttl : 1), loop = 1;
+    int sndbuf = 4 << 20; // цикл большого парка уходит пачкой
+    if (p->fd < 0 ||
+        setsockopt(p->fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) != 0 ||
+        setsockopt(p->fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) != 0) {
+        snprintf(err, errLen, "сокет: %s", strerror(errno));
+        uadp_pub_free(p);
+        return NULL;
+    }
+    setsockopt(p->fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    if (cfg->iface) {
+        struct in_addr ifAddr;
+        if (inet_pton(AF_INET, cfg->iface, &ifAddr) != 1 ||
+            setsockopt(p->fd, IPPROTO_IP, IP_MULTICAST_IF, &ifAddr, sizeof(ifAddr)) != 0) {
+            snprintf(err, errLen, "интерфейс %s: %s", cfg->iface, strerror(errno));
+            uadp_pub_free(p);
+            return NULL;
+        }
+    }
+
+    for (size_t m = 0; m < p->nMessages; m++) {
+        p->iov[m].iov_base = p->buf + m * p->msgCap;
+        p->msgs[m].msg_hdr.msg_name    = &p->dst;
+        p->msgs[m].msg_hdr.msg_namelen = sizeof(p->dst);
+        p->msgs[m].msg_hdr.msg_iov     = &p->iov[m];
+        p->msgs[m].msg_hdr.msg_iovlen  = 1;
+    }
+    return p;
+}
+
+void uadp_pub_free(UadpPublisher *p) {
+    if (!p)
+        return;
+    if (p->fd >= 0)
+        close(p->fd);
+    free(p->buf);
+    free(p->msgs);
+    free(p->iov);
+    free(p);
+}
+
+// Датаграмма блока m: агрегаты [first, first + count)
+static size_t encode_block(UadpPublisher *p, size_t m, int64_t timestamp, const double *vib,
+                           const double *temp, const double *press, const uint8_t *alarm) {
+    const size_t first = m * p->block;
+    const size_t count = first + p->block <= p->n ? p->block : p->n - first;
+    uint8_t *start = p->buf + m * p->msgCap, *b = start;
+
+    // NetworkMessage
+    *b++ = UADP_VERSION | UADP_PUBLISHERID | UADP_GROUPHEADER | UADP_PAYLOADHEADER | UADP_EXTFLAGS1;
+    *b++ = UADP_EXT1_PUBID_UINT16 | UADP_EXT1_TIMESTAMP;
+    b = put_u16(b, p->publisherId);
+    *b++ = UADP_GROUP_WRITERGROUP | UADP_GROUP_SEQNUM;
+    b = put_u16(b, p->writerGroupId);
+    b = put_u16(b, p->networkSeq++);
+    *b++ = 1;                                  // одно DataSetMessage
+    b = put_u16(b, (uint16_t)(m + 1));         // DataSetWriterId
+    b = put_u64(b, (uint64_t)timestamp);
+
+    // DataSetMessage (keyframe)
+    *b++ = UADP_DSM_VALID | UADP_DSM_SEQNUM;
+    b = put_u16(b, p->cycle);
+    b = put_u16(b, (uint16_t)(1 + 4 * count)); // FieldCount
+    *b++ = UADP_UINT32;
+    b = put_u32(b, (uint32_t)first);
+    for (size_t i = first; i < first + count; i++) {
+        *b++ = UADP_DOUBLE;
+        b = put_double(b, vib[i]);
+        *b++ = UADP_DOUBLE;
+        b = put_double(b, temp[i]);
+        *b++ = UADP_DOUBLE;
+        b = put_double(b, press[i]);
+        *b++ = UADP_BOOLEAN;
+        *b++ = alarm[i] ? 1 : 0;
+    }
+    return (size_t)(b - start);
+}
+
+size_t uadp_pub_send(UadpPublisher *p, int64_t timestamp, const double *vib, const double *temp,
+                     const double *press, const uint8_t *alarm) {
+    for (size_t m = 0; m < p->nMessages; m++)
+        p->iov[m].iov_len = encode_block(p, m, timestamp, vib, temp, press, alarm);
+    p->cycle++;
+
+    size_t sent = 0;
+    while (sent < p->nMessages) {
+        size_t batch = p->nMessages - sent < UADP_BATCH ? p->nMessages - sent : UADP_BATCH;
+        int r = sendmmsg(p->fd, p->msgs + sent, (unsigned)batch, 0);
+        if (r <= 0) {
+            if (r < 0 && errno == EINTR)
+                continue;
+            p->errors += p->nMessages - sent; // буфер сокета полон или сеть недоступна — цикл теряется
+            break;
+        }
+        for (int k = 0; k < r; k++)
+            p->bytes += p->msgs[sent + (size_t)k].msg_len;
+        sent += (size_t)r;
+    }
+    return sent;
+}
+
+uint64_t uadp_pub_bytes(const UadpPublisher *p)  { return p->bytes; }
+uint64_t uadp_pub_errors(const UadpPublisher *p) { return p->errors; }
@@ -0,0 +1,56 @@
+/*
+ * uadp_pub.h — публикация телеметрии парка по OPC UA PubSub (UADP поверх UDP multicast)
+ * ------------------------------------------------------------------------------------
+ * Каждому потребителю (сборщик, прогноз, мосты Grafana) сейчас нужна своя сессия
+ * opc.tcp, и нагрузка сервера растёт с их числом. Здесь сервер раз в интервал
+ * отправляет набор данных equipment.* в multicast-группу: одна отправка датаграммы
+ * на блок агрегатов, сколько бы подписчиков ни слушали группу.
+ *
+ * Формат — UADP NetworkMessage (OPC UA Part 14, 7.2.2), без шифрования:
+ *   заголовок: PublisherId (UInt16), GroupHeader (WriterGroupId, SequenceNumber),
+ *   PayloadHeader (один DataSetWriterId), Timestamp — время тика;
+ *   одно DataSetMessage (keyframe, поля в кодировке Variant, свой SequenceNumber):
+ *     [0]            UInt32  — номер первого агрегата блока
+ *     [1 + 4·j + 0]  Double  — вибрация агрегата first + j, мм/с
+ *     [1 + 4·j + 1]  Double  — температура, °C
+ *     [1 + 4·j + 2]  Double  — давление, бар
+ *     [1 + 4·j + 3]  Boolean — тревога
+ * DataSetWriterId = номер блока + 1. Блок по умолчанию — 32 агрегата (~950 байт,
+ * датаграмма укладывается в MTU 1500 без фрагментации).
+ * Разбор на стороне потребителя — opcua_client/uadp_sub.c.
+ *
+ * Датаграммы цикла собираются в один буфер и уходят пачками через sendmmsg().
+ */
+#ifndef UADP_PUB_H
+#define UADP_PUB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define UADP_DEFAULT_URL "opc.udp://224.0.0.22:4840"
+#define UADP_MAX_BLOCK   1024 // агрегатов в одном сообщении (датаграмма < 64 КБ)
+
+typedef struct {
+    const char *url;              // opc.udp://<группа>:<порт>
+    const char *iface;            // IPv4-адрес интерфейса для multicast; NULL — по умолчанию
+    uint16_t    publisherId;
+    uint16_t    writerGroupId;
+    size_t      assetsPerMessage; // 1..UADP_MAX_BLOCK
+    int         ttl;              // IP_MULTICAST_TTL; 1 — только локальная сеть
+} UadpPublisherConfig;
+
+typedef struct UadpPublisher UadpPublisher;
+
+// Сокет и буферы на nAssets агрегатов. NULL при ошибке, текст — в err
+UadpPublisher *uadp_pub_new(const UadpPublisherConfig *cfg, size_t nAssets, char *err, size_t errLen);
+void uadp_pub_free(UadpPublisher *p);
+
+// Один цикл публикации: все агрегаты блоками; timestamp — UA_DateTime тика.
+// Возвращает число отправленных датаграмм
+size_t uadp_pub_send(UadpPublisher *p, int64_t timestamp, const double *vib, const double *temp,
+                     const double *press, const uint8_t *alarm);
+
+uint64_t uadp_pub_bytes(const UadpPublisher *p);  // отправлено байт всего
+uint64_t uadp_pub_errors(const UadpPublisher *p); // датаграмм не отправлено
+
+#endif
@@ -0,0 +1,40 @@
+/*
+ * waveform.c — реализация waveform.h
+ */
+#include "waveform.h"
+#include "sim_rng.h"
+#include <math.h>
+
+#define WF_STREAM 0x5741564546524D31ULL // отдельный поток ГПСЧ для шума формы сигнала
+
+void waveform_default(WaveformConfig *c, double sampleRate, size_t blockSize) {
+    c->sampleRate  = sampleRate;
+    c->blockSize   = blockSize;
+    c->shaftHz     = 25.0;
+    c->bpfoHz      = 3.585 * 25.0;
+    c->resonanceHz = 3000.0;
+    c->damping     = 800.0;
+}
+
+void waveform_block(const WaveformConfig *c, uint64_t key, uint64_t pos,
+                    double level, double defect, double *restrict out) {
+    const double dt   = 1.0 / c->sampleRate;
+    const double w1   = 2.0 * M_PI * c->shaftHz;
+    const double wr   = 2.0 * M_PI * c->resonanceHz;
+    const double bpfo = c->bpfoHz;
+    const double a1 = 1.2 * level, a2 = 0.4 * level, an = 0.5 * level;
+    const uint64_t nkey = key ^ WF_STREAM;
+
+    const double t0 = (double)pos * dt;
+    const int n = (int)c->blockSize;
+
+    // Индекс int: int32 → double есть в AVX2, а int64 → double — только в AVX-512
+    for (int j = 0; j < n; j++) {
+        double t = t0 + (double)j * dt;
+        // Время с последнего удара: floor векторизуется, fmod — нет
+        double tau = t - floor(t * bpfo) / bpfo;
+        out[j] = a1 * sin(w1 * t) + a2 * sin(2.0 * w1 * t)
+               + defect * exp(-c->damping * tau) * sin(wr * tau)
+               + an * (urand(nkey, pos + j) - 0.5);
+    }
+}
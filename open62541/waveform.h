@@ -0,0 +1,37 @@
+/*
+ * waveform.h — генерация сырой формы вибросигнала подшипника блоками
+ * -----------------------------------------------------------------
+ * Модель виброскорости (мм/с) на частоте дискретизации 10–50 кГц:
+ *   — гармоники оборотной частоты вала (1× и 2×), амплитуда ~ уровню вибрации;
+ *   — удары дефекта наружного кольца с частотой BPFO, каждый возбуждает
+ *     затухающий резонанс корпуса (классическая картина для огибающей);
+ *   — широкополосный шум.
+ * Блок пишется в буфер вызывающего, без выделения памяти. Номер первого
+ * отсчёта pos сквозной, поэтому фаза непрерывна между блоками, а цикл
+ * по отсчётам без ветвлений векторизуется (-O3 -ffast-math).
+ */
+#ifndef WAVEFORM_H
+#define WAVEFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    double sampleRate;   // частота дискретизации, Гц
+    size_t blockSize;    // отсчётов в блоке
+    double shaftHz;      // оборотная частота вала, Гц
+    double bpfoHz;       // частота ударов дефекта наружного кольца, Гц
+    double resonanceHz;  // резонанс корпуса, возбуждаемый ударами, Гц
+    double damping;      // затухание удара, 1/с
+} WaveformConfig;
+
+// Параметры по умолчанию: вал 25 Гц (1500 об/мин), BPFO = 3.585 × вал, резонанс 3 кГц
+void waveform_default(WaveformConfig *c, double sampleRate, size_t blockSize);
+
+// Блок из c->blockSize отсчётов, начиная со сквозного номера pos.
+// level — уровень вибрации агрегата (мм/с), defect — амплитуда ударов дефекта (0 — нет дефекта),
+// key — ключ ГПСЧ агрегата (sim_rng.h).
+void waveform_block(const WaveformConfig *c, uint64_t key, uint64_t pos,
+                    double level, double defect, double *out);
+
+#endif